@@ -78,6 +78,7 @@ set(ODBFLAGS
   --std c++11
   --database ${DATABASE}
   --generate-query
+  --generate-prepared
   --generate-schema
   --schema-format sql
   --sql-file-suffix -odb
@@ -47,6 +47,36 @@ struct BuildTarget
 
 typedef std::shared_ptr<BuildTarget> BuildTargetPtr;
 
+/**
+ * This view connects the sources of the build actions to their targets,
+ * together with the metadata of both files.
+ */
+#pragma db view \
+  object(BuildSource) \
+  object(BuildTarget : BuildSource::action == BuildTarget::action) \
+  object(File = SourceFile : BuildSource::file) \
+  object(File = TargetFile : BuildTarget::file)
+struct BuildFileEdge
+{
+  #pragma db column(SourceFile::id)
+  FileId fromId;
+
+  #pragma db column(SourceFile::path)
+  std::string fromPath;
+
+  #pragma db column(SourceFile::type)
+  std::string fromType;
+
+  #pragma db column(TargetFile::id)
+  FileId toId;
+
+  #pragma db column(TargetFile::path)
+  std::string toPath;
+
+  #pragma db column(TargetFile::type)
+  std::string toType;
+};
+
 } // model
 } // cc
 
@@ -17,6 +17,7 @@
 #include <util/filesystem.h>
 #include <util/logutil.h>
 #include <util/odbtransaction.h>
+#include <util/projectgeneration.h>
 
 #include <parser/parsercontext.h>
 #include <parser/pluginhandler.h>
@@ -326,7 +327,12 @@ int main(int argc, char* argv[])
   }
 
   //--- Prepare workspace and project directory ---//
-  
+
+  // The generation has to be read before a forced parsing removes the project
+  // directory, so that running services notice the change of the database.
+  std::uint64_t generation = cc::util::readProjectGeneration(
+    vm["workspace"].as<std::string>() + '/' + vm["name"].as<std::string>());
+
   std::string projDir = prepareProjectDir(vm);
   if (projDir.empty())
     return 1;
@@ -396,7 +402,9 @@ int main(int argc, char* argv[])
     ctx.fileStatus.clear();
   }
 
-  if (!vm.count("force"))
+  // A new database has nothing to clean up, even if some plugin finds data of
+  // an earlier project in the project directory.
+  if (!vm.count("force") && !isNewDb)
   {
     for (const std::string& pluginName : pluginNames)
     {
@@ -469,6 +477,8 @@ int main(int argc, char* argv[])
   if (vm.count("description"))
     pt.put("description", vm["description"].as<std::string>());
 
+  pt.put("generation", generation + 1);
+
   boost::property_tree::write_json(projDir + "/project_info.json", pt);
 
   // TODO: Print statistics.
@@ -249,6 +249,17 @@ struct CppAstCount
   std::size_t count;
 };
 
+#pragma db view object(CppAstNode) \
+  query ((?) + "GROUP BY" + CppAstNode::entityHash)
+struct CppAstCountGroupByEntity
+{
+  #pragma db column(CppAstNode::entityHash)
+  std::uint64_t entityHash;
+
+  #pragma db column("count(" + CppAstNode::id + ")")
+  std::size_t count;
+};
+
 }
 }
 
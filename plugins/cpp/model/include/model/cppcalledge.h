@@ -0,0 +1,90 @@
+#ifndef CC_MODEL_CPPCALLEDGE_H
+#define CC_MODEL_CPPCALLEDGE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <odb/core.hxx>
+#include <odb/lazy-ptr.hxx>
+
+#include "cppastnode.h"
+
+namespace cc
+{
+namespace model
+{
+
+/**
+ * An edge of the call graph: a function call in the body of a function
+ * definition. The edges are collected during parsing so that the callers and
+ * the callees of a function can be looked up by index instead of searching
+ * the call AST nodes by their position.
+ */
+#pragma db object
+struct CppCallEdge
+{
+  #pragma db id auto
+  int id;
+
+  /**
+   * Entity hash of the function in which definition the call occurs.
+   */
+  #pragma db index
+  std::uint64_t caller;
+
+  /**
+   * Entity hash of the called function.
+   */
+  #pragma db index
+  std::uint64_t callee;
+
+  /**
+   * The AST node of the call expression.
+   */
+  #pragma db not_null
+  #pragma db on_delete(cascade)
+  odb::lazy_shared_ptr<CppAstNode> callSite;
+
+  /**
+   * True if the call is a virtual call, i.e. the called function can be an
+   * override of the callee.
+   */
+  bool virtualCall;
+
+  std::string toString() const
+  {
+    return std::string("CppCallEdge")
+      .append("\nid = ").append(std::to_string(id))
+      .append("\ncaller = ").append(std::to_string(caller))
+      .append("\ncallee = ").append(std::to_string(callee))
+      .append("\nvirtualCall = ").append(virtualCall ? "true" : "false");
+  }
+};
+
+typedef std::shared_ptr<CppCallEdge> CppCallEdgePtr;
+
+#pragma db view object(CppCallEdge)
+struct CppCallEdgeCount
+{
+  #pragma db column("count(" + CppCallEdge::id + ")")
+  std::size_t count;
+};
+
+/**
+ * This native view returns the edges of the call graph reachable from a
+ * function. The complete SQL statement (a recursive common table expression)
+ * is given at query time, see CppServiceHandler::queryCallGraph().
+ */
+#pragma db view query()
+struct CppCallGraphEdge
+{
+  std::uint64_t caller;
+  std::uint64_t callee;
+  std::size_t depth;
+};
+
+} // model
+} // cc
+
+#endif // CC_MODEL_CPPCALLEDGE_H
@@ -123,6 +123,58 @@ inline std::uint64_t createIdentifier(const CppEdgeAttribute& attr_)
     std::to_string(attr_.edge->id) + attr_.key + attr_.value);
 }
 
+/**
+ * This view aggregates the edges between files to the directories of the
+ * files. Each row tells how many edges lead from the files of a directory to
+ * the files of another one.
+ */
+#pragma db view \
+  object(CppEdge) \
+  object(File = FromFile : CppEdge::from) \
+  object(File = ToFile : CppEdge::to) \
+  query((?) + "GROUP BY" + FromFile::parent + "," + ToFile::parent)
+struct CppDirectoryEdge
+{
+  #pragma db column(FromFile::parent)
+  FileId from;
+
+  #pragma db column(ToFile::parent)
+  FileId to;
+
+  #pragma db column("count(" + CppEdge::id + ")")
+  std::size_t count;
+};
+
+/**
+ * This view returns the edges between files together with the metadata of the
+ * files at both ends, so the neighbours of several files can be fetched by a
+ * single query when a diagram is expanded.
+ */
+#pragma db view \
+  object(CppEdge) \
+  object(File = FromFile : CppEdge::from) \
+  object(File = ToFile : CppEdge::to)
+struct CppFileEdge
+{
+  #pragma db column(FromFile::id)
+  FileId fromId;
+
+  #pragma db column(FromFile::path)
+  std::string fromPath;
+
+  #pragma db column(FromFile::type)
+  std::string fromType;
+
+  #pragma db column(ToFile::id)
+  FileId toId;
+
+  #pragma db column(ToFile::path)
+  std::string toPath;
+
+  #pragma db column(ToFile::type)
+  std::string toType;
+};
+
 } // model
 } // cc
 
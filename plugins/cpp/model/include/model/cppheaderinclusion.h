@@ -42,6 +42,35 @@ struct CppHeaderInclusion
 
 typedef std::shared_ptr<CppHeaderInclusion> CppHeaderInclusionPtr;
 
+/**
+ * This view returns the header inclusions together with the metadata of the
+ * includer and the included files.
+ */
+#pragma db view \
+  object(CppHeaderInclusion) \
+  object(File = Includer : CppHeaderInclusion::includer) \
+  object(File = Included : CppHeaderInclusion::included)
+struct CppHeaderInclusionFiles
+{
+  #pragma db column(Includer::id)
+  FileId fromId;
+
+  #pragma db column(Includer::path)
+  std::string fromPath;
+
+  #pragma db column(Includer::type)
+  std::string fromType;
+
+  #pragma db column(Included::id)
+  FileId toId;
+
+  #pragma db column(Included::path)
+  std::string toPath;
+
+  #pragma db column(Included::type)
+  std::string toType;
+};
+
 } // model
 } // cc
 
@@ -16,6 +16,8 @@
 
 #include <model/cppastnode.h>
 #include <model/cppastnode-odb.hxx>
+#include <model/cppcalledge.h>
+#include <model/cppcalledge-odb.hxx>
 #include <model/cppenum.h>
 #include <model/cppenum-odb.hxx>
 #include <model/cppfriendship.h>
@@ -129,6 +131,7 @@ public:
       util::persistAll(_friends, _ctx.db);
       util::persistAll(_functions, _ctx.db);
       util::persistAll(_relations, _ctx.db);
+      util::persistAll(_callEdges, _ctx.db);
     });
   }
 
@@ -1301,7 +1304,10 @@ public:
     astNode->id = model::createIdentifier(*astNode);
 
     if (insertToCache(ce_, astNode))
+    {
       _astNodes.push_back(astNode);
+      addCallEdge(astNode);
+    }
 
     return true;
   }
@@ -1328,7 +1334,10 @@ public:
     astNode->id = model::createIdentifier(*astNode);
 
     if (insertToCache(ne_, astNode))
+    {
       _astNodes.push_back(astNode);
+      addCallEdge(astNode);
+    }
 
     _locToAstValue[ne_->getAllocatedTypeSourceInfo()->
       getTypeLoc().getBeginLoc().getRawEncoding()] = getSourceText(
@@ -1361,7 +1370,10 @@ public:
     astNode->id = model::createIdentifier(*astNode);
 
     if (insertToCache(de_, astNode))
+    {
       _astNodes.push_back(astNode);
+      addCallEdge(astNode);
+    }
 
     addDestructorUsage(de_->getDestroyedType(), astNode->location, de_);
 
@@ -1403,8 +1415,13 @@ public:
     astNode->id = model::createIdentifier(*astNode);
 
     if (insertToCache(ce_, astNode))
+    {
       _astNodes.push_back(astNode);
 
+      if (funcCallee)
+        addCallEdge(astNode);
+    }
+
     return true;
   }
 
@@ -1548,11 +1565,36 @@ private:
         astNode->id = model::createIdentifier(*astNode);
 
         if (insertToCache(clangPtr_, astNode))
+        {
           _astNodes.push_back(astNode);
+          addCallEdge(astNode);
+        }
       }
     }
   }
 
+  /**
+   * This function records a call graph edge from the function definition
+   * being visited to the function called by the given AST node. Calls outside
+   * of function bodies (e.g. in the initializer of a global variable) have no
+   * caller, so no edge is recorded for them.
+   */
+  void addCallEdge(const model::CppAstNodePtr& callSite_)
+  {
+    if (_functionStack.empty() || !_functionStack.top()->astNodeId)
+      return;
+
+    model::CppCallEdgePtr edge = std::make_shared<model::CppCallEdge>();
+
+    edge->caller = _functionStack.top()->entityHash;
+    edge->callee = callSite_->entityHash;
+    edge->callSite = callSite_;
+    edge->virtualCall
+      = callSite_->astType == model::CppAstNode::AstType::VirtualCall;
+
+    _callEdges.push_back(edge);
+  }
+
   /**
    * This function inserts a model::CppAstNodeId to a cache in a thread-safe
    * way. The cache is static so the parsers in each thread can use the same.
@@ -1823,6 +1865,7 @@ private:
   std::vector<model::CppInheritancePtr>    _inheritances;
   std::vector<model::CppFriendshipPtr>     _friends;
   std::vector<model::CppRelationPtr>       _relations;
+  std::vector<model::CppCallEdgePtr>       _callEdges;
 
   // TODO: Maybe we don't even need a stack, if functions can't be nested.
   // Check lambda.
@@ -4,6 +4,7 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <set>
 #include <unordered_set>
 #include <string>
 
@@ -15,10 +16,13 @@
 
 #include <model/cppastnode.h>
 #include <model/cppastnode-odb.hxx>
+#include <model/cppcalledge.h>
+#include <model/cppcalledge-odb.hxx>
 #include <model/cpprelation.h>
 #include <model/cpprelation-odb.hxx>
 
 #include <util/odbtransaction.h>
+#include <util/diagramcache.h>
 #include <util/graph.h>
 #include <webserver/servercontext.h>
 
@@ -29,6 +33,8 @@ namespace service
 namespace language
 {
 
+class ResultCache;
+
 class CppServiceHandler : virtual public LanguageServiceIf
 {
   friend class Diagram;
@@ -39,6 +45,8 @@ public:
     std::shared_ptr<std::string> datadir_,
     const cc::webserver::ServerContext& context_);
 
+  ~CppServiceHandler();
+
   void getFileTypes(std::vector<std::string>& return_) override;
 
   void getAstNodeInfo(
@@ -70,6 +78,11 @@ public:
     const core::AstNodeId& astNodeId_,
     const std::int32_t diagramId_) override;
 
+  void getDiagramGraph(
+    std::string& return_,
+    const core::AstNodeId& astNodeId_,
+    const std::int32_t diagramId_) override;
+
   util::Graph returnDiagram(
     const core::AstNodeId& astNodeId_,
     const std::int32_t diagramId_);
@@ -87,6 +100,11 @@ public:
     const core::FileId& fileId_,
     const int32_t diagramId_) override;
 
+  void getFileDiagramGraph(
+    std::string& return_,
+    const core::FileId& fileId_,
+    const int32_t diagramId_) override;
+
   util::Graph returnFileDiagram(
     const core::FileId& fileId_,
     const int32_t diagramId_);
@@ -109,6 +127,11 @@ public:
     const core::AstNodeId& astNodeId_,
     const std::int32_t referenceId_) override;
 
+  void getReferenceCountBatch(
+    std::map<core::AstNodeId, std::map<std::int32_t, std::int32_t>>& return_,
+    const std::vector<core::AstNodeId>& astNodeIds_,
+    const std::vector<std::int32_t>& referenceIds_) override;
+
   void getReferencesInFile(
     std::vector<AstNodeInfo>& return_,
     const core::AstNodeId& astNodeId_,
@@ -140,6 +163,28 @@ public:
     std::vector<SyntaxHighlight>& return_,
     const core::FileRange& range_) override;
 
+  /**
+   * This function returns the edges of the call graph which are reachable
+   * from the given function in at most depth_ steps. The whole graph is
+   * fetched by a single recursive query.
+   * @param entityHash_ Entity hash of the function.
+   * @param reverse_ If true then the graph of the callers is returned instead
+   * of the callees. Like the callers in getReferences(), it doesn't contain
+   * the virtual calls.
+   * @return The edges with the minimal distance at which they were reached.
+   */
+  std::vector<model::CppCallGraphEdge> queryCallGraph(
+    std::uint64_t entityHash_,
+    std::size_t depth_,
+    bool reverse_ = false);
+
+  /**
+   * This function returns the definitions of the given functions.
+   */
+  void getFunctionDefinitions(
+    std::vector<AstNodeInfo>& return_,
+    const std::set<std::uint64_t>& entityHashes_);
+
   enum ReferenceType
   {
     DEFINITION, /*!< By this option the definition(s) of the AST node can be
@@ -267,6 +312,26 @@ public:
   };
 
 private:
+  /**
+   * These functions compute the results of the corresponding public methods
+   * without consulting the result cache.
+   */
+  void computeDocumentation(
+    std::string& return_,
+    const core::AstNodeId& astNodeId_);
+
+  void computeProperties(
+    std::map<std::string, std::string>& return_,
+    const core::AstNodeId& astNodeId_);
+
+  void computeReferenceTypes(
+    std::map<std::string, std::int32_t>& return_,
+    const core::AstNodeId& astNodeId_);
+
+  std::int32_t computeReferenceCount(
+    const core::AstNodeId& astNodeId_,
+    const std::int32_t referenceId_);
+
   static bool compareByPosition(
     const model::CppAstNode& lhs,
     const model::CppAstNode& rhs);
@@ -284,6 +349,16 @@ private:
    */
   model::CppAstNode queryCppAstNode(const core::AstNodeId& astNodeId_);
 
+  /**
+   * This function returns the model::CppAstNode objects which belong to the
+   * given AST node IDs in the order of the IDs. The nodes are fetched by a few
+   * set-based queries.
+   * @exception core::InvalidId Exception is thrown if no AST node belongs to
+   * any of the given IDs.
+   */
+  std::vector<model::CppAstNode> queryCppAstNodeBatch(
+    const std::vector<core::AstNodeId>& astNodeIds_);
+
   /**
    * This function returns the model::CppAstNode objects which meet the
    * requirements of the given query and have the same entity hash as the given
@@ -323,18 +398,36 @@ private:
     const core::AstNodeId& astNodeId_);
 
   /**
-   * This function returns an AST query to get the function calls in the given
-   * function.
+   * This function returns the model::CppAstNode objects which have the same
+   * entity hash as the given AST node and have the given AST type. This query
+   * is prepared only once per database connection.
    */
-  odb::query<model::CppAstNode> astCallsQuery(
-    const model::CppAstNode& astNode_);
+  std::vector<model::CppAstNode> queryCppAstNodesByType(
+    const core::AstNodeId& astNodeId_,
+    model::CppAstNode::AstType astType_);
 
   /**
-   * This function returns the function calls in a given function.
+   * This function returns the function calls in a given function. The calls
+   * are looked up in the call graph edges collected by the parser.
    * @param astNodeId_ An AST node ID which belongs to a function.
    */
   std::vector<model::CppAstNode> queryCalls(const core::AstNodeId& astNodeId_);
 
+  /**
+   * This function returns the call graph edges of a function.
+   * @param reverse_ If false then the calls in the body of the function are
+   * returned, otherwise its non-virtual calls in other functions.
+   */
+  std::vector<model::CppCallEdge> queryCallEdges(
+    std::uint64_t entityHash_,
+    bool reverse_ = false);
+
+  /**
+   * This function returns the function definitions of the given entities.
+   */
+  std::vector<model::CppAstNode> queryFunctionDefinitions(
+    const std::set<std::uint64_t>& entityHashes_);
+
   /**
    * This function returns the functions which override the given one.
    * @param reverse_ If this parameter is true then the function returns the
@@ -393,6 +486,25 @@ private:
   std::shared_ptr<std::string> _datadir;
   const cc::webserver::ServerContext& _context;
 
+  /**
+   * Cache of the hot read-only queries which is shared by the handlers of the
+   * same project. It is null if caching is disabled.
+   */
+  std::shared_ptr<ResultCache> _resultCache;
+
+  /**
+   * Cache of the built and rendered diagrams which is shared by the handlers
+   * of the same project. The diagrams are rendered through it even if its
+   * size is zero, i.e. diagram caching is disabled.
+   */
+  std::shared_ptr<util::DiagramCache> _diagramCache;
+
+  /**
+   * If true, the hot query helpers use ODB prepared queries cached on the
+   * database connections instead of building dynamic queries on every call.
+   */
+  bool _usePreparedQueries;
+
   std::string toShortDiagnosticString(const model::CppAstNode& node) const;
 };
 
@@ -2,6 +2,10 @@
 #include <queue>
 #include <regex>
 
+#include <odb/connection.hxx>
+#include <odb/prepared-query.hxx>
+
+#include <util/dbutil.h>
 #include <util/util.h>
 #include <util/logutil.h>
 
@@ -23,11 +27,14 @@
 #include <model/cppmacroexpansion-odb.hxx>
 #include <model/cppdoccomment.h>
 #include <model/cppdoccomment-odb.hxx>
+#include <model/cppcalledge.h>
+#include <model/cppcalledge-odb.hxx>
 
 #include <service/cppservice.h>
 
 #include "diagram.h"
 #include "filediagram.h"
+#include "resultcache.h"
 
 namespace
 {
@@ -59,6 +66,10 @@ namespace
   typedef odb::result<cc::model::File> FileResult;
   typedef odb::query<cc::model::CppDocComment> DocCommentQuery;
   typedef odb::result<cc::model::CppDocComment> DocCommentResult;
+  typedef odb::query<cc::model::CppCallEdge> CallEdgeQuery;
+  typedef odb::result<cc::model::CppCallEdge> CallEdgeResult;
+  typedef odb::query<cc::model::CppCallGraphEdge> CallGraphQuery;
+  typedef odb::result<cc::model::CppCallGraphEdge> CallGraphResult;
 
   /**
    * This struct transforms a model::CppAstNode to an AstNodeInfo Thrift
@@ -104,6 +115,106 @@ namespace
     const std::map<cc::model::CppAstNodeId, std::vector<std::string>>& _tags;
     std::shared_ptr<odb::database> _db;
   };
+
+  //--- Prepared queries ---//
+
+  /**
+   * Parameters of the query which returns the AST nodes of an entity having
+   * the given AST type.
+   */
+  struct EntityTypeParams
+  {
+    std::uint64_t entityHash;
+    cc::model::CppAstNode::AstType astType;
+  };
+
+  /**
+   * Parameters of the queries which search AST nodes around a position.
+   */
+  struct PositionParams
+  {
+    std::uint64_t file;
+    cc::model::Position::PosType line;
+    cc::model::Position::PosType column;
+  };
+
+  /**
+   * Parameters of the queries which search the call graph edges of a function.
+   */
+  struct CallEdgeParams
+  {
+    std::uint64_t entityHash;
+  };
+
+  AstQuery entityTypeQuery(const EntityTypeParams& params_)
+  {
+    return AstQuery::entityHash == AstQuery::_ref(params_.entityHash) &&
+      AstQuery::location.range.end.line != cc::model::Position::npos &&
+      AstQuery::astType == AstQuery::_ref(params_.astType);
+  }
+
+  AstQuery nodesAtPositionQuery(const PositionParams& params_)
+  {
+    return AstQuery::location.file == AstQuery::_ref(params_.file) &&
+      // StartPos <= Pos
+      ((AstQuery::location.range.start.line == AstQuery::_ref(params_.line) &&
+        AstQuery::location.range.start.column
+          <= AstQuery::_ref(params_.column)) ||
+       AstQuery::location.range.start.line < AstQuery::_ref(params_.line)) &&
+      // Pos < EndPos
+      ((AstQuery::location.range.end.line == AstQuery::_ref(params_.line) &&
+        AstQuery::location.range.end.column
+          > AstQuery::_ref(params_.column)) ||
+       AstQuery::location.range.end.line > AstQuery::_ref(params_.line));
+  }
+
+  CallEdgeQuery callsFromQuery(const CallEdgeParams& params_)
+  {
+    return CallEdgeQuery::caller == CallEdgeQuery::_ref(params_.entityHash);
+  }
+
+  CallEdgeQuery callsToQuery(const CallEdgeParams& params_)
+  {
+    return CallEdgeQuery::callee == CallEdgeQuery::_ref(params_.entityHash) &&
+      CallEdgeQuery::virtualCall == false;
+  }
+
+  /**
+   * This function runs a query of which parameters are bound by reference to
+   * a Params object. If usePrepared_ is true then the query is prepared only
+   * once per database connection under the given name, so the database
+   * doesn't have to parse and plan the same statement on every call. Otherwise
+   * a new dynamic query is built.
+   * @param build_ A function which builds the query from the parameter object.
+   * The members of the object have to be bound with _ref().
+   */
+  template <typename T, typename Params, typename Build>
+  odb::result<T> executeQuery(
+    odb::database& db_,
+    bool usePrepared_,
+    const char* name_,
+    Build build_,
+    const Params& params_)
+  {
+    if (!usePrepared_)
+      return db_.query<T>(build_(params_));
+
+    odb::connection& conn = odb::transaction::current().connection();
+
+    Params* cached;
+    odb::prepared_query<T> query = conn.lookup_query<T>(name_, cached);
+
+    if (!query)
+    {
+      std::unique_ptr<Params> params(new Params());
+      cached = params.get();
+      query = conn.prepare_query<T>(name_, build_(*cached));
+      conn.cache_query(query, std::move(params));
+    }
+
+    *cached = params_;
+    return query.execute();
+  }
 }
 
 namespace cc
@@ -120,10 +231,32 @@ CppServiceHandler::CppServiceHandler(
     : _db(db_),
       _transaction(db_),
       _datadir(datadir_),
-      _context(context_)
+      _context(context_),
+      _usePreparedQueries(
+        !_context.options.count("cpp-prepared-queries") ||
+        _context.options["cpp-prepared-queries"].as<bool>())
 {
+  std::size_t cacheSize = _context.options.count("cpp-result-cache-size")
+    ? _context.options["cpp-result-cache-size"].as<std::size_t>()
+    : 64;
+
+  if (cacheSize != 0)
+    _resultCache = ResultCache::forProject(*_datadir, cacheSize << 20);
+
+  std::size_t diagramCacheSize
+    = _context.options.count("cpp-diagram-cache-size")
+    ? _context.options["cpp-diagram-cache-size"].as<std::size_t>()
+    : 128;
+
+  bool diagramDiskCache = _context.options.count("cpp-diagram-disk-cache")
+    && _context.options["cpp-diagram-disk-cache"].as<bool>();
+
+  _diagramCache = util::DiagramCache::forProject(
+    *_datadir, diagramCacheSize << 20, diagramDiskCache);
 }
 
+CppServiceHandler::~CppServiceHandler() = default;
+
 void CppServiceHandler::getFileTypes(std::vector<std::string>& return_)
 {
   return_.push_back("CPP");
@@ -159,6 +292,19 @@ void CppServiceHandler::getSourceText(
 }
 
 void CppServiceHandler::getDocumentation(
+  std::string& return_,
+  const core::AstNodeId& astNodeId_)
+{
+  if (!_resultCache)
+    return computeDocumentation(return_, astNodeId_);
+
+  _resultCache->get(return_, "getDocumentation", astNodeId_,
+    [&, this](std::string& result_){
+      computeDocumentation(result_, astNodeId_);
+    });
+}
+
+void CppServiceHandler::computeDocumentation(
     std::string& return_,
     const core::AstNodeId& astNodeId_)
 {
@@ -176,21 +322,72 @@ void CppServiceHandler::getDocumentation(
     {
       case model::CppAstNode::SymbolType::Type:
       {
-        //--- Data members ---//
+        //--- Methods ---//
+
+        // A class may have hundreds of methods, so their AST nodes, function
+        // records and documentation comments are fetched by a few set-based
+        // queries instead of querying them one by one.
+
+        std::map<model::CppAstNodeId, std::string> visibilities;
+
+        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
+          MemTypeQuery::typeHash == node.entityHash &&
+          MemTypeQuery::kind == model::CppMemberType::Kind::Method))
+          visibilities[mem.memberAstNode.object_id()]
+            = model::visibilityToString(mem.visibility);
+
+        std::vector<model::CppAstNode> methods
+          = util::queryInChunks<model::CppAstNode>(*_db, visibilities,
+            [](auto begin_, auto end_){
+              std::vector<model::CppAstNodeId> ids;
+              for (auto it = begin_; it != end_; ++it)
+                ids.push_back(it->first);
+              return AstQuery::id.in_range(ids.begin(), ids.end());
+            });
+
+        std::sort(methods.begin(), methods.end(), compareByValue);
+
+        std::set<std::uint64_t> hashes;
+        for (const model::CppAstNode& method : methods)
+          hashes.insert(method.entityHash);
+
+        std::map<std::uint64_t, model::CppFunction> functions;
+        for (model::CppFunction& function
+          : util::queryInChunks<model::CppFunction>(*_db, hashes,
+            [](auto begin_, auto end_){
+              return FuncQuery::entityHash.in_range(begin_, end_);
+            }))
+          functions.emplace(function.entityHash, std::move(function));
+
+        std::map<std::uint64_t, std::string> docs;
+        for (model::CppDocComment& doc
+          : util::queryInChunks<model::CppDocComment>(*_db, hashes,
+            [](auto begin_, auto end_){
+              return DocCommentQuery::entityHash.in_range(begin_, end_);
+            }))
+          docs.emplace(doc.entityHash, std::move(doc.content));
 
-        std::vector<AstNodeInfo> methods;
-        getReferences(methods, astNodeId_, METHOD, {});
+        //--- Assemble the HTML ---//
 
-        for (const AstNodeInfo& method : methods)
+        for (const model::CppAstNode& method : methods)
         {
-          std::map<std::string, std::string> properties;
-          getProperties(properties, method.id);
+          auto function = functions.find(method.entityHash);
 
           return_ += "<div class=\"group\"><div class=\"signature\">";
 
           //--- Add tags ---/
 
-          for (const std::string& tag : method.tags)
+          std::vector<std::string> tags;
+
+          const std::string& visibility = visibilities[method.id];
+          if (!visibility.empty())
+            tags.push_back(visibility);
+
+          if (function != functions.end())
+            for (const model::Tag& tag : function->second.tags)
+              tags.push_back(model::tagToString(tag));
+
+          for (const std::string& tag : tags)
             if (tag == "public" || tag == "private" || tag == "protected")
               return_ += "<span class=\"icon-visibility icon-" + tag
                       +  "\"></span>";
@@ -198,21 +395,18 @@ void CppServiceHandler::getDocumentation(
               return_ += "<span class=\"tag tag-" + tag +"\" title=\""
                       +  tag + "\">" + (char)std::toupper(tag[0]) + "</span>";
 
-          auto signature = properties.find("Signature");
           return_
-            += signature == properties.end()
-            ?  method.astNodeValue
-            :  signature->second;
+            += function == functions.end()
+            ?  method.astValue
+            :  function->second.name;
 
           return_ += "</div>";
 
-          //--- Query documentation of members ---//
+          //--- Documentation of members ---//
 
-          DocCommentResult doc = _db->query<model::CppDocComment>(
-            DocCommentQuery::entityHash == method.entityHash);
-
-          if (!doc.empty())
-            return_ += doc.begin()->content;
+          auto doc = docs.find(method.entityHash);
+          if (doc != docs.end())
+            return_ += doc->second;
 
           return_ += "</div>";
         }
@@ -228,16 +422,14 @@ void CppServiceHandler::getAstNodeInfoByPosition(
   _transaction([&, this](){
     //--- Query nodes at the given position ---//
 
-    AstResult nodes = _db->query<model::CppAstNode>(
-      AstQuery::location.file == std::stoull(fpos_.file) &&
-      // StartPos <= Pos
-      ((AstQuery::location.range.start.line == fpos_.pos.line &&
-        AstQuery::location.range.start.column <= fpos_.pos.column) ||
-       AstQuery::location.range.start.line < fpos_.pos.line) &&
-      // Pos < EndPos
-      ((AstQuery::location.range.end.line == fpos_.pos.line &&
-        AstQuery::location.range.end.column > fpos_.pos.column) ||
-       AstQuery::location.range.end.line > fpos_.pos.line));
+    PositionParams params;
+    params.file = std::stoull(fpos_.file);
+    params.line = fpos_.pos.line;
+    params.column = fpos_.pos.column;
+
+    AstResult nodes = executeQuery<model::CppAstNode>(*_db,
+      _usePreparedQueries, "cpp-nodes-at-position", nodesAtPositionQuery,
+      params);
 
     //--- Select innermost clickable node ---//
 
@@ -270,6 +462,19 @@ void CppServiceHandler::getAstNodeInfoByPosition(
 void CppServiceHandler::getProperties(
   std::map<std::string, std::string>& return_,
   const core::AstNodeId& astNodeId_)
+{
+  if (!_resultCache)
+    return computeProperties(return_, astNodeId_);
+
+  _resultCache->get(return_, "getProperties", astNodeId_,
+    [&, this](std::map<std::string, std::string>& result_){
+      computeProperties(result_, astNodeId_);
+    });
+}
+
+void CppServiceHandler::computeProperties(
+  std::map<std::string, std::string>& return_,
+  const core::AstNodeId& astNodeId_)
 {
   _transaction([&, this](){
     model::CppAstNode node = queryCppAstNode(astNodeId_);
@@ -393,6 +598,91 @@ void CppServiceHandler::getProperties(
 std::int32_t CppServiceHandler::getReferenceCount(
   const core::AstNodeId& astNodeId_,
   const std::int32_t referenceId_)
+{
+  if (!_resultCache)
+    return computeReferenceCount(astNodeId_, referenceId_);
+
+  std::int32_t count;
+  _resultCache->get(count, "getReferenceCount",
+    astNodeId_ + ':' + std::to_string(referenceId_),
+    [&, this](std::int32_t& result_){
+      result_ = computeReferenceCount(astNodeId_, referenceId_);
+    });
+
+  return count;
+}
+
+void CppServiceHandler::getReferenceCountBatch(
+  std::map<core::AstNodeId, std::map<std::int32_t, std::int32_t>>& return_,
+  const std::vector<core::AstNodeId>& astNodeIds_,
+  const std::vector<std::int32_t>& referenceIds_)
+{
+  _transaction([&, this](){
+    std::vector<model::CppAstNode> nodes = queryCppAstNodeBatch(astNodeIds_);
+
+    std::set<std::uint64_t> hashes;
+    for (const model::CppAstNode& node : nodes)
+      hashes.insert(node.entityHash);
+
+    for (std::int32_t referenceId : referenceIds_)
+    {
+      // These reference types count the AST nodes of the entity having a
+      // given AST type, so they can be answered for every node by one grouped
+      // query. See computeReferenceCount() for the same conditions.
+      AstQuery query(true);
+
+      switch (referenceId)
+      {
+        case DEFINITION:
+          query = AstQuery::astType == model::CppAstNode::AstType::Definition;
+          break;
+
+        case DECLARATION:
+          query =
+            AstQuery::astType == model::CppAstNode::AstType::Declaration &&
+            AstQuery::visibleInSourceCode == true;
+          break;
+
+        case USAGE:
+          break;
+
+        case CALLS_OF_THIS:
+          query = AstQuery::astType == model::CppAstNode::AstType::Usage;
+          break;
+
+        case UNDEFINITION:
+          query = AstQuery::astType == model::CppAstNode::AstType::UnDefinition;
+          break;
+
+        default:
+          // The other reference types need more complex queries.
+          for (const core::AstNodeId& astNodeId : astNodeIds_)
+            return_[astNodeId][referenceId]
+              = getReferenceCount(astNodeId, referenceId);
+
+          continue;
+      }
+
+      std::map<std::uint64_t, std::int32_t> counts;
+
+      for (const model::CppAstCountGroupByEntity& count
+        : util::queryInChunks<model::CppAstCountGroupByEntity>(*_db, hashes,
+          [&query](auto begin_, auto end_){
+            return AstQuery::entityHash.in_range(begin_, end_) &&
+              AstQuery::location.range.end.line != model::Position::npos &&
+              query;
+          }))
+        counts[count.entityHash] = count.count;
+
+      for (std::size_t i = 0; i < nodes.size(); ++i)
+        return_[astNodeIds_[i]][referenceId] = counts[nodes[i].entityHash];
+    }
+  });
+}
+
+std::int32_t CppServiceHandler::computeReferenceCount(
+  const core::AstNodeId& astNodeId_,
+  const std::int32_t referenceId_)
 {
   model::CppAstNode node = queryCppAstNode(astNodeId_);
 
@@ -420,23 +710,11 @@ std::int32_t CppServiceHandler::getReferenceCount(
 
       case CALLEE:
       {
-        std::int32_t count = 0;
+        std::set<std::uint64_t> callees;
+        for (const model::CppCallEdge& edge : queryCallEdges(node.entityHash))
+          callees.insert(edge.callee);
 
-        std::set<std::uint64_t> defHashes;
-        for (const model::CppAstNode& call : queryCalls(astNodeId_))
-        {
-          model::CppAstNode node = queryCppAstNode(std::to_string(call.id));
-          defHashes.insert(node.entityHash);
-        }
-
-        if (!defHashes.empty())
-          count += _db->query_value<model::CppAstCount>(
-            AstQuery::entityHash.in_range(
-              defHashes.begin(), defHashes.end()) &&
-            AstQuery::astType == model::CppAstNode::AstType::Definition &&
-            AstQuery::location.range.end.line != model::Position::npos).count;
-
-        return count;
+        return queryFunctionDefinitions(callees).size();
       }
 
       case CALLER:
@@ -597,6 +875,19 @@ std::int32_t CppServiceHandler::getReferenceCount(
 void CppServiceHandler::getReferenceTypes(
   std::map<std::string, std::int32_t>& return_,
   const core::AstNodeId& astNodeId_)
+{
+  if (!_resultCache)
+    return computeReferenceTypes(return_, astNodeId_);
+
+  _resultCache->get(return_, "getReferenceTypes", astNodeId_,
+    [&, this](std::map<std::string, std::int32_t>& result_){
+      computeReferenceTypes(result_, astNodeId_);
+    });
+}
+
+void CppServiceHandler::computeReferenceTypes(
+  std::map<std::string, std::int32_t>& return_,
+  const core::AstNodeId& astNodeId_)
 {
   model::CppAstNode node = queryCppAstNode(astNodeId_);
 
@@ -683,53 +974,35 @@ void CppServiceHandler::getReferences(
         break;
 
       case CALLS_OF_THIS:
-        nodes = queryCppAstNodes(
+        nodes = queryCppAstNodesByType(
           astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::Usage);
+          model::CppAstNode::AstType::Usage);
         break;
 
       case CALLEE:
-        for (const model::CppAstNode& call : queryCalls(astNodeId_))
-        {
-          core::AstNodeId astNodeId = std::to_string(call.id);
-          std::vector<model::CppAstNode> defs = queryDefinitions(astNodeId);
-          nodes.insert(nodes.end(), defs.begin(), defs.end());
-        }
+      {
+        node = queryCppAstNode(astNodeId_);
 
-        std::sort(nodes.begin(), nodes.end());
-        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        std::set<std::uint64_t> callees;
+        for (const model::CppCallEdge& edge : queryCallEdges(node.entityHash))
+          callees.insert(edge.callee);
 
+        nodes = queryFunctionDefinitions(callees);
         break;
+      }
 
       case CALLER:
-        for (const model::CppAstNode& astNode : queryCppAstNodes(
-          astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::Usage))
-        {
-          const model::Position& start = astNode.location.range.start;
-          const model::Position& end   = astNode.location.range.end;
-
-          AstResult result = _db->query<model::CppAstNode>(
-            AstQuery::astType    == model::CppAstNode::AstType::Definition &&
-            AstQuery::symbolType == model::CppAstNode::SymbolType::Function &&
-            // Same file
-            AstQuery::location.file == astNode.location.file.object_id() &&
-            // StartPos >= Pos
-            ((AstQuery::location.range.start.line == start.line &&
-              AstQuery::location.range.start.column <= start.column) ||
-             AstQuery::location.range.start.line < start.line) &&
-            // Pos > EndPos
-            ((AstQuery::location.range.end.line == end.line &&
-              AstQuery::location.range.end.column > end.column) ||
-             AstQuery::location.range.end.line > end.line));
-
-          nodes.insert(nodes.end(), result.begin(), result.end());
-        }
+      {
+        node = queryCppAstNode(astNodeId_);
 
-        std::sort(nodes.begin(), nodes.end());
-        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        std::set<std::uint64_t> callers;
+        for (const model::CppCallEdge& edge
+          : queryCallEdges(node.entityHash, true))
+          callers.insert(edge.caller);
 
+        nodes = queryFunctionDefinitions(callers);
         break;
+      }
 
       case VIRTUAL_CALL:
       {
@@ -1294,10 +1567,19 @@ void CppServiceHandler::getDiagram(
   const core::AstNodeId& astNodeId_,
   const std::int32_t diagramId_)
 {
-  util::Graph graph = returnDiagram(astNodeId_, diagramId_);
+  return_ = _diagramCache->getSvg(
+    "cpp-diagram-" + std::to_string(diagramId_), astNodeId_,
+    [&, this](){ return returnDiagram(astNodeId_, diagramId_); });
+}
 
-  if (graph.nodeCount() != 0)
-    return_ = graph.output(util::Graph::SVG);
+void CppServiceHandler::getDiagramGraph(
+  std::string& return_,
+  const core::AstNodeId& astNodeId_,
+  const std::int32_t diagramId_)
+{
+  return_ = _diagramCache->getJson(
+    "cpp-diagram-" + std::to_string(diagramId_), astNodeId_,
+    [&, this](){ return returnDiagram(astNodeId_, diagramId_); });
 }
 
 util::Graph CppServiceHandler::returnDiagram(
@@ -1378,10 +1660,23 @@ void CppServiceHandler::getFileDiagram(
   const core::FileId& fileId_,
   const int32_t diagramId_)
 {
-  util::Graph graph = returnFileDiagram(fileId_, diagramId_);
+  const core::FileId fileId = FileDiagram::nodeFileId(fileId_);
+
+  return_ = _diagramCache->getSvg(
+    "cpp-file-diagram-" + std::to_string(diagramId_), fileId,
+    [&, this](){ return returnFileDiagram(fileId, diagramId_); });
+}
+
+void CppServiceHandler::getFileDiagramGraph(
+  std::string& return_,
+  const core::FileId& fileId_,
+  const int32_t diagramId_)
+{
+  const core::FileId fileId = FileDiagram::nodeFileId(fileId_);
 
-  if (graph.nodeCount() != 0)
-    return_ = graph.output(util::Graph::SVG);
+  return_ = _diagramCache->getJson(
+    "cpp-file-diagram-" + std::to_string(diagramId_), fileId,
+    [&, this](){ return returnFileDiagram(fileId, diagramId_); });
 }
 
 util::Graph CppServiceHandler::returnFileDiagram(
@@ -1488,6 +1783,47 @@ model::CppAstNode CppServiceHandler::queryCppAstNode(
   });
 }
 
+std::vector<model::CppAstNode> CppServiceHandler::queryCppAstNodeBatch(
+  const std::vector<core::AstNodeId>& astNodeIds_)
+{
+  std::set<model::CppAstNodeId> ids;
+  for (const core::AstNodeId& astNodeId : astNodeIds_)
+    ids.insert(std::stoull(astNodeId));
+
+  return _transaction([&, this](){
+    std::map<model::CppAstNodeId, model::CppAstNode> found;
+
+    std::vector<model::CppAstNode> result
+      = util::queryInChunks<model::CppAstNode>(*_db, ids,
+        [](auto begin_, auto end_){
+          return AstQuery::id.in_range(begin_, end_);
+        });
+
+    for (model::CppAstNode& node : result)
+      found.emplace(node.id, std::move(node));
+
+    std::vector<model::CppAstNode> nodes;
+    nodes.reserve(astNodeIds_.size());
+
+    for (const core::AstNodeId& astNodeId : astNodeIds_)
+    {
+      auto it = found.find(std::stoull(astNodeId));
+
+      if (it == found.end())
+      {
+        core::InvalidId ex;
+        ex.__set_msg("Invalid CppAstNode ID");
+        ex.__set_nodeid(astNodeId);
+        throw ex;
+      }
+
+      nodes.push_back(it->second);
+    }
+
+    return nodes;
+  });
+}
+
 std::vector<model::CppAstNode> CppServiceHandler::queryCppAstNodes(
   const core::AstNodeId& astNodeId_,
   const AstQuery& query_)
@@ -1520,50 +1856,133 @@ std::uint32_t CppServiceHandler::queryCppAstNodeCountInFile(
     AstQuery::location.file == std::stoull(fileId_) && query_).count;
 }
 
+std::vector<model::CppAstNode> CppServiceHandler::queryCppAstNodesByType(
+  const core::AstNodeId& astNodeId_,
+  model::CppAstNode::AstType astType_)
+{
+  return _transaction([&, this](){
+    model::CppAstNode node = queryCppAstNode(astNodeId_);
+
+    EntityTypeParams params;
+    params.entityHash = node.entityHash;
+    params.astType = astType_;
+
+    AstResult result = executeQuery<model::CppAstNode>(*_db,
+      _usePreparedQueries, "cpp-nodes-by-entity-type", entityTypeQuery,
+      params);
+
+    return std::vector<model::CppAstNode>(result.begin(), result.end());
+  });
+}
+
 std::vector<model::CppAstNode> CppServiceHandler::queryDefinitions(
   const core::AstNodeId& astNodeId_)
 {
-  return queryCppAstNodes(
+  return queryCppAstNodesByType(
     astNodeId_,
-    AstQuery::astType == model::CppAstNode::AstType::Definition);
+    model::CppAstNode::AstType::Definition);
 }
 
-odb::query<model::CppAstNode> CppServiceHandler::astCallsQuery(
-  const model::CppAstNode& astNode_)
+std::vector<model::CppAstNode> CppServiceHandler::queryCalls(
+  const core::AstNodeId& astNodeId_)
 {
-  const model::Position& start = astNode_.location.range.start;
-  const model::Position& end = astNode_.location.range.end;
-
-  return (AstQuery::location.file == astNode_.location.file.object_id() &&
-    (AstQuery::astType == model::CppAstNode::AstType::Usage ||
-     AstQuery::astType == model::CppAstNode::AstType::VirtualCall) &&
-    AstQuery::symbolType == model::CppAstNode::SymbolType::Function &&
-    // StartPos >= Pos
-    ((AstQuery::location.range.start.line == start.line &&
-      AstQuery::location.range.start.column >= start.column) ||
-     AstQuery::location.range.start.line > start.line) &&
-    // Pos > EndPos
-    ((AstQuery::location.range.end.line == end.line &&
-      AstQuery::location.range.end.column < end.column) ||
-     AstQuery::location.range.end.line < end.line));
+  model::CppAstNode node = queryCppAstNode(astNodeId_);
+
+  std::vector<model::CppAstNodeId> callSites;
+  for (const model::CppCallEdge& edge : queryCallEdges(node.entityHash))
+    callSites.push_back(edge.callSite.object_id());
+
+  return util::queryInChunks<model::CppAstNode>(*_db, callSites,
+    [](auto begin_, auto end_){
+      return AstQuery::id.in_range(begin_, end_);
+    });
 }
 
-std::vector<model::CppAstNode> CppServiceHandler::queryCalls(
-  const core::AstNodeId& astNodeId_)
+std::vector<model::CppCallEdge> CppServiceHandler::queryCallEdges(
+  std::uint64_t entityHash_,
+  bool reverse_)
 {
-  std::vector<model::CppAstNode> nodes = queryDefinitions(astNodeId_);
+  CallEdgeParams params;
+  params.entityHash = entityHash_;
 
-  if (nodes.empty())
-    return nodes;
+  CallEdgeResult result = reverse_
+    ? executeQuery<model::CppCallEdge>(*_db,
+        _usePreparedQueries, "cpp-calls-to", callsToQuery, params)
+    : executeQuery<model::CppCallEdge>(*_db,
+        _usePreparedQueries, "cpp-calls-from", callsFromQuery, params);
 
-  model::CppAstNode node = nodes.front();
-  AstResult result = _db->query<model::CppAstNode>(astCallsQuery(node));
+  return std::vector<model::CppCallEdge>(result.begin(), result.end());
+}
 
-  nodes = std::vector<model::CppAstNode>(result.begin(), result.end());
+std::vector<model::CppAstNode> CppServiceHandler::queryFunctionDefinitions(
+  const std::set<std::uint64_t>& entityHashes_)
+{
+  std::vector<model::CppAstNode> nodes
+    = util::queryInChunks<model::CppAstNode>(*_db, entityHashes_,
+      [](auto begin_, auto end_){
+        return AstQuery::entityHash.in_range(begin_, end_) &&
+          AstQuery::astType == model::CppAstNode::AstType::Definition &&
+          AstQuery::location.range.end.line != model::Position::npos;
+      });
+
+  std::sort(nodes.begin(), nodes.end());
+  nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
 
   return nodes;
 }
 
+std::vector<model::CppCallGraphEdge> CppServiceHandler::queryCallGraph(
+  std::uint64_t entityHash_,
+  std::size_t depth_,
+  bool reverse_)
+{
+  // The edges are walked forward along "caller" -> "callee", or backward if
+  // the callers are requested. UNION (instead of UNION ALL) and the depth
+  // limit make the recursion terminate on recursive functions too.
+  const std::string from = reverse_ ? "\"callee\"" : "\"caller\"";
+  const std::string to = reverse_ ? "\"caller\"" : "\"callee\"";
+
+  CallGraphQuery query(
+    "WITH RECURSIVE \"edge\"(\"caller\", \"callee\") AS ("
+    "SELECT \"caller\", \"callee\" FROM \"CppCallEdge\"");
+
+  if (reverse_)
+    query += " WHERE \"virtualCall\" = " + CallGraphQuery::_val(false);
+
+  query +=
+    "), \"reach\"(\"caller\", \"callee\", \"depth\") AS ("
+    "SELECT \"caller\", \"callee\", 1 FROM \"edge\" WHERE " + from +
+    " = " + CallGraphQuery::_val(entityHash_) +
+    " UNION "
+    "SELECT \"e\".\"caller\", \"e\".\"callee\", \"r\".\"depth\" + 1 "
+    "FROM \"edge\" AS \"e\" JOIN \"reach\" AS \"r\" "
+    "ON \"e\"." + from + " = \"r\"." + to +
+    " WHERE \"r\".\"depth\" < " + CallGraphQuery::_val(depth_) +
+    ") SELECT \"caller\", \"callee\", CAST(MIN(\"depth\") AS BIGINT) "
+    "FROM \"reach\" GROUP BY \"caller\", \"callee\"";
+
+  return _transaction([&, this](){
+    CallGraphResult result = _db->query<model::CppCallGraphEdge>(query);
+    return std::vector<model::CppCallGraphEdge>(result.begin(), result.end());
+  });
+}
+
+void CppServiceHandler::getFunctionDefinitions(
+  std::vector<AstNodeInfo>& return_,
+  const std::set<std::uint64_t>& entityHashes_)
+{
+  _transaction([&, this](){
+    std::vector<model::CppAstNode> nodes
+      = queryFunctionDefinitions(entityHashes_);
+
+    return_.reserve(nodes.size());
+    std::transform(
+      nodes.begin(), nodes.end(),
+      std::back_inserter(return_),
+      CreateAstNodeInfo(getTags(nodes)));
+  });
+}
+
 std::vector<model::CppAstNode> CppServiceHandler::queryOverrides(
   const core::AstNodeId& astNodeId_,
   bool reverse_)
@@ -1744,14 +2163,14 @@ std::size_t CppServiceHandler::queryOverridesCount(
 std::size_t CppServiceHandler::queryCallsCount(
   const core::AstNodeId& astNodeId_)
 {
-  std::vector<model::CppAstNode> nodes = queryDefinitions(astNodeId_);
-
-  if (nodes.empty())
-    return std::size_t(0);
+  model::CppAstNode node = queryCppAstNode(astNodeId_);
 
-  model::CppAstNode node = nodes.front();
+  CallEdgeParams params;
+  params.entityHash = node.entityHash;
 
-  return _db->query_value<model::CppAstCount>(astCallsQuery(node)).count;
+  return executeQuery<model::CppCallEdgeCount>(*_db,
+    _usePreparedQueries, "cpp-calls-from-count", callsFromQuery,
+    params).begin()->count;
 }
 
 inline std::string
@@ -55,7 +55,11 @@ Diagram::Diagram(
   std::shared_ptr<std::string> datadir_,
   const cc::webserver::ServerContext& context_)
     : _cppHandler(db_, datadir_, context_),
-      _projectHandler(db_, datadir_, context_)
+      _projectHandler(db_, datadir_, context_),
+      _callDiagramDepth(
+        context_.options.count("cpp-function-call-diagram-depth")
+        ? context_.options["cpp-function-call-diagram-depth"].as<std::size_t>()
+        : 2)
 {
 }
 
@@ -180,7 +184,6 @@ void Diagram::getFunctionCallDiagram(
   util::Graph& graph_,
   const core::AstNodeId& astNodeId_)
 {
-  std::map<core::AstNodeId, util::Graph::Node> visitedNodes;
   std::vector<AstNodeInfo> nodes;
 
   graph_.setAttribute("rankdir", "LR");
@@ -193,61 +196,62 @@ void Diagram::getFunctionCallDiagram(
   if (nodes.empty())
     return;
 
+  std::uint64_t centerHash = nodes.front().entityHash;
   util::Graph::Node centerNode = addNode(graph_, nodes.front());
   decorateNode(graph_, centerNode, centerNodeDecoration);
-  visitedNodes[astNodeId_] = centerNode;
 
-  //--- Callees ---//
+  //--- Call graph ---//
+
+  // Both directions of the call graph are fetched by one query each, then
+  // the definitions of the reached functions by one more.
+  std::vector<model::CppCallGraphEdge> calleeEdges
+    = _cppHandler.queryCallGraph(centerHash, _callDiagramDepth);
+  std::vector<model::CppCallGraphEdge> callerEdges
+    = _cppHandler.queryCallGraph(centerHash, _callDiagramDepth, true);
+
+  std::set<std::uint64_t> entityHashes;
+  for (const model::CppCallGraphEdge& edge : calleeEdges)
+    entityHashes.insert(edge.callee);
+  for (const model::CppCallGraphEdge& edge : callerEdges)
+    entityHashes.insert(edge.caller);
+  entityHashes.erase(centerHash);
 
   nodes.clear();
-  _cppHandler.getReferences(nodes, astNodeId_, CppServiceHandler::CALLEE, {});
+  _cppHandler.getFunctionDefinitions(nodes, entityHashes);
+
+  std::map<std::uint64_t, std::vector<util::Graph::Node>> graphNodes;
+  graphNodes[centerHash].push_back(centerNode);
 
   for (const AstNodeInfo& node : nodes)
-  {
-    util::Graph::Node calleeNode;
+    graphNodes[node.entityHash].push_back(addNode(graph_, node));
 
-    auto it = visitedNodes.find(node.id);
-    if (it == visitedNodes.end())
-    {
-      calleeNode = addNode(graph_, node);
-      decorateNode(graph_, calleeNode, calleeNodeDecoration);
-      visitedNodes.insert(it, std::make_pair(node.id, calleeNode));
-    }
-    else
-      calleeNode = it->second;
+  //--- Callees ---//
 
-    if (!graph_.hasEdge(centerNode, calleeNode))
+  for (const model::CppCallGraphEdge& edge : calleeEdges)
+    for (const util::Graph::Node& callee : graphNodes[edge.callee])
     {
-      util::Graph::Edge edge = graph_.createEdge(centerNode, calleeNode);
-      decorateEdge(graph_, edge, calleeEdgeDecoration);
+      if (callee != centerNode)
+        decorateNode(graph_, callee, calleeNodeDecoration);
+
+      for (const util::Graph::Node& caller : graphNodes[edge.caller])
+        if (!graph_.hasEdge(caller, callee))
+          decorateEdge(graph_, graph_.createEdge(caller, callee),
+            calleeEdgeDecoration);
     }
-  }
 
   //--- Callers ---//
 
-  nodes.clear();
-  _cppHandler.getReferences(nodes, astNodeId_, CppServiceHandler::CALLER, {});
-
-  for (const AstNodeInfo& node : nodes)
-  {
-    util::Graph::Node callerNode;
-
-    auto it = visitedNodes.find(node.id);
-    if (it == visitedNodes.end())
+  for (const model::CppCallGraphEdge& edge : callerEdges)
+    for (const util::Graph::Node& caller : graphNodes[edge.caller])
     {
-      callerNode = addNode(graph_, node);
-      decorateNode(graph_, callerNode, callerNodeDecoration);
-      visitedNodes.insert(it, std::make_pair(node.id, callerNode));
-    }
-    else
-      callerNode = it->second;
+      if (caller != centerNode)
+        decorateNode(graph_, caller, callerNodeDecoration);
 
-    if (!graph_.hasEdge(callerNode, centerNode))
-    {
-      util::Graph::Edge edge = graph_.createEdge(callerNode, centerNode);
-      decorateEdge(graph_, edge, callerEdgeDecoration);
+      for (const util::Graph::Node& callee : graphNodes[edge.callee])
+        if (!graph_.hasEdge(caller, callee))
+          decorateEdge(graph_, graph_.createEdge(caller, callee),
+            callerEdgeDecoration);
     }
-  }
 
   _subgraphs.clear();
 }
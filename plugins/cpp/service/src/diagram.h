@@ -20,6 +20,11 @@ public:
     std::shared_ptr<std::string> datadir_,
     const cc::webserver::ServerContext& context_);
 
+  /**
+   * This diagram shows the functions which are called by the given one and
+   * which call it, up to the depth given by the
+   * cpp-function-call-diagram-depth option.
+   */
   void getFunctionCallDiagram(
     util::Graph& graph_,
     const core::AstNodeId& astNodeId_);
@@ -157,6 +162,12 @@ private:
 
   CppServiceHandler _cppHandler;
   core::ProjectServiceHandler _projectHandler;
+
+  /**
+   * Number of call levels shown in both directions in the function call
+   * diagram.
+   */
+  const std::size_t _callDiagramDepth;
 };
 
 }
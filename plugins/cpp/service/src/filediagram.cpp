@@ -22,16 +22,50 @@ namespace service
 namespace language
 {
 
-typedef odb::query<model::CppHeaderInclusion> IncludeQuery;
-typedef odb::result<model::CppHeaderInclusion> IncludeResult;
-typedef odb::query<model::CppEdge> EdgeQuery;
-typedef odb::result<model::CppEdge> EdgeResult;
-typedef odb::query<model::BuildTarget> TargetQuery;
-typedef odb::result<model::BuildTarget> TargetResult;
-typedef odb::query<model::BuildSource> SourceQuery;
-typedef odb::result<model::BuildSource> SourceResult;
 typedef odb::query<model::File> FileQuery;
-typedef odb::result<model::File> FileResult;
+typedef odb::query<model::CppDirectoryEdge> DirEdgeQuery;
+typedef odb::query<model::CppFileEdge> FileEdgeQuery;
+typedef odb::query<model::CppHeaderInclusionFiles> IncludeFilesQuery;
+typedef odb::query<model::BuildFileEdge> BuildFileEdgeQuery;
+
+namespace
+{
+
+core::FileInfo toFileInfo(const model::File& file_)
+{
+  core::FileInfo fileInfo;
+  fileInfo.id = std::to_string(file_.id);
+  fileInfo.path = file_.path;
+  fileInfo.type = file_.type;
+  return fileInfo;
+}
+
+/**
+ * Returns the file at the other end of an edge fetched by a file edge view.
+ */
+template <typename View>
+core::FileInfo neighbourFile(const View& edge_, bool reverse_)
+{
+  core::FileInfo fileInfo;
+  fileInfo.id = std::to_string(reverse_ ? edge_.fromId : edge_.toId);
+  fileInfo.path = reverse_ ? edge_.fromPath : edge_.toPath;
+  fileInfo.type = reverse_ ? edge_.fromType : edge_.toType;
+  return fileInfo;
+}
+
+std::vector<model::FileId> toFileIds(
+  const std::vector<util::Graph::Node>& fileNodes_)
+{
+  std::vector<model::FileId> fileIds;
+  fileIds.reserve(fileNodes_.size());
+
+  for (const util::Graph::Node& node : fileNodes_)
+    fileIds.push_back(std::stoull(node));
+
+  return fileIds;
+}
+
+}
 
 FileDiagram::FileDiagram(
   std::shared_ptr<odb::database> db_,
@@ -40,7 +74,13 @@ FileDiagram::FileDiagram(
     : _db(db_),
       _transaction(db_),
       _cppHandler(db_, datadir_, context_),
-      _projectHandler(db_, datadir_, context_)
+      _projectHandler(db_, datadir_, context_),
+      _subsystemDepth(context_.options.count("cpp-subsystem-diagram-depth")
+        ? context_.options["cpp-subsystem-diagram-depth"].as<std::size_t>()
+        : 2),
+      _subsystemFanOut(context_.options.count("cpp-subsystem-diagram-fanout")
+        ? context_.options["cpp-subsystem-diagram-fanout"].as<std::size_t>()
+        : 12)
 {
 }
 
@@ -53,25 +93,24 @@ void FileDiagram::getComponentUsersDiagram(
   util::Graph::Node currentNode = addNode(graph_, fileInfo);
   decorateNode(graph_, currentNode, centerNodeDecoration);
 
-  std::set<util::Graph::Node> provides = util::bfsBuild(graph_, currentNode,
-    std::bind(&FileDiagram::getProvides, this, std::placeholders::_1,
-    std::placeholders::_2), {}, providesEdgeDecoration, 1);
+  std::set<util::Graph::Node> provides = util::bfsBuildLevels(graph_,
+    {currentNode}, std::bind(&FileDiagram::getProvides, this,
+    std::placeholders::_1, std::placeholders::_2),
+    {}, providesEdgeDecoration, 1);
 
   std::set<util::Graph::Node> usedHeaders = provides;
-  for (const util::Graph::Node& provide : provides)
-  {
-    std::set<util::Graph::Node> revusages = util::bfsBuild(graph_, provide,
-      std::bind(&FileDiagram::getRevUsages, this, std::placeholders::_1,
-      std::placeholders::_2), {}, revUsagesEdgeDecoration);
 
-    for (const util::Graph::Node& revusage : revusages)
-      usedHeaders.insert(revusage);
-  }
+  std::set<util::Graph::Node> revusages = util::bfsBuildLevels(graph_,
+    std::vector<util::Graph::Node>(provides.begin(), provides.end()),
+    std::bind(&FileDiagram::getRevUsages, this, std::placeholders::_1,
+    std::placeholders::_2), {}, revUsagesEdgeDecoration);
+
+  usedHeaders.insert(revusages.begin(), revusages.end());
 
-  for (const util::Graph::Node& source : usedHeaders)
-    util::bfsBuild(graph_, source, std::bind(&FileDiagram::getRevContains,
-      this, std::placeholders::_1, std::placeholders::_2),
-      {}, revContainsEdgeDecoration);
+  util::bfsBuildLevels(graph_,
+    std::vector<util::Graph::Node>(usedHeaders.begin(), usedHeaders.end()),
+    std::bind(&FileDiagram::getRevContains, this, std::placeholders::_1,
+    std::placeholders::_2), {}, revContainsEdgeDecoration);
 }
 
 std::string FileDiagram::getComponentUsersDiagramLegend()
@@ -100,21 +139,24 @@ void FileDiagram::getIncludeDependencyDiagram(
   _projectHandler.getFileInfo(fileInfo, fileId_);
   util::Graph::Node currentNode = addNode(graph_, fileInfo);
 
-  util::bfsBuild(graph_, currentNode,std::bind(&FileDiagram::getUsages,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, usagesEdgeDecoration, 3);
+  // Like the former bfsBuild() calls, the relations of only the first three
+  // nodes are expanded (the queried file and two of its neighbours), not
+  // three complete levels.
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getUsages, this, std::placeholders::_1,
+    std::placeholders::_2), {}, usagesEdgeDecoration, -1, 3);
 
-  util::bfsBuild(graph_, currentNode,std::bind(&FileDiagram::getRevUsages,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, revUsagesEdgeDecoration, 3);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getRevUsages, this, std::placeholders::_1,
+    std::placeholders::_2), {}, revUsagesEdgeDecoration, -1, 3);
 
-  util::bfsBuild(graph_, currentNode, std::bind(&FileDiagram::getProvides,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, usagesEdgeDecoration, 3);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getProvides, this, std::placeholders::_1,
+    std::placeholders::_2), {}, usagesEdgeDecoration, -1, 3);
 
-  util::bfsBuild(graph_, currentNode, std::bind(&FileDiagram::getRevProvides,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, revUsagesEdgeDecoration, 3);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getRevProvides, this, std::placeholders::_1,
+    std::placeholders::_2), {}, revUsagesEdgeDecoration, -1, 3);
 }
 
 std::string FileDiagram::getIncludeDependencyDiagramLegend()
@@ -143,28 +185,30 @@ void FileDiagram::getExternalDependencyDiagram(
   util::Graph::Node currentNode = addNode(graph_, fileInfo);
   decorateNode(graph_, currentNode, centerNodeDecoration);
 
-  std::set<util::Graph::Node> subdirs = util::bfsBuild(graph_, currentNode,
-    std::bind(&FileDiagram::getSubDirs, this, std::placeholders::_1,
-    std::placeholders::_2), {}, subdirEdgeDecoration);
+  std::set<util::Graph::Node> subdirs = util::bfsBuildLevels(graph_,
+    {currentNode}, std::bind(&FileDiagram::getSubDirs, this,
+    std::placeholders::_1, std::placeholders::_2),
+    {}, subdirEdgeDecoration);
 
   subdirs.insert(currentNode);
 
-  for (const util::Graph::Node& subdir : subdirs)
-  {
-    for (const util::Graph::Node& impl : getImplements(graph_, subdir))
+  const std::vector<util::Graph::Node> dirs(subdirs.begin(), subdirs.end());
+
+  for (const auto& impls : getImplements(graph_, dirs))
+    for (const util::Graph::Node& impl : impls.second)
       if (subdirs.find(impl) == subdirs.end())
       {
-        util::Graph::Edge edge = graph_.createEdge(subdir, impl);
+        util::Graph::Edge edge = graph_.createEdge(impls.first, impl);
         decorateEdge(graph_, edge, implementsEdgeDecoration);
       }
 
-    for (const util::Graph::Node& dep : getDepends(graph_, subdir))
+  for (const auto& deps : getDepends(graph_, dirs))
+    for (const util::Graph::Node& dep : deps.second)
       if (subdirs.find(dep) == subdirs.end())
       {
-        util::Graph::Edge edge = graph_.createEdge(subdir, dep);
+        util::Graph::Edge edge = graph_.createEdge(deps.first, dep);
         decorateEdge(graph_, edge, dependsEdgeDecoration);
       }
-  }
 }
 
 std::string FileDiagram::getExternalDependencyDiagramLegend()
@@ -194,20 +238,20 @@ void FileDiagram::getExternalUsersDiagram(
   util::Graph::Node currentNode = addNode(graph_, fileInfo);
   decorateNode(graph_, currentNode, centerNodeDecoration);
 
-  std::set<util::Graph::Node> subdirs = util::bfsBuild(graph_, currentNode,
-    std::bind(&FileDiagram::getSubDirs, this, std::placeholders::_1,
-    std::placeholders::_2), {}, subdirEdgeDecoration);
+  std::set<util::Graph::Node> subdirs = util::bfsBuildLevels(graph_,
+    {currentNode}, std::bind(&FileDiagram::getSubDirs, this,
+    std::placeholders::_1, std::placeholders::_2),
+    {}, subdirEdgeDecoration);
 
-  for (const util::Graph::Node& subdir : subdirs)
-  {
-    util::bfsBuild(graph_, subdir,std::bind(&FileDiagram::getRevImplements,
-      this, std::placeholders::_1, std::placeholders::_2),
-      {}, revImplementsEdgeDecoration);
+  const std::vector<util::Graph::Node> dirs(subdirs.begin(), subdirs.end());
 
-    util::bfsBuild(graph_, subdir,std::bind(&FileDiagram::getRevDepends,
-      this, std::placeholders::_1, std::placeholders::_2),
-      {}, revDependsEdgeDecoration);
-  }
+  util::bfsBuildLevels(graph_, dirs, std::bind(&FileDiagram::getRevImplements,
+    this, std::placeholders::_1, std::placeholders::_2),
+    {}, revImplementsEdgeDecoration);
+
+  util::bfsBuildLevels(graph_, dirs, std::bind(&FileDiagram::getRevDepends,
+    this, std::placeholders::_1, std::placeholders::_2),
+    {}, revDependsEdgeDecoration);
 }
 
 std::string FileDiagram::getExternalUsersDiagramLegend()
@@ -236,29 +280,29 @@ void FileDiagram::getInterfaceDiagram(
   _projectHandler.getFileInfo(fileInfo, fileId_);
   util::Graph::Node currentNode = addNode(graph_, fileInfo);
 
-  util::bfsBuild(graph_, currentNode, std::bind(&FileDiagram::getProvides,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, providesEdgeDecoration, 1);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getProvides, this, std::placeholders::_1,
+    std::placeholders::_2), {}, providesEdgeDecoration, 1);
 
-  util::bfsBuild(graph_, currentNode, std::bind(&FileDiagram::getContains,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, containsEdgeDecoration, 1);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getContains, this, std::placeholders::_1,
+    std::placeholders::_2), {}, containsEdgeDecoration, 1);
 
-  util::bfsBuild(graph_, currentNode, std::bind(&FileDiagram::getUsages,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, usagesEdgeDecoration, 1);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getUsages, this, std::placeholders::_1,
+    std::placeholders::_2), {}, usagesEdgeDecoration, 1);
 
-  util::bfsBuild(graph_, currentNode, std::bind(&FileDiagram::getRevProvides,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, revProvidesEdgeDecoration, 1);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getRevProvides, this, std::placeholders::_1,
+    std::placeholders::_2), {}, revProvidesEdgeDecoration, 1);
 
-  util::bfsBuild(graph_, currentNode, std::bind(&FileDiagram::getRevContains,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, revContainsEdgeDecoration, 1);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getRevContains, this, std::placeholders::_1,
+    std::placeholders::_2), {}, revContainsEdgeDecoration, 1);
 
-  util::bfsBuild(graph_, currentNode, std::bind(&FileDiagram::getRevUsages,
-    this, std::placeholders::_1, std::placeholders::_2),
-    {}, revUsagesEdgeDecoration, 1);
+  util::bfsBuildLevels(graph_, {currentNode},
+    std::bind(&FileDiagram::getRevUsages, this, std::placeholders::_1,
+    std::placeholders::_2), {}, revUsagesEdgeDecoration, 1);
 }
 
 std::string FileDiagram::getInterfaceDiagramLegend()
@@ -291,32 +335,118 @@ void FileDiagram::getSubsystemDependencyDiagram(
   util::Graph::Node currentNode = addNode(graph_, fileInfo);
   decorateNode(graph_, currentNode, centerNodeDecoration);
 
-  std::set<util::Graph::Node> subdirs = util::bfsBuild(graph_, currentNode,
-    std::bind(&FileDiagram::getSubDirs, this, std::placeholders::_1,
-    std::placeholders::_2), {}, subdirEdgeDecoration);
+  // The directories which are hidden by the fan-out limit are mapped to the
+  // aggregated node of their siblings.
+  std::map<model::FileId, util::Graph::Node> dirNodes;
+  dirNodes[std::stoull(fileId_)] = currentNode;
 
-  subdirs.insert(currentNode);
+  _transaction([&, this]{
+    std::vector<model::FileId> level{std::stoull(fileId_)};
 
-  for (const util::Graph::Node& subdir : subdirs)
-  {
-    for (const util::Graph::Node& impl : getImplements(graph_, subdir))
-      if (subdirs.find(impl) != subdirs.end())
-      {
-        util::Graph::Edge edge = graph_.createEdge(subdir, impl);
-        decorateEdge(graph_, edge, implementsEdgeDecoration);
-      }
-      else
-        graph_.delNode(impl);
+    for (std::size_t depth = 0; depth < _subsystemDepth && !level.empty();
+         ++depth)
+    {
+      std::map<model::FileId, std::vector<model::File>> children;
 
-    for (const util::Graph::Node& dep : getDepends(graph_, subdir))
-      if (subdirs.find(dep) != subdirs.end())
+      for (model::File& dir : util::queryInChunks<model::File>(*_db, level,
+        [](auto begin_, auto end_){
+          return FileQuery::parent.in_range(begin_, end_) &&
+            FileQuery::type == model::File::DIRECTORY_TYPE;
+        }))
+        children[dir.parent.object_id()].push_back(std::move(dir));
+
+      level.clear();
+
+      for (auto& item : children)
       {
-        util::Graph::Edge edge = graph_.createEdge(subdir, dep);
-        decorateEdge(graph_, edge, dependsEdgeDecoration);
+        std::vector<model::File>& subdirs = item.second;
+        const util::Graph::Node parentNode = dirNodes[item.first];
+
+        std::sort(subdirs.begin(), subdirs.end(),
+          [](const model::File& lhs_, const model::File& rhs_){
+            return lhs_.path < rhs_.path;
+          });
+
+        // The queried directory shows all of its subdirectories, so the
+        // aggregated node of a directory can be expanded by querying it.
+        std::size_t shown = depth == 0
+          ? subdirs.size()
+          : std::min(subdirs.size(), _subsystemFanOut);
+
+        for (std::size_t i = 0; i < shown; ++i)
+        {
+          util::Graph::Node node = addNode(graph_, toFileInfo(subdirs[i]));
+          decorateEdge(graph_, graph_.createEdge(parentNode, node),
+            subdirEdgeDecoration);
+
+          dirNodes[subdirs[i].id] = node;
+          level.push_back(subdirs[i].id);
+        }
+
+        if (shown == subdirs.size())
+          continue;
+
+        // The ID of the aggregated node is decoded to the parent by
+        // nodeFileId(), so clicking it shows the diagram of the parent with
+        // all of its subdirectories.
+        util::Graph::Node more = graph_.getOrCreateNode(
+          MORE_NODE_PREFIX + std::to_string(item.first));
+        decorateNode(graph_, more, moreNodeDecoration);
+        graph_.setNodeAttribute(more, "label",
+          std::to_string(subdirs.size() - shown) + " more directories");
+        decorateEdge(graph_, graph_.createEdge(parentNode, more),
+          subdirEdgeDecoration);
+
+        for (std::size_t i = shown; i < subdirs.size(); ++i)
+          dirNodes[subdirs[i].id] = more;
       }
-      else
-        graph_.delNode(dep);
+    }
+
+    addDirectoryEdges(graph_, dirNodes, model::CppEdge::PROVIDE,
+      implementsEdgeDecoration);
+    addDirectoryEdges(graph_, dirNodes, model::CppEdge::USE,
+      dependsEdgeDecoration);
+  });
+}
+
+core::FileId FileDiagram::nodeFileId(const util::Graph::Node& node_)
+{
+  return node_.compare(0, MORE_NODE_PREFIX.size(), MORE_NODE_PREFIX) == 0
+    ? node_.substr(MORE_NODE_PREFIX.size())
+    : node_;
+}
+
+void FileDiagram::addDirectoryEdges(
+  util::Graph& graph_,
+  const std::map<model::FileId, util::Graph::Node>& dirNodes_,
+  model::CppEdge::Type type_,
+  const Decoration& decoration_)
+{
+  std::vector<model::FileId> dirs;
+  dirs.reserve(dirNodes_.size());
+  for (const auto& item : dirNodes_)
+    dirs.push_back(item.first);
+
+  std::set<std::pair<util::Graph::Node, util::Graph::Node>> edges;
+
+  for (const model::CppDirectoryEdge& dirEdge
+    : util::queryInChunks<model::CppDirectoryEdge>(*_db, dirs,
+      [type_](auto begin_, auto end_){
+        return DirEdgeQuery::CppEdge::type == type_ &&
+          DirEdgeQuery::FromFile::parent.in_range(begin_, end_);
+      }))
+  {
+    auto from = dirNodes_.find(dirEdge.from);
+    auto to = dirNodes_.find(dirEdge.to);
+
+    if (from != dirNodes_.end() && to != dirNodes_.end() &&
+        from->second != to->second)
+      edges.insert(std::make_pair(from->second, to->second));
   }
+
+  for (const auto& edge : edges)
+    decorateEdge(graph_, graph_.createEdge(edge.first, edge.second),
+      decoration_);
 }
 
 std::string FileDiagram::getSubsystemDependencyDiagramLegend()
@@ -329,6 +459,7 @@ std::string FileDiagram::getSubsystemDependencyDiagramLegend()
   builder.addNode("source file", sourceFileNodeDecoration);
   builder.addNode("header file", headerFileNodeDecoration);
   builder.addNode("object file", objectFileNodeDecoration);
+  builder.addNode("more directories", moreNodeDecoration);
 
   builder.addEdge("sub directory", subdirEdgeDecoration);
   builder.addEdge("implements", implementsEdgeDecoration);
@@ -337,361 +468,219 @@ std::string FileDiagram::getSubsystemDependencyDiagramLegend()
   return builder.getOutput();
 }
 
-std::vector<util::Graph::Node> FileDiagram::getIncludedFiles(
+template <typename View, typename Build>
+FileDiagram::Neighbours FileDiagram::getFileNeighbours(
   util::Graph& graph_,
-  const util::Graph::Node& node_,
-  bool reverse_)
+  const std::vector<util::Graph::Node>& fileNodes_,
+  bool reverse_,
+  Build build_)
 {
-  std::vector<util::Graph::Node> include;
+  std::vector<model::FileId> fileIds = toFileIds(fileNodes_);
+  std::set<std::pair<model::FileId, model::FileId>> edges;
+  Neighbours neighbours;
 
   _transaction([&, this]{
-    IncludeResult res = _db->query<model::CppHeaderInclusion>(
-      (reverse_
-         ? IncludeQuery::included->id
-         : IncludeQuery::includer->id) == std::stoull(node_));
-
-    for (const auto& inclusion : res)
+    for (const View& edge : util::queryInChunks<View>(*_db, fileIds, build_))
     {
-      model::FileId fileId = reverse_
-        ? inclusion.includer.object_id()
-        : inclusion.included.object_id();
+      model::FileId fileId = reverse_ ? edge.toId : edge.fromId;
+      model::FileId neighbourId = reverse_ ? edge.fromId : edge.toId;
 
-      core::FileInfo fileInfo;
-      _projectHandler.getFileInfo(fileInfo, std::to_string(fileId));
-      include.push_back(addNode(graph_, fileInfo));
+      // The same files may be connected several times, e.g. by build actions.
+      if (!edges.insert(std::make_pair(fileId, neighbourId)).second)
+        continue;
+
+      neighbours[std::to_string(fileId)].push_back(
+        addNode(graph_, neighbourFile(edge, reverse_)));
     }
   });
 
-  return include;
-}
-
-std::vector<util::Graph::Node> FileDiagram::getIncludes(
-  util::Graph& graph_,
-  const util::Graph::Node& node_)
-{
-  return getIncludedFiles(graph_, node_);
-}
-
-std::vector<util::Graph::Node> FileDiagram::getRevIncludes(
-  util::Graph& graph_,
-  const util::Graph::Node& node_)
-{
-  return getIncludedFiles(graph_, node_, true);
+  return neighbours;
 }
 
-std::vector<util::Graph::Node> FileDiagram::getSubDirs(
+FileDiagram::Neighbours FileDiagram::getDirectoryNeighbours(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_,
+  model::CppEdge::Type type_,
+  bool reverse_)
 {
-  std::vector<util::Graph::Node> usages;
+  std::vector<model::FileId> dirIds = toFileIds(fileNodes_);
+  std::map<model::FileId, std::set<model::FileId>> related;
+  std::set<model::FileId> relatedIds;
+  Neighbours neighbours;
 
   _transaction([&, this]{
-    FileResult sub = _db->query<model::File>(
-      FileQuery::parent == std::stoull(node_) &&
-      FileQuery::type == model::File::DIRECTORY_TYPE);
-
-    for (const model::File& subdir : sub)
+    for (const model::CppDirectoryEdge& dirEdge
+      : util::queryInChunks<model::CppDirectoryEdge>(*_db, dirIds,
+        [type_, reverse_](auto begin_, auto end_){
+          return DirEdgeQuery::CppEdge::type == type_ && (reverse_
+            ? DirEdgeQuery::ToFile::parent.in_range(begin_, end_)
+            : DirEdgeQuery::FromFile::parent.in_range(begin_, end_));
+        }))
     {
-      core::FileInfo fileInfo;
-      _projectHandler.getFileInfo(fileInfo, std::to_string(subdir.id));
-
-      usages.push_back(addNode(graph_, fileInfo));
-    }
-  });
-
-  return usages;
-}
-
-std::vector<util::Graph::Node> FileDiagram::getImplements(
-  util::Graph& graph_,
-  const util::Graph::Node& node_)
-{
-  return getImplementedFiles(graph_, node_);
-}
+      model::FileId dirId = reverse_ ? dirEdge.to : dirEdge.from;
+      model::FileId neighbourId = reverse_ ? dirEdge.from : dirEdge.to;
 
-std::vector<util::Graph::Node> FileDiagram::getRevImplements(
-  util::Graph& graph_,
-  const util::Graph::Node& node_)
-{
-  return getImplementedFiles(graph_, node_, true);
-}
-
-std::vector<util::Graph::Node> FileDiagram::getImplementedFiles(
-  util::Graph& graph_,
-  const util::Graph::Node& node_,
-  bool reverse_)
-{
-  std::vector<core::FileId> implements;
-  _transaction([&, this]
-  {
-    auto contained = _db->query<model::File>(
-      odb::query<model::File>::parent == std::stoull(node_) &&
-      odb::query<model::File>::type != model::File::DIRECTORY_TYPE
-    );
-    std::unordered_set<core::FileId> used;
+      if (dirId == neighbourId)
+        continue;
 
-    for (const model::File &file : contained)
-    {
-      auto files = getProvidedFileIds(graph_, std::to_string(file.id), reverse_);
-      used.insert(files.begin(), files.end());
-    }
-    for (const core::FileId& fileId : used)
-    {
-      auto file = _db->load<model::File>(std::stoull(fileId));
-      implements.push_back(std::to_string(file.get()->parent.object_id()));
+      related[dirId].insert(neighbourId);
+      relatedIds.insert(neighbourId);
     }
-    std::sort(implements.begin(), implements.end());
-    auto it = std::unique(implements.begin(), implements.end());
-    implements.resize(it - implements.begin());
-    implements.erase(std::remove_if(implements.begin(), implements.end(),
-                     [&node_](const util::Graph::Node& n){ return node_ == n; }),
-                     implements.end());
-  });
 
-  std::vector<util::Graph::Node> annotated;
+    std::map<model::FileId, core::FileInfo> dirs;
+    for (const model::File& dir : util::queryInChunks<model::File>(
+      *_db, relatedIds, [](auto begin_, auto end_){
+        return FileQuery::id.in_range(begin_, end_);
+      }))
+      dirs[dir.id] = toFileInfo(dir);
 
-  for (const core::FileId& fileId : implements)
-  {
-    core::FileInfo fileInfo;
-    _projectHandler.getFileInfo(fileInfo, fileId);
+    for (const auto& item : related)
+      for (model::FileId neighbourId : item.second)
+      {
+        auto dir = dirs.find(neighbourId);
+        if (dir != dirs.end())
+          neighbours[std::to_string(item.first)].push_back(
+            addNode(graph_, dir->second));
+      }
+  });
 
-    annotated.push_back(addNode(graph_, fileInfo));
-  }
-  return annotated;
+  return neighbours;
 }
 
-std::vector<util::Graph::Node> FileDiagram::getDepends(
+FileDiagram::Neighbours FileDiagram::getIncludes(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  return getDependFiles(graph_, node_);
+  return getFileNeighbours<model::CppHeaderInclusionFiles>(
+    graph_, fileNodes_, false, [](auto begin_, auto end_){
+      return IncludeFilesQuery::Includer::id.in_range(begin_, end_);
+    });
 }
 
-std::vector<util::Graph::Node> FileDiagram::getRevDepends(
+FileDiagram::Neighbours FileDiagram::getRevIncludes(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  return getDependFiles(graph_, node_, true);
+  return getFileNeighbours<model::CppHeaderInclusionFiles>(
+    graph_, fileNodes_, true, [](auto begin_, auto end_){
+      return IncludeFilesQuery::Included::id.in_range(begin_, end_);
+    });
 }
 
-std::vector<util::Graph::Node> FileDiagram::getDependFiles(
+FileDiagram::Neighbours FileDiagram::getSubDirs(
   util::Graph& graph_,
-  const util::Graph::Node& node_,
-  bool reverse_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  std::vector<core::FileId> depends;
+  std::vector<model::FileId> dirIds = toFileIds(fileNodes_);
+  Neighbours neighbours;
 
   _transaction([&, this]{
-    auto contained = _db->query<model::File>(
-      odb::query<model::File>::parent == std::stoull(node_) &&
-      odb::query<model::File>::type != model::File::DIRECTORY_TYPE
-      );
-
-    std::unordered_set<core::FileId> used;
-
-    for(const model::File& file : contained)
-    {
-      auto files = getUsedFileIds(graph_, std::to_string(file.id), reverse_);
-      used.insert(files.begin(), files.end());
-    }
-
-    for(const core::FileId& fileId : used)
-    {
-      auto files =_db->query<model::File>(
-        odb::query<model::File>::id == std::stoull(fileId)
-        );
-
-      for(const model::File& file : files)
-      {
-        depends.push_back(std::to_string(file.parent.object_id()));
-      }
-    }
-
-    std::sort(depends.begin(), depends.end());
-    auto it = std::unique(depends.begin(), depends.end());
-    depends.resize(it - depends.begin());
-    depends.erase(std::remove_if(depends.begin(), depends.end(),
-                     [&node_](const util::Graph::Node& n){ return node_ == n; }),
-                     depends.end());
+    for (const model::File& subdir : util::queryInChunks<model::File>(
+      *_db, dirIds, [](auto begin_, auto end_){
+        return FileQuery::parent.in_range(begin_, end_) &&
+          FileQuery::type == model::File::DIRECTORY_TYPE;
+      }))
+      neighbours[std::to_string(subdir.parent.object_id())].push_back(
+        addNode(graph_, toFileInfo(subdir)));
   });
 
-  std::vector<util::Graph::Node> annotated;
-
-  for (const core::FileId& fileId: depends)
-  {
-    core::FileInfo fileInfo;
-    _projectHandler.getFileInfo(fileInfo, fileId);
-
-    annotated.push_back(addNode(graph_, fileInfo));
-  }
-  return annotated;
+  return neighbours;
 }
 
-std::vector<util::Graph::Node> FileDiagram::getProvides(
+FileDiagram::Neighbours FileDiagram::getImplements(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  return getProvidedFiles(graph_, node_);
+  return getDirectoryNeighbours(
+    graph_, fileNodes_, model::CppEdge::PROVIDE, false);
 }
 
-std::vector<util::Graph::Node> FileDiagram::getRevProvides(
+FileDiagram::Neighbours FileDiagram::getRevImplements(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  return getProvidedFiles(graph_, node_, true);
+  return getDirectoryNeighbours(
+    graph_, fileNodes_, model::CppEdge::PROVIDE, true);
 }
 
-std::vector<util::Graph::Node> FileDiagram::getProvidedFiles(
+FileDiagram::Neighbours FileDiagram::getDepends(
   util::Graph& graph_,
-  const util::Graph::Node& node_,
-  bool reverse_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  std::vector<util::Graph::Node> depends;
-
-  std::vector<core::FileId> fileIds = getProvidedFileIds(graph_, node_, reverse_);
-
-  for (const core::FileId& fileId : fileIds)
-  {
-    core::FileInfo fileInfo;
-    _projectHandler.getFileInfo(fileInfo, fileId);
-
-    depends.push_back(addNode(graph_, fileInfo));
-  }
-
-  return depends;
+  return getDirectoryNeighbours(
+    graph_, fileNodes_, model::CppEdge::USE, false);
 }
 
-std::vector<core::FileId> FileDiagram::getProvidedFileIds(
-  util::Graph&,
-  const util::Graph::Node& node_,
-  bool reverse_)
+FileDiagram::Neighbours FileDiagram::getRevDepends(
+  util::Graph& graph_,
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  std::vector<core::FileId> depends;
-
-  _transaction([&, this]{
-    EdgeResult res = _db->query<model::CppEdge>(
-      (reverse_
-       ? EdgeQuery::to->id
-       : EdgeQuery::from->id) == std::stoull(node_) &&
-      EdgeQuery::type == model::CppEdge::PROVIDE);
-
-    for (const model::CppEdge& edge : res)
-    {
-      core::FileId fileId = reverse_ ? std::to_string(edge.from->id) : std::to_string(edge.to->id);
-      depends.push_back(fileId);
-    }
-  });
-
-  return depends;
+  return getDirectoryNeighbours(
+    graph_, fileNodes_, model::CppEdge::USE, true);
 }
 
-std::vector<util::Graph::Node> FileDiagram::getContains(
+FileDiagram::Neighbours FileDiagram::getProvides(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  std::vector<util::Graph::Node> contained;
-
-  _transaction([&, this]{
-    TargetResult targets = _db->query<model::BuildTarget>(
-      TargetQuery::file == std::stoull(node_));
-
-    for (const model::BuildTarget& target : targets)
-      for (const auto& source : target.action->sources)
-      {
-        model::FileId fileId = source.lock().load()->file->id;
-        core::FileInfo fileInfo;
-        _projectHandler.getFileInfo(fileInfo, std::to_string(fileId));
-        contained.push_back(addNode(graph_, fileInfo));
-      }
-  });
-
-  return contained;
+  return getFileNeighbours<model::CppFileEdge>(
+    graph_, fileNodes_, false, [](auto begin_, auto end_){
+      return FileEdgeQuery::CppEdge::type == model::CppEdge::PROVIDE &&
+        FileEdgeQuery::FromFile::id.in_range(begin_, end_);
+    });
 }
 
-std::vector<util::Graph::Node> FileDiagram::getRevContains(
+FileDiagram::Neighbours FileDiagram::getRevProvides(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  std::vector<util::Graph::Node> contained;
-  std::set<model::FileId> files;
-
-  _transaction([&, this]{
-    SourceResult sources = _db->query<model::BuildSource>(
-      SourceQuery::file == std::stoull(node_));
-    for (const model::BuildSource& source : sources)
-      for (const auto& target : source.action->targets)
-      {
-        model::FileId fileId = target.lock().load()->file->id;
-
-        if (!files.insert(fileId).second)
-          continue;
-
-        core::FileInfo fileInfo;
-        _projectHandler.getFileInfo(fileInfo, std::to_string(fileId));
-        contained.push_back(addNode(graph_, fileInfo));
-      }
-  });
-
-  return contained;
+  return getFileNeighbours<model::CppFileEdge>(
+    graph_, fileNodes_, true, [](auto begin_, auto end_){
+      return FileEdgeQuery::CppEdge::type == model::CppEdge::PROVIDE &&
+        FileEdgeQuery::ToFile::id.in_range(begin_, end_);
+    });
 }
 
-std::vector<util::Graph::Node> FileDiagram::getUsages(
+FileDiagram::Neighbours FileDiagram::getContains(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  return getUsedFiles(graph_, node_);
+  return getFileNeighbours<model::BuildFileEdge>(
+    graph_, fileNodes_, true, [](auto begin_, auto end_){
+      return BuildFileEdgeQuery::TargetFile::id.in_range(begin_, end_);
+    });
 }
 
-std::vector<util::Graph::Node> FileDiagram::getRevUsages(
+FileDiagram::Neighbours FileDiagram::getRevContains(
   util::Graph& graph_,
-  const util::Graph::Node& node_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  return getUsedFiles(graph_, node_, true);
+  return getFileNeighbours<model::BuildFileEdge>(
+    graph_, fileNodes_, false, [](auto begin_, auto end_){
+      return BuildFileEdgeQuery::SourceFile::id.in_range(begin_, end_);
+    });
 }
 
-std::vector<util::Graph::Node> FileDiagram::getUsedFiles(
+FileDiagram::Neighbours FileDiagram::getUsages(
   util::Graph& graph_,
-  const util::Graph::Node& node_,
-  bool reverse_)
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  std::vector<util::Graph::Node> usages;
-
-  std::vector<core::FileId> fileIds = getUsedFileIds(graph_, node_, reverse_);
-
-  for (const core::FileId& fileId: fileIds)
-  {
-    core::FileInfo fileInfo;
-    _projectHandler.getFileInfo(fileInfo, fileId);
-
-    usages.push_back(addNode(graph_, fileInfo));
-  }
-
-  return usages;
+  return getFileNeighbours<model::CppFileEdge>(
+    graph_, fileNodes_, false, [](auto begin_, auto end_){
+      return FileEdgeQuery::CppEdge::type == model::CppEdge::USE &&
+        FileEdgeQuery::FromFile::id.in_range(begin_, end_);
+    });
 }
 
-std::vector<core::FileId> FileDiagram::getUsedFileIds(
-  util::Graph&,
-  const util::Graph::Node& node_,
-  bool reverse_)
+FileDiagram::Neighbours FileDiagram::getRevUsages(
+  util::Graph& graph_,
+  const std::vector<util::Graph::Node>& fileNodes_)
 {
-  std::vector<core::FileId> usages;
-
-  _transaction([&, this]{
-    EdgeResult res = _db->query<model::CppEdge>(
-      (reverse_
-       ? EdgeQuery::to->id
-       : EdgeQuery::from->id) == std::stoull(node_) &&
-      EdgeQuery::type == model::CppEdge::USE);
-
-    for (const model::CppEdge& edge : res)
-    {
-      core::FileId fileId = reverse_ ? std::to_string(edge.from->id) : std::to_string(edge.to->id);
-
-      usages.push_back(fileId);
-    }
-  });
-
-  return usages;
+  return getFileNeighbours<model::CppFileEdge>(
+    graph_, fileNodes_, true, [](auto begin_, auto end_){
+      return FileEdgeQuery::CppEdge::type == model::CppEdge::USE &&
+        FileEdgeQuery::ToFile::id.in_range(begin_, end_);
+    });
 }
 
 util::Graph::Node FileDiagram::addNode(
@@ -792,6 +781,13 @@ const FileDiagram::Decoration FileDiagram::directoryNodeDecoration = {
   {"shape", "folder"}
 };
 
+const std::string FileDiagram::MORE_NODE_PREFIX = "more:";
+
+const FileDiagram::Decoration FileDiagram::moreNodeDecoration = {
+  {"shape", "folder"},
+  {"style", "dashed"}
+};
+
 const FileDiagram::Decoration FileDiagram::usagesEdgeDecoration = {
   {"label", "uses"}
 };
@@ -1,6 +1,8 @@
 #ifndef CC_SERVICE_LANGUAGE_FILEDIAGRAM_H
 #define CC_SERVICE_LANGUAGE_FILEDIAGRAM_H
 
+#include <model/cppedge.h>
+
 #include <service/cppservice.h>
 #include <projectservice/projectservice.h>
 #include <util/graph.h>
@@ -80,11 +82,31 @@ public:
    * This diagram shows the directories relationship between the subdirectories
    * of the queried module. This diagram is useful to understand the
    * relationships of the subdirectories (submodules) of a module.
+   *
+   * Only a limited number of directory levels are shown, and a directory below
+   * the queried one shows a limited number of its subdirectories. The rest of
+   * them are aggregated to a "more directories" node which carries their
+   * relations too. The queried directory shows all of its subdirectories, so
+   * clicking a directory or an aggregated node expands it in a new diagram.
+   * The ID of an aggregated node is the ID of its parent directory with the
+   * MORE_NODE_PREFIX prefix (see nodeFileId()).
    */
   void getSubsystemDependencyDiagram(
     util::Graph& graph_,
     const core::FileId& fileId_);
 
+  /**
+   * Returns the ID of the file which is expanded by clicking the given node
+   * of a file diagram: the parent directory of an aggregated node, or the
+   * file of any other node.
+   */
+  static core::FileId nodeFileId(const util::Graph::Node& node_);
+
+  /**
+   * Prefix of the ID of an aggregated "more directories" node.
+   */
+  static const std::string MORE_NODE_PREFIX;
+
   /**
    * This function creates legend for the Subsystem dependency diagram.
    * @return The generated legend as a string in SVG format.
@@ -146,226 +168,179 @@ private:
   std::string getLastNParts(const std::string& path_, std::size_t n_);
 
   /**
-   * This function creates graph nodes for each files which the given one
-   * includes.
-   * @see getIncludedFiles()
+   * The neighbours of the nodes on a level of a breadth-first search, grouped
+   * by the nodes of the level.
+   * @see util::bfsBuildLevels()
    */
-  std::vector<util::Graph::Node> getIncludes(
-    util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+  typedef std::map<util::Graph::Node, std::vector<util::Graph::Node>>
+    Neighbours;
 
   /**
-   * This function creates graph nodes for each files which includes the given
-   * file.
-   * @note This function is the revert version of the getIncludes function.
-   * @see getIncludedFiles()
+   * This function creates graph nodes for each files which the given ones
+   * include.
    */
-  std::vector<util::Graph::Node> getRevIncludes(
+  Neighbours getIncludes(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function returns the graph nodes which the given file includes.
-   * @param graph_ A graph object.
-   * @param fileNode_ Graph file node object which represents a file object.
-   * @param reverse_ If true then it creates graph nodes for each file which
-   * includes the given file.
-   * @return Created graph nodes.
+   * This function creates graph nodes for each files which include the given
+   * ones.
+   * @note This function is the revert version of the getIncludes function.
    */
-  std::vector<util::Graph::Node> getIncludedFiles(
+  Neighbours getRevIncludes(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_,
-    bool reverse_ = false);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for sub directories of the actual file
-   * node and returns the created graph nodes.
-   * @param graph_ A graph object.
-   * @param fileNode_ Graph file node object which represents a file object.
-   * @return Subdirectory graph nodes.
+   * This function creates graph nodes for the sub directories of the given
+   * directory nodes.
    */
-  std::vector<util::Graph::Node> getSubDirs(
+  Neighbours getSubDirs(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for each files which files implements
-   * the given one.
-   * @see getImplementedFiles()
+   * This function creates graph nodes for the directories which the given
+   * directories implement.
+   * @note Directory `A` implements directory `B` if a file in `A` provides a
+   * file in `B` (see getProvides()).
+   * @see getDirectoryNeighbours()
    */
-  std::vector<util::Graph::Node> getImplements(
+  Neighbours getImplements(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for each files which implements the given
-   * file.
+   * This function creates graph nodes for the directories which implement the
+   * given directories.
    * @note This function is the revert version of the getImplements function.
-   * @see getImplementedFiles()
    */
-  std::vector<util::Graph::Node> getRevImplements(
+  Neighbours getRevImplements(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
-
-  /**
-    * This function creates graph nodes for each files which implements the
-    * given file.
-    * @note `A` implements `B` if a function which is defined in `A` declared
-    * in `B`.
-    * @param graph_ A graph object.
-    * @param fileNode_ Graph file node object which represents a file object.
-    * @param reverse_ If true then it creates graph nodes for each file which
-    * implements the given file.
-    * @return Created graph nodes.
-    */
-  std::vector<util::Graph::Node> getImplementedFiles(
-    util::Graph& graph_,
-    const util::Graph::Node& fileNode_,
-    bool reverse_ = false);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function returns graph nodes which the given file depends on.
-   * @see getDependFiles()
+   * This function creates graph nodes for the directories which the given
+   * directories depend on.
+   * @note Directory `A` depends on directory `B` if a file in `A` uses a file
+   * in `B` (see getUsages()).
+   * @see getDirectoryNeighbours()
    */
-  std::vector<util::Graph::Node> getDepends(
+  Neighbours getDepends(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function returns graph nodes which depends from the given file.
-   * @note This function is the revert version of the getImplements function.
-   * @see getDependFiles()
+   * This function creates graph nodes for the directories which depend on the
+   * given directories.
+   * @note This function is the revert version of the getDepends function.
    */
-  std::vector<util::Graph::Node> getRevDepends(
+  Neighbours getRevDepends(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function returns graph nodes which the given file depends on.
-   * @note File `A` depends on file `B` if:
-   *   - `A` has a value declaration which type is a record type which was
-   *     declared in `B`.
-   *     E.g.: In file A `T x;` is a value declaration and T is a record type
-   *           which was declared in file `B` then `A` depends on `B`.
-   *   - `A` has a function call which declaration is located in file `B`.
-   *     E.g.: In file A `f()` is a function call which function was declared
-   *           in file `B` then `A` depends on `B`.
-   * @param graph_ A graph object.
-   * @param fileNode_ Graph file node object which represents a file object.
-   * @param reverse_ If true then it creates graph nodes for each file which
-   * depends the given file.
-   * @return Created graph nodes.
+   * This function creates graph nodes for each files which the given files
+   * provide.
+   * @note `A` provides `B` if a function which is defined in `A` is declared
+   * in `B` and `A` is not the same as `B`.
    */
-  std::vector<util::Graph::Node> getDependFiles(
+  Neighbours getProvides(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_,
-    bool reverse_ = false);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for each files which files provides
-   * the given one.
-   * @see getProvidedFiles()
+   * This function creates graph nodes for each files which provide the given
+   * files.
+   * @note This function is the revert version of the getProvides function.
    */
-  std::vector<util::Graph::Node> getProvides(
+  Neighbours getRevProvides(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for each files which provides the given
-   * file.
-   * @note This function is the revert version of the getProvides function.
-   * @see getProvidedFiles()
+   * This function creates graph nodes for each build sources which are
+   * related to the given build targets.
    */
-  std::vector<util::Graph::Node> getRevProvides(
+  Neighbours getContains(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for each files which provides the
-   * given file.
-   * `A` provides `B` if a function which is defined in `A` , declared in `B`
-   * and `A` is not the same as `B`.
-   * @param graph_ A graph object.
-   * @param fileNode_ Graph file node object which represents a file object.
-   * @param reverse_ If true then it creates graph nodes for each file which
-   * provides the given file.
-   * @return Created graph nodes.
+   * This function creates graph nodes for each build targets which are
+   * related to the given build sources.
    */
-  std::vector<util::Graph::Node> getProvidedFiles(
-    util::Graph& graph_,
-    const util::Graph::Node& fileNode_,
-    bool reverse_ = false);
-
-  std::vector<core::FileId> getProvidedFileIds(
+  Neighbours getRevContains(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_,
-    bool reverse_ = false);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for each build sources which related to
-   * the given build target.
-   * @param graph_ A graph object.
-   * @param fileNode_ Graph file node object which represents a file object.
-   * @return Created graph nodes.
+   * This function creates graph nodes for each files which the given files
+   * use.
+   * @note File `A` use file `B` (A<>B) if:
+   *   - `A` has a value declaration which type is a record type which was
+   *     declared in `B`.
+   *     E.g.: In file A `T x;` is a value declaration and T is a record type
+   *           which was declared in file `B` then `A` use `B`.
+   *   - `A` has a function call which declaration is located in file `B`.
+   *     E.g.: In file A `f()` is a function call which function was declared
+   *           in file `B` then `A` use `B`.
    */
-  std::vector<util::Graph::Node> getContains(
+  Neighbours getUsages(
     util::Graph& graph_,
-    const util::Graph::Node& fileNode_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for each build targets which related to
-   * the given build source.
-   * @param graph_ A graph object.
-   * @param fileNode_ Graph file node object which represents a file object.
-   * @return Created graph nodes.
+   * This function creates graph nodes for each files which use the given
+   * files.
+   * @note This function is the revert version of the getUsages function.
    */
-  std::vector<util::Graph::Node> getRevContains(
+  Neighbours getRevUsages(
     util::Graph& graph_,
-    const util::Graph::Node& node_);
+    const std::vector<util::Graph::Node>& fileNodes_);
 
   /**
-   * This function creates graph nodes for each files which files use the
-   * given one.
-   * @see getUsedFiles()
+   * This function creates graph nodes for the files at the other end of the
+   * given kind of file edges. The edges of all given files are fetched by
+   * set-based queries together with the metadata of the neighbour files, so
+   * a level of a breadth-first search costs a constant number of queries.
+   * @tparam View A database view which has the ID, path and type of the files
+   * at both ends of the edges (fromId, fromPath, fromType, toId etc.).
+   * @param reverse_ If true then the edges are followed backwards.
+   * @param build_ Builds the query condition for a range of file IDs.
    */
-  std::vector<util::Graph::Node> getUsages(
+  template <typename View, typename Build>
+  Neighbours getFileNeighbours(
     util::Graph& graph_,
-    const util::Graph::Node& node_);
+    const std::vector<util::Graph::Node>& fileNodes_,
+    bool reverse_,
+    Build build_);
 
   /**
-   * This function creates graph nodes for each files which use the given file.
-   * @note This function is the revert version of the getUsages function.
-   * @see getUsedFiles()
+   * This function creates graph nodes for the directories connected to the
+   * given directories: `A` is connected to `B` if a file in `A` has an edge of
+   * the given type to a file in `B`.
+   * @param reverse_ If true then the edges are followed backwards.
    */
-  std::vector<util::Graph::Node> getRevUsages(
+  Neighbours getDirectoryNeighbours(
     util::Graph& graph_,
-    const util::Graph::Node& node_);
+    const std::vector<util::Graph::Node>& fileNodes_,
+    model::CppEdge::Type type_,
+    bool reverse_);
 
   /**
-   * This function returns graph nodes which the given file depends on.
-   * @note File `A` use file `B` (A<>B) if:
-   *   - `A` has a value declaration which type is a record type which was
-   *     declared in `B`.
-   *     E.g.: In file A `T x;` is a value declaration and T is a record type
-   *           which was declared in file `B` then `A` use `B`.
-   *   - `A` has a function call which declaration is located in file `B`.
-   *     E.g.: In file A `f()` is a function call which function was declared
-   *           in file `B` then `A` use `B`.
-   * @param graph_ A graph object.
-   * @param fileNode_ Graph file node object which represents a file object.
-   * @param reverse_ If true then it creates graph nodes for each file which
-   * use the given file.
-   * @return Created graph nodes.
+   * This function adds the edges between the given directory nodes. An edge
+   * is added if a file in a directory has an edge of the given type to a file
+   * in the other directory. The edges are fetched by set-based queries.
+   * @param dirNodes_ Maps the directories to their graph nodes. Several
+   * directories may be represented by the same node.
    */
-  std::vector<util::Graph::Node> getUsedFiles(
+  void addDirectoryEdges(
     util::Graph& graph_,
-    const util::Graph::Node& node_,
-    bool reverse_ = false);
-
-  std::vector<core::FileId> getUsedFileIds(
-    util::Graph& graph_,
-    const util::Graph::Node& node_,
-    bool reverse_);
+    const std::map<model::FileId, util::Graph::Node>& dirNodes_,
+    model::CppEdge::Type type_,
+    const Decoration& decoration_);
 
   static const Decoration centerNodeDecoration;
   static const Decoration sourceFileNodeDecoration;
@@ -373,6 +348,7 @@ private:
   static const Decoration binaryFileNodeDecoration;
   static const Decoration objectFileNodeDecoration;
   static const Decoration directoryNodeDecoration;
+  static const Decoration moreNodeDecoration;
 
   static const Decoration usagesEdgeDecoration;
   static const Decoration revUsagesEdgeDecoration;
@@ -390,6 +366,17 @@ private:
   util::OdbTransaction _transaction;
   CppServiceHandler _cppHandler;
   core::ProjectServiceHandler _projectHandler;
+
+  /**
+   * Number of directory levels shown in the subsystem dependency diagram.
+   */
+  std::size_t _subsystemDepth;
+
+  /**
+   * Number of subdirectories shown per directory in the subsystem dependency
+   * diagram.
+   */
+  std::size_t _subsystemFanOut;
 };
 
 } // language
@@ -1,5 +1,7 @@
 #include <webserver/pluginhelper.h>
 
+#include <util/graphlayout.h>
+
 #include <service/cppservice.h>
 
 #pragma clang diagnostic push
@@ -8,7 +10,53 @@ extern "C"
 {
   boost::program_options::options_description getOptions()
   {
-    boost::program_options::options_description description("C++ Plugin");
+    namespace po = boost::program_options;
+
+    po::options_description description("C++ Plugin");
+
+    description.add_options()
+      ("cpp-result-cache-size", po::value<std::size_t>()->default_value(64),
+       "Size of the cache in megabytes which stores the results of frequent "
+       "C++ service queries (properties, documentation, references) of a "
+       "project. The cache is dropped when the project is reparsed. "
+       "0 turns off caching.")
+      ("cpp-diagram-cache-size", po::value<std::size_t>()->default_value(128),
+       "Size of the cache in megabytes which stores the built and rendered "
+       "C++ diagrams of a project. 0 turns off diagram caching.")
+      ("cpp-diagram-layout-workers", po::value<std::size_t>()->default_value(4),
+       "Maximal number of diagram layouts running at the same time. Every "
+       "layout runs in a separate worker process.")
+      ("cpp-diagram-layout-timeout",
+       po::value<std::size_t>()->default_value(60),
+       "Deadline of a diagram layout in seconds, including the time spent "
+       "waiting for a free worker. Slower layouts are killed.")
+      ("cpp-diagram-max-nodes", po::value<std::size_t>()->default_value(1000),
+       "Diagrams with more nodes are summarized by omitting their less "
+       "connected nodes before the layout.")
+      ("cpp-diagram-max-edges", po::value<std::size_t>()->default_value(4000),
+       "Diagrams with more edges are summarized by omitting their less "
+       "connected nodes before the layout.")
+      ("cpp-function-call-diagram-depth",
+       po::value<std::size_t>()->default_value(2),
+       "Number of call levels shown in both directions in the function call "
+       "diagram. The call graph of these levels is fetched by a single "
+       "query.")
+      ("cpp-subsystem-diagram-depth",
+       po::value<std::size_t>()->default_value(2),
+       "Number of directory levels shown in the subsystem dependency "
+       "diagram. Deeper levels are shown by clicking a directory.")
+      ("cpp-subsystem-diagram-fanout",
+       po::value<std::size_t>()->default_value(12),
+       "Number of subdirectories shown per directory in the subsystem "
+       "dependency diagram. The rest are aggregated into one node. The "
+       "queried directory shows all of its subdirectories.")
+      ("cpp-diagram-disk-cache", po::value<bool>()->default_value(false),
+       "Store the cached diagrams also in the diagramcache directory of the "
+       "project in the workspace, so they survive a restart of the server.")
+      ("cpp-prepared-queries", po::value<bool>()->default_value(true),
+       "Use prepared statements for the most frequent C++ service queries. "
+       "The statements are prepared once per database connection.");
+
     return description;
   }
 
@@ -16,6 +64,29 @@ extern "C"
     const cc::webserver::ServerContext& context_,
     cc::webserver::PluginHandler<cc::webserver::RequestHandler>* pluginHandler_)
   {
+    // The layout pool is shared by every project, so it is configured here
+    // and not by the service handler of each project.
+    const boost::program_options::variables_map& options = context_.options;
+    cc::util::GraphLayout::Options layoutOptions;
+
+    layoutOptions.worker
+      = context_.compassRoot + "/bin/CodeCompass_graphlayout";
+
+    if (options.count("cpp-diagram-layout-workers"))
+      layoutOptions.workers
+        = options["cpp-diagram-layout-workers"].as<std::size_t>();
+    if (options.count("cpp-diagram-layout-timeout"))
+      layoutOptions.timeout = std::chrono::seconds(
+        options["cpp-diagram-layout-timeout"].as<std::size_t>());
+    if (options.count("cpp-diagram-max-nodes"))
+      layoutOptions.maxNodes
+        = options["cpp-diagram-max-nodes"].as<std::size_t>();
+    if (options.count("cpp-diagram-max-edges"))
+      layoutOptions.maxEdges
+        = options["cpp-diagram-max-edges"].as<std::size_t>();
+
+    cc::util::GraphLayout::instance().configure(layoutOptions);
+
     cc::webserver::registerPluginSimple(
       context_,
       pluginHandler_,
@@ -0,0 +1,133 @@
+#include <mutex>
+#include <unordered_map>
+
+#include <util/logutil.h>
+
+#include "resultcache.h"
+
+namespace
+{
+
+/**
+ * Visitor which approximates the memory footprint of a cached value.
+ */
+struct ValueSize : boost::static_visitor<std::size_t>
+{
+  std::size_t operator()(std::int32_t) const
+  {
+    return sizeof(std::int32_t);
+  }
+
+  std::size_t operator()(const std::string& str_) const
+  {
+    return sizeof(std::string) + str_.capacity();
+  }
+
+  template <typename Mapped>
+  std::size_t operator()(const std::map<std::string, Mapped>& map_) const
+  {
+    // A map node contains the value and three pointers plus the color.
+    std::size_t size = sizeof(map_);
+
+    for (const auto& item : map_)
+      size += sizeof(item) + 4 * sizeof(void*)
+        + item.first.capacity() + (*this)(item.second);
+
+    return size;
+  }
+};
+
+}
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+std::size_t ResultCache::ValueSizer::operator()(
+  const std::string& key_,
+  const Value& value_) const
+{
+  // The key is stored twice: in the LRU list and in the index.
+  return 2 * (sizeof(std::string) + key_.capacity())
+    + boost::apply_visitor(ValueSize(), value_);
+}
+
+std::shared_ptr<ResultCache> ResultCache::forProject(
+  const std::string& datadir_,
+  std::size_t capacity_)
+{
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<ResultCache>> caches;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  std::shared_ptr<ResultCache> cache = caches[datadir_].lock();
+  if (!cache)
+  {
+    cache = std::make_shared<ResultCache>(datadir_, capacity_);
+    caches[datadir_] = cache;
+  }
+
+  return cache;
+}
+
+ResultCache::ResultCache(const std::string& datadir_, std::size_t capacity_)
+  : _datadir(datadir_),
+    _generation(datadir_),
+    _lastGeneration(_generation.current()),
+    _cache(capacity_)
+{
+}
+
+ResultCache::~ResultCache()
+{
+  logStatistics("closed");
+}
+
+std::string ResultCache::makeKey(
+  const std::string& method_,
+  const std::string& args_)
+{
+  std::uint64_t generation = _generation.current();
+  std::uint64_t last = _lastGeneration;
+
+  if (generation != last &&
+      _lastGeneration.compare_exchange_strong(last, generation))
+  {
+    logStatistics("invalidated by generation " + std::to_string(generation));
+    _cache.clear();
+  }
+
+  std::string key = std::to_string(generation);
+  key += '\0';
+  key += method_;
+  key += '\0';
+  key += args_;
+
+  return key;
+}
+
+ResultCache::Statistics ResultCache::statistics() const
+{
+  return _cache.statistics();
+}
+
+void ResultCache::logStatistics(const std::string& reason_) const
+{
+  Statistics stats = _cache.statistics();
+
+  LOG(info)
+    << "C++ result cache of '" << _datadir << "' " << reason_
+    << " (hits: " << stats.hits
+    << ", misses: " << stats.misses
+    << ", evictions: " << stats.evictions
+    << ", entries: " << stats.entries
+    << ", bytes: " << stats.bytes << ")";
+}
+
+} // language
+} // service
+} // cc
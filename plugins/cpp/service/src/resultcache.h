@@ -0,0 +1,113 @@
+#ifndef CC_SERVICE_LANGUAGE_RESULTCACHE_H
+#define CC_SERVICE_LANGUAGE_RESULTCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <boost/variant.hpp>
+
+#include <util/lrucache.h>
+#include <util/projectgeneration.h>
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+/**
+ * Caches the results of frequently called, read-only CppServiceHandler
+ * methods. The entries are keyed by the name of the method, its serialized
+ * arguments and the generation of the project database. When the parser bumps
+ * the generation (i.e. the database content changed) the whole cache is
+ * dropped.
+ *
+ * One cache instance belongs to a project directory, so the handlers created
+ * internally by the diagram builders share the entries with the handler
+ * registered at the web server.
+ */
+class ResultCache
+{
+public:
+  typedef boost::variant<
+    std::int32_t,
+    std::string,
+    std::map<std::string, std::string>,
+    std::map<std::string, std::int32_t>> Value;
+
+  struct ValueSizer
+  {
+    std::size_t operator()(const std::string& key_, const Value& value_) const;
+  };
+
+  typedef util::LruCache<std::string, Value, ValueSizer> CacheType;
+  typedef CacheType::Statistics Statistics;
+
+  /**
+   * Returns the cache belonging to the given project directory. The cache is
+   * created on the first call, later calls ignore the capacity parameter.
+   * @param datadir_ Project directory in the workspace.
+   * @param capacity_ Maximal size of the cached results in bytes.
+   */
+  static std::shared_ptr<ResultCache> forProject(
+    const std::string& datadir_,
+    std::size_t capacity_);
+
+  ResultCache(const std::string& datadir_, std::size_t capacity_);
+  ~ResultCache();
+
+  /**
+   * Fills return_ with the cached result of the given method call. If the
+   * result is not cached yet then compute_ is called to fill return_ and the
+   * result is stored in the cache. If compute_ throws an exception then
+   * nothing is cached.
+   * @param method_ Name of the cached method.
+   * @param args_ Serialized arguments of the call.
+   * @param compute_ Functor which computes the result into its parameter.
+   */
+  template <typename Result, typename Compute>
+  void get(
+    Result& return_,
+    const std::string& method_,
+    const std::string& args_,
+    Compute compute_)
+  {
+    std::string key = makeKey(method_, args_);
+
+    Value value;
+    if (_cache.find(key, value))
+    {
+      return_ = boost::get<Result>(value);
+      return;
+    }
+
+    compute_(return_);
+    _cache.insert(key, return_);
+  }
+
+  Statistics statistics() const;
+
+private:
+  /**
+   * Builds a cache key from the current generation and the method call. The
+   * cache is cleared if the generation has changed since the last call.
+   */
+  std::string makeKey(const std::string& method_, const std::string& args_);
+
+  void logStatistics(const std::string& reason_) const;
+
+  const std::string _datadir;
+  util::ProjectGeneration _generation;
+  std::atomic<std::uint64_t> _lastGeneration;
+  CacheType _cache;
+};
+
+} // language
+} // service
+} // cc
+
+#endif // CC_SERVICE_LANGUAGE_RESULTCACHE_H
@@ -0,0 +1,24 @@
+namespace cc
+{
+namespace test
+{
+
+int callee(int x_)
+{
+  return x_ + 1;
+}
+
+int caller(int x_)
+{
+  return callee(callee(x_));
+}
+
+int topCaller(int x_)
+{
+  return caller(x_) + callee(x_);
+}
+
+int globalValue = callee(0); /*!< Called outside of a function body. */
+
+} // test
+} // cc
@@ -0,0 +1,509 @@
+#include "largeclass.h"
+
+namespace cc
+{
+namespace test
+{
+
+int LargeClass::getField0() const
+{
+  return _fields[0];
+}
+
+int LargeClass::getField1() const
+{
+  return _fields[1];
+}
+
+int LargeClass::getField2() const
+{
+  return _fields[2];
+}
+
+int LargeClass::getField3() const
+{
+  return _fields[3];
+}
+
+int LargeClass::getField4() const
+{
+  return _fields[4];
+}
+
+int LargeClass::getField5() const
+{
+  return _fields[5];
+}
+
+int LargeClass::getField6() const
+{
+  return _fields[6];
+}
+
+int LargeClass::getField7() const
+{
+  return _fields[7];
+}
+
+int LargeClass::getField8() const
+{
+  return _fields[8];
+}
+
+int LargeClass::getField9() const
+{
+  return _fields[9];
+}
+
+int LargeClass::getField10() const
+{
+  return _fields[10];
+}
+
+int LargeClass::getField11() const
+{
+  return _fields[11];
+}
+
+int LargeClass::getField12() const
+{
+  return _fields[12];
+}
+
+int LargeClass::getField13() const
+{
+  return _fields[13];
+}
+
+int LargeClass::getField14() const
+{
+  return _fields[14];
+}
+
+int LargeClass::getField15() const
+{
+  return _fields[15];
+}
+
+int LargeClass::getField16() const
+{
+  return _fields[16];
+}
+
+int LargeClass::getField17() const
+{
+  return _fields[17];
+}
+
+int LargeClass::getField18() const
+{
+  return _fields[18];
+}
+
+int LargeClass::getField19() const
+{
+  return _fields[19];
+}
+
+int LargeClass::getField20() const
+{
+  return _fields[20];
+}
+
+int LargeClass::getField21() const
+{
+  return _fields[21];
+}
+
+int LargeClass::getField22() const
+{
+  return _fields[22];
+}
+
+int LargeClass::getField23() const
+{
+  return _fields[23];
+}
+
+int LargeClass::getField24() const
+{
+  return _fields[24];
+}
+
+int LargeClass::getField25() const
+{
+  return _fields[25];
+}
+
+int LargeClass::getField26() const
+{
+  return _fields[26];
+}
+
+int LargeClass::getField27() const
+{
+  return _fields[27];
+}
+
+int LargeClass::getField28() const
+{
+  return _fields[28];
+}
+
+int LargeClass::getField29() const
+{
+  return _fields[29];
+}
+
+int LargeClass::getField30() const
+{
+  return _fields[30];
+}
+
+int LargeClass::getField31() const
+{
+  return _fields[31];
+}
+
+int LargeClass::getField32() const
+{
+  return _fields[32];
+}
+
+int LargeClass::getField33() const
+{
+  return _fields[33];
+}
+
+int LargeClass::getField34() const
+{
+  return _fields[34];
+}
+
+int LargeClass::getField35() const
+{
+  return _fields[35];
+}
+
+int LargeClass::getField36() const
+{
+  return _fields[36];
+}
+
+int LargeClass::getField37() const
+{
+  return _fields[37];
+}
+
+int LargeClass::getField38() const
+{
+  return _fields[38];
+}
+
+int LargeClass::getField39() const
+{
+  return _fields[39];
+}
+
+int LargeClass::getField40() const
+{
+  return _fields[40];
+}
+
+int LargeClass::getField41() const
+{
+  return _fields[41];
+}
+
+int LargeClass::getField42() const
+{
+  return _fields[42];
+}
+
+int LargeClass::getField43() const
+{
+  return _fields[43];
+}
+
+int LargeClass::getField44() const
+{
+  return _fields[44];
+}
+
+int LargeClass::getField45() const
+{
+  return _fields[45];
+}
+
+int LargeClass::getField46() const
+{
+  return _fields[46];
+}
+
+int LargeClass::getField47() const
+{
+  return _fields[47];
+}
+
+int LargeClass::getField48() const
+{
+  return _fields[48];
+}
+
+int LargeClass::getField49() const
+{
+  return _fields[49];
+}
+
+int LargeClass::getField50() const
+{
+  return _fields[50];
+}
+
+int LargeClass::getField51() const
+{
+  return _fields[51];
+}
+
+int LargeClass::getField52() const
+{
+  return _fields[52];
+}
+
+int LargeClass::getField53() const
+{
+  return _fields[53];
+}
+
+int LargeClass::getField54() const
+{
+  return _fields[54];
+}
+
+int LargeClass::getField55() const
+{
+  return _fields[55];
+}
+
+int LargeClass::getField56() const
+{
+  return _fields[56];
+}
+
+int LargeClass::getField57() const
+{
+  return _fields[57];
+}
+
+int LargeClass::getField58() const
+{
+  return _fields[58];
+}
+
+int LargeClass::getField59() const
+{
+  return _fields[59];
+}
+
+int LargeClass::getField60() const
+{
+  return _fields[60];
+}
+
+int LargeClass::getField61() const
+{
+  return _fields[61];
+}
+
+int LargeClass::getField62() const
+{
+  return _fields[62];
+}
+
+int LargeClass::getField63() const
+{
+  return _fields[63];
+}
+
+int LargeClass::getField64() const
+{
+  return _fields[64];
+}
+
+int LargeClass::getField65() const
+{
+  return _fields[65];
+}
+
+int LargeClass::getField66() const
+{
+  return _fields[66];
+}
+
+int LargeClass::getField67() const
+{
+  return _fields[67];
+}
+
+int LargeClass::getField68() const
+{
+  return _fields[68];
+}
+
+int LargeClass::getField69() const
+{
+  return _fields[69];
+}
+
+int LargeClass::getField70() const
+{
+  return _fields[70];
+}
+
+int LargeClass::getField71() const
+{
+  return _fields[71];
+}
+
+int LargeClass::getField72() const
+{
+  return _fields[72];
+}
+
+int LargeClass::getField73() const
+{
+  return _fields[73];
+}
+
+int LargeClass::getField74() const
+{
+  return _fields[74];
+}
+
+int LargeClass::getField75() const
+{
+  return _fields[75];
+}
+
+int LargeClass::getField76() const
+{
+  return _fields[76];
+}
+
+int LargeClass::getField77() const
+{
+  return _fields[77];
+}
+
+int LargeClass::getField78() const
+{
+  return _fields[78];
+}
+
+int LargeClass::getField79() const
+{
+  return _fields[79];
+}
+
+int LargeClass::getField80() const
+{
+  return _fields[80];
+}
+
+int LargeClass::getField81() const
+{
+  return _fields[81];
+}
+
+int LargeClass::getField82() const
+{
+  return _fields[82];
+}
+
+int LargeClass::getField83() const
+{
+  return _fields[83];
+}
+
+int LargeClass::getField84() const
+{
+  return _fields[84];
+}
+
+int LargeClass::getField85() const
+{
+  return _fields[85];
+}
+
+int LargeClass::getField86() const
+{
+  return _fields[86];
+}
+
+int LargeClass::getField87() const
+{
+  return _fields[87];
+}
+
+int LargeClass::getField88() const
+{
+  return _fields[88];
+}
+
+int LargeClass::getField89() const
+{
+  return _fields[89];
+}
+
+int LargeClass::getField90() const
+{
+  return _fields[90];
+}
+
+int LargeClass::getField91() const
+{
+  return _fields[91];
+}
+
+int LargeClass::getField92() const
+{
+  return _fields[92];
+}
+
+int LargeClass::getField93() const
+{
+  return _fields[93];
+}
+
+int LargeClass::getField94() const
+{
+  return _fields[94];
+}
+
+int LargeClass::getField95() const
+{
+  return _fields[95];
+}
+
+int LargeClass::getField96() const
+{
+  return _fields[96];
+}
+
+int LargeClass::getField97() const
+{
+  return _fields[97];
+}
+
+int LargeClass::getField98() const
+{
+  return _fields[98];
+}
+
+int LargeClass::getField99() const
+{
+  return _fields[99];
+}
+
+} // test
+} // cc
@@ -0,0 +1,523 @@
+#ifndef CC_TEST_LARGECLASS_H
+#define CC_TEST_LARGECLASS_H
+
+namespace cc
+{
+namespace test
+{
+
+/**
+ * A class with many documented methods. It is used for measuring the
+ * latency of the documentation query.
+ */
+class LargeClass
+{
+public:
+  /**
+   * Returns the value of field 0.
+   */
+  int getField0() const;
+
+  /**
+   * Returns the value of field 1.
+   */
+  int getField1() const;
+
+  /**
+   * Returns the value of field 2.
+   */
+  int getField2() const;
+
+  /**
+   * Returns the value of field 3.
+   */
+  int getField3() const;
+
+  /**
+   * Returns the value of field 4.
+   */
+  int getField4() const;
+
+  /**
+   * Returns the value of field 5.
+   */
+  int getField5() const;
+
+  /**
+   * Returns the value of field 6.
+   */
+  int getField6() const;
+
+  /**
+   * Returns the value of field 7.
+   */
+  int getField7() const;
+
+  /**
+   * Returns the value of field 8.
+   */
+  int getField8() const;
+
+  /**
+   * Returns the value of field 9.
+   */
+  int getField9() const;
+
+  /**
+   * Returns the value of field 10.
+   */
+  int getField10() const;
+
+  /**
+   * Returns the value of field 11.
+   */
+  int getField11() const;
+
+  /**
+   * Returns the value of field 12.
+   */
+  int getField12() const;
+
+  /**
+   * Returns the value of field 13.
+   */
+  int getField13() const;
+
+  /**
+   * Returns the value of field 14.
+   */
+  int getField14() const;
+
+  /**
+   * Returns the value of field 15.
+   */
+  int getField15() const;
+
+  /**
+   * Returns the value of field 16.
+   */
+  int getField16() const;
+
+  /**
+   * Returns the value of field 17.
+   */
+  int getField17() const;
+
+  /**
+   * Returns the value of field 18.
+   */
+  int getField18() const;
+
+  /**
+   * Returns the value of field 19.
+   */
+  int getField19() const;
+
+  /**
+   * Returns the value of field 20.
+   */
+  int getField20() const;
+
+  /**
+   * Returns the value of field 21.
+   */
+  int getField21() const;
+
+  /**
+   * Returns the value of field 22.
+   */
+  int getField22() const;
+
+  /**
+   * Returns the value of field 23.
+   */
+  int getField23() const;
+
+  /**
+   * Returns the value of field 24.
+   */
+  int getField24() const;
+
+  /**
+   * Returns the value of field 25.
+   */
+  int getField25() const;
+
+  /**
+   * Returns the value of field 26.
+   */
+  int getField26() const;
+
+  /**
+   * Returns the value of field 27.
+   */
+  int getField27() const;
+
+  /**
+   * Returns the value of field 28.
+   */
+  int getField28() const;
+
+  /**
+   * Returns the value of field 29.
+   */
+  int getField29() const;
+
+  /**
+   * Returns the value of field 30.
+   */
+  int getField30() const;
+
+  /**
+   * Returns the value of field 31.
+   */
+  int getField31() const;
+
+  /**
+   * Returns the value of field 32.
+   */
+  int getField32() const;
+
+  /**
+   * Returns the value of field 33.
+   */
+  int getField33() const;
+
+  /**
+   * Returns the value of field 34.
+   */
+  int getField34() const;
+
+  /**
+   * Returns the value of field 35.
+   */
+  int getField35() const;
+
+  /**
+   * Returns the value of field 36.
+   */
+  int getField36() const;
+
+  /**
+   * Returns the value of field 37.
+   */
+  int getField37() const;
+
+  /**
+   * Returns the value of field 38.
+   */
+  int getField38() const;
+
+  /**
+   * Returns the value of field 39.
+   */
+  int getField39() const;
+
+  /**
+   * Returns the value of field 40.
+   */
+  int getField40() const;
+
+  /**
+   * Returns the value of field 41.
+   */
+  int getField41() const;
+
+  /**
+   * Returns the value of field 42.
+   */
+  int getField42() const;
+
+  /**
+   * Returns the value of field 43.
+   */
+  int getField43() const;
+
+  /**
+   * Returns the value of field 44.
+   */
+  int getField44() const;
+
+  /**
+   * Returns the value of field 45.
+   */
+  int getField45() const;
+
+  /**
+   * Returns the value of field 46.
+   */
+  int getField46() const;
+
+  /**
+   * Returns the value of field 47.
+   */
+  int getField47() const;
+
+  /**
+   * Returns the value of field 48.
+   */
+  int getField48() const;
+
+  /**
+   * Returns the value of field 49.
+   */
+  int getField49() const;
+
+  /**
+   * Returns the value of field 50.
+   */
+  int getField50() const;
+
+  /**
+   * Returns the value of field 51.
+   */
+  int getField51() const;
+
+  /**
+   * Returns the value of field 52.
+   */
+  int getField52() const;
+
+  /**
+   * Returns the value of field 53.
+   */
+  int getField53() const;
+
+  /**
+   * Returns the value of field 54.
+   */
+  int getField54() const;
+
+  /**
+   * Returns the value of field 55.
+   */
+  int getField55() const;
+
+  /**
+   * Returns the value of field 56.
+   */
+  int getField56() const;
+
+  /**
+   * Returns the value of field 57.
+   */
+  int getField57() const;
+
+  /**
+   * Returns the value of field 58.
+   */
+  int getField58() const;
+
+  /**
+   * Returns the value of field 59.
+   */
+  int getField59() const;
+
+  /**
+   * Returns the value of field 60.
+   */
+  int getField60() const;
+
+  /**
+   * Returns the value of field 61.
+   */
+  int getField61() const;
+
+  /**
+   * Returns the value of field 62.
+   */
+  int getField62() const;
+
+  /**
+   * Returns the value of field 63.
+   */
+  int getField63() const;
+
+  /**
+   * Returns the value of field 64.
+   */
+  int getField64() const;
+
+  /**
+   * Returns the value of field 65.
+   */
+  int getField65() const;
+
+  /**
+   * Returns the value of field 66.
+   */
+  int getField66() const;
+
+  /**
+   * Returns the value of field 67.
+   */
+  int getField67() const;
+
+  /**
+   * Returns the value of field 68.
+   */
+  int getField68() const;
+
+  /**
+   * Returns the value of field 69.
+   */
+  int getField69() const;
+
+  /**
+   * Returns the value of field 70.
+   */
+  int getField70() const;
+
+  /**
+   * Returns the value of field 71.
+   */
+  int getField71() const;
+
+  /**
+   * Returns the value of field 72.
+   */
+  int getField72() const;
+
+  /**
+   * Returns the value of field 73.
+   */
+  int getField73() const;
+
+  /**
+   * Returns the value of field 74.
+   */
+  int getField74() const;
+
+  /**
+   * Returns the value of field 75.
+   */
+  int getField75() const;
+
+  /**
+   * Returns the value of field 76.
+   */
+  int getField76() const;
+
+  /**
+   * Returns the value of field 77.
+   */
+  int getField77() const;
+
+  /**
+   * Returns the value of field 78.
+   */
+  int getField78() const;
+
+  /**
+   * Returns the value of field 79.
+   */
+  int getField79() const;
+
+  /**
+   * Returns the value of field 80.
+   */
+  int getField80() const;
+
+  /**
+   * Returns the value of field 81.
+   */
+  int getField81() const;
+
+  /**
+   * Returns the value of field 82.
+   */
+  int getField82() const;
+
+  /**
+   * Returns the value of field 83.
+   */
+  int getField83() const;
+
+  /**
+   * Returns the value of field 84.
+   */
+  int getField84() const;
+
+  /**
+   * Returns the value of field 85.
+   */
+  int getField85() const;
+
+  /**
+   * Returns the value of field 86.
+   */
+  int getField86() const;
+
+  /**
+   * Returns the value of field 87.
+   */
+  int getField87() const;
+
+  /**
+   * Returns the value of field 88.
+   */
+  int getField88() const;
+
+  /**
+   * Returns the value of field 89.
+   */
+  int getField89() const;
+
+  /**
+   * Returns the value of field 90.
+   */
+  int getField90() const;
+
+  /**
+   * Returns the value of field 91.
+   */
+  int getField91() const;
+
+  /**
+   * Returns the value of field 92.
+   */
+  int getField92() const;
+
+  /**
+   * Returns the value of field 93.
+   */
+  int getField93() const;
+
+  /**
+   * Returns the value of field 94.
+   */
+  int getField94() const;
+
+  /**
+   * Returns the value of field 95.
+   */
+  int getField95() const;
+
+  /**
+   * Returns the value of field 96.
+   */
+  int getField96() const;
+
+  /**
+   * Returns the value of field 97.
+   */
+  int getField97() const;
+
+  /**
+   * Returns the value of field 98.
+   */
+  int getField98() const;
+
+  /**
+   * Returns the value of field 99.
+   */
+  int getField99() const;
+
+private:
+  int _fields[100];
+};
+
+} // test
+} // cc
+
+#endif // CC_TEST_LARGECLASS_H
@@ -0,0 +1,175 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <model/file.h>
+#include <model/file-odb.hxx>
+
+#include <service/cppservice.h>
+
+#include <util/dbutil.h>
+#include <util/graph.h>
+
+using namespace cc;
+using namespace cc::service::language;
+
+namespace po = boost::program_options;
+
+typedef odb::query<model::File> FileQuery;
+
+extern const char* dbConnectionString;
+
+/**
+ * These tests check the depth and fan-out limits of the subsystem dependency
+ * diagram on the directories of the test project, from the root directory
+ * down to the sources.
+ */
+class CppFileDiagramTest : public ::testing::Test
+{
+public:
+  CppFileDiagramTest() :
+    _db(cc::util::connectDatabase(dbConnectionString)),
+    _transaction(_db)
+  {
+    _transaction([this](){
+      for (const model::File& dir : _db->query<model::File>(
+        FileQuery::type == model::File::DIRECTORY_TYPE))
+      {
+        if (dir.path == "/")
+          _root = dir.id;
+        else
+          _subdirs[dir.parent.object_id()].push_back(dir.id);
+      }
+    });
+  }
+
+protected:
+  /**
+   * Draws the subsystem dependency diagram of the directory with the given
+   * limits.
+   */
+  util::Graph subsystemDiagram(
+    model::FileId dir_,
+    std::size_t depth_,
+    std::size_t fanOut_)
+  {
+    po::variables_map options;
+    options.insert(std::make_pair("cpp-subsystem-diagram-depth",
+      po::variable_value(depth_, false)));
+    options.insert(std::make_pair("cpp-subsystem-diagram-fanout",
+      po::variable_value(fanOut_, false)));
+
+    cc::webserver::ServerContext context(_compassRoot, options);
+    CppServiceHandler handler(_db, std::make_shared<std::string>(""), context);
+
+    return handler.returnFileDiagram(
+      std::to_string(dir_), CppServiceHandler::SUBSYSTEM_DEPENDENCY);
+  }
+
+  const std::vector<model::FileId>& subdirs(model::FileId dir_)
+  {
+    return _subdirs[dir_];
+  }
+
+  static std::string moreNode(model::FileId dir_)
+  {
+    return "more:" + std::to_string(dir_);
+  }
+
+  std::shared_ptr<odb::database> _db;
+  util::OdbTransaction _transaction;
+  const std::string _compassRoot;
+
+  model::FileId _root = 0;
+  std::map<model::FileId, std::vector<model::FileId>> _subdirs;
+};
+
+TEST_F(CppFileDiagramTest, DepthLimit)
+{
+  ASSERT_NE(0u, _root);
+  ASSERT_FALSE(subdirs(_root).empty());
+
+  _transaction([this](){
+    util::Graph graph = subsystemDiagram(_root, 1, 1000);
+
+    // Only the subdirectories of the root are shown.
+    EXPECT_EQ(1 + subdirs(_root).size(),
+      static_cast<std::size_t>(graph.nodeCount()));
+
+    for (model::FileId dir : subdirs(_root))
+    {
+      EXPECT_TRUE(graph.hasNode(std::to_string(dir)));
+      EXPECT_FALSE(graph.hasNode(moreNode(dir)));
+
+      for (model::FileId subdir : subdirs(dir))
+        EXPECT_FALSE(graph.hasNode(std::to_string(subdir)));
+    }
+  });
+}
+
+TEST_F(CppFileDiagramTest, FanOutLimit)
+{
+  ASSERT_NE(0u, _root);
+
+  _transaction([this](){
+    util::Graph graph = subsystemDiagram(_root, 2, 0);
+    int nodes = 1;
+    int aggregated = 0;
+
+    // The root shows all of its subdirectories, but the subdirectories of
+    // those are aggregated to one node per directory.
+    for (model::FileId dir : subdirs(_root))
+    {
+      EXPECT_TRUE(graph.hasNode(std::to_string(dir)));
+      ++nodes;
+
+      if (subdirs(dir).empty())
+      {
+        EXPECT_FALSE(graph.hasNode(moreNode(dir)));
+        continue;
+      }
+
+      ASSERT_TRUE(graph.hasNode(moreNode(dir)));
+      EXPECT_TRUE(graph.hasEdge(std::to_string(dir), moreNode(dir)));
+      EXPECT_EQ(
+        std::to_string(subdirs(dir).size()) + " more directories",
+        graph.getNodeAttribute(moreNode(dir), "label"));
+
+      // The aggregated node doesn't reuse the ID of its parent.
+      EXPECT_EQ(moreNode(dir), graph.getNodeAttribute(moreNode(dir), "id"));
+
+      for (model::FileId subdir : subdirs(dir))
+        EXPECT_FALSE(graph.hasNode(std::to_string(subdir)));
+
+      ++nodes;
+      ++aggregated;
+    }
+
+    // The sources of the test project are a few levels below the root.
+    EXPECT_LT(0, aggregated);
+    EXPECT_EQ(nodes, graph.nodeCount());
+  });
+}
+
+TEST_F(CppFileDiagramTest, AggregatedNodeExpandsParent)
+{
+  ASSERT_NE(0u, _root);
+
+  po::variables_map options;
+  cc::webserver::ServerContext context(_compassRoot, options);
+  CppServiceHandler handler(_db, std::make_shared<std::string>(""), context);
+
+  std::string parent, aggregated;
+
+  handler.getFileDiagramGraph(
+    parent, std::to_string(_root), CppServiceHandler::SUBSYSTEM_DEPENDENCY);
+  handler.getFileDiagramGraph(
+    aggregated, moreNode(_root), CppServiceHandler::SUBSYSTEM_DEPENDENCY);
+
+  EXPECT_EQ(parent, aggregated);
+}
@@ -1,8 +1,14 @@
 #define GTEST_HAS_TR1_TUPLE 1
 #define GTEST_USE_OWN_TR1_TUPLE 0
 
+#include <set>
+#include <tuple>
+
 #include <gtest/gtest.h>
 
+#include <model/cppcalledge.h>
+#include <model/cppcalledge-odb.hxx>
+
 #include <service/cppservice.h>
 
 #include <util/dbutil.h>
@@ -13,6 +19,10 @@ using namespace cc;
 using namespace cc::service;
 using namespace cc::service::test;
 
+typedef odb::query<model::CppAstNode> AstQuery;
+typedef odb::result<model::CppAstNode> AstResult;
+typedef odb::query<model::CppCallEdge> CallEdgeQuery;
+
 class CppReferenceServiceTest : public ::testing::Test
 {
 public:
@@ -34,6 +44,8 @@ public:
 
     _inheritanceClassHeader = _helper.getFileId("inheritance.h");
     _inheritanceClassSrc = _helper.getFileId("inheritance.cpp");
+
+    _callsSrc = _helper.getFileId("calls.cpp");
   }
 
   /**
@@ -52,7 +64,143 @@ public:
       { {"Definition", expectedLines_} });
   }
 
+  /**
+   * This function checks that the call references of a clicked function are
+   * the same as the ones found by the AST node positions, the way they were
+   * looked up before the call graph edges were stored.
+   */
+  void checkCallReferences(int line_, int col_, model::FileId fileId_)
+  {
+    core::AstNodeId nodeId
+      = _helper.getAstNodeInfoByPos(line_, col_, fileId_).id;
+
+    _transaction([&, this](){
+      model::CppAstNode node
+        = *_db->load<model::CppAstNode>(std::stoull(nodeId));
+
+      std::vector<model::CppAstNode> calls = callsByPosition(node.entityHash);
+
+      std::set<std::uint64_t> callees;
+      for (const model::CppAstNode& call : calls)
+        callees.insert(call.entityHash);
+
+      std::set<std::uint64_t> callers;
+      for (const model::CppAstNode& usage : _db->query<model::CppAstNode>(
+        AstQuery::entityHash == node.entityHash &&
+        AstQuery::astType == model::CppAstNode::AstType::Usage))
+      {
+        for (const model::CppAstNode& def : enclosingFunctions(usage))
+          callers.insert(def.entityHash);
+      }
+
+      EXPECT_EQ(idSet(calls),
+        references(nodeId, CppServiceHandler::THIS_CALLS));
+      EXPECT_EQ(idSet(definitions(callees)),
+        references(nodeId, CppServiceHandler::CALLEE));
+      EXPECT_EQ(idSet(definitions(callers)),
+        references(nodeId, CppServiceHandler::CALLER));
+    });
+  }
+
 protected:
+  std::set<core::AstNodeId> references(
+    const core::AstNodeId& nodeId_,
+    CppServiceHandler::ReferenceType referenceType_)
+  {
+    std::vector<AstNodeInfo> refs;
+    _cppservice->getReferences(refs, nodeId_, referenceType_, {});
+
+    std::set<core::AstNodeId> ids;
+    for (const AstNodeInfo& reference : refs)
+      ids.insert(reference.id);
+
+    return ids;
+  }
+
+  static std::set<core::AstNodeId> idSet(
+    const std::vector<model::CppAstNode>& nodes_)
+  {
+    std::set<core::AstNodeId> ids;
+    for (const model::CppAstNode& node : nodes_)
+      ids.insert(std::to_string(node.id));
+
+    return ids;
+  }
+
+  /**
+   * Returns the function definitions of the given entities.
+   */
+  std::vector<model::CppAstNode> definitions(
+    const std::set<std::uint64_t>& entityHashes_)
+  {
+    std::vector<model::CppAstNode> nodes;
+
+    for (std::uint64_t entityHash : entityHashes_)
+    {
+      AstResult result = _db->query<model::CppAstNode>(
+        AstQuery::entityHash == entityHash &&
+        AstQuery::astType == model::CppAstNode::AstType::Definition &&
+        AstQuery::location.range.end.line != model::Position::npos);
+      nodes.insert(nodes.end(), result.begin(), result.end());
+    }
+
+    return nodes;
+  }
+
+  /**
+   * Returns the function calls which are located in the range of the
+   * definitions of the given function.
+   */
+  std::vector<model::CppAstNode> callsByPosition(std::uint64_t entityHash_)
+  {
+    std::vector<model::CppAstNode> calls;
+
+    for (const model::CppAstNode& def : definitions({entityHash_}))
+    {
+      const model::Position& start = def.location.range.start;
+      const model::Position& end = def.location.range.end;
+
+      AstResult result = _db->query<model::CppAstNode>(
+        AstQuery::location.file == def.location.file.object_id() &&
+        (AstQuery::astType == model::CppAstNode::AstType::Usage ||
+         AstQuery::astType == model::CppAstNode::AstType::VirtualCall) &&
+        AstQuery::symbolType == model::CppAstNode::SymbolType::Function &&
+        ((AstQuery::location.range.start.line == start.line &&
+          AstQuery::location.range.start.column >= start.column) ||
+         AstQuery::location.range.start.line > start.line) &&
+        ((AstQuery::location.range.end.line == end.line &&
+          AstQuery::location.range.end.column < end.column) ||
+         AstQuery::location.range.end.line < end.line));
+
+      calls.insert(calls.end(), result.begin(), result.end());
+    }
+
+    return calls;
+  }
+
+  /**
+   * Returns the function definitions which contain the given AST node.
+   */
+  std::vector<model::CppAstNode> enclosingFunctions(
+    const model::CppAstNode& node_)
+  {
+    const model::Position& start = node_.location.range.start;
+    const model::Position& end = node_.location.range.end;
+
+    AstResult result = _db->query<model::CppAstNode>(
+      AstQuery::astType == model::CppAstNode::AstType::Definition &&
+      AstQuery::symbolType == model::CppAstNode::SymbolType::Function &&
+      AstQuery::location.file == node_.location.file.object_id() &&
+      ((AstQuery::location.range.start.line == start.line &&
+        AstQuery::location.range.start.column <= start.column) ||
+       AstQuery::location.range.start.line < start.line) &&
+      ((AstQuery::location.range.end.line == end.line &&
+        AstQuery::location.range.end.column > end.column) ||
+       AstQuery::location.range.end.line > end.line));
+
+    return std::vector<model::CppAstNode>(result.begin(), result.end());
+  }
+
   std::shared_ptr<odb::database> _db;
   cc::util::OdbTransaction _transaction;
   std::shared_ptr<CppServiceHandler> _cppservice;
@@ -66,6 +214,8 @@ protected:
 
   model::FileId _inheritanceClassHeader;
   model::FileId _inheritanceClassSrc;
+
+  model::FileId _callsSrc;
 };
 
 /******************************************************************************
@@ -193,3 +343,138 @@ TEST_F(CppReferenceServiceTest, DerivedClassTest)
   _helper.checkReferences(8,  15, _inheritanceClassSrc, expected);
   _helper.checkReferences(50, 10, _inheritanceClassSrc, expected);
 }
+
+/******************************************************************************
+ *                            Call references
+ ******************************************************************************/
+
+TEST_F(CppReferenceServiceTest, CallEdgeTest)
+{
+  core::AstNodeId calleeId = _helper.getAstNodeInfoByPos(6, 5, _callsSrc).id;
+  core::AstNodeId callerId = _helper.getAstNodeInfoByPos(11, 5, _callsSrc).id;
+
+  _transaction([&, this](){
+    model::CppAstNode callee
+      = *_db->load<model::CppAstNode>(std::stoull(calleeId));
+    model::CppAstNode caller
+      = *_db->load<model::CppAstNode>(std::stoull(callerId));
+
+    std::multiset<std::size_t> lines;
+    for (const model::CppCallEdge& edge : _db->query<model::CppCallEdge>(
+      CallEdgeQuery::callee == callee.entityHash))
+    {
+      EXPECT_FALSE(edge.virtualCall);
+      lines.insert(edge.callSite.load()->location.range.start.line);
+
+      if (edge.callSite->location.range.start.line == 13)
+        EXPECT_EQ(caller.entityHash, edge.caller);
+    }
+
+    // The call in the initializer of the global variable (line 21) is not in
+    // a function body, so it has no edge.
+    EXPECT_EQ(std::multiset<std::size_t>({13, 13, 18}), lines);
+  });
+}
+
+TEST_F(CppReferenceServiceTest, CallReferencesTest)
+{
+  _helper.checkReferences(6, 5, _callsSrc, {
+    {"Caller", {11, 16}}, /*!< caller, topCaller; not the global variable */
+    {"This calls", {}}});
+
+  _helper.checkReferences(11, 5, _callsSrc, {
+    {"Caller", {16}},
+    {"Callee", {6}},
+    {"This calls", {13, 13}}});
+
+  _helper.checkReferences(16, 5, _callsSrc, {
+    {"Caller", {}},
+    {"Callee", {6, 11}},
+    {"This calls", {18, 18}}});
+}
+
+TEST_F(CppReferenceServiceTest, CallReferencesMatchPositionsTest)
+{
+  checkCallReferences(6, 5, _callsSrc);
+  checkCallReferences(11, 5, _callsSrc);
+  checkCallReferences(16, 5, _callsSrc);
+}
+
+TEST_F(CppReferenceServiceTest, CallGraphTest)
+{
+  std::uint64_t callee
+    = _helper.getAstNodeInfoByPos(6, 5, _callsSrc).entityHash;
+  std::uint64_t caller
+    = _helper.getAstNodeInfoByPos(11, 5, _callsSrc).entityHash;
+  std::uint64_t topCaller
+    = _helper.getAstNodeInfoByPos(16, 5, _callsSrc).entityHash;
+
+  typedef std::tuple<std::uint64_t, std::uint64_t, std::size_t> Edge;
+  typedef std::set<Edge> EdgeSet;
+
+  auto edgeSet = [](const std::vector<model::CppCallGraphEdge>& edges_)
+  {
+    EdgeSet edges;
+    for (const model::CppCallGraphEdge& edge : edges_)
+      edges.insert(Edge(edge.caller, edge.callee, edge.depth));
+    return edges;
+  };
+
+  EXPECT_EQ(
+    EdgeSet({
+      Edge(topCaller, caller, 1),
+      Edge(topCaller, callee, 1)}),
+    edgeSet(_cppservice->queryCallGraph(topCaller, 1)));
+
+  EXPECT_EQ(
+    EdgeSet({
+      Edge(topCaller, caller, 1),
+      Edge(topCaller, callee, 1),
+      Edge(caller, callee, 2)}),
+    edgeSet(_cppservice->queryCallGraph(topCaller, 2)));
+
+  EXPECT_EQ(
+    EdgeSet({
+      Edge(caller, callee, 1),
+      Edge(topCaller, callee, 1),
+      Edge(topCaller, caller, 2)}),
+    edgeSet(_cppservice->queryCallGraph(callee, 3, true)));
+
+  EXPECT_TRUE(_cppservice->queryCallGraph(callee, 3).empty());
+}
+
+/******************************************************************************
+ *                            Batch queries
+ ******************************************************************************/
+
+TEST_F(CppReferenceServiceTest, ReferenceCountBatchTest)
+{
+  std::vector<core::AstNodeId> nodeIds = {
+    _helper.getAstNodeInfoByPos(9,  13, _inheritanceClassHeader).id,
+    _helper.getAstNodeInfoByPos(21, 13, _inheritanceClassHeader).id,
+    _helper.getAstNodeInfoByPos(31, 13, _inheritanceClassHeader).id,
+    _helper.getAstNodeInfoByPos(50, 10, _inheritanceClassSrc).id};
+
+  std::vector<std::int32_t> referenceIds = {
+    CppServiceHandler::DEFINITION,
+    CppServiceHandler::DECLARATION,
+    CppServiceHandler::USAGE,
+    CppServiceHandler::METHOD,
+    CppServiceHandler::INHERIT_FROM};
+
+  std::map<core::AstNodeId, std::map<std::int32_t, std::int32_t>> counts;
+
+  _transaction([&, this](){
+    _cppservice->getReferenceCountBatch(counts, nodeIds, referenceIds);
+  });
+
+  ASSERT_EQ(nodeIds.size(), counts.size());
+
+  for (std::size_t i = 0; i < nodeIds.size(); ++i)
+  {
+    for (std::int32_t referenceId : referenceIds)
+      EXPECT_EQ(
+        _cppservice->getReferenceCount(nodeIds[i], referenceId),
+        counts[nodeIds[i]][referenceId]);
+  }
+}
@@ -0,0 +1,325 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <service/cppservice.h>
+
+#include <util/dbutil.h>
+#include <util/graphlayout.h>
+#include <util/logutil.h>
+
+#include "servicehelper.h"
+
+using namespace cc;
+using namespace cc::service::test;
+
+namespace po = boost::program_options;
+
+/**
+ * These tests measure the latency of the hot C++ service queries. The
+ * prepared and dynamic query configurations are compared and their results
+ * must be the same. The latencies are mostly logged only since they depend on
+ * the machine and on the database backend.
+ */
+class CppServiceLatencyTest : public ::testing::Test
+{
+public:
+  CppServiceLatencyTest() :
+    _db(cc::util::connectDatabase(dbConnectionString)),
+    _transaction(_db),
+    _preparedOptions(createOptions(true)),
+    _dynamicOptions(createOptions(false)),
+    _preparedContext(_compassRoot, _preparedOptions),
+    _dynamicContext(_compassRoot, _dynamicOptions),
+    _prepared(new CppServiceHandler(
+      _db, std::make_shared<std::string>(""), _preparedContext)),
+    _dynamic(new CppServiceHandler(
+      _db, std::make_shared<std::string>(""), _dynamicContext))
+  {
+    ServiceHelper helper(_db, _prepared);
+
+    for (const char* file : {
+      "simpleclass.h", "simpleclass.cpp", "inheritance.h", "inheritance.cpp"})
+    {
+      model::FileId fileId = helper.getFileId(file);
+
+      _transaction([&, this](){
+        for (const model::CppAstNode& node : _db->query<model::CppAstNode>(
+          odb::query<model::CppAstNode>::location.file == fileId &&
+          odb::query<model::CppAstNode>::visibleInSourceCode == true))
+        {
+          core::FilePosition fpos;
+          fpos.file = std::to_string(fileId);
+          fpos.pos.line = node.location.range.start.line;
+          fpos.pos.column = node.location.range.start.column;
+
+          _positions.push_back(fpos);
+          _nodeIds.push_back(std::to_string(node.id));
+        }
+      });
+    }
+  }
+
+protected:
+  static po::variables_map createOptions(bool prepared_)
+  {
+    po::variables_map options;
+
+    // The result cache would hide the cost of the queries.
+    options.insert(std::make_pair("cpp-result-cache-size",
+      po::variable_value(std::size_t(0), false)));
+    options.insert(std::make_pair("cpp-prepared-queries",
+      po::variable_value(prepared_, false)));
+
+    return options;
+  }
+
+  /**
+   * Returns the given percentile of the sorted latency samples.
+   */
+  static double percentile(const std::vector<double>& sorted_, double p_)
+  {
+    if (sorted_.empty())
+      return 0;
+
+    std::size_t index = static_cast<std::size_t>(p_ * (sorted_.size() - 1));
+    return sorted_[index];
+  }
+
+  /**
+   * Calls the function and appends its running time in microseconds to the
+   * samples.
+   */
+  template <typename F>
+  void measure(std::vector<double>& samples_, F func_)
+  {
+    auto start = std::chrono::steady_clock::now();
+    func_();
+    auto end = std::chrono::steady_clock::now();
+
+    samples_.push_back(
+      std::chrono::duration<double, std::micro>(end - start).count());
+  }
+
+  void report(
+    const std::string& method_,
+    std::vector<double>& prepared_,
+    std::vector<double>& dynamic_)
+  {
+    std::sort(prepared_.begin(), prepared_.end());
+    std::sort(dynamic_.begin(), dynamic_.end());
+
+    LOG(info)
+      << method_ << " latency over " << prepared_.size() << " calls (us): "
+      << "prepared p50 = " << percentile(prepared_, 0.5)
+      << ", p99 = " << percentile(prepared_, 0.99) << "; "
+      << "dynamic p50 = " << percentile(dynamic_, 0.5)
+      << ", p99 = " << percentile(dynamic_, 0.99);
+  }
+
+  static std::vector<core::AstNodeId> sortedIds(
+    const std::vector<AstNodeInfo>& nodes_)
+  {
+    std::vector<core::AstNodeId> ids;
+    for (const AstNodeInfo& node : nodes_)
+      ids.push_back(node.id);
+
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  }
+
+  static const int _rounds = 10;
+
+  std::shared_ptr<odb::database> _db;
+  cc::util::OdbTransaction _transaction;
+
+  std::string _compassRoot;
+  po::variables_map _preparedOptions;
+  po::variables_map _dynamicOptions;
+  cc::webserver::ServerContext _preparedContext;
+  cc::webserver::ServerContext _dynamicContext;
+
+  std::shared_ptr<CppServiceHandler> _prepared;
+  std::shared_ptr<CppServiceHandler> _dynamic;
+
+  std::vector<core::FilePosition> _positions;
+  std::vector<core::AstNodeId> _nodeIds;
+};
+
+TEST_F(CppServiceLatencyTest, AstNodeInfoByPosition)
+{
+  std::vector<double> prepared, dynamic;
+
+  for (int i = 0; i < _rounds; ++i)
+    for (const core::FilePosition& fpos : _positions)
+    {
+      AstNodeInfo preparedInfo, dynamicInfo;
+
+      measure(prepared, [&, this](){
+        _prepared->getAstNodeInfoByPosition(preparedInfo, fpos);
+      });
+      measure(dynamic, [&, this](){
+        _dynamic->getAstNodeInfoByPosition(dynamicInfo, fpos);
+      });
+
+      EXPECT_EQ(dynamicInfo.id, preparedInfo.id);
+    }
+
+  report("getAstNodeInfoByPosition", prepared, dynamic);
+}
+
+TEST_F(CppServiceLatencyTest, References)
+{
+  std::vector<double> prepared, dynamic;
+
+  for (int i = 0; i < _rounds; ++i)
+    for (const core::AstNodeId& nodeId : _nodeIds)
+      for (std::int32_t refType : {
+        CppServiceHandler::DEFINITION,
+        CppServiceHandler::THIS_CALLS,
+        CppServiceHandler::CALLS_OF_THIS,
+        CppServiceHandler::CALLEE,
+        CppServiceHandler::CALLER})
+      {
+        std::vector<AstNodeInfo> preparedRefs, dynamicRefs;
+
+        measure(prepared, [&, this](){
+          _prepared->getReferences(preparedRefs, nodeId, refType, {});
+        });
+        measure(dynamic, [&, this](){
+          _dynamic->getReferences(dynamicRefs, nodeId, refType, {});
+        });
+
+        EXPECT_EQ(sortedIds(dynamicRefs), sortedIds(preparedRefs));
+      }
+
+  report("getReferences", prepared, dynamic);
+}
+
+TEST_F(CppServiceLatencyTest, DocumentationOfLargeClass)
+{
+  ServiceHelper helper(_db, _prepared);
+  AstNodeInfo largeClass = helper.getAstNodeInfoByPos(
+    13, 10, helper.getFileId("largeclass.h"));
+
+  std::vector<double> latencies;
+  std::string documentation;
+
+  for (int i = 0; i < _rounds; ++i)
+  {
+    documentation.clear();
+
+    measure(latencies, [&, this](){
+      _prepared->getDocumentation(documentation, largeClass.id);
+    });
+  }
+
+  for (int i = 0; i < 100; ++i)
+  {
+    std::string field = std::to_string(i);
+
+    EXPECT_NE(std::string::npos, documentation.find("getField" + field + "("));
+    EXPECT_NE(std::string::npos, documentation.find("field " + field + "."));
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  LOG(info)
+    << "getDocumentation latency of a class with 100 methods (us): "
+    << "p50 = " << percentile(latencies, 0.5)
+    << ", p99 = " << percentile(latencies, 0.99);
+
+  // The documentation is built by a constant number of queries, so even a
+  // slow database should serve it well within a second.
+  EXPECT_GT(1e6, percentile(latencies, 0.99));
+}
+
+TEST_F(CppServiceLatencyTest, CachedDiagram)
+{
+  ServiceHelper helper(_db, _prepared);
+  AstNodeInfo largeClass = helper.getAstNodeInfoByPos(
+    13, 10, helper.getFileId("largeclass.h"));
+
+  cc::util::GraphLayout::Options layoutOptions;
+  layoutOptions.worker = GRAPH_LAYOUT_WORKER;
+  cc::util::GraphLayout::instance().configure(layoutOptions);
+
+  // The handlers of the same project share the diagram cache.
+  std::shared_ptr<cc::util::DiagramCache> cache
+    = cc::util::DiagramCache::forProject("", 0, false);
+  cc::util::DiagramCache::Statistics before = cache->statistics();
+
+  std::vector<double> latencies;
+  std::string first, diagram;
+
+  for (int i = 0; i < _rounds; ++i)
+  {
+    diagram.clear();
+
+    measure(latencies, [&, this](){
+      _prepared->getDiagram(
+        diagram, largeClass.id, CppServiceHandler::DETAILED_CLASS);
+    });
+
+    if (i == 0)
+      first = diagram;
+
+    EXPECT_EQ(first, diagram);
+  }
+
+  cc::util::DiagramCache::Statistics after = cache->statistics();
+
+  // The error image of a failed layout is an SVG too, so the nodes of the
+  // graph are looked for.
+  EXPECT_NE(first, cc::util::GraphLayout::messageSvg(
+    "This diagram is too complex to be rendered in time."));
+  EXPECT_NE(std::string::npos, first.find("class=\"node\""));
+  EXPECT_NE(std::string::npos, first.find("id=\"" + largeClass.id + "\""));
+  EXPECT_NE(std::string::npos, first.find("getField99"));
+  EXPECT_EQ(before.dot.hits + _rounds - 1, after.dot.hits);
+
+  LOG(info)
+    << "getDiagram latency of a class with 100 methods (us): "
+    << "first = " << latencies.front()
+    << ", cached = " << latencies.back();
+}
+
+TEST_F(CppServiceLatencyTest, DiagramGraph)
+{
+  ServiceHelper helper(_db, _prepared);
+  AstNodeInfo largeClass = helper.getAstNodeInfoByPos(
+    13, 10, helper.getFileId("largeclass.h"));
+
+  std::vector<double> svgLatencies, jsonLatencies;
+  std::string svg, json;
+
+  for (int i = 0; i < _rounds; ++i)
+  {
+    measure(svgLatencies, [&, this](){
+      _prepared->getDiagram(
+        svg, largeClass.id, CppServiceHandler::DETAILED_CLASS);
+    });
+    measure(jsonLatencies, [&, this](){
+      _prepared->getDiagramGraph(
+        json, largeClass.id, CppServiceHandler::DETAILED_CLASS);
+    });
+  }
+
+  EXPECT_EQ(0u, json.find("{\"directed\":true"));
+  EXPECT_NE(std::string::npos, json.find("\"nodes\":[{\"id\":"));
+  EXPECT_NE(std::string::npos, json.find("getField99"));
+  EXPECT_EQ(std::string::npos, json.find("<svg"));
+
+  std::sort(svgLatencies.begin(), svgLatencies.end());
+  std::sort(jsonLatencies.begin(), jsonLatencies.end());
+
+  LOG(info)
+    << "getDiagram vs. getDiagramGraph latency of a class with 100 methods "
+    << "(us): SVG p50 = " << percentile(svgLatencies, 0.5)
+    << ", JSON p50 = " << percentile(jsonLatencies, 0.5)
+    << "; SVG size = " << svg.size() << ", JSON size = " << json.size();
+}
@@ -51,8 +51,9 @@ function (topic, Menu, MenuItem, PopupMenuItem, model, viewHandler) {
     },
 
     mouseOverInfo : function (diagramType, nodeId) {
+      // An aggregated "more directories" node stands for its parent directory.
       return {
-        fileId : nodeId,
+        fileId : nodeId.replace(/^more:/, ''),
         selection : [1,1,1,1]
       };
     }
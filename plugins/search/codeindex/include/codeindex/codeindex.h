@@ -0,0 +1,120 @@
+#ifndef CC_CODEINDEX_CODEINDEX_H
+#define CC_CODEINDEX_CODEINDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cc
+{
+namespace codeindex
+{
+
+struct IndexHeader;
+struct FileRecord;
+
+/**
+ * Read-only view of a code index file written by CodeIndexBuilder. The file is
+ * memory mapped, so opening it is cheap and the pages are shared by the
+ * processes using it.
+ *
+ * The index consists of the contents of the indexed files and a positional
+ * trigram index: for every trigram of the lower case contents the lines
+ * containing it are listed. A query is answered by intersecting the lines of
+ * the trigrams of its literals; the resulting candidate lines have to be
+ * verified by the caller.
+ */
+class CodeIndex
+{
+public:
+  /**
+   * An indexed file.
+   */
+  struct File
+  {
+    std::uint64_t id;
+    std::string path;
+
+    /**
+     * The content of the file. It points into the mapped index file.
+     */
+    const char* content;
+    std::size_t contentSize;
+
+    /**
+     * Start offset of every line in the content.
+     */
+    const std::uint32_t* lineOffsets;
+    std::uint32_t lineCount;
+
+    /**
+     * Returns the text of a line without the line terminator.
+     * @param line_ Zero-based line number.
+     */
+    std::string line(std::uint32_t line_) const;
+  };
+
+  /**
+   * Called with the candidate lines of a file in ascending order. Returning
+   * false stops the enumeration.
+   */
+  typedef std::function<bool(
+    std::uint32_t file_,
+    const std::vector<std::uint32_t>& lines_)> CandidateCallback;
+
+  /**
+   * Opens a code index file.
+   * @return The index or nullptr if the file doesn't exist.
+   * @throw std::runtime_error if the file can't be mapped or it is not a valid
+   * code index.
+   */
+  static std::shared_ptr<const CodeIndex> open(const std::string& path_);
+
+  ~CodeIndex();
+
+  CodeIndex(const CodeIndex&) = delete;
+  CodeIndex& operator=(const CodeIndex&) = delete;
+
+  /**
+   * Returns the number of the indexed files. The files are ordered by their
+   * path.
+   */
+  std::uint32_t fileCount() const;
+
+  File file(std::uint32_t file_) const;
+
+  /**
+   * Returns the size of the index file in bytes.
+   */
+  std::size_t size() const;
+
+  /**
+   * Enumerates the lines which may contain all of the given lower case
+   * literals, file by file. Literals shorter than a trigram don't narrow the
+   * candidates, if there is no longer one then every line is a candidate.
+   */
+  void findCandidates(
+    const std::vector<std::string>& literals_,
+    const CandidateCallback& callback_) const;
+
+private:
+  CodeIndex() = default;
+
+  void* _data = nullptr;
+  std::size_t _size = 0;
+
+  const IndexHeader* _header = nullptr;
+  const FileRecord* _files = nullptr;
+  const char* _strings = nullptr;
+  const std::uint32_t* _lineOffsets = nullptr;
+  const std::uint32_t* _trigrams = nullptr;
+  const std::uint64_t* _postingOffsets = nullptr;
+  const std::uint8_t* _postings = nullptr;
+};
+
+} // codeindex
+} // cc
+
+#endif // CC_CODEINDEX_CODEINDEX_H
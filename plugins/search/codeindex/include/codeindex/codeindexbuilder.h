@@ -0,0 +1,119 @@
+#ifndef CC_CODEINDEX_CODEINDEXBUILDER_H
+#define CC_CODEINDEX_CODEINDEXBUILDER_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cc
+{
+namespace codeindex
+{
+
+class CodeIndex;
+
+/**
+ * Collects the contents of the files and writes them to a code index file
+ * with their trigram index (see CodeIndex).
+ *
+ * The memory use doesn't grow with the size of the code: the contents are
+ * spooled to a temporary file as they are added, and the trigram index is
+ * built by sorting runs of (trigram, line) pairs of a limited size, which are
+ * written to temporary files and merged. Only the paths of the files and the
+ * line offsets of their contents are kept in memory.
+ */
+class CodeIndexBuilder
+{
+public:
+  /**
+   * @param path_ Path of the index file. The temporary files of the builder
+   * are written next to it.
+   * @param runSize_ Number of (trigram, line) pairs sorted in memory at once
+   * while the trigram index is built.
+   */
+  explicit CodeIndexBuilder(
+    std::string path_,
+    std::size_t runSize_ = 1 << 22);
+
+  /**
+   * Removes the temporary files.
+   */
+  ~CodeIndexBuilder();
+
+  CodeIndexBuilder(const CodeIndexBuilder&) = delete;
+  CodeIndexBuilder& operator=(const CodeIndexBuilder&) = delete;
+
+  /**
+   * Adds a file to the index. If a file with the same id was added already
+   * then it is replaced. This function is thread-safe.
+   */
+  void addFile(
+    std::uint64_t id_,
+    const std::string& path_,
+    const std::string& content_);
+
+  /**
+   * Adds the files of an existing index, except for those rejected by the
+   * filter. This way an index can be updated without reading the unchanged
+   * files again.
+   * @param keep_ Returns false for the ids of the files to leave out.
+   */
+  void addFiles(
+    const CodeIndex& index_,
+    const std::function<bool(std::uint64_t)>& keep_);
+
+  /**
+   * Returns the number of the added files.
+   */
+  std::size_t fileCount() const;
+
+  /**
+   * Builds the trigram index and writes the index file. The file is written
+   * under a temporary name and then renamed, so the readers of a previous
+   * version are not disturbed.
+   * @throw std::runtime_error if the file can't be written.
+   */
+  void write();
+
+private:
+  struct File
+  {
+    std::uint64_t id;
+    std::string path;
+
+    /**
+     * Position of the content in the spool file.
+     */
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  void addFile(
+    std::uint64_t id_,
+    const std::string& path_,
+    const char* content_,
+    std::size_t contentSize_);
+
+  const std::string _path;
+  const std::size_t _runSize;
+
+  mutable std::mutex _mutex;
+  std::vector<File> _files;
+  std::unordered_map<std::uint64_t, std::size_t> _fileIndex;
+
+  /**
+   * The contents of the added files after each other. The content of a
+   * replaced file stays in it unused.
+   */
+  std::ofstream _contents;
+  std::uint64_t _contentsSize = 0;
+};
+
+} // codeindex
+} // cc
+
+#endif // CC_CODEINDEX_CODEINDEXBUILDER_H
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <codeindex/codeindex.h>
+
+#include "format.h"
+
+namespace
+{
+
+using namespace cc::codeindex;
+
+/**
+ * Reads the keys of a posting list one by one.
+ */
+struct PostingCursor
+{
+  const std::uint8_t* pos;
+  const std::uint8_t* end;
+  std::uint64_t key = 0;
+  bool valid = true;
+
+  PostingCursor(const std::uint8_t* begin_, const std::uint8_t* end_)
+    : pos(begin_), end(end_)
+  {
+    next();
+  }
+
+  void next()
+  {
+    if (pos == end)
+    {
+      valid = false;
+      return;
+    }
+
+    std::uint64_t delta = 0;
+    for (unsigned shift = 0; pos != end; shift += 7)
+    {
+      std::uint8_t byte = *pos++;
+      delta |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        break;
+    }
+
+    key += delta;
+  }
+
+  /**
+   * Moves to the first key which is not less than the target.
+   */
+  void seek(std::uint64_t target_)
+  {
+    while (valid && key < target_)
+      next();
+  }
+};
+
+std::runtime_error indexError(
+  const std::string& path_,
+  const std::string& message_)
+{
+  return std::runtime_error("Invalid code index '" + path_ + "': " + message_);
+}
+
+bool inRange(
+  std::uint64_t offset_,
+  std::uint64_t count_,
+  std::uint64_t itemSize_,
+  std::uint64_t size_)
+{
+  return offset_ <= size_ && count_ <= (size_ - offset_) / itemSize_;
+}
+
+}
+
+namespace cc
+{
+namespace codeindex
+{
+
+std::string CodeIndex::File::line(std::uint32_t line_) const
+{
+  std::size_t begin = lineOffsets[line_];
+  std::size_t end = line_ + 1 < lineCount
+    ? lineOffsets[line_ + 1]
+    : contentSize;
+
+  if (end > begin && content[end - 1] == '\n')
+    --end;
+  if (end > begin && content[end - 1] == '\r')
+    --end;
+
+  return std::string(content + begin, end - begin);
+}
+
+std::shared_ptr<const CodeIndex> CodeIndex::open(const std::string& path_)
+{
+  int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+  {
+    if (errno == ENOENT)
+      return nullptr;
+
+    throw indexError(path_, std::strerror(errno));
+  }
+
+  struct stat statbuf;
+  if (::fstat(fd, &statbuf) == -1)
+  {
+    int error = errno;
+    ::close(fd);
+    throw indexError(path_, std::strerror(error));
+  }
+
+  std::size_t size = statbuf.st_size;
+  if (size < sizeof(IndexHeader))
+  {
+    ::close(fd);
+    throw indexError(path_, "the file is truncated");
+  }
+
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  int error = errno;
+  ::close(fd);
+
+  if (data == MAP_FAILED)
+    throw indexError(path_, std::strerror(error));
+
+  std::shared_ptr<CodeIndex> index(new CodeIndex());
+  index->_data = data;
+  index->_size = size;
+
+  const char* base = static_cast<const char*>(data);
+  const IndexHeader* header = reinterpret_cast<const IndexHeader*>(base);
+
+  if (std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+    throw indexError(path_, "bad magic number");
+
+  if (header->version != INDEX_VERSION)
+    throw indexError(path_,
+      "unsupported version " + std::to_string(header->version));
+
+  if (!inRange(header->filesOffset, header->fileCount,
+        sizeof(FileRecord), size) ||
+      !inRange(header->lineOffsetsOffset, header->lineCount,
+        sizeof(std::uint32_t), size) ||
+      !inRange(header->trigramsOffset, header->trigramCount,
+        sizeof(std::uint32_t), size) ||
+      !inRange(header->postingOffsetsOffset, header->trigramCount + 1,
+        sizeof(std::uint64_t), size) ||
+      !inRange(header->stringsOffset, header->stringsSize, 1, size) ||
+      !inRange(header->postingsOffset, header->postingsSize, 1, size))
+    throw indexError(path_, "a section is out of the file");
+
+  index->_header = header;
+  index->_files = reinterpret_cast<const FileRecord*>(
+    base + header->filesOffset);
+  index->_lineOffsets = reinterpret_cast<const std::uint32_t*>(
+    base + header->lineOffsetsOffset);
+  index->_trigrams = reinterpret_cast<const std::uint32_t*>(
+    base + header->trigramsOffset);
+  index->_postingOffsets = reinterpret_cast<const std::uint64_t*>(
+    base + header->postingOffsetsOffset);
+  index->_strings = base + header->stringsOffset;
+  index->_postings = reinterpret_cast<const std::uint8_t*>(
+    base + header->postingsOffset);
+
+  for (std::uint32_t i = 0; i < header->fileCount; ++i)
+  {
+    const FileRecord& file = index->_files[i];
+
+    if (!inRange(file.path, file.pathSize, 1, header->stringsSize) ||
+        !inRange(file.content, file.contentSize, 1, header->stringsSize) ||
+        !inRange(file.firstLine, file.lineCount, 1, header->lineCount))
+      throw indexError(path_, "a file record is out of range");
+  }
+
+  if (header->trigramCount > 0 &&
+      index->_postingOffsets[header->trigramCount] > header->postingsSize)
+    throw indexError(path_, "the postings are out of range");
+
+  return index;
+}
+
+CodeIndex::~CodeIndex()
+{
+  if (_data)
+    ::munmap(_data, _size);
+}
+
+std::uint32_t CodeIndex::fileCount() const
+{
+  return _header->fileCount;
+}
+
+std::size_t CodeIndex::size() const
+{
+  return _size;
+}
+
+CodeIndex::File CodeIndex::file(std::uint32_t file_) const
+{
+  const FileRecord& record = _files[file_];
+
+  File file;
+  file.id = record.id;
+  file.path.assign(_strings + record.path, record.pathSize);
+  file.content = _strings + record.content;
+  file.contentSize = record.contentSize;
+  file.lineOffsets = _lineOffsets + record.firstLine;
+  file.lineCount = record.lineCount;
+
+  return file;
+}
+
+void CodeIndex::findCandidates(
+  const std::vector<std::string>& literals_,
+  const CandidateCallback& callback_) const
+{
+  std::vector<std::uint32_t> trigrams;
+  for (const std::string& literal : literals_)
+    for (std::size_t i = 0; i + 3 <= literal.size(); ++i)
+      trigrams.push_back(trigramAt(literal.data() + i));
+
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(
+    std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+  std::vector<std::uint32_t> lines;
+
+  //--- Without trigrams every line is a candidate ---//
+
+  if (trigrams.empty())
+  {
+    for (std::uint32_t file = 0; file < _header->fileCount; ++file)
+    {
+      lines.resize(_files[file].lineCount);
+      for (std::uint32_t line = 0; line < lines.size(); ++line)
+        lines[line] = line;
+
+      if (!lines.empty() && !callback_(file, lines))
+        return;
+    }
+
+    return;
+  }
+
+  //--- Open the posting lists of the trigrams ---//
+
+  const std::uint32_t* trigramsEnd = _trigrams + _header->trigramCount;
+  std::vector<PostingCursor> cursors;
+
+  for (std::uint32_t trigram : trigrams)
+  {
+    const std::uint32_t* it
+      = std::lower_bound(_trigrams, trigramsEnd, trigram);
+
+    // A trigram which is nowhere in the code can't be matched.
+    if (it == trigramsEnd || *it != trigram)
+      return;
+
+    std::size_t i = it - _trigrams;
+    cursors.emplace_back(
+      _postings + _postingOffsets[i],
+      _postings + _postingOffsets[i + 1]);
+  }
+
+  // The shortest lists go first, so the intersection skips faster.
+  std::sort(cursors.begin(), cursors.end(),
+    [](const PostingCursor& left_, const PostingCursor& right_)
+    {
+      return left_.end - left_.pos < right_.end - right_.pos;
+    });
+
+  //--- Intersect the posting lists ---//
+
+  std::uint32_t currentFile = 0;
+  std::uint64_t target = cursors.front().key;
+
+  while (true)
+  {
+    bool found = true;
+
+    for (PostingCursor& cursor : cursors)
+    {
+      cursor.seek(target);
+
+      if (!cursor.valid)
+      {
+        if (!lines.empty())
+          callback_(currentFile, lines);
+        return;
+      }
+
+      if (cursor.key != target)
+      {
+        target = cursor.key;
+        found = false;
+        break;
+      }
+    }
+
+    if (!found)
+      continue;
+
+    std::uint32_t file = target >> 32;
+    if (file != currentFile && !lines.empty())
+    {
+      if (!callback_(currentFile, lines))
+        return;
+      lines.clear();
+    }
+
+    currentFile = file;
+    lines.push_back(static_cast<std::uint32_t>(target));
+
+    ++target;
+  }
+}
+
+} // codeindex
+} // cc
@@ -0,0 +1,529 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+
+#include <codeindex/codeindex.h>
+#include <codeindex/codeindexbuilder.h>
+
+#include "format.h"
+
+namespace
+{
+
+using namespace cc::codeindex;
+
+/**
+ * A line containing a trigram.
+ */
+struct Posting
+{
+  std::uint32_t trigram;
+  std::uint64_t key;
+
+  bool operator<(const Posting& other_) const
+  {
+    return trigram != other_.trigram
+      ? trigram < other_.trigram
+      : key < other_.key;
+  }
+};
+
+/**
+ * Size of a posting in a run file: the trigram and the key without padding.
+ */
+const std::size_t RUN_RECORD_SIZE
+  = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+/**
+ * Reads the postings of a run file in order.
+ */
+class RunReader
+{
+public:
+  explicit RunReader(const std::string& path_)
+    : _in(path_, std::ios::binary)
+  {
+    if (!_in)
+      throw std::runtime_error("Failed to open '" + path_ + "'");
+
+    next();
+  }
+
+  bool valid() const
+  {
+    return _valid;
+  }
+
+  const Posting& posting() const
+  {
+    return _posting;
+  }
+
+  void next()
+  {
+    if (_pos == _size)
+    {
+      _in.read(_buffer, sizeof(_buffer));
+      _size = _in.gcount();
+      _pos = 0;
+
+      if (_size < RUN_RECORD_SIZE)
+      {
+        _valid = false;
+        return;
+      }
+    }
+
+    std::memcpy(&_posting.trigram, _buffer + _pos, sizeof(std::uint32_t));
+    std::memcpy(&_posting.key, _buffer + _pos + sizeof(std::uint32_t),
+      sizeof(std::uint64_t));
+    _pos += RUN_RECORD_SIZE;
+  }
+
+private:
+  std::ifstream _in;
+  char _buffer[RUN_RECORD_SIZE * 4096];
+  std::size_t _size = 0;
+  std::size_t _pos = 0;
+  Posting _posting;
+  bool _valid = true;
+};
+
+/**
+ * Builds the postings section from the postings ordered by trigram and key.
+ * The delta encoded posting lists are written to a file, only the distinct
+ * trigrams and the offsets of their lists are kept in memory.
+ */
+class PostingsWriter
+{
+public:
+  explicit PostingsWriter(const std::string& path_)
+    : _out(path_, std::ios::binary | std::ios::trunc)
+  {
+  }
+
+  void add(const Posting& posting_)
+  {
+    if (trigrams.empty() || trigrams.back() != posting_.trigram)
+    {
+      trigrams.push_back(posting_.trigram);
+      offsets.push_back(size);
+      _last = 0;
+    }
+
+    std::uint64_t delta = posting_.key - _last;
+    _last = posting_.key;
+
+    do
+    {
+      std::uint8_t byte = delta & 0x7f;
+      delta >>= 7;
+      _bytes.push_back(delta ? byte | 0x80 : byte);
+      ++size;
+    } while (delta);
+
+    if (_bytes.size() >= 1 << 16)
+      flush();
+  }
+
+  /**
+   * Writes the buffered bytes and closes the list of the last trigram.
+   * @throw std::runtime_error if the file can't be written.
+   */
+  void finish(const std::string& path_)
+  {
+    flush();
+    offsets.push_back(size);
+
+    _out.close();
+    if (!_out)
+      throw std::runtime_error("Failed to write '" + path_ + "'");
+  }
+
+  std::vector<std::uint32_t> trigrams;
+  std::vector<std::uint64_t> offsets;
+  std::uint64_t size = 0;
+
+private:
+  void flush()
+  {
+    _out.write(reinterpret_cast<const char*>(_bytes.data()), _bytes.size());
+    _bytes.clear();
+  }
+
+  std::ofstream _out;
+  std::vector<std::uint8_t> _bytes;
+  std::uint64_t _last = 0;
+};
+
+/**
+ * Returns the start offsets of the lines of the content. A line terminator at
+ * the end doesn't start a new line.
+ */
+std::vector<std::uint32_t> lineOffsets(const std::string& content_)
+{
+  std::vector<std::uint32_t> offsets;
+
+  if (content_.empty())
+    return offsets;
+
+  offsets.push_back(0);
+  for (std::size_t i = 0; i + 1 < content_.size(); ++i)
+    if (content_[i] == '\n')
+      offsets.push_back(i + 1);
+
+  return offsets;
+}
+
+void writePadding(std::ofstream& out_)
+{
+  static const char zeros[8] = {};
+  out_.write(zeros, align(out_.tellp()) - out_.tellp());
+}
+
+template <typename T>
+void writeVector(std::ofstream& out_, const std::vector<T>& vector_)
+{
+  out_.write(
+    reinterpret_cast<const char*>(vector_.data()),
+    vector_.size() * sizeof(T));
+  writePadding(out_);
+}
+
+/**
+ * Reads size_ bytes from the offset of the file.
+ */
+void readAt(
+  std::ifstream& in_,
+  std::uint64_t offset_,
+  std::uint64_t size_,
+  std::string& buffer_)
+{
+  buffer_.resize(size_);
+  in_.seekg(offset_);
+  in_.read(&buffer_[0], size_);
+}
+
+}
+
+namespace cc
+{
+namespace codeindex
+{
+
+CodeIndexBuilder::CodeIndexBuilder(std::string path_, std::size_t runSize_)
+  : _path(std::move(path_)),
+    _runSize(std::max<std::size_t>(runSize_, 1)),
+    _contents(_path + ".contents.tmp", std::ios::binary | std::ios::trunc)
+{
+}
+
+CodeIndexBuilder::~CodeIndexBuilder()
+{
+  _contents.close();
+
+  boost::system::error_code ec;
+  boost::filesystem::remove(_path + ".contents.tmp", ec);
+}
+
+void CodeIndexBuilder::addFile(
+  std::uint64_t id_,
+  const std::string& path_,
+  const std::string& content_)
+{
+  addFile(id_, path_, content_.data(), content_.size());
+}
+
+void CodeIndexBuilder::addFile(
+  std::uint64_t id_,
+  const std::string& path_,
+  const char* content_,
+  std::size_t contentSize_)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  File file{id_, path_, _contentsSize, contentSize_};
+
+  _contents.write(content_, contentSize_);
+  _contentsSize += contentSize_;
+
+  auto it = _fileIndex.emplace(id_, _files.size());
+  if (it.second)
+    _files.push_back(std::move(file));
+  else
+    _files[it.first->second] = std::move(file);
+}
+
+void CodeIndexBuilder::addFiles(
+  const CodeIndex& index_,
+  const std::function<bool(std::uint64_t)>& keep_)
+{
+  for (std::uint32_t i = 0; i < index_.fileCount(); ++i)
+  {
+    CodeIndex::File file = index_.file(i);
+
+    if (keep_(file.id))
+      addFile(file.id, file.path, file.content, file.contentSize);
+  }
+}
+
+std::size_t CodeIndexBuilder::fileCount() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _files.size();
+}
+
+void CodeIndexBuilder::write()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  const std::string contentsPath = _path + ".contents.tmp";
+  const std::string postingsPath = _path + ".postings.tmp";
+  const std::string tempPath = _path + ".tmp";
+
+  std::vector<std::string> runPaths;
+
+  auto removeTemporaries = [&]()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove(postingsPath, ec);
+    for (const std::string& runPath : runPaths)
+      boost::filesystem::remove(runPath, ec);
+  };
+
+  try
+  {
+    _contents.flush();
+    if (!_contents)
+      throw std::runtime_error("Failed to write '" + contentsPath + "'");
+
+    std::ifstream contents(contentsPath, std::ios::binary);
+    if (!contents)
+      throw std::runtime_error("Failed to open '" + contentsPath + "'");
+
+    std::vector<const File*> files;
+    for (const File& file : _files)
+      files.push_back(&file);
+
+    std::sort(files.begin(), files.end(),
+      [](const File* left_, const File* right_)
+      {
+        return left_->path < right_->path;
+      });
+
+    //--- Build the file records and the sorted runs of postings ---//
+
+    std::vector<FileRecord> records;
+    std::vector<std::uint32_t> allLineOffsets;
+    std::vector<Posting> run;
+    std::vector<std::uint32_t> lineTrigrams;
+    std::string content;
+    std::string lowerLine;
+    std::uint64_t stringsSize = 0;
+
+    run.reserve(std::min<std::size_t>(_runSize, 1 << 20));
+
+    auto writeRun = [&]()
+    {
+      std::sort(run.begin(), run.end());
+
+      runPaths.push_back(_path + ".run" + std::to_string(runPaths.size())
+        + ".tmp");
+      std::ofstream out(runPaths.back(), std::ios::binary | std::ios::trunc);
+
+      for (const Posting& posting : run)
+      {
+        out.write(reinterpret_cast<const char*>(&posting.trigram),
+          sizeof(posting.trigram));
+        out.write(reinterpret_cast<const char*>(&posting.key),
+          sizeof(posting.key));
+      }
+
+      out.close();
+      if (!out)
+        throw std::runtime_error("Failed to write '" + runPaths.back() + "'");
+
+      run.clear();
+    };
+
+    for (std::uint32_t i = 0; i < files.size(); ++i)
+    {
+      const File& file = *files[i];
+
+      readAt(contents, file.offset, file.size, content);
+      if (!contents)
+        throw std::runtime_error("Failed to read '" + contentsPath + "'");
+
+      std::vector<std::uint32_t> offsets = lineOffsets(content);
+
+      FileRecord record;
+      record.id = file.id;
+      record.path = stringsSize;
+      record.pathSize = file.path.size();
+      record.content = stringsSize + file.path.size();
+      record.contentSize = file.size;
+      record.firstLine = allLineOffsets.size();
+      record.lineCount = offsets.size();
+      records.push_back(record);
+
+      stringsSize += file.path.size() + file.size;
+
+      for (std::uint32_t line = 0; line < offsets.size(); ++line)
+      {
+        std::size_t begin = offsets[line];
+        std::size_t end = line + 1 < offsets.size()
+          ? offsets[line + 1] - 1
+          : content.size();
+
+        lowerLine.assign(content, begin, end - begin);
+        std::transform(lowerLine.begin(), lowerLine.end(), lowerLine.begin(),
+          [](char c_) { return toLower(c_); });
+
+        lineTrigrams.clear();
+        for (std::size_t j = 0; j + 3 <= lowerLine.size(); ++j)
+          lineTrigrams.push_back(trigramAt(lowerLine.data() + j));
+
+        std::sort(lineTrigrams.begin(), lineTrigrams.end());
+        lineTrigrams.erase(
+          std::unique(lineTrigrams.begin(), lineTrigrams.end()),
+          lineTrigrams.end());
+
+        std::uint64_t key = postingKey(i, line);
+        for (std::uint32_t trigram : lineTrigrams)
+        {
+          run.push_back(Posting{trigram, key});
+
+          if (run.size() >= _runSize)
+            writeRun();
+        }
+      }
+
+      allLineOffsets.insert(
+        allLineOffsets.end(), offsets.begin(), offsets.end());
+    }
+
+    //--- Merge the runs into the postings ---//
+
+    // The keys grow from run to run, so the postings of a trigram are in key
+    // order if the runs are taken in their order.
+    PostingsWriter postings(postingsPath);
+
+    if (runPaths.empty())
+    {
+      std::sort(run.begin(), run.end());
+      for (const Posting& posting : run)
+        postings.add(posting);
+    }
+    else
+    {
+      if (!run.empty())
+        writeRun();
+
+      std::vector<std::unique_ptr<RunReader>> readers;
+      for (const std::string& runPath : runPaths)
+        readers.emplace_back(new RunReader(runPath));
+
+      typedef std::pair<std::uint32_t, std::size_t> HeapItem;
+      std::priority_queue<
+        HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+
+      for (std::size_t i = 0; i < readers.size(); ++i)
+        if (readers[i]->valid())
+          heap.emplace(readers[i]->posting().trigram, i);
+
+      while (!heap.empty())
+      {
+        std::uint32_t trigram = heap.top().first;
+        std::size_t index = heap.top().second;
+        RunReader& reader = *readers[index];
+        heap.pop();
+
+        // The postings of the trigram in this run follow each other.
+        do
+        {
+          postings.add(reader.posting());
+          reader.next();
+        } while (reader.valid() && reader.posting().trigram == trigram);
+
+        if (reader.valid())
+          heap.emplace(reader.posting().trigram, index);
+      }
+    }
+
+    run.clear();
+    run.shrink_to_fit();
+
+    postings.finish(postingsPath);
+
+    //--- Lay out the sections ---//
+
+    IndexHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.fileCount = records.size();
+    header.lineCount = allLineOffsets.size();
+    header.trigramCount = postings.trigrams.size();
+    header.filesOffset = align(sizeof(IndexHeader));
+    header.lineOffsetsOffset = align(
+      header.filesOffset + records.size() * sizeof(FileRecord));
+    header.trigramsOffset = align(
+      header.lineOffsetsOffset
+      + allLineOffsets.size() * sizeof(std::uint32_t));
+    header.postingOffsetsOffset = align(
+      header.trigramsOffset
+      + postings.trigrams.size() * sizeof(std::uint32_t));
+    header.stringsOffset = align(
+      header.postingOffsetsOffset
+      + postings.offsets.size() * sizeof(std::uint64_t));
+    header.stringsSize = stringsSize;
+    header.postingsOffset = align(header.stringsOffset + stringsSize);
+    header.postingsSize = postings.size;
+
+    //--- Write the file ---//
+
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+      throw std::runtime_error(
+        "Failed to open '" + tempPath + "' for writing");
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writePadding(out);
+    writeVector(out, records);
+    writeVector(out, allLineOffsets);
+    writeVector(out, postings.trigrams);
+    writeVector(out, postings.offsets);
+
+    for (const File* file : files)
+    {
+      readAt(contents, file->offset, file->size, content);
+      out.write(file->path.data(), file->path.size());
+      out.write(content.data(), content.size());
+    }
+    writePadding(out);
+
+    std::ifstream postingsIn(postingsPath, std::ios::binary);
+    if (postings.size > 0)
+      out << postingsIn.rdbuf();
+
+    out.close();
+    if (!out || !contents)
+      throw std::runtime_error("Failed to write '" + tempPath + "'");
+  }
+  catch (...)
+  {
+    removeTemporaries();
+    throw;
+  }
+
+  removeTemporaries();
+
+  boost::filesystem::rename(tempPath, _path);
+}
+
+} // codeindex
+} // cc
@@ -0,0 +1,90 @@
+#ifndef CC_CODEINDEX_FORMAT_H
+#define CC_CODEINDEX_FORMAT_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Layout of the code index file. The file is read by the machine which wrote
+ * it, so the numbers are stored in native byte order. The sections follow the
+ * header in this order, each aligned to 8 bytes:
+ *
+ *  - FileRecord for every file, ordered by path.
+ *  - Line start offsets (uint32) of every file after each other.
+ *  - The distinct trigrams (uint32) in ascending order.
+ *  - Posting offsets (uint64): the postings of the i-th trigram are in the
+ *    [offsets[i], offsets[i + 1]) range of the postings section.
+ *  - Strings: the paths and the contents of the files.
+ *  - Postings: the (file index << 32 | line) keys of the lines containing a
+ *    trigram in ascending order, delta encoded as LEB128 varints.
+ */
+
+namespace cc
+{
+namespace codeindex
+{
+
+const char INDEX_MAGIC[8] = {'C', 'C', 'C', 'O', 'D', 'E', 'I', 'X'};
+const std::uint32_t INDEX_VERSION = 1;
+
+struct IndexHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t fileCount;
+  std::uint64_t lineCount;
+  std::uint64_t trigramCount;
+  std::uint64_t filesOffset;
+  std::uint64_t lineOffsetsOffset;
+  std::uint64_t trigramsOffset;
+  std::uint64_t postingOffsetsOffset;
+  std::uint64_t stringsOffset;
+  std::uint64_t stringsSize;
+  std::uint64_t postingsOffset;
+  std::uint64_t postingsSize;
+};
+
+struct FileRecord
+{
+  std::uint64_t id;
+  std::uint64_t path; /*!< Offset in the strings section. */
+  std::uint64_t content; /*!< Offset in the strings section. */
+  std::uint64_t contentSize;
+  std::uint64_t firstLine; /*!< Index of the first line offset. */
+  std::uint32_t pathSize;
+  std::uint32_t lineCount;
+};
+
+/**
+ * Packs the first three characters of the string into a trigram.
+ */
+inline std::uint32_t trigramAt(const char* str_)
+{
+  return
+    static_cast<std::uint32_t>(static_cast<unsigned char>(str_[0])) << 16 |
+    static_cast<std::uint32_t>(static_cast<unsigned char>(str_[1])) << 8 |
+    static_cast<std::uint32_t>(static_cast<unsigned char>(str_[2]));
+}
+
+/**
+ * The index is case-insensitive for ASCII letters.
+ */
+inline char toLower(char c_)
+{
+  return 'A' <= c_ && c_ <= 'Z' ? c_ - 'A' + 'a' : c_;
+}
+
+inline std::uint64_t postingKey(std::uint32_t file_, std::uint32_t line_)
+{
+  return static_cast<std::uint64_t>(file_) << 32 | line_;
+}
+
+inline std::uint64_t align(std::uint64_t offset_)
+{
+  return (offset_ + 7) & ~std::uint64_t(7);
+}
+
+} // codeindex
+} // cc
+
+#endif // CC_CODEINDEX_FORMAT_H
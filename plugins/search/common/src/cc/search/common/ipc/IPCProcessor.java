@@ -1,6 +1,8 @@
 package cc.search.common.ipc;
 
 import cc.search.common.config.CommonOptions;
+import java.io.BufferedInputStream;
+import java.io.BufferedOutputStream;
 import java.io.FileInputStream;
 import java.io.FileNotFoundException;
 import java.io.FileOutputStream;
@@ -66,8 +68,12 @@ public class IPCProcessor implements AutoCloseable {
     TProtocol outProtocol = null;
 
     try {
-      inTransport = new TIOStreamTransport(new FileInputStream(getFileNameFromFd(options_.ipcInFd)));
-      outTransport = new TIOStreamTransport(new FileOutputStream(getFileNameFromFd(options_.ipcOutFd)));
+      // The streams are buffered, otherwise every field of a message would be
+      // a separate system call. The processor flushes the replies.
+      inTransport = new TIOStreamTransport(new BufferedInputStream(
+        new FileInputStream(getFileNameFromFd(options_.ipcInFd))));
+      outTransport = new TIOStreamTransport(new BufferedOutputStream(
+        new FileOutputStream(getFileNameFromFd(options_.ipcOutFd))));
       inProtocol = factory.getProtocol(inTransport);
       outProtocol = factory.getProtocol(outTransport);
     } catch (TTransportException ex) {
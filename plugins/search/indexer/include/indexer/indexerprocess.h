@@ -1,6 +1,7 @@
 #ifndef CC_PARSER_INDEXERPROCESS_H
 #define CC_PARSER_INDEXERPROCESS_H
 
+#include <set>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -81,12 +82,22 @@ public:
     const std::string& filePath_,
     const std::string& mimeType_) override;
   
+  virtual void indexFiles(const std::vector<search::FileToIndex>& files_)
+    override;
+
   virtual void addFieldValues(
     const std::string& fileId_,
     const search::Fields& fields_) override;
 
+  virtual void removeFile(const std::string& fileId_) override;
+
+  virtual void getFileIds(std::set<std::string>& fileIds_) override;
+
   virtual void buildSuggestions() override;
 
+  virtual void mergeIndexes(const std::vector<std::string>& indexDirs_)
+    override;
+
   virtual void getStatistics(
     std::map<std::string, std::string>& stat_) override;
   
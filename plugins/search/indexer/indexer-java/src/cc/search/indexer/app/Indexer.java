@@ -1,10 +1,12 @@
 package cc.search.indexer.app;
 
 import cc.parser.search.FieldValue;
+import cc.parser.search.FileToIndex;
 import cc.parser.search.IndexerService;
 import cc.search.analysis.SourceAnalyzer;
 import cc.search.analysis.tags.TagGeneratorManager;
 import cc.search.common.FileLoggerInitializer;
+import cc.search.common.IndexFields;
 import cc.search.common.ipc.IPCProcessor;
 import cc.search.common.config.InvalidValueException;
 import cc.search.common.config.UnknownArgumentException;
@@ -18,6 +20,8 @@ import java.util.ArrayList;
 import java.util.List;
 import java.util.Map;
 import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Set;
 import java.util.concurrent.ExecutionException;
 import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
@@ -26,12 +30,20 @@ import java.util.logging.Level;
 import java.util.logging.Logger;
 import org.apache.lucene.analysis.Analyzer;
 import org.apache.lucene.index.DirectoryReader;
+import org.apache.lucene.index.DocsEnum;
 import org.apache.lucene.index.IndexWriter;
 import org.apache.lucene.index.IndexWriterConfig;
 import org.apache.lucene.index.IndexWriterConfig.OpenMode;
+import org.apache.lucene.index.MultiFields;
 import org.apache.lucene.index.ReaderManager;
+import org.apache.lucene.index.Term;
+import org.apache.lucene.index.Terms;
+import org.apache.lucene.index.TermsEnum;
+import org.apache.lucene.search.DocIdSetIterator;
 import org.apache.lucene.store.Directory;
 import org.apache.lucene.store.FSDirectory;
+import org.apache.lucene.util.Bits;
+import org.apache.lucene.util.BytesRef;
 import org.apache.lucene.util.Version;
 
 /**
@@ -215,6 +227,13 @@ public class Indexer implements AutoCloseable, IndexerService.Iface {
     }
   }
 
+  @Override
+  public void indexFiles(List<FileToIndex> files_) {
+    for (FileToIndex file : files_) {
+      indexFile(file.fileId, file.filePath, file.mimeType);
+    }
+  }
+
   @Override
   public void addFieldValues(String fileId_,
     Map<String, List<FieldValue>> fields_) throws org.apache.thrift.TException {
@@ -247,6 +266,60 @@ public class Indexer implements AutoCloseable, IndexerService.Iface {
     }
   }
 
+  @Override
+  public void removeFile(String fileId_) {
+    _log.log(Level.FINEST, "Removing file {0} from index.", fileId_);
+
+    try {
+      _indexWriter.deleteDocuments(new Term(IndexFields.fileDbIdField,
+        fileId_));
+    } catch (IOException ex) {
+      _log.log(Level.SEVERE, "Removing file {0} failed with exception!",
+        fileId_);
+    } catch (Exception ex) {
+      _log.log(Level.SEVERE, "An unknown exception caught!", ex);
+    }
+  }
+
+  @Override
+  public Set<String> getFileIds() {
+    final HashSet<String> res = new HashSet<>();
+
+    try {
+      _readerManager.maybeRefreshBlocking();
+
+      final DirectoryReader reader = _readerManager.acquire();
+      try {
+        final Terms terms = MultiFields.getTerms(reader,
+          IndexFields.fileDbIdField);
+        if (terms == null) {
+          return res;
+        }
+
+        // The terms of the deleted documents are kept until a merge.
+        final Bits liveDocs = MultiFields.getLiveDocs(reader);
+        final TermsEnum termsEnum = terms.iterator(null);
+        DocsEnum docsEnum = null;
+
+        BytesRef term;
+        while ((term = termsEnum.next()) != null) {
+          docsEnum = termsEnum.docs(liveDocs, docsEnum, DocsEnum.FLAG_NONE);
+          if (docsEnum.nextDoc() != DocIdSetIterator.NO_MORE_DOCS) {
+            res.add(term.utf8ToString());
+          }
+        }
+      } finally {
+        _readerManager.release(reader);
+      }
+    } catch (IOException ex) {
+      _log.log(Level.SEVERE, "Failed to read the file ids of the index!", ex);
+    } catch (Exception ex) {
+      _log.log(Level.SEVERE, "An unknown exception caught!", ex);
+    }
+
+    return res;
+  }
+
   @Override
   public void buildSuggestions() {
     _log.log(Level.FINEST, "Start building suggestion databases");
@@ -268,6 +341,35 @@ public class Indexer implements AutoCloseable, IndexerService.Iface {
     }
   }
 
+  @Override
+  public void mergeIndexes(List<String> indexDirs_) {
+    _log.log(Level.INFO, "Merging {0} index database(s)", indexDirs_.size());
+
+    final List<Directory> dirs = new ArrayList<>();
+
+    try {
+      for (String indexDir : indexDirs_) {
+        dirs.add(FSDirectory.open(new File(indexDir),
+          _options.createLockFactory()));
+      }
+
+      _indexWriter.addIndexes(dirs.toArray(new Directory[dirs.size()]));
+      _indexWriter.commit();
+    } catch (IOException ex) {
+      _log.log(Level.SEVERE, "Failed to merge index databases!", ex);
+    } catch (Exception ex) {
+      _log.log(Level.SEVERE, "An unknown exception caught!", ex);
+    } finally {
+      for (Directory dir : dirs) {
+        try {
+          dir.close();
+        } catch (IOException ex) {
+          _log.log(Level.WARNING, "Error on closing merged index!", ex);
+        }
+      }
+    }
+  }
+
   @Override
   public Map<String,String> getStatistics() {
     final HashMap<String, String> res = new HashMap<>();
@@ -79,6 +79,25 @@ struct FieldValue
  3:optional string context
 }
 
+/**
+ * A file to add to the index database.
+ */
+struct FileToIndex
+{
+  /**
+   * Database id of the file.
+   */
+  1: string fileId,
+  /**
+   * Indexable file path.
+   */
+  2: string filePath,
+  /**
+   * Mime type of the file.
+   */
+  3: string mimeType
+}
+
 /**
  * A field is a map between its name and a vector of string values with their
  * position.
@@ -108,6 +127,13 @@ service IndexerService
     2:string filePath_,
     3:string mimeType_),
 
+  /**
+   * Add more files to the index database in one message.
+   *
+   * @param files_ indexable files.
+   */
+  oneway void indexFiles(1:list<FileToIndex> files_),
+
   /**
    * Adds the given field values to a document. The document will not be
    * created if it does not exists (so it does nothing in this case).
@@ -119,12 +145,33 @@ service IndexerService
     1:string fileId_,
     2:Fields fields_),
 
+  /**
+   * Removes the document of a file from the index database.
+   *
+   * @param fileId_ database id of the file.
+   */
+  oneway void removeFile(1:string fileId_),
+
+  /**
+   * Returns the database ids of the files in the index database.
+   */
+  set<string> getFileIds(),
+
   /**
    * (Re)Builds a suggestion index databases. Its a blocking call, so it may
    * take a long time.
    */
   void buildSuggestions(),
 
+  /**
+   * Adds the documents of the given index databases to this index. The given
+   * databases must not be opened for writing by other indexers. It's a
+   * blocking call.
+   *
+   * @param indexDirs_ paths of the index databases to merge.
+   */
+  void mergeIndexes(1:list<string> indexDirs_),
+
   /**
    * Returns the search index statistics:
    *  - Number of documnets in the index
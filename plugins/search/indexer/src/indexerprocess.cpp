@@ -3,6 +3,7 @@
 
 #include <boost/log/expressions.hpp>
 
+#include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/TFDTransport.h>
 #include <thrift/protocol/TBinaryProtocol.h>
 
@@ -103,15 +104,20 @@ IndexerProcess::IndexerProcess(
   }
   else
   {
-    // Get the client interface
-    using Transport = apache::thrift::transport::TFDTransport;
+    // Get the client interface. The pipes are buffered, otherwise every field
+    // of a message would be a separate system call. The client flushes the
+    // buffer at the end of each message.
+    using FDTransport = apache::thrift::transport::TFDTransport;
+    using Transport = apache::thrift::transport::TBufferedTransport;
     using ProtocolFactory =
       apache::thrift::protocol::TBinaryProtocolFactoryT<Transport>;
 
     std::shared_ptr<apache::thrift::transport::TTransport> transIn(
-      new Transport(_pipeFd2[0], Transport::NO_CLOSE_ON_DESTROY));
+      new Transport(std::make_shared<FDTransport>(
+        _pipeFd2[0], FDTransport::NO_CLOSE_ON_DESTROY)));
     std::shared_ptr<apache::thrift::transport::TTransport> transOut(
-      new Transport(_pipeFd[1], Transport::NO_CLOSE_ON_DESTROY));
+      new Transport(std::make_shared<FDTransport>(
+        _pipeFd[1], FDTransport::NO_CLOSE_ON_DESTROY)));
 
     ProtocolFactory protFactory;
 
@@ -151,6 +157,17 @@ void IndexerProcess::indexFile(
   _indexer->indexFile(fileId_, filePath_, mimeType_);
 }
   
+void IndexerProcess::indexFiles(const std::vector<search::FileToIndex>& files_)
+{
+  if (!isAlive())
+  {
+    LOG(error) << "Index process is not alive!";
+    ::abort();
+  }
+
+  _indexer->indexFiles(files_);
+}
+
 void IndexerProcess::addFieldValues(
   const std::string& fileId_,
   const search::Fields& fields_)
@@ -164,6 +181,28 @@ void IndexerProcess::addFieldValues(
   _indexer->addFieldValues(fileId_, fields_);
 }
 
+void IndexerProcess::removeFile(const std::string& fileId_)
+{
+  if (!isAlive())
+  {
+    LOG(error) << "Index process is not alive!";
+    ::abort();
+  }
+
+  _indexer->removeFile(fileId_);
+}
+
+void IndexerProcess::getFileIds(std::set<std::string>& fileIds_)
+{
+  if (!isAlive())
+  {
+    LOG(error) << "Index process is not alive!";
+    ::abort();
+  }
+
+  _indexer->getFileIds(fileIds_);
+}
+
 void IndexerProcess::buildSuggestions()
 {
   if (!isAlive())
@@ -175,6 +214,17 @@ void IndexerProcess::buildSuggestions()
   _indexer->buildSuggestions();
 }
 
+void IndexerProcess::mergeIndexes(const std::vector<std::string>& indexDirs_)
+{
+  if (!isAlive())
+  {
+    LOG(error) << "Index process is not alive!";
+    ::abort();
+  }
+
+  _indexer->mergeIndexes(indexDirs_);
+}
+
 void IndexerProcess::getStatistics(std::map<std::string, std::string>& stat_)
 {
   if (!isAlive())
@@ -1,13 +1,27 @@
 #ifndef CC_PARSER_SEARCHPARSER_H
 #define CC_PARSER_SEARCHPARSER_H
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_set>
+
 #include <magic.h>
 
 #include <util/parserutil.h>
+#include <util/threadpool.h>
+
+#include <model/file.h>
+#include <model/filecontent.h>
+
+#include <codeindex/codeindexbuilder.h>
 
 #include <parser/abstractparser.h>
 #include <parser/parsercontext.h>
 
+#include <searchindexer_types.h>
+
 namespace cc
 {
 namespace parser
@@ -21,29 +35,138 @@ public:
   SearchParser(ParserContext& ctx_);
   virtual ~SearchParser();
 
+  virtual bool cleanupDatabase() override;
   virtual bool parse() override;
 
 private:
+  /**
+   * A disjoint part of the indexed files. Each shard is indexed by its own
+   * indexer process into its own index database on a separate thread.
+   */
+  struct IndexShard
+  {
+    ~IndexShard();
+
+    /**
+     * Directory of the index database of the shard.
+     */
+    std::string indexDatabase;
+
+    /**
+     * Java index process.
+     */
+    std::unique_ptr<IndexerProcess> indexProcess;
+
+    /**
+     * libmagic handler for mime types. A cookie can't be used by more threads.
+     */
+    ::magic_t fileMagic = nullptr;
+
+    /**
+     * Files waiting to be sent to the indexer process.
+     */
+    std::vector<search::FileToIndex> batch;
+
+    /**
+     * Thread which prepares the files of the shard and hands them to the
+     * indexer process in batches.
+     */
+    std::unique_ptr<util::JobQueueThreadPool<std::string>> pool;
+  };
+
+  std::unique_ptr<IndexerProcess> openIndexer(
+    const std::string& indexDatabase_,
+    bool create_);
+  bool openShards();
+  void openCodeIndex();
+
+  /**
+   * Adds the files of the search database which are not indexed again to the
+   * code index, reading their contents from the database.
+   */
+  void addUnchangedToCodeIndex();
+  void indexFile(IndexShard& shard_, const std::string& path_);
+  void addToCodeIndex(
+    const model::File& file_,
+    odb::lazy_shared_ptr<model::FileContent> content_);
+  void sendBatch(IndexShard& shard_);
   void postParse();
   util::DirIterCallback getParserCallback(const std::string& path_);
   bool shouldHandle(const std::string& path_);
 
 private:
   /**
-   * Java index process.
+   * Index shards, at least one.
+   */
+  std::vector<std::unique_ptr<IndexShard>> _shards;
+
+  /**
+   * Number of the files handed to the shards. Round-robin distribution.
    */
-  std::unique_ptr<IndexerProcess> _indexProcess;
+  std::size_t _fileCounter = 0;
 
   /**
-   * libmagic handler for mime types.
+   * Number of the files indexed by all shards. The files are persisted after
+   * every few hundred of them.
    */
-  ::magic_t _fileMagic;
+  std::atomic<std::size_t> _indexedFileCount{0};
+
+  /**
+   * Persisting the files excludes marking them as indexed.
+   */
+  std::shared_timed_mutex _persistMutex;
+
+  /**
+   * True if the files are added to the existing search database instead of
+   * building it from scratch. This is set by cleanupDatabase(), which runs
+   * only if the project database existed before this parse, and only if the
+   * search database exists too.
+   */
+  bool _incremental = false;
+
+  /**
+   * Files which are in the search database already, so they are not indexed
+   * again by an incremental parse.
+   */
+  std::unordered_set<model::FileId> _indexedFileIds;
+
+  /**
+   * Number of the files removed from the search database.
+   */
+  std::size_t _removedFileCount = 0;
+
+  /**
+   * Start time of the parse for the throughput statistics.
+   */
+  std::chrono::steady_clock::time_point _parseStart;
+
+  /**
+   * Number of the indexer processes.
+   */
+  std::size_t _indexProcessCount;
 
   /**
    * Directory of search database.
    */
   std::string _searchDatabase;
 
+  /**
+   * Directory of the index databases of the shards which are merged into the
+   * search database at the end of the parse.
+   */
+  std::string _shardDirectory;
+
+  /**
+   * Path of the native code index file.
+   */
+  std::string _codeIndexPath;
+
+  /**
+   * Collects the contents of the indexed files for the native code index. It
+   * is null if the code index is disabled.
+   */
+  std::unique_ptr<codeindex::CodeIndexBuilder> _codeIndexBuilder;
+
   /**
    * Directories which have to be skipped during the parse.
    */
@@ -2,16 +2,27 @@
 #include <cstdlib>
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <set>
+#include <mutex>
+#include <shared_mutex>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include <boost/filesystem.hpp>
 
+#include <util/dbutil.h>
+#include <util/hash.h>
 #include <util/logutil.h>
+#include <util/odbtransaction.h>
 
 #include <model/file.h>
 #include <model/file-odb.hxx>
+#include <model/filecontent.h>
+#include <model/filecontent-odb.hxx>
+
+#include <codeindex/codeindex.h>
 
 #include <parser/sourcemanager.h>
 #include <indexer/indexerprocess.h>
@@ -31,26 +42,67 @@ std::array<const char*, 15> excludedSuffixes{{
   ".Metrics.dat", ".pp"
 }};
 
-SearchParser::SearchParser(ParserContext& ctx_) : AbstractParser(ctx_),
-  _fileMagic(::magic_open(MAGIC_MIME_TYPE | MAGIC_SYMLINK))
+namespace
+{
+
+/**
+ * The files of the source manager are persisted in batches of this size,
+ * because persisting them blocks the other indexing threads.
+ */
+const std::size_t persistBatchSize = 500;
+
+/**
+ * The files are sent to the indexer processes in batches of this size, so the
+ * cost of a message is shared by many files.
+ */
+const std::size_t indexBatchSize = 256;
+
+::magic_t openFileMagic()
 {
-  if (!_fileMagic)
+  ::magic_t fileMagic = ::magic_open(MAGIC_MIME_TYPE | MAGIC_SYMLINK);
+
+  if (!fileMagic)
   {
     LOG(warning) << "Failed to create a libmagic cookie!";
   }
-  else if (::magic_load(_fileMagic, nullptr) != 0)
+  else if (::magic_load(fileMagic, nullptr) != 0)
   {
     LOG(warning)
       << "magic_load failed! libmagic error: "
-      << ::magic_error(_fileMagic);
+      << ::magic_error(fileMagic);
 
-    ::magic_close(_fileMagic);
-    _fileMagic = nullptr;
+    ::magic_close(fileMagic);
+    fileMagic = nullptr;
   }
 
+  return fileMagic;
+}
+
+}
+
+SearchParser::IndexShard::~IndexShard()
+{
+  // The thread uses the libmagic cookie, so it has to be stopped first.
+  pool.reset();
+
+  if (fileMagic)
+    ::magic_close(fileMagic);
+}
+
+SearchParser::SearchParser(ParserContext& ctx_) : AbstractParser(ctx_)
+{
   std::string wsDir = ctx_.options["workspace"].as<std::string>();
   std::string projDir = wsDir + '/' + ctx_.options["name"].as<std::string>();
   _searchDatabase = projDir + "/search";
+  _shardDirectory = projDir + "/search-shards";
+  _codeIndexPath = projDir + "/codeindex";
+
+  _indexProcessCount = ctx_.options.count("search-index-processes")
+    ? ctx_.options["search-index-processes"].as<std::size_t>()
+    : static_cast<std::size_t>(std::max(ctx_.options["jobs"].as<int>(), 1));
+
+  if (_indexProcessCount == 0)
+    _indexProcessCount = 1;
 
   if (_ctx.options.count("search-skip-directory"))
     for (const std::string& path
@@ -58,39 +110,211 @@ SearchParser::SearchParser(ParserContext& ctx_) : AbstractParser(ctx_),
     {
       _skipDirectories.push_back(fs::canonical(fs::absolute(path)).string());
     }
+}
 
-  try
-  {
-    //--- Close last instance (if any) ---//
+std::unique_ptr<IndexerProcess> SearchParser::openIndexer(
+  const std::string& indexDatabase_,
+  bool create_)
+{
+  return std::unique_ptr<IndexerProcess>(new IndexerProcess(
+    indexDatabase_,
+    _ctx.compassRoot,
+    create_
+      ? IndexerProcess::OpenMode::Create
+      : IndexerProcess::OpenMode::ReplaceExisting,
+    IndexerProcess::LockMode::Simple,
+    _ctx.options.count("logtarget")
+      ? _ctx.options["logtarget"].as<std::string>()
+      : ""));
+}
 
-    _indexProcess.reset();
+bool SearchParser::openShards()
+{
+  //--- A single shard writes the search database directly ---//
 
-    //--- Open a new process ---//
+  if (_indexProcessCount > 1)
+  {
+    fs::remove_all(_shardDirectory);
+    fs::create_directories(_shardDirectory);
+  }
 
-    _indexProcess.reset(new IndexerProcess(
-      _searchDatabase,
-      ctx_.compassRoot,
-      IndexerProcess::OpenMode::Create,
-      IndexerProcess::LockMode::Simple,
-      ctx_.options.count("logtarget")
-        ? ctx_.options["logtarget"].as<std::string>()
-        : ""));
+  try
+  {
+    for (std::size_t i = 0; i < _indexProcessCount; ++i)
+    {
+      std::unique_ptr<IndexShard> shard(new IndexShard);
+
+      shard->indexDatabase = _indexProcessCount == 1
+        ? _searchDatabase
+        : _shardDirectory + '/' + std::to_string(i);
+      shard->indexProcess = openIndexer(
+        shard->indexDatabase, _indexProcessCount > 1 || !_incremental);
+      shard->fileMagic = openFileMagic();
+
+      IndexShard& current = *shard;
+      shard->pool = util::make_thread_pool<std::string>(
+        1, [this, &current](const std::string& path_)
+        {
+          indexFile(current, path_);
+        }, true);
+
+      _shards.push_back(std::move(shard));
+    }
   }
   catch (const IndexerProcess::Failure& ex_)
   {
     LOG(error) << "Indexer process failure: " << ex_.what();
+    _shards.clear();
+    return false;
+  }
+
+  LOG(info) << "Search parser uses " << _shards.size()
+    << " indexer process(es).";
+
+  return true;
+}
+
+void SearchParser::openCodeIndex()
+{
+  if (!_ctx.options["search-code-index"].as<bool>())
+  {
+    // The search service would serve an outdated index.
+    boost::system::error_code ec;
+    fs::remove(_codeIndexPath, ec);
+    return;
+  }
+
+  _codeIndexBuilder.reset(new codeindex::CodeIndexBuilder(_codeIndexPath));
+
+  if (!_incremental)
+    return;
+
+  //--- The unchanged files are taken over from the previous index ---//
+
+  std::shared_ptr<const codeindex::CodeIndex> previous;
+
+  try
+  {
+    previous = codeindex::CodeIndex::open(_codeIndexPath);
+  }
+  catch (const std::exception& ex_)
+  {
+    LOG(warning) << ex_.what();
+  }
+
+  if (!previous)
+  {
+    // The unchanged files are in the search database already, only their
+    // contents are read from the database for the code index.
+    LOG(info) << "Code index is not available, the unchanged files are read "
+      "from the database.";
+    addUnchangedToCodeIndex();
+    return;
   }
+
+  _codeIndexBuilder->addFiles(*previous, [this](std::uint64_t fileId_)
+  {
+    return _indexedFileIds.count(fileId_) != 0;
+  });
+
+  LOG(info) << "Code index contains " << _codeIndexBuilder->fileCount()
+    << " unchanged files.";
+}
+
+void SearchParser::addUnchangedToCodeIndex()
+{
+  typedef odb::query<model::File> FileQuery;
+
+  std::vector<model::FileId> fileIds(
+    _indexedFileIds.begin(), _indexedFileIds.end());
+
+  util::OdbTransaction transaction(_ctx.db);
+  transaction([&, this]{
+    for (model::File& file : util::queryInChunks<model::File>(
+      *_ctx.db, fileIds, [](auto begin_, auto end_){
+        return FileQuery::id.in_range(begin_, end_);
+      }))
+    {
+      if (!file.content)
+        continue;
+
+      model::FileContentPtr content = file.content.load();
+      _codeIndexBuilder->addFile(file.id, file.path, content->content);
+    }
+  });
+}
+
+bool SearchParser::cleanupDatabase()
+{
+  if (!fs::is_directory(_searchDatabase) || fs::is_empty(_searchDatabase))
+    return true;
+
+  try
+  {
+    std::unique_ptr<IndexerProcess> indexer
+      = openIndexer(_searchDatabase, false);
+
+    for (const auto& item : _ctx.fileStatus)
+    {
+      switch (item.second)
+      {
+        case IncrementalStatus::MODIFIED:
+        case IncrementalStatus::DELETED:
+        case IncrementalStatus::ACTION_CHANGED:
+          LOG(debug) << "[searchparser] Index cleanup: " << item.first;
+          indexer->removeFile(std::to_string(util::fnvHash(item.first)));
+          ++_removedFileCount;
+          break;
+
+        case IncrementalStatus::ADDED:
+          // Empty deliberately, new files are found by the parse.
+          break;
+      }
+    }
+
+    std::set<std::string> fileIds;
+    indexer->getFileIds(fileIds);
+
+    for (const std::string& fileId : fileIds)
+      _indexedFileIds.insert(std::stoull(fileId));
+  }
+  catch (const std::exception& ex_)
+  {
+    LOG(warning)
+      << "Failed to clean up the search database, it will be rebuilt: "
+      << ex_.what();
+
+    _indexedFileIds.clear();
+    return true;
+  }
+
+  _incremental = true;
+
+  LOG(info) << "Search database contains " << _indexedFileIds.size()
+    << " unchanged files, " << _removedFileCount << " files removed.";
+
+  return true;
 }
 
 bool SearchParser::parse()
 {
-  if (fs::is_directory(_searchDatabase))
+  _parseStart = std::chrono::steady_clock::now();
+
+  if (!_incremental && fs::is_directory(_searchDatabase))
   {
     fs::remove_all(_searchDatabase);
     fs::create_directory(_searchDatabase);
     LOG(info) << "Search database already exists, dropping.";
   }
 
+  openCodeIndex();
+
+  if (!openShards())
+  {
+    LOG(warning) << "Indexer process is not available, skip search parsing.";
+    return true;
+  }
+
   for (const std::string& path :
     _ctx.options["input"].as<std::vector<std::string>>())
   {
@@ -115,14 +339,8 @@ bool SearchParser::parse()
   return true;
 }
 
-util::DirIterCallback SearchParser::getParserCallback(const std::string& path_)
+util::DirIterCallback SearchParser::getParserCallback(const std::string&)
 {
-  if (!_indexProcess)
-  {
-    LOG(warning) << "Indexer process is not available, skip path: " << path_;
-    return [](const std::string&){ return false; };
-  }
-
   return [this](const std::string& currPath_)
   {
     if (fs::is_directory(currPath_))
@@ -138,35 +356,106 @@ util::DirIterCallback SearchParser::getParserCallback(const std::string& path_)
       }
     }
 
+    // The unchanged files are in the search database already.
+    if (!_indexedFileIds.empty())
+    {
+      boost::system::error_code ec;
+      fs::path canonicalPath = fs::canonical(currPath_, ec);
+
+      if (!ec && _indexedFileIds.count(util::fnvHash(canonicalPath.native())))
+        return true;
+    }
+
     if (!shouldHandle(currPath_))
       return true;
 
-    model::FilePtr file = _ctx.srcMgr.getFile(currPath_);
+    // The shards get the files in turns, so they are disjoint.
+    IndexShard& shard = *_shards[_fileCounter++ % _shards.size()];
+    shard.pool->enqueue(currPath_);
+
+    return true;
+  };
+}
+
+void SearchParser::indexFile(IndexShard& shard_, const std::string& path_)
+{
+  try
+  {
+    model::FilePtr file;
+    odb::lazy_shared_ptr<model::FileContent> content;
 
-    if (file)
     {
-      std::string mimeType("text/plain");
-      if (_fileMagic)
-      {
-        const char* mimeStr = ::magic_file(_fileMagic, currPath_.c_str());
-
-        if (mimeStr)
-          mimeType = mimeStr;
-        else
-          LOG(warning)
-            << "Failed to get mime type for file '"
-            << currPath_ << "'. libmagic error: "
-            << ::magic_error(_fileMagic);
-      }
+      // The flag has to be set before the file is persisted. The content
+      // pointer is unloaded by persisting, so it's copied here as well.
+      std::shared_lock<std::shared_timed_mutex> lock(_persistMutex);
+
+      file = _ctx.srcMgr.getFile(path_);
+      if (!file)
+        return;
 
       file->inSearchIndex = true;
+      content = file->content;
+    }
+
+    if (_codeIndexBuilder && content)
+      addToCodeIndex(*file, content);
+
+    std::string mimeType("text/plain");
+    if (shard_.fileMagic)
+    {
+      const char* mimeStr = ::magic_file(shard_.fileMagic, path_.c_str());
+
+      if (mimeStr)
+        mimeType = mimeStr;
+      else
+        LOG(warning)
+          << "Failed to get mime type for file '"
+          << path_ << "'. libmagic error: "
+          << ::magic_error(shard_.fileMagic);
+    }
+
+    if (++_indexedFileCount % persistBatchSize == 0)
+    {
+      std::lock_guard<std::shared_timed_mutex> lock(_persistMutex);
       _ctx.srcMgr.persistFiles();
-      _indexProcess->indexFile(
-        std::to_string(file->id), file->path, mimeType);
     }
 
-    return true;
-  };
+    search::FileToIndex fileToIndex;
+    fileToIndex.fileId = std::to_string(file->id);
+    fileToIndex.filePath = file->path;
+    fileToIndex.mimeType = std::move(mimeType);
+    shard_.batch.push_back(std::move(fileToIndex));
+
+    if (shard_.batch.size() >= indexBatchSize)
+      sendBatch(shard_);
+  }
+  catch (const std::exception& ex_)
+  {
+    LOG(warning) << "Failed to index file '" << path_ << "': " << ex_.what();
+  }
+}
+
+void SearchParser::addToCodeIndex(
+  const model::File& file_,
+  odb::lazy_shared_ptr<model::FileContent> content_)
+{
+  model::FileContentPtr content = content_.get_eager();
+
+  if (!content)
+  {
+    util::OdbTransaction transaction(_ctx.db);
+    transaction([&]{
+      content = content_.load();
+    });
+  }
+
+  _codeIndexBuilder->addFile(file_.id, file_.path, content->content);
+}
+
+void SearchParser::sendBatch(IndexShard& shard_)
+{
+  shard_.indexProcess->indexFiles(shard_.batch);
+  shard_.batch.clear();
 }
 
 bool SearchParser::shouldHandle(const std::string& path_)
@@ -215,22 +504,111 @@ bool SearchParser::shouldHandle(const std::string& path_)
 
 void SearchParser::postParse()
 {
-  _indexProcess->buildSuggestions();
+  //--- Wait for the shards to hand over their files ---//
+
+  for (const std::unique_ptr<IndexShard>& shard : _shards)
+  {
+    shard->pool->wait();
+
+    try
+    {
+      if (!shard->batch.empty())
+        sendBatch(*shard);
+    }
+    catch (const std::exception& ex_)
+    {
+      LOG(warning) << "Failed to send files to the indexer: " << ex_.what();
+    }
+  }
+
+  _ctx.srcMgr.persistFiles();
+
+  // The suggestions are built from the whole index, so they are rebuilt only
+  // if the index has changed.
+  bool changed =
+    !_incremental || _indexedFileCount > 0 || _removedFileCount > 0;
+
+  if (!changed)
+    LOG(info) << "Search database is up to date.";
+
   try
   {
-    // Wait for indexer process to exit.
-    _indexProcess.reset(nullptr);
+    if (_shards.size() == 1)
+    {
+      if (changed)
+        _shards.front()->indexProcess->buildSuggestions();
+
+      // Wait for indexer process to exit.
+      _shards.clear();
+    }
+    else
+    {
+      //--- Wait for the indexer processes to finish the shards ---//
+
+      std::vector<std::string> shardDatabases;
+      for (const std::unique_ptr<IndexShard>& shard : _shards)
+        shardDatabases.push_back(shard->indexDatabase);
+
+      _shards.clear();
+
+      //--- Merge the shards into the search database ---//
+
+      if (changed)
+      {
+        LOG(info) << "Merging " << shardDatabases.size()
+          << " search index shards.";
+
+        std::unique_ptr<IndexerProcess> merger
+          = openIndexer(_searchDatabase, !_incremental);
+        merger->mergeIndexes(shardDatabases);
+        merger->buildSuggestions();
+
+        // Wait for indexer process to exit.
+        merger.reset();
+      }
+    }
+  }
+  catch (const IndexerProcess::Failure& ex_)
+  {
+    LOG(error) << "Indexer process failure: " << ex_.what();
   }
   catch (...)
   {
     LOG(warning) << "Unknown exception in endTravarse()!";
   }
+
+  fs::remove_all(_shardDirectory);
+
+  //--- Write the native code index ---//
+
+  if (_codeIndexBuilder && (changed || !fs::exists(_codeIndexPath)))
+  {
+    try
+    {
+      _codeIndexBuilder->write();
+
+      LOG(info) << "Code index written with "
+        << _codeIndexBuilder->fileCount() << " files.";
+    }
+    catch (const std::exception& ex_)
+    {
+      LOG(warning) << "Failed to write the code index: " << ex_.what();
+    }
+  }
+
+  _codeIndexBuilder.reset();
+
+  double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - _parseStart).count();
+
+  LOG(info)
+    << "Search parser indexed " << _indexedFileCount << " files in "
+    << seconds << " s (" << (seconds > 0 ? _indexedFileCount / seconds : 0)
+    << " files/s).";
 }
 
 SearchParser::~SearchParser()
 {
-  if (_fileMagic)
-    ::magic_close(_fileMagic);
 }
 
 #pragma clang diagnostic push
@@ -244,7 +622,16 @@ extern "C"
     description.add_options()
       ("search-skip-directory", po::value<std::vector<std::string>>(),
        "Directories can be skipped during the parse. Here you can list the "
-       "paths of the directories.");
+       "paths of the directories.")
+      ("search-index-processes", po::value<std::size_t>(),
+       "Number of the indexer processes. The files are split among them and "
+       "their indexes are merged at the end. Each process is a JVM of its "
+       "own, so mind the memory. By default, it's the number of jobs.")
+      ("search-code-index", po::value<bool>()->default_value(false),
+       "Build a native trigram index of the file contents for the regex and "
+       "literal code search. The contents are kept in memory until the end "
+       "of the parse. The index is stored in the project's workspace "
+       "directory, and it's about three times as large as the sources.");
 
     return description;
   }
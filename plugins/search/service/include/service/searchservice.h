@@ -14,7 +14,11 @@
 
 #include <SearchService.h>
 
-#include <service/serviceprocess.h>
+#include <codeindex/codeindex.h>
+#include <projectservice/filenameindex.h>
+#include <util/projectgeneration.h>
+#include <service/searchstream.h>
+#include <service/serviceprocesspool.h>
 
 namespace cc
 {
@@ -23,6 +27,9 @@ namespace service
 namespace search
 {
 
+class QueryLog;
+class SuggestionCache;
+
 class SearchServiceHandler : virtual public SearchServiceIf {
 public:
 
@@ -35,6 +42,18 @@ public:
     SearchResult& _return,
     const SearchParams& params_) override;
 
+  void startSearch(
+    SearchProgress& _return,
+    const SearchParams& params_,
+    const std::int32_t timeoutMs_) override;
+
+  void continueSearch(
+    SearchProgress& _return,
+    const std::string& continuation_,
+    const std::int32_t timeoutMs_) override;
+
+  void cancelSearch(const std::string& continuation_) override;
+
   void searchFile(
     FileSearchResult& _return,
     const SearchParams&     params_) override;
@@ -46,6 +65,10 @@ public:
   void suggest(SearchSuggestions& _return,
     const SearchSuggestionParams& params_) override;
 
+  void getStatistics(
+    SearchStatistics& _return,
+    const std::int32_t maxQueries_) override;
+
 private:
   /**
    * Validates a regluar expression. If the expression is invalid then a thrift
@@ -55,10 +78,91 @@ private:
    */
   static void validateRegexp(const std::string& regexp_);
 
+  /**
+   * Runs a text, definition or log search on the search service processes.
+   * The range of the parameters is requested in growing chunks, so the first
+   * results arrive early and a broad query doesn't hold a process for long,
+   * but the query is not run again for every few files.
+   * @param profile_ The time of the search is added to it.
+   * @return The number of the matching files.
+   */
+  std::size_t searchText(
+    SearchStream& stream_,
+    const SearchParams& params_,
+    QueryProfile& profile_);
+
+  /**
+   * Checks the parameters of a code search and returns the code index.
+   * @throw SearchException if the index is missing or the query is invalid.
+   */
+  std::shared_ptr<const codeindex::CodeIndex> prepareCodeSearch(
+    const SearchParams& params_);
+
+  /**
+   * Runs a regex or literal search on the native code index.
+   * @param profile_ The time of the search is added to it.
+   * @return The number of the matching files.
+   */
+  std::size_t searchCode(
+    SearchStream& stream_,
+    const codeindex::CodeIndex& index_,
+    const SearchParams& params_,
+    QueryProfile& profile_);
+
+  /**
+   * Fetches the next part of the results of a search started by
+   * startSearch().
+   */
+  void fetchProgress(
+    SearchProgress& return_,
+    const std::string& continuation_,
+    std::int32_t timeoutMs_);
+
+  /**
+   * Returns the native code index of the project or nullptr if the project
+   * was parsed without it. The index is reopened when the project is parsed
+   * again.
+   */
+  std::shared_ptr<const codeindex::CodeIndex> codeIndex();
+
+  /**
+   * Runs the query on a search service process and logs its time.
+   *
+   * @param name_ Name of the query for the log.
+   * @return The time of waiting for the process and running the query.
+   */
+  template <typename F>
+  ServiceProcessPool::Timing callJavaProcess(const char* name_, F func_);
+
   std::shared_ptr<odb::database> _db;
 
-  std::unique_ptr<ServiceProcess> _javaProcess;
-  std::mutex _javaProcessMutex;
+  std::shared_ptr<core::FileNameIndex> _fileNameIndex;
+
+  const std::string _codeIndexPath;
+  util::ProjectGeneration _generation;
+
+  /**
+   * Guards the fields of the code index below.
+   */
+  std::mutex _codeIndexMutex;
+  std::shared_ptr<const codeindex::CodeIndex> _codeIndex;
+  std::uint64_t _codeIndexGeneration = 0;
+  bool _codeIndexOpened = false;
+
+  std::shared_ptr<SuggestionCache> _suggestionCache;
+
+  /**
+   * Profiles of the recent queries for getStatistics().
+   */
+  std::shared_ptr<QueryLog> _queryLog;
+
+  std::unique_ptr<ServiceProcessPool> _javaProcesses;
+
+  /**
+   * The searches started by startSearch(). It is the last member, so the
+   * searches are stopped before the rest is destroyed.
+   */
+  SearchStreams _streams;
 };
 
 } // search
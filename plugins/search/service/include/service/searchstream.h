@@ -0,0 +1,175 @@
+#ifndef CC_SERVICE_SEARCHSTREAM_H
+#define CC_SERVICE_SEARCHSTREAM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <util/threadpool.h>
+
+#include <SearchService.h>
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+/**
+ * Results of a search which are produced by a background thread and fetched
+ * by the client part by part.
+ */
+class SearchStream
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * @param pageSize_ Number of the result entries requested by the client.
+   */
+  explicit SearchStream(
+    std::size_t pageSize_ = std::numeric_limits<std::size_t>::max());
+
+  //--- Producer side ---//
+
+  /**
+   * Adds a result entry in the requested range.
+   * @return False if the search has to stop.
+   */
+  bool add(SearchResultEntry entry_);
+
+  /**
+   * Sets the number of the file matches found so far.
+   * @return False if the search has to stop.
+   */
+  bool setTotal(std::size_t total_);
+
+  /**
+   * Returns true if the client is not interested in the results anymore.
+   */
+  bool cancelled() const;
+
+  /**
+   * Marks the end of the results. If the search failed then the message is
+   * sent to the client as a SearchException.
+   */
+  void finish(const std::string& error_ = std::string());
+
+  //--- Client side ---//
+
+  /**
+   * Waits until the requested range is filled, the search is finished or the
+   * timeout expires, then takes the result entries found since the previous
+   * call.
+   * @throw SearchException if the search failed.
+   */
+  void fetch(SearchProgress& return_, Clock::duration timeout_);
+
+  void cancel();
+
+  /**
+   * Returns true if the search is finished and its results were fetched.
+   */
+  bool drained() const;
+
+  /**
+   * The time of the last call of fetch().
+   */
+  Clock::time_point lastAccess() const;
+
+private:
+  mutable std::mutex _mutex;
+  std::condition_variable _signal;
+
+  const std::size_t _pageSize;
+  std::size_t _added = 0;
+  std::vector<SearchResultEntry> _entries;
+  std::size_t _total = 0;
+
+  bool _pageDelivered = false;
+  bool _finished = false;
+  bool _drained = false;
+  std::string _error;
+
+  std::atomic<bool> _cancelled{false};
+  Clock::time_point _lastAccess;
+};
+
+/**
+ * Searches running on a fixed pool of threads, identified by random
+ * continuation tokens. A search which is not fetched for a while is cancelled
+ * and forgotten, so the clients which navigated away don't leak them.
+ */
+class SearchStreams
+{
+public:
+  typedef std::function<void(SearchStream&)> Producer;
+
+  /**
+   * @param maxStreams_ Maximal number of the searches kept at the same time.
+   * Over this the least recently fetched one is cancelled.
+   * @param idleTimeout_ Searches which are not fetched for this long are
+   * cancelled.
+   * @param threads_ Number of the searches running at the same time. The
+   * others wait in a queue.
+   */
+  SearchStreams(
+    std::size_t maxStreams_,
+    SearchStream::Clock::duration idleTimeout_,
+    std::size_t threads_);
+
+  /**
+   * Cancels the searches and joins the threads.
+   */
+  ~SearchStreams();
+
+  /**
+   * Queues the producer on the thread pool. A search cancelled before it
+   * starts is not run. The exceptions thrown by the producer are reported to
+   * the client by SearchStream::fetch().
+   * @param pageSize_ Number of the result entries requested by the client.
+   * @return The continuation token of the search.
+   */
+  std::string start(std::size_t pageSize_, Producer producer_);
+
+  /**
+   * Returns the search of the token or nullptr if it is unknown, expired or
+   * its results were fetched already.
+   */
+  std::shared_ptr<SearchStream> get(const std::string& token_);
+
+  void cancel(const std::string& token_);
+
+private:
+  /**
+   * Forgets the drained and the expired searches. Has to be called under
+   * _mutex.
+   */
+  void sweep();
+
+  std::string newToken();
+
+  const std::size_t _maxStreams;
+  const SearchStream::Clock::duration _idleTimeout;
+
+  std::mutex _mutex;
+  std::map<std::string, std::shared_ptr<SearchStream>> _streams;
+  std::mt19937_64 _random;
+
+  std::unique_ptr<util::JobQueueThreadPool<std::function<void()>>> _threads;
+};
+
+} // search
+} // service
+} // cc
+
+#endif // CC_SERVICE_SEARCHSTREAM_H
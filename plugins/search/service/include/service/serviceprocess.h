@@ -114,6 +114,30 @@ public:
     _service->search(_return, params_);
   }
 
+  void startSearch(
+    SearchProgress& _return,
+    const SearchParams& params_,
+    const std::int32_t timeoutMs_) override
+  {
+    checkProcess();
+    _service->startSearch(_return, params_, timeoutMs_);
+  }
+
+  void continueSearch(
+    SearchProgress& _return,
+    const std::string& continuation_,
+    const std::int32_t timeoutMs_) override
+  {
+    checkProcess();
+    _service->continueSearch(_return, continuation_, timeoutMs_);
+  }
+
+  void cancelSearch(const std::string& continuation_) override
+  {
+    checkProcess();
+    _service->cancelSearch(continuation_);
+  }
+
   void searchFile(
     FileSearchResult& _return,
     const SearchParams& params_) override
@@ -142,6 +166,14 @@ public:
     _service->suggest(_return, params_);
   }
 
+  void getStatistics(
+    SearchStatistics& _return,
+    const std::int32_t maxQueries_) override
+  {
+    checkProcess();
+    _service->getStatistics(_return, maxQueries_);
+  }
+
 private:
   /**
    * Throws a thrift exception if the service process is dead.
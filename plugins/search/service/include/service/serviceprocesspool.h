@@ -0,0 +1,302 @@
+#ifndef CC_SERVICE_SERVICEPROCESSPOOL_H
+#define CC_SERVICE_SERVICEPROCESSPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <thrift/transport/TTransportException.h>
+
+#include <util/logutil.h>
+
+#include <service/serviceprocess.h>
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+/**
+ * Pool of search service processes opened on the same index. The index is
+ * only read by the services, so the processes can serve queries in parallel.
+ * A query is sent to the process with the fewest queued queries. A process
+ * serves one query at a time, the others wait for it in a queue.
+ *
+ * A process which died is restarted in the background, in the meantime the
+ * queries are served by the others.
+ *
+ * The pool is written against the Process type so that the restarts can be
+ * tested without starting Java processes. A Process has to provide isAlive()
+ * and throw Process::ProcessDied from a call when it is dead.
+ */
+template <typename Process>
+class BasicServiceProcessPool
+{
+public:
+  typedef std::function<std::unique_ptr<Process>()> Factory;
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Thrown when no process is alive to serve a query.
+   */
+  class Unavailable : public apache::thrift::TException
+  {
+  public:
+    Unavailable() :
+      apache::thrift::TException("No search service process is running.") {}
+  };
+
+  /**
+   * Time of a call: waiting for a free process and running the query.
+   */
+  struct Timing
+  {
+    Clock::duration wait;
+    Clock::duration run;
+  };
+
+  /**
+   * Starts the processes.
+   * @param size_ Number of processes, at least one is started.
+   * @param factory_ Starts a new process.
+   * @param retryDelay_ Time to wait before retrying a failed restart.
+   */
+  BasicServiceProcessPool(
+    std::size_t size_,
+    Factory factory_,
+    Clock::duration retryDelay_ = std::chrono::seconds(5))
+    : _factory(std::move(factory_)), _retryDelay(retryDelay_)
+  {
+    if (size_ == 0)
+      size_ = 1;
+
+    for (std::size_t i = 0; i < size_; ++i)
+    {
+      std::unique_ptr<Slot> slot(new Slot);
+      slot->process = _factory();
+      slot->alive = true;
+
+      _slots.push_back(std::move(slot));
+    }
+
+    _restarter = std::thread(&BasicServiceProcessPool::restarter, this);
+  }
+
+  ~BasicServiceProcessPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_restartMutex);
+      _stop = true;
+    }
+
+    _restartSignal.notify_all();
+    _restarter.join();
+  }
+
+  /**
+   * Calls the function with the least loaded live process. If the process
+   * died, the query is retried on another one.
+   * @throw Unavailable if no process is alive.
+   */
+  template <typename F>
+  Timing call(F func_)
+  {
+    for (std::size_t attempt = 0; attempt < _slots.size(); ++attempt)
+    {
+      Slot* slot = acquire();
+      if (!slot)
+        break;
+
+      Clock::time_point queued = Clock::now();
+      std::unique_lock<std::mutex> lock(slot->mutex);
+      Clock::time_point started = Clock::now();
+
+      if (!slot->process)
+      {
+        // The process died while this query was waiting for it.
+        lock.unlock();
+        release(slot);
+        continue;
+      }
+
+      try
+      {
+        func_(*slot->process);
+      }
+      catch (const typename Process::ProcessDied&)
+      {
+        died(slot, lock);
+        continue;
+      }
+      catch (const apache::thrift::transport::TTransportException&)
+      {
+        // The process may have died during the query.
+        if (slot->process->isAlive())
+        {
+          lock.unlock();
+          release(slot);
+          throw;
+        }
+
+        died(slot, lock);
+        continue;
+      }
+      catch (...)
+      {
+        lock.unlock();
+        release(slot);
+        throw;
+      }
+
+      Timing timing{started - queued, Clock::now() - started};
+
+      lock.unlock();
+      release(slot);
+
+      return timing;
+    }
+
+    throw Unavailable();
+  }
+
+private:
+  struct Slot
+  {
+    /**
+     * Guards the process: a process serves one query at a time.
+     */
+    std::mutex mutex;
+    std::unique_ptr<Process> process;
+
+    /**
+     * Number of the queries queued for or served by the process.
+     */
+    std::atomic<std::size_t> load{0};
+    std::atomic_bool alive{false};
+  };
+
+  /**
+   * Returns the least loaded live slot with its load incremented, or nullptr
+   * if all processes are dead.
+   */
+  Slot* acquire()
+  {
+    Slot* best = nullptr;
+
+    for (const std::unique_ptr<Slot>& slot : _slots)
+      if (slot->alive && (!best || slot->load < best->load))
+        best = slot.get();
+
+    if (best)
+      ++best->load;
+
+    return best;
+  }
+
+  void release(Slot* slot_)
+  {
+    --slot_->load;
+  }
+
+  /**
+   * Takes the dead process out of the slot and schedules its restart.
+   */
+  void died(Slot* slot_, std::unique_lock<std::mutex>& lock_)
+  {
+    LOG(error) << "Search service process died, restarting it.";
+
+    slot_->alive = false;
+
+    // The dead process is destroyed out of the lock.
+    std::unique_ptr<Process> process = std::move(slot_->process);
+    lock_.unlock();
+    release(slot_);
+
+    process.reset();
+
+    {
+      std::lock_guard<std::mutex> lock(_restartMutex);
+      _restartQueue.push(slot_);
+    }
+
+    _restartSignal.notify_one();
+  }
+
+  /**
+   * Restarts the dead processes in the background.
+   */
+  void restarter()
+  {
+    std::unique_lock<std::mutex> lock(_restartMutex);
+
+    while (true)
+    {
+      _restartSignal.wait(lock,
+        [this]{ return _stop || !_restartQueue.empty(); });
+
+      if (_stop)
+        return;
+
+      Slot* slot = _restartQueue.front();
+      _restartQueue.pop();
+
+      lock.unlock();
+
+      std::unique_ptr<Process> process;
+
+      try
+      {
+        process = _factory();
+      }
+      catch (const std::exception& ex)
+      {
+        LOG(error)
+          << "Couldn't restart search service process: " << ex.what();
+      }
+
+      lock.lock();
+
+      if (!process)
+      {
+        // Try again a bit later, unless the pool is being destroyed.
+        _restartQueue.push(slot);
+        _restartSignal.wait_for(lock, _retryDelay, [this]{ return _stop; });
+        continue;
+      }
+
+      {
+        std::lock_guard<std::mutex> slotLock(slot->mutex);
+        slot->process = std::move(process);
+        slot->alive = true;
+      }
+
+      LOG(info) << "Search service process restarted.";
+    }
+  }
+
+  const Factory _factory;
+  const Clock::duration _retryDelay;
+  std::vector<std::unique_ptr<Slot>> _slots;
+
+  std::mutex _restartMutex;
+  std::condition_variable _restartSignal;
+  std::queue<Slot*> _restartQueue;
+  bool _stop = false;
+  std::thread _restarter;
+};
+
+typedef BasicServiceProcessPool<ServiceProcess> ServiceProcessPool;
+
+} // search
+} // service
+} // cc
+
+#endif // CC_SERVICE_SERVICEPROCESSPOOL_H
@@ -14,23 +14,35 @@ import cc.search.service.app.SearchAppCommon;
 import cc.search.suggestion.SuggestionHandler;
 import cc.service.search.FileSearchResult;
 import cc.service.core.InvalidId;
+import cc.service.search.IndexFieldStatistics;
+import cc.service.search.IndexStatistics;
+import cc.service.search.QueryProfile;
 import cc.service.search.SearchResult;
 import cc.service.search.SearchResultEntry;
 import cc.service.search.SearchException;
 import cc.service.search.SearchOptions;
 import cc.service.search.SearchParams;
+import cc.service.search.SearchProgress;
 import cc.service.search.SearchSuggestionParams;
 import cc.service.search.SearchSuggestions;
 import cc.service.search.SearchService;
+import cc.service.search.SearchStatistics;
+import cc.service.search.SearchTiming;
 import cc.service.search.SearchType;
 import java.io.IOException;
-import java.util.Date;
+import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.List;
 import java.util.Set;
+import java.util.TreeMap;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 import org.apache.lucene.analysis.Analyzer;
+import org.apache.lucene.index.AtomicReaderContext;
+import org.apache.lucene.index.DirectoryReader;
+import org.apache.lucene.index.Fields;
 import org.apache.lucene.index.Term;
+import org.apache.lucene.index.Terms;
 import org.apache.lucene.queryparser.classic.ParseException;
 import org.apache.lucene.search.BooleanClause;
 import org.apache.lucene.search.BooleanQuery;
@@ -39,6 +51,7 @@ import org.apache.lucene.search.Query;
 import org.apache.lucene.search.QueryWrapperFilter;
 import org.apache.lucene.search.RegexpQuery;
 import org.apache.lucene.search.TopDocs;
+import org.apache.lucene.store.Directory;
 import org.apache.thrift.TException;
 
 /**
@@ -108,7 +121,7 @@ abstract class SearchHandler extends SearchAppCommon
     _log.info("Running text query...");
     _log.finer(params_.toString());
 
-    Date start = new Date();
+    long start = System.nanoTime();
     
     final Filter filter = getFilterForSearch(params_);
     TopDocs docs;
@@ -120,23 +133,99 @@ abstract class SearchHandler extends SearchAppCommon
       docs = search(context_.get(), filter);
     }
     
+    final long matchTime = System.nanoTime() - start;
     _log.log(Level.INFO, "Got {1} doc(s) in {0} total milliseconds",
         new Object[] {
-          new Date().getTime() - start.getTime(),
+          matchTime / 1000000,
           docs.scoreDocs.length
         });
 
-    start = new Date();
+    start = System.nanoTime();
     List<SearchResultEntry> entries = computeResultEntries(context_, docs);
     
+    final long lineMatchTime = System.nanoTime() - start;
     _log.log(Level.INFO, "Got {1} result(s) in {0} total milliseconds",
         new Object[] {
-          new Date().getTime() - start.getTime(),
+          lineMatchTime / 1000000,
           entries.size()
         });
     
-    return new SearchResult(
+    SearchResult result = new SearchResult(
       Math.min(docs.totalHits, DEFAULT_HIT_LIMIT), entries);
+    result.setTiming(
+      new SearchTiming(matchTime / 1000, lineMatchTime / 1000));
+
+    return result;
+  }
+
+  /**
+   * Collects the statistics of the index.
+   *
+   * @return the index statistics.
+   * @throws IOException
+   */
+  private IndexStatistics getIndexStatistics() throws IOException {
+    final IndexStatistics stats = new IndexStatistics();
+    stats.setDocumentCount(_indexReader.numDocs());
+    stats.setDeletedDocumentCount(_indexReader.numDeletedDocs());
+    stats.setSegmentCount(_indexReader.leaves().size());
+    stats.setFields(new ArrayList<IndexFieldStatistics>());
+    stats.setFileSizes(new HashMap<String, Long>());
+
+    // The fields are summed over the segments.
+    final TreeMap<String, IndexFieldStatistics> fields = new TreeMap<>();
+
+    for (AtomicReaderContext leaf : _indexReader.leaves()) {
+      final Fields leafFields = leaf.reader().fields();
+      if (leafFields == null) {
+        continue;
+      }
+
+      for (String field : leafFields) {
+        final Terms terms = leafFields.terms(field);
+        if (terms == null) {
+          continue;
+        }
+
+        IndexFieldStatistics fieldStats = fields.get(field);
+        if (fieldStats == null) {
+          fieldStats = new IndexFieldStatistics(field, 0, 0, 0);
+          fields.put(field, fieldStats);
+        }
+
+        fieldStats.documentCount += terms.getDocCount();
+        fieldStats.termCount = addKnown(fieldStats.termCount, terms.size());
+        fieldStats.tokenCount = addKnown(fieldStats.tokenCount,
+          terms.getSumTotalTermFreq());
+      }
+    }
+
+    stats.fields.addAll(fields.values());
+
+    if (_indexReader instanceof DirectoryReader) {
+      final Directory dir = ((DirectoryReader) _indexReader).directory();
+
+      for (String file : dir.listAll()) {
+        final long size = dir.fileLength(file);
+        final int dot = file.lastIndexOf('.');
+        final String type = dot != -1
+          ? file.substring(dot + 1)
+          : file.replaceFirst("_.*", "");
+
+        final Long sum = stats.fileSizes.get(type);
+        stats.fileSizes.put(type, sum == null ? size : sum + size);
+        stats.sizeBytes += size;
+      }
+    }
+
+    return stats;
+  }
+
+  /**
+   * Adds two statistic values where -1 means unknown.
+   */
+  private static long addKnown(long sum_, long value_) {
+    return sum_ == -1 || value_ == -1 ? -1 : sum_ + value_;
   }
   
   /**
@@ -197,6 +286,23 @@ abstract class SearchHandler extends SearchAppCommon
     }
   }
 
+  @Override
+  public SearchProgress startSearch(SearchParams params_, int timeoutMs_)
+    throws TException {
+    throw new UnsupportedOperationException("Not supported yet.");
+  }
+
+  @Override
+  public SearchProgress continueSearch(String continuation_, int timeoutMs_)
+    throws TException {
+    throw new UnsupportedOperationException("Not supported yet.");
+  }
+
+  @Override
+  public void cancelSearch(String continuation_) throws TException {
+    throw new UnsupportedOperationException("Not supported yet.");
+  }
+
   @Override
   public FileSearchResult searchFile(SearchParams params_) throws TException {
     throw new UnsupportedOperationException("Not supported yet.");
@@ -207,6 +313,24 @@ abstract class SearchHandler extends SearchAppCommon
     throw new UnsupportedOperationException("Not supported yet.");
   }
 
+  @Override
+  public SearchStatistics getStatistics(int maxQueries_) throws TException {
+    // The query profiles are collected by the C++ side of the service.
+    try {
+      final SearchStatistics stats = new SearchStatistics();
+      stats.setIndex(getIndexStatistics());
+      stats.setSlowestQueries(new ArrayList<QueryProfile>());
+      stats.setCaches(new HashMap<String, String>());
+
+      return stats;
+    } catch (IOException ex) {
+      _log.log(Level.SEVERE, "Getting index statistics failed!", ex);
+      SearchException exc = new SearchException();
+      exc.message = ex.getMessage();
+      throw exc;
+    }
+  }
+
   @Override
   public SearchSuggestions suggest(SearchSuggestionParams params_)
     throws TException {
@@ -28,7 +28,15 @@ enum SearchOptions
   /**
    * Try to find a logging region by a line from a log file.
    */
-  FindLogText       = 0x0040
+  FindLogText       = 0x0040,
+  /**
+   * Do a regular expression search in the source by the native code index
+   */
+  SearchCodeRegex   = 0x0080,
+  /**
+   * Do a literal text search in the source by the native code index
+   */
+  SearchCodeLiteral = 0x0100
 }
 
 /**
@@ -174,6 +182,21 @@ struct SearchResultEntry
   2:project.FileInfo finfo,
 }
 
+/**
+ * Time split of a query run by a search service process, in microseconds.
+ */
+struct SearchTiming
+{
+  /**
+   * Running the query on the index.
+   */
+  1:i64 matchUs,
+  /**
+   * Finding the matching lines in the result documents.
+   */
+  2:i64 lineMatchUs
+}
+
 /**
  * Describes a search result
  */
@@ -186,7 +209,33 @@ struct SearchResult
   /**
    * The results in the actual range: [firstFileIndex, lastFileIndex]
    */
-  2:list<SearchResultEntry> results
+  2:list<SearchResultEntry> results,
+  /**
+   * Time split of the query, set by the search service process.
+   */
+  3:optional SearchTiming timing
+}
+
+/**
+ * A part of the result of a search running in the background (see
+ * SearchService.startSearch).
+ */
+struct SearchProgress
+{
+  /**
+   * The result entries found since the previous call. totalFiles is the number
+   * of the file matches found so far.
+   */
+  1:SearchResult result,
+  /**
+   * True if the search is finished. Then totalFiles is final and the search
+   * can't be continued.
+   */
+  2:bool complete,
+  /**
+   * Identifies the search in continueSearch() and cancelSearch() calls.
+   */
+  3:string continuation
 }
 
 /**
@@ -239,6 +288,100 @@ struct RangedHitCountResult
   3:string              query
 }
 
+/**
+ * Statistics of a field of the search index.
+ */
+struct IndexFieldStatistics
+{
+  1:string field,
+  /**
+   * Number of the documents having the field.
+   */
+  2:i64 documentCount,
+  /**
+   * Number of the distinct terms summed over the index segments, -1 if
+   * unknown.
+   */
+  3:i64 termCount,
+  /**
+   * Number of the term occurrences, -1 if unknown.
+   */
+  4:i64 tokenCount
+}
+
+/**
+ * Statistics of the search index.
+ */
+struct IndexStatistics
+{
+  1:i64 documentCount,
+  2:i64 deletedDocumentCount,
+  3:i64 segmentCount,
+  /**
+   * Size of the index on the disk in bytes.
+   */
+  4:i64 sizeBytes,
+  5:list<IndexFieldStatistics> fields,
+  /**
+   * Size of the index files in bytes by their extension, e.g. "tim" for the
+   * terms, "pos" for the positions and "tvd" for the term vectors. Compound
+   * segments ("cfs") are not broken down.
+   */
+  6:map<string, i64> fileSizes
+}
+
+/**
+ * Time split of a query served by the search service, in microseconds.
+ */
+struct QueryProfile
+{
+  /**
+   * The called service method.
+   */
+  1:string method,
+  2:string query,
+  3:i64 options,
+  /**
+   * Start of the query in milliseconds since the epoch.
+   */
+  4:i64 startTime,
+  5:i64 totalUs,
+  /**
+   * Waiting for a free search service process.
+   */
+  6:i64 queueWaitUs,
+  /**
+   * Communication with the search service process.
+   */
+  7:i64 ipcUs,
+  /**
+   * Running the query on the Lucene index, the code index or the file name
+   * index.
+   */
+  8:i64 matchUs,
+  /**
+   * Finding the matching lines in the result files.
+   */
+  9:i64 lineMatchUs,
+  10:i64 resultCount
+}
+
+/**
+ * Statistics for tuning a search deployment.
+ */
+struct SearchStatistics
+{
+  1:IndexStatistics index,
+  /**
+   * The slowest queries among the recent ones, slowest first.
+   */
+  2:list<QueryProfile> slowestQueries,
+  /**
+   * Statistics of the caches and the native indexes of the service.
+   */
+  3:map<string, string> caches
+}
+
 /**
  * The search service.
  */
@@ -250,6 +393,32 @@ service SearchService
   SearchResult search(
     1:SearchParams params_) throws(1:SearchException se),
 
+  /**
+   * Starts a text search in the background. The result entries in the range of
+   * the parameters are returned as they are found: the call returns when the
+   * range is filled, the search is finished or the timeout expires, whichever
+   * comes first. The rest can be fetched by continueSearch().
+   *
+   * A search which is not continued for a minute is cancelled.
+   */
+  SearchProgress startSearch(
+    1:SearchParams params_,
+    2:i32 timeoutMs_) throws(1:SearchException se),
+
+  /**
+   * Returns the result entries found since the previous call of a search
+   * started by startSearch(). It waits for new results like startSearch().
+   */
+  SearchProgress continueSearch(
+    1:string continuation_,
+    2:i32 timeoutMs_) throws(1:SearchException se),
+
+  /**
+   * Stops a search started by startSearch(), e.g. when the client navigates
+   * away from its results.
+   */
+  void cancelSearch(1:string continuation_),
+
   /**
    * Does a file search based on SQL database.
    */
@@ -270,6 +439,15 @@ service SearchService
    */
   oneway void pleaseStop(),
 
+  /**
+   * Returns the statistics of the search index and the profiles of the
+   * slowest recent queries.
+   *
+   * @param maxQueries_ Maximal number of the returned query profiles.
+   */
+  SearchStatistics getStatistics(1:i32 maxQueries_)
+    throws (1:SearchException se),
+
   /**
    * Suggests a search text based on the paramaters.
    */
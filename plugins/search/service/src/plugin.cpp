@@ -7,7 +7,20 @@ extern "C"
 {
   boost::program_options::options_description getOptions()
   {
-    boost::program_options::options_description description("Search Plugin");
+    namespace po = boost::program_options;
+
+    po::options_description description("Search Plugin");
+
+    description.add_options()
+      ("search-processes", po::value<std::size_t>()->default_value(1),
+       "Number of search service processes per project. The text searches "
+       "are served by them in parallel, but each process is a separate JVM "
+       "with its own heap and index readers.")
+      ("search-threads", po::value<std::size_t>()->default_value(4),
+       "Number of the searches started by startSearch() which run at the same "
+       "time per project. The others wait until one of them finishes or is "
+       "cancelled.");
+
     return description;
   }
 
@@ -0,0 +1,100 @@
+#include <algorithm>
+
+#include "querylog.h"
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+QueryLog::Timer::Timer(
+  QueryLog& log_,
+  const std::string& method_,
+  const std::string& query_,
+  std::int64_t options_)
+  : _log(log_), _start(Clock::now())
+{
+  _profile.method = method_;
+  _profile.query = query_;
+  _profile.options = options_;
+  _profile.startTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void QueryLog::Timer::finish(std::size_t resultCount_)
+{
+  _profile.totalUs = micros(Clock::now() - _start);
+  _profile.resultCount = resultCount_;
+  _log.add(_profile);
+}
+
+QueryLog::QueryLog(std::size_t capacity_) : _capacity(capacity_)
+{
+}
+
+void QueryLog::add(QueryProfile profile_)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  _profiles.push_back(std::move(profile_));
+  if (_profiles.size() > _capacity)
+    _profiles.pop_front();
+}
+
+std::vector<QueryProfile> QueryLog::slowest(std::size_t count_) const
+{
+  std::vector<QueryProfile> profiles;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    profiles.assign(_profiles.begin(), _profiles.end());
+  }
+
+  auto slower = [](const QueryProfile& left_, const QueryProfile& right_)
+  {
+    return left_.totalUs > right_.totalUs;
+  };
+
+  if (count_ < profiles.size())
+  {
+    std::partial_sort(profiles.begin(), profiles.begin() + count_,
+      profiles.end(), slower);
+    profiles.resize(count_);
+  }
+  else
+    std::sort(profiles.begin(), profiles.end(), slower);
+
+  return profiles;
+}
+
+void QueryLog::addProcessCall(
+  QueryProfile& profile_,
+  Clock::duration wait_,
+  Clock::duration run_,
+  const SearchTiming* processTiming_)
+{
+  std::int64_t run = micros(run_);
+
+  profile_.queueWaitUs += micros(wait_);
+
+  if (processTiming_)
+  {
+    profile_.matchUs += processTiming_->matchUs;
+    profile_.lineMatchUs += processTiming_->lineMatchUs;
+    run -= processTiming_->matchUs + processTiming_->lineMatchUs;
+  }
+
+  profile_.ipcUs += std::max<std::int64_t>(run, 0);
+}
+
+std::int64_t QueryLog::micros(Clock::duration duration_)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    duration_).count();
+}
+
+} // search
+} // service
+} // cc
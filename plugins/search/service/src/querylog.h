@@ -0,0 +1,94 @@
+#ifndef CC_SERVICE_SEARCH_QUERYLOG_H
+#define CC_SERVICE_SEARCH_QUERYLOG_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <SearchService.h>
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+/**
+ * Keeps the profiles of the recent queries, so the slowest ones can be listed
+ * by SearchServiceHandler::getStatistics().
+ */
+class QueryLog
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Measures the parts of a query. The profile is added to the log by
+   * finish(); if the query fails, it is not logged.
+   */
+  class Timer
+  {
+  public:
+    Timer(
+      QueryLog& log_,
+      const std::string& method_,
+      const std::string& query_,
+      std::int64_t options_);
+
+    QueryProfile& profile() { return _profile; }
+
+    void finish(std::size_t resultCount_);
+
+  private:
+    QueryLog& _log;
+    QueryProfile _profile;
+    const Clock::time_point _start;
+  };
+
+  /**
+   * @param capacity_ Number of the recent queries kept.
+   */
+  explicit QueryLog(std::size_t capacity_);
+
+  void add(QueryProfile profile_);
+
+  /**
+   * Returns the slowest recent queries, slowest first.
+   */
+  std::vector<QueryProfile> slowest(std::size_t count_) const;
+
+  /**
+   * Adds the time split of a call to a search service process to the profile.
+   * The time which is not reported by the process is spent on the
+   * communication.
+   * @param wait_ Waiting for a free process.
+   * @param run_ Running the query in the process.
+   * @param processTiming_ Time split reported by the process, if any.
+   */
+  static void addProcessCall(
+    QueryProfile& profile_,
+    Clock::duration wait_,
+    Clock::duration run_,
+    const SearchTiming* processTiming_ = nullptr);
+
+  /**
+   * Converts a duration to the microseconds of a profile.
+   */
+  static std::int64_t micros(Clock::duration duration_);
+
+private:
+  const std::size_t _capacity;
+
+  mutable std::mutex _mutex;
+  std::deque<QueryProfile> _profiles;
+};
+
+} // search
+} // service
+} // cc
+
+#endif // CC_SERVICE_SEARCH_QUERYLOG_H
@@ -3,6 +3,7 @@
 #include <memory>
 #include <ctime>
 #include <chrono>
+#include <tuple>
 
 #include <boost/filesystem.hpp>
 
@@ -16,9 +17,13 @@
 #include <util/logutil.h>
 #include <util/dbutil.h>
 #include <util/odbtransaction.h>
+#include <util/regexliterals.h>
 
 #include <service/searchservice.h>
 
+#include "querylog.h"
+#include "suggestioncache.h"
+
 namespace fs = boost::filesystem;
 
 namespace
@@ -90,6 +95,109 @@ private:
   boost::regex _dirFilter;
 };
 
+/**
+ * Finds the matches of a code search query in a line.
+ */
+class CodeMatcher
+{
+public:
+  CodeMatcher(const std::string& query_, bool literal_) :
+    _literal(literal_)
+  {
+    if (_literal)
+      _literals.push_back(toLower(query_));
+    else
+    {
+      _regex.assign(query_, boost::regex::icase);
+      _literals = cc::util::requiredLiterals(query_, true);
+    }
+  }
+
+  /**
+   * The lower case literals which are in every matching line.
+   */
+  const std::vector<std::string>& literals() const
+  {
+    return _literals;
+  }
+
+  /**
+   * Returns true if the line matches. The range of the matches is returned as
+   * zero-based [begin_, end_) offsets.
+   */
+  bool match(const std::string& line_, std::size_t& begin_, std::size_t& end_)
+  {
+    if (_literal)
+    {
+      _lowerLine = toLower(line_);
+
+      begin_ = _lowerLine.find(_literals.front());
+      if (begin_ == std::string::npos)
+        return false;
+
+      end_ = _lowerLine.rfind(_literals.front()) + _literals.front().size();
+      return true;
+    }
+
+    boost::sregex_iterator it(line_.begin(), line_.end(), _regex);
+    boost::sregex_iterator end;
+
+    if (it == end)
+      return false;
+
+    begin_ = it->position();
+    for (; it != end; ++it)
+      end_ = it->position() + it->length();
+
+    return true;
+  }
+
+private:
+  static std::string toLower(const std::string& str_)
+  {
+    std::string lower(str_);
+    for (char& c : lower)
+      if ('A' <= c && c <= 'Z')
+        c = c - 'A' + 'a';
+    return lower;
+  }
+
+  const bool _literal;
+  boost::regex _regex;
+  std::vector<std::string> _literals;
+  std::string _lowerLine;
+};
+
+/**
+ * Number of the files requested from a search service process at once by a
+ * search started by startSearch(). The search service process runs the whole
+ * Lucene query for every chunk, so the chunks grow from the first one, which
+ * is small to deliver the first results soon, up to the maximal size.
+ */
+const std::size_t MIN_SEARCH_CHUNK_SIZE = 50;
+const std::size_t MAX_SEARCH_CHUNK_SIZE = 1600;
+
+/**
+ * Upper limit of the time a startSearch() or continueSearch() call waits for
+ * results, so a client can't hold a server thread for long.
+ */
+const std::chrono::seconds MAX_SEARCH_TIMEOUT(10);
+
+/**
+ * Returns the range of the search parameters as the index of the first file
+ * and the number of files.
+ */
+std::pair<std::size_t, std::size_t> searchRange(
+  const cc::service::search::SearchParams& params_)
+{
+  if (!params_.__isset.range)
+    return {0, std::numeric_limits<std::size_t>::max()};
+
+  return {
+    std::max<std::int64_t>(0, params_.range.start),
+    std::max<std::int64_t>(0, params_.range.maxSize)};
+}
+
 } // anonymous namespace
 
 namespace cc
@@ -103,104 +211,406 @@ SearchServiceHandler::SearchServiceHandler(
   std::shared_ptr<odb::database> db_,
   std::shared_ptr<std::string> datadir_,
   const cc::webserver::ServerContext& context_) :
-    _db(db_)
+    _db(db_),
+    _fileNameIndex(core::FileNameIndex::forProject(db_, *datadir_)),
+    _codeIndexPath(*datadir_ + "/codeindex"),
+    _generation(*datadir_),
+    _suggestionCache(std::make_shared<SuggestionCache>(
+      *datadir_, 4 * 1024 * 1024, std::chrono::minutes(10))),
+    _queryLog(std::make_shared<QueryLog>(1000)),
+    _streams(64, std::chrono::minutes(1),
+      context_.options.count("search-threads")
+        ? context_.options["search-threads"].as<std::size_t>()
+        : 4)
 {
-  _javaProcess.reset(new ServiceProcess(*datadir_ + "/search",
-                                        context_.compassRoot,
-                                        context_.options.count("logtarget")
-                                          ? context_.options["logtarget"].as<std::string>()
-                                          : ""));
+  std::string indexDatabase = *datadir_ + "/search";
+  std::string compassRoot = context_.compassRoot;
+  std::string logTarget = context_.options.count("logtarget")
+    ? context_.options["logtarget"].as<std::string>()
+    : "";
+
+  std::size_t processes = context_.options.count("search-processes")
+    ? context_.options["search-processes"].as<std::size_t>()
+    : 1;
+
+  _javaProcesses.reset(new ServiceProcessPool(processes,
+    [indexDatabase, compassRoot, logTarget]()
+    {
+      return std::unique_ptr<ServiceProcess>(
+        new ServiceProcess(indexDatabase, compassRoot, logTarget));
+    }));
+}
+
+template <typename F>
+ServiceProcessPool::Timing SearchServiceHandler::callJavaProcess(
+  const char* name_,
+  F func_)
+{
+  using std::chrono::milliseconds;
+  using std::chrono::duration_cast;
+
+  try
+  {
+    ServiceProcessPool::Timing timing = _javaProcesses->call(func_);
+
+    LOG(info)
+      << name_ << " time: " << duration_cast<milliseconds>(timing.run).count()
+      << " milliseconds, waited for a search process: "
+      << duration_cast<milliseconds>(timing.wait).count()
+      << " milliseconds.";
+
+    return timing;
+  }
+  catch (const ServiceProcessPool::Unavailable& unavailable)
+  {
+    LOG(error) << unavailable.what();
+
+    SearchException ex;
+    ex.message = "The search service is restarting, please try again later.";
+    throw ex;
+  }
 }
 
 void SearchServiceHandler::search(
   SearchResult& _return,
   const SearchParams& params_)
 {
-  std::lock_guard<std::mutex> lock(_javaProcessMutex);
+  QueryLog::Timer timer(*_queryLog, "search", params_.query, params_.options);
 
-  try
+  if (params_.options &
+      (SearchOptions::SearchCodeRegex | SearchOptions::SearchCodeLiteral))
   {
-    auto start = std::chrono::steady_clock::now();
+    SearchStream stream;
+    searchCode(stream, *prepareCodeSearch(params_), params_, timer.profile());
+    stream.finish();
+
+    SearchProgress progress;
+    stream.fetch(progress, SearchStream::Clock::duration::zero());
+    _return = std::move(progress.result);
+
+    timer.finish(_return.totalFiles);
+    return;
+  }
 
-    _javaProcess->search(_return, params_);
+  ServiceProcessPool::Timing timing = callJavaProcess("Search",
+    [&](ServiceProcess& process_)
+    {
+      _return = SearchResult();
+      process_.search(_return, params_);
+    });
+
+  QueryLog::addProcessCall(timer.profile(), timing.wait, timing.run,
+    _return.__isset.timing ? &_return.timing : nullptr);
+  timer.finish(_return.totalFiles);
+}
 
-    auto end = std::chrono::steady_clock::now();
-    auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+void SearchServiceHandler::startSearch(
+  SearchProgress& _return,
+  const SearchParams& params_,
+  const std::int32_t timeoutMs_)
+{
+  std::size_t pageSize = searchRange(params_).second;
+  std::string continuation;
+
+  if (params_.options &
+      (SearchOptions::SearchCodeRegex | SearchOptions::SearchCodeLiteral))
+  {
+    std::shared_ptr<const codeindex::CodeIndex> index
+      = prepareCodeSearch(params_);
 
-    LOG(info) << "Search time: " << dur.count() << " milliseconds.";
+    continuation = _streams.start(pageSize,
+      [this, index, params_](SearchStream& stream_)
+      {
+        QueryLog::Timer timer(
+          *_queryLog, "startSearch", params_.query, params_.options);
+        timer.finish(searchCode(stream_, *index, params_, timer.profile()));
+      });
   }
-  catch (const ServiceProcess::ProcessDied&)
+  else
   {
-    LOG(error) << "Java search service died! Terminating server...";
-    ::abort();
+    LOG(info) << "Start search: query = " << params_.query;
+
+    continuation = _streams.start(pageSize,
+      [this, params_](SearchStream& stream_)
+      {
+        QueryLog::Timer timer(
+          *_queryLog, "startSearch", params_.query, params_.options);
+        timer.finish(searchText(stream_, params_, timer.profile()));
+      });
   }
+
+  fetchProgress(_return, continuation, timeoutMs_);
 }
 
-void SearchServiceHandler::searchFile(
-    FileSearchResult& _return,
-    const SearchParams&     params_)
+void SearchServiceHandler::continueSearch(
+  SearchProgress& _return,
+  const std::string& continuation_,
+  const std::int32_t timeoutMs_)
 {
-  LOG(info) << "Search for file: query = " << params_.query;
+  fetchProgress(_return, continuation_, timeoutMs_);
+}
+
+void SearchServiceHandler::cancelSearch(const std::string& continuation_)
+{
+  _streams.cancel(continuation_);
+}
+
+void SearchServiceHandler::fetchProgress(
+  SearchProgress& return_,
+  const std::string& continuation_,
+  std::int32_t timeoutMs_)
+{
+  std::shared_ptr<SearchStream> stream = _streams.get(continuation_);
+  if (!stream)
+  {
+    SearchException ex;
+    ex.message = "The search has expired, please search again.";
+    throw ex;
+  }
 
-  odb::transaction t(_db->begin());
+  std::chrono::milliseconds timeout(std::max<std::int32_t>(0, timeoutMs_));
+  stream->fetch(return_, std::min<SearchStream::Clock::duration>(
+    timeout, MAX_SEARCH_TIMEOUT));
+  return_.continuation = return_.complete ? std::string() : continuation_;
+}
 
-  typedef odb::result<model::ParentIdCollector> parentIds;
-  typedef odb::result<model::File> fileResult;
-  typedef odb::query<model::File> query;
+std::size_t SearchServiceHandler::searchText(
+  SearchStream& stream_,
+  const SearchParams& params_,
+  QueryProfile& profile_)
+{
+  std::size_t begin;
+  std::size_t maxSize;
+  std::tie(begin, maxSize) = searchRange(params_);
+  std::size_t total = 0;
 
-  validateRegexp(params_.query);
+  SearchParams chunk = params_;
+  chunk.__isset.range = true;
+  std::size_t nextChunkSize = MIN_SEARCH_CHUNK_SIZE;
 
-  try
+  for (std::size_t done = 0; done < maxSize && !stream_.cancelled();)
   {
-    FilterHelper filters(params_.filter);
+    std::size_t chunkSize = std::min(maxSize - done, nextChunkSize);
+    nextChunkSize = std::min(2 * nextChunkSize, MAX_SEARCH_CHUNK_SIZE);
+    chunk.range.start = begin + done;
+    chunk.range.maxSize = chunkSize;
+
+    // The process is released between the chunks, so the queries waiting for
+    // it are not blocked until the whole range is matched.
+    SearchResult result;
+    ServiceProcessPool::Timing timing = callJavaProcess("Search chunk",
+      [&](ServiceProcess& process_)
+      {
+        result = SearchResult();
+        process_.search(result, chunk);
+      });
+
+    QueryLog::addProcessCall(profile_, timing.wait, timing.run,
+      result.__isset.timing ? &result.timing : nullptr);
+
+    total = std::max<std::int64_t>(0, result.totalFiles);
+    stream_.setTotal(total);
+
+    for (SearchResultEntry& entry : result.results)
+      if (!stream_.add(std::move(entry)))
+        return total;
 
-    parentIds parents = _db->query<model::ParentIdCollector>(
-      query::type != model::File::DIRECTORY_TYPE &&
-      query::filename + SQL_REGEX + query::_val(params_.query));
+    done += chunkSize;
+    if (begin + done >= total)
+      break;
+  }
+
+  return total;
+}
+
+std::shared_ptr<const codeindex::CodeIndex>
+SearchServiceHandler::prepareCodeSearch(const SearchParams& params_)
+{
+  LOG(info) << "Search in code: query = " << params_.query;
+
+  std::shared_ptr<const codeindex::CodeIndex> index = codeIndex();
+  if (!index)
+  {
+    SearchException ex;
+    ex.message = "The code index is not available. The project has to be "
+      "parsed with the --search-code-index option.";
+    throw ex;
+  }
+
+  bool literal = params_.options & SearchOptions::SearchCodeLiteral;
+  if (literal && params_.query.empty())
+  {
+    SearchException ex;
+    ex.message = "Empty query";
+    throw ex;
+  }
+
+  if (!literal)
+    validateRegexp(params_.query);
+
+  return index;
+}
+
+std::size_t SearchServiceHandler::searchCode(
+  SearchStream& stream_,
+  const codeindex::CodeIndex& index_,
+  const SearchParams& params_,
+  QueryProfile& profile_)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  bool literal = params_.options & SearchOptions::SearchCodeLiteral;
+  CodeMatcher matcher(params_.query, literal);
+  FilterHelper filters(params_.filter);
+
+  std::size_t begin;
+  std::size_t maxSize;
+  std::tie(begin, maxSize) = searchRange(params_);
+
+  std::size_t total = 0;
+  std::chrono::steady_clock::duration lineMatchTime{0};
 
-    std::vector<model::FileId> parentVector;
-    for (const auto& parent : parents)
+  index_.findCandidates(matcher.literals(), [&](
+    std::uint32_t file_,
+    const std::vector<std::uint32_t>& lines_)
+  {
+    if (stream_.cancelled())
+      return false;
+
+    codeindex::CodeIndex::File file = index_.file(file_);
+
+    if (filters.shouldSkip(file.path))
+      return true;
+
+    // The files out of the range are only counted, so their first matching
+    // line is enough.
+    bool inRange = begin <= total && total - begin < maxSize;
+    std::string fileId = std::to_string(file.id);
+    auto lineMatchStart = std::chrono::steady_clock::now();
+
+    SearchResultEntry entry;
+
+    for (std::uint32_t line : lines_)
     {
-      parentVector.push_back(parent.parent);
+      std::string text = file.line(line);
+      std::size_t matchBegin;
+      std::size_t matchEnd;
+
+      if (!matcher.match(text, matchBegin, matchEnd))
+        continue;
+
+      LineMatch lineMatch;
+      lineMatch.range.file = fileId;
+      lineMatch.range.range.startpos.line = line + 1;
+      lineMatch.range.range.startpos.column = matchBegin + 1;
+      lineMatch.range.range.endpos.line = line + 1;
+      lineMatch.range.range.endpos.column = matchEnd + 1;
+      lineMatch.text = std::move(text);
+      entry.matchingLines.push_back(std::move(lineMatch));
+
+      if (!inRange)
+        break;
     }
 
-    std::size_t minIdx = 0;
-    std::size_t maxIdx = parentVector.size();
-    if (params_.__isset.range)
+    lineMatchTime += std::chrono::steady_clock::now() - lineMatchStart;
+
+    if (entry.matchingLines.empty())
+      return true;
+
+    if (!stream_.setTotal(++total))
+      return false;
+
+    if (inRange)
     {
-      minIdx = std::min(static_cast<int64_t>(maxIdx), params_.range.start);
-      maxIdx = std::min(static_cast<int64_t>(maxIdx),
-        params_.range.start + params_.range.maxSize);
+      entry.finfo.id = fileId;
+      entry.finfo.name = fs::path(file.path).filename().native();
+      entry.finfo.path = file.path;
+      return stream_.add(std::move(entry));
     }
 
-    if (minIdx == maxIdx)
+    return true;
+  });
+
+  auto time = std::chrono::steady_clock::now() - start;
+  profile_.matchUs += QueryLog::micros(time - lineMatchTime);
+  profile_.lineMatchUs += QueryLog::micros(lineMatchTime);
+
+  LOG(debug) << "Code search took "
+    << std::chrono::duration_cast<std::chrono::milliseconds>(time).count()
+    << " ms, " << total << " files matched"
+    << (stream_.cancelled() ? " before it was cancelled." : ".");
+
+  return total;
+}
+
+std::shared_ptr<const codeindex::CodeIndex> SearchServiceHandler::codeIndex()
+{
+  std::uint64_t generation = _generation.current();
+
+  std::lock_guard<std::mutex> lock(_codeIndexMutex);
+
+  if (!_codeIndexOpened || _codeIndexGeneration != generation)
+  {
+    _codeIndexOpened = true;
+    _codeIndexGeneration = generation;
+
+    try
     {
-      // No result
-      _return.totalFiles = 0;
-      return;
+      _codeIndex = codeindex::CodeIndex::open(_codeIndexPath);
     }
+    catch (const std::exception& ex)
+    {
+      LOG(warning) << ex.what();
+      _codeIndex.reset();
+    }
+  }
+
+  return _codeIndex;
+}
+
+void SearchServiceHandler::searchFile(
+    FileSearchResult& _return,
+    const SearchParams&     params_)
+{
+  LOG(info) << "Search for file: query = " << params_.query;
+
+  validateRegexp(params_.query);
+
+  QueryLog::Timer timer(
+    *_queryLog, "searchFile", params_.query, params_.options);
+
+  try
+  {
+    FilterHelper filters(params_.filter);
+
+    // The result is paged by the directories of the matching files.
+    std::size_t begin;
+    std::size_t maxSize;
+    std::tie(begin, maxSize) = searchRange(params_);
 
-    fileResult r (_db->query<model::File>(
-      query::type != model::File::DIRECTORY_TYPE &&
-      query::filename + SQL_REGEX + query::_val(params_.query) &&
-      query::parent.in_range(parentVector.begin() + minIdx,
-        parentVector.begin() + maxIdx)));
+    // The first query may wait for the file name index to be loaded from
+    // the database.
+    auto matchStart = std::chrono::steady_clock::now();
 
-    for (const auto& f : r)
+    std::size_t totalDirs;
+    std::vector<core::FileInfo> files = _fileNameIndex->searchRegex(
+      params_.query, begin, maxSize, totalDirs);
+
+    timer.profile().matchUs = QueryLog::micros(
+      std::chrono::steady_clock::now() - matchStart);
+
+    for (core::FileInfo& file : files)
     {
-      if (filters.shouldSkip(f.path))
+      if (filters.shouldSkip(file.path))
       {
         continue;
       }
 
-      core::FileInfo info;
-      info.id = std::to_string(f.id);
-      info.name = f.filename;
-      info.path = f.path;
-
-      _return.results.push_back(info);
-      _return.totalFiles = parentVector.size();
+      _return.results.push_back(std::move(file));
+      _return.totalFiles = totalDirs;
     }
+
+    timer.finish(totalDirs);
   }
   catch (odb::exception &odbex)
   {
@@ -249,6 +659,19 @@ void SearchServiceHandler::getSearchTypes(
 
     _return.push_back(type);
   }
+
+  if (codeIndex())
+  {
+    ::cc::service::search::SearchType type;
+
+    type.id = ::cc::service::search::SearchOptions::SearchCodeRegex;
+    type.name = "Regex code search";
+    _return.push_back(type);
+
+    type.id = ::cc::service::search::SearchOptions::SearchCodeLiteral;
+    type.name = "Literal code search";
+    _return.push_back(type);
+  }
 }
 
 void SearchServiceHandler::pleaseStop()
@@ -258,24 +681,60 @@ void SearchServiceHandler::pleaseStop()
 void SearchServiceHandler::suggest(SearchSuggestions& _return,
   const SearchSuggestionParams& params_)
 {
-  std::lock_guard<std::mutex> lock(_javaProcessMutex);
+  _return = SearchSuggestions();
 
-  try
-  {
-    auto start = std::chrono::steady_clock::now();
+  if (params_.__isset.tag)
+    _return.__set_tag(params_.tag);
 
-    _javaProcess->suggest(_return, params_);
+  if (_suggestionCache->find(params_, _return.results))
+    return;
 
-    auto end = std::chrono::steady_clock::now();
-    auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(end-start);
+  // Only the suggestions served by a search service process are logged, the
+  // cached ones would push the interesting queries out of the log.
+  QueryLog::Timer timer(
+    *_queryLog, "suggest", params_.userInput, params_.options);
 
-    LOG(info) << "Suggest time: " << dur.count() << " milliseconds.";
-  }
-  catch (const ServiceProcess::ProcessDied&)
+  ServiceProcessPool::Timing timing = callJavaProcess("Suggest",
+    [&](ServiceProcess& process_)
+    {
+      _return = SearchSuggestions();
+      process_.suggest(_return, params_);
+    });
+
+  QueryLog::addProcessCall(timer.profile(), timing.wait, timing.run);
+  timer.finish(_return.results.size());
+
+  _suggestionCache->insert(params_, _return.results);
+}
+
+void SearchServiceHandler::getStatistics(
+  SearchStatistics& _return,
+  const std::int32_t maxQueries_)
+{
+  callJavaProcess("Statistics", [&](ServiceProcess& process_)
   {
-    LOG(error) << "Java search service died! Terminating server...";
-    ::abort();
-  }
+    _return = SearchStatistics();
+    process_.getStatistics(_return, maxQueries_);
+  });
+
+  _return.slowestQueries = _queryLog->slowest(
+    std::max<std::int32_t>(maxQueries_, 0));
+
+  SuggestionCache::Statistics suggestions = _suggestionCache->statistics();
+  _return.caches["Suggestion cache hits"] = std::to_string(suggestions.hits);
+  _return.caches["Suggestion cache misses"]
+    = std::to_string(suggestions.misses);
+  _return.caches["Suggestion cache evictions"]
+    = std::to_string(suggestions.evictions);
+  _return.caches["Suggestion cache entries"]
+    = std::to_string(suggestions.entries);
+  _return.caches["Suggestion cache bytes"] = std::to_string(suggestions.bytes);
+
+  std::shared_ptr<const codeindex::CodeIndex> index = codeIndex();
+  _return.caches["Code index files"]
+    = index ? std::to_string(index->fileCount()) : "not built";
+  if (index)
+    _return.caches["Code index bytes"] = std::to_string(index->size());
 }
 
 void SearchServiceHandler::validateRegexp(const std::string& regexp_)
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstdio>
+
+#include <util/logutil.h>
+
+#include <service/searchstream.h>
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+SearchStream::SearchStream(std::size_t pageSize_)
+  : _pageSize(pageSize_), _lastAccess(Clock::now())
+{
+}
+
+bool SearchStream::add(SearchResultEntry entry_)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.push_back(std::move(entry_));
+    ++_added;
+  }
+
+  _signal.notify_all();
+  return !_cancelled;
+}
+
+bool SearchStream::setTotal(std::size_t total_)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _total = total_;
+  return !_cancelled;
+}
+
+bool SearchStream::cancelled() const
+{
+  return _cancelled;
+}
+
+void SearchStream::finish(const std::string& error_)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _finished = true;
+    _error = error_;
+  }
+
+  _signal.notify_all();
+}
+
+void SearchStream::fetch(SearchProgress& return_, Clock::duration timeout_)
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _lastAccess = Clock::now();
+
+  _signal.wait_for(lock, timeout_, [this]
+  {
+    return _finished || _cancelled || (_added >= _pageSize && !_pageDelivered);
+  });
+
+  _lastAccess = Clock::now();
+
+  if (_finished && !_error.empty())
+  {
+    _drained = true;
+
+    SearchException ex;
+    ex.message = _error;
+    throw ex;
+  }
+
+  return_.result.results = std::move(_entries);
+  return_.result.totalFiles = _total;
+  return_.complete = _finished || _cancelled;
+  _entries.clear();
+
+  if (_added >= _pageSize)
+    _pageDelivered = true;
+
+  if (return_.complete)
+    _drained = true;
+}
+
+void SearchStream::cancel()
+{
+  _cancelled = true;
+  _signal.notify_all();
+}
+
+bool SearchStream::drained() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _drained;
+}
+
+SearchStream::Clock::time_point SearchStream::lastAccess() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _lastAccess;
+}
+
+SearchStreams::SearchStreams(
+  std::size_t maxStreams_,
+  SearchStream::Clock::duration idleTimeout_,
+  std::size_t threads_)
+  : _maxStreams(std::max<std::size_t>(maxStreams_, 1)),
+    _idleTimeout(idleTimeout_),
+    _random(std::random_device()()),
+    _threads(util::make_thread_pool<std::function<void()>>(
+      std::max<std::size_t>(threads_, 1),
+      [](const std::function<void()>& job_) { job_(); },
+      true))
+{
+}
+
+SearchStreams::~SearchStreams()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (const auto& item : _streams)
+      item.second->cancel();
+    _streams.clear();
+  }
+
+  // The queued searches are cancelled, so they finish at once.
+  _threads->wait();
+}
+
+std::string SearchStreams::start(std::size_t pageSize_, Producer producer_)
+{
+  std::shared_ptr<SearchStream> stream
+    = std::make_shared<SearchStream>(pageSize_);
+  std::string token;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    sweep();
+
+    while (_streams.size() >= _maxStreams)
+    {
+      auto oldest = std::min_element(_streams.begin(), _streams.end(),
+        [](const decltype(_streams)::value_type& left_,
+           const decltype(_streams)::value_type& right_)
+        {
+          return left_.second->lastAccess() < right_.second->lastAccess();
+        });
+
+      LOG(debug) << "Too many searches, cancelling the least recently used.";
+      oldest->second->cancel();
+      _streams.erase(oldest);
+    }
+
+    token = newToken();
+    _streams[token] = stream;
+  }
+
+  _threads->enqueue([stream, producer_]()
+  {
+    if (stream->cancelled())
+    {
+      stream->finish();
+      return;
+    }
+
+    try
+    {
+      producer_(*stream);
+      stream->finish();
+    }
+    catch (const SearchException& ex)
+    {
+      stream->finish(ex.message);
+    }
+    catch (const std::exception& ex)
+    {
+      LOG(error) << "Search failed: " << ex.what();
+      stream->finish(ex.what());
+    }
+  });
+
+  return token;
+}
+
+std::shared_ptr<SearchStream> SearchStreams::get(const std::string& token_)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  sweep();
+
+  auto it = _streams.find(token_);
+  return it == _streams.end() ? nullptr : it->second;
+}
+
+void SearchStreams::cancel(const std::string& token_)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto it = _streams.find(token_);
+  if (it != _streams.end())
+  {
+    it->second->cancel();
+    _streams.erase(it);
+  }
+
+  sweep();
+}
+
+void SearchStreams::sweep()
+{
+  SearchStream::Clock::time_point now = SearchStream::Clock::now();
+
+  for (auto it = _streams.begin(); it != _streams.end();)
+  {
+    if (it->second->drained())
+      it = _streams.erase(it);
+    else if (now - it->second->lastAccess() > _idleTimeout)
+    {
+      LOG(debug) << "Cancelling an abandoned search.";
+      it->second->cancel();
+      it = _streams.erase(it);
+    }
+    else
+      ++it;
+  }
+}
+
+std::string SearchStreams::newToken()
+{
+  char token[33];
+  std::snprintf(token, sizeof(token), "%016llx%016llx",
+    static_cast<unsigned long long>(_random()),
+    static_cast<unsigned long long>(_random()));
+
+  return token;
+}
+
+} // search
+} // service
+} // cc
@@ -0,0 +1,276 @@
+#include <algorithm>
+
+#include <util/logutil.h>
+
+#include "suggestioncache.h"
+
+namespace
+{
+
+/**
+ * Whitespace characters which separate the words of the input in the symbol
+ * suggester (see Java's Character.isWhitespace).
+ */
+bool isWhitespace(char c_)
+{
+  return c_ == ' '
+    || ('\t' <= c_ && c_ <= '\r')
+    || ('\x1c' <= c_ && c_ <= '\x1f');
+}
+
+bool isAscii(const std::string& str_)
+{
+  return std::none_of(str_.begin(), str_.end(),
+    [](char c_) { return static_cast<unsigned char>(c_) >= 0x80; });
+}
+
+/**
+ * Lowers the case of the string like the search service does with the input.
+ * @return False if the string contains a non-ASCII character. The case of
+ * those is not lowered the same way as in Java, so they can't be filtered.
+ */
+bool toLower(const std::string& str_, std::string& lower_)
+{
+  lower_ = str_;
+
+  for (char& c : lower_)
+    if ('A' <= c && c <= 'Z')
+      c = c - 'A' + 'a';
+
+  return isAscii(str_);
+}
+
+std::vector<std::string> splitWords(const std::string& str_)
+{
+  std::vector<std::string> words;
+  std::string word;
+
+  for (char c : str_)
+    if (!isWhitespace(c))
+      word += c;
+    else if (!word.empty())
+    {
+      words.push_back(std::move(word));
+      word.clear();
+    }
+
+  if (!word.empty())
+    words.push_back(std::move(word));
+
+  return words;
+}
+
+/**
+ * Returns true if the symbol suggester would find the suggestion for the
+ * input: one of the words of the input is in the suggestion, the last one as
+ * a prefix of a word. The suggester lowers the case of the input only, so the
+ * words of the suggestion are compared to the lower case input as they are.
+ */
+bool matchesInput(
+  const std::vector<std::string>& inputWords_,
+  const std::vector<std::string>& suggestionWords_)
+{
+  const std::string& last = inputWords_.back();
+
+  for (const std::string& word : suggestionWords_)
+  {
+    if (word.compare(0, last.size(), last) == 0)
+      return true;
+
+    if (std::find(inputWords_.begin(), inputWords_.end() - 1, word)
+        != inputWords_.end() - 1)
+      return true;
+  }
+
+  return false;
+}
+
+std::vector<std::string> truncate(
+  const std::vector<std::string>& results_,
+  std::int64_t limit_)
+{
+  std::size_t size = std::min<std::size_t>(
+    results_.size(), std::max<std::int64_t>(limit_, 0));
+
+  return std::vector<std::string>(results_.begin(), results_.begin() + size);
+}
+
+}
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+std::size_t SuggestionCache::ValueSizer::operator()(
+  const std::string& key_,
+  const Value& value_) const
+{
+  // The key is stored twice: in the LRU list and in the index.
+  std::size_t size = 2 * (sizeof(std::string) + key_.capacity())
+    + sizeof(Value);
+
+  for (const std::string& result : value_.results)
+    size += sizeof(std::string) + result.capacity();
+
+  return size;
+}
+
+SuggestionCache::SuggestionCache(
+  const std::string& datadir_,
+  std::size_t capacity_,
+  Clock::duration timeToLive_)
+  : _datadir(datadir_),
+    _timeToLive(timeToLive_),
+    _generation(datadir_),
+    _lastGeneration(_generation.current()),
+    _cache(capacity_)
+{
+}
+
+SuggestionCache::~SuggestionCache()
+{
+  logStatistics("closed");
+}
+
+bool SuggestionCache::find(
+  const SearchSuggestionParams& params_,
+  std::vector<std::string>& results_)
+{
+  std::string input;
+  toLower(params_.userInput, input);
+
+  Value value;
+  if (findValue(makeKey(params_.options, input), value) &&
+      (value.complete || value.limit >= params_.limit))
+  {
+    results_ = truncate(value.results, params_.limit);
+    return true;
+  }
+
+  return findByPrefix(params_, results_);
+}
+
+void SuggestionCache::insert(
+  const SearchSuggestionParams& params_,
+  const std::vector<std::string>& results_)
+{
+  std::string input;
+  toLower(params_.userInput, input);
+
+  Value value;
+  value.results = results_;
+  value.complete = static_cast<std::int64_t>(results_.size()) < params_.limit;
+  value.limit = params_.limit;
+  value.created = Clock::now();
+
+  _cache.insert(makeKey(params_.options, input), std::move(value));
+}
+
+SuggestionCache::Statistics SuggestionCache::statistics() const
+{
+  return _cache.statistics();
+}
+
+std::string SuggestionCache::makeKey(
+  std::int64_t options_,
+  const std::string& input_)
+{
+  std::uint64_t generation = _generation.current();
+  std::uint64_t last = _lastGeneration;
+
+  if (generation != last &&
+      _lastGeneration.compare_exchange_strong(last, generation))
+  {
+    logStatistics("invalidated by generation " + std::to_string(generation));
+    _cache.clear();
+  }
+
+  std::string key = std::to_string(generation);
+  key += '\0';
+  key += std::to_string(options_);
+  key += '\0';
+  key += input_;
+
+  return key;
+}
+
+bool SuggestionCache::findValue(const std::string& key_, Value& value_)
+{
+  return _cache.find(key_, value_)
+    && Clock::now() - value_.created <= _timeToLive;
+}
+
+bool SuggestionCache::findByPrefix(
+  const SearchSuggestionParams& params_,
+  std::vector<std::string>& results_)
+{
+  // The search service asks the file name suggester if both are requested.
+  if (!(params_.options & SearchOptions::SearchInDefs) ||
+      (params_.options & SearchOptions::SearchForFileName))
+    return false;
+
+  std::string input;
+  if (!toLower(params_.userInput, input) ||
+      input.empty() || isWhitespace(input.back()))
+    return false;
+
+  // Only the prefixes ending in the last word of the input are usable: a new
+  // word extends the set of the suggestions.
+  std::size_t lastWord = input.size();
+  while (lastWord > 0 && !isWhitespace(input[lastWord - 1]))
+    --lastWord;
+
+  std::vector<std::string> inputWords = splitWords(input);
+
+  for (std::size_t length = input.size() - 1; length > lastWord; --length)
+  {
+    Value value;
+    if (!findValue(makeKey(params_.options, input.substr(0, length)), value) ||
+        !value.complete)
+      continue;
+
+    Value filtered;
+    filtered.complete = true;
+    filtered.limit = params_.limit;
+    filtered.created = value.created;
+
+    for (const std::string& result : value.results)
+    {
+      // Java splits the words at non-ASCII whitespace too.
+      if (!isAscii(result))
+        return false;
+
+      if (matchesInput(inputWords, splitWords(result)))
+        filtered.results.push_back(result);
+    }
+
+    results_ = truncate(filtered.results, params_.limit);
+    _cache.insert(makeKey(params_.options, input), std::move(filtered));
+    ++_prefixHits;
+
+    return true;
+  }
+
+  return false;
+}
+
+void SuggestionCache::logStatistics(const std::string& reason_) const
+{
+  Statistics stats = _cache.statistics();
+
+  LOG(info)
+    << "Suggestion cache of '" << _datadir << "' " << reason_
+    << " (hits: " << stats.hits
+    << ", prefix hits: " << _prefixHits
+    << ", misses: " << stats.misses
+    << ", evictions: " << stats.evictions
+    << ", entries: " << stats.entries
+    << ", bytes: " << stats.bytes << ")";
+}
+
+} // search
+} // service
+} // cc
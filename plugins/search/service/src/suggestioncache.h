@@ -0,0 +1,122 @@
+#ifndef CC_SERVICE_SEARCH_SUGGESTIONCACHE_H
+#define CC_SERVICE_SEARCH_SUGGESTIONCACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <SearchService.h>
+
+#include <util/lrucache.h>
+#include <util/projectgeneration.h>
+
+namespace cc
+{
+namespace service
+{
+namespace search
+{
+
+/**
+ * Caches the results of SearchServiceHandler::suggest(), so typing in the
+ * search box is mostly answered without asking a search service process. The
+ * entries are keyed by the options and the user input, they expire after a
+ * while and the whole cache is dropped when the project is parsed again.
+ *
+ * Symbol suggestions match the input as a prefix of a word, so the complete
+ * suggestion list of a prefix of the input (i.e. one shorter than the limit
+ * of its request) contains every suggestion of the input. Such a list is
+ * filtered instead of asking the search service. The file name suggestions
+ * are fuzzy, their cached lists are only used for the same input.
+ */
+class SuggestionCache
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Value
+  {
+    std::vector<std::string> results;
+
+    /**
+     * True if results contains every suggestion for the input, not only the
+     * first limit ones.
+     */
+    bool complete;
+    std::int64_t limit;
+    Clock::time_point created;
+  };
+
+  struct ValueSizer
+  {
+    std::size_t operator()(const std::string& key_, const Value& value_) const;
+  };
+
+  typedef util::LruCache<std::string, Value, ValueSizer> CacheType;
+  typedef CacheType::Statistics Statistics;
+
+  /**
+   * @param datadir_ Project directory in the workspace.
+   * @param capacity_ Maximal size of the cached suggestions in bytes.
+   * @param timeToLive_ Time after which a cached suggestion list expires.
+   */
+  SuggestionCache(
+    const std::string& datadir_,
+    std::size_t capacity_,
+    Clock::duration timeToLive_);
+  ~SuggestionCache();
+
+  /**
+   * Fills results_ with the cached suggestions for the parameters.
+   * @return True if the suggestions were found in the cache.
+   */
+  bool find(
+    const SearchSuggestionParams& params_,
+    std::vector<std::string>& results_);
+
+  /**
+   * Stores the suggestions returned by the search service for the parameters.
+   */
+  void insert(
+    const SearchSuggestionParams& params_,
+    const std::vector<std::string>& results_);
+
+  Statistics statistics() const;
+
+private:
+  /**
+   * Builds a cache key from the current generation and the input. The cache
+   * is cleared if the generation has changed since the last call.
+   */
+  std::string makeKey(std::int64_t options_, const std::string& input_);
+
+  /**
+   * Returns the cached, unexpired value of the key.
+   */
+  bool findValue(const std::string& key_, Value& value_);
+
+  /**
+   * Looks for the complete symbol suggestion list of a prefix of the input
+   * and filters it for the input.
+   */
+  bool findByPrefix(
+    const SearchSuggestionParams& params_,
+    std::vector<std::string>& results_);
+
+  void logStatistics(const std::string& reason_) const;
+
+  const std::string _datadir;
+  const Clock::duration _timeToLive;
+  util::ProjectGeneration _generation;
+  std::atomic<std::uint64_t> _lastGeneration;
+  std::atomic<std::uint64_t> _prefixHits{0};
+  CacheType _cache;
+};
+
+} // search
+} // service
+} // cc
+
+#endif // CC_SERVICE_SEARCH_SUGGESTIONCACHE_H
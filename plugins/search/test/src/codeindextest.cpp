@@ -0,0 +1,222 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <codeindex/codeindex.h>
+#include <codeindex/codeindexbuilder.h>
+
+using namespace cc::codeindex;
+
+namespace
+{
+
+typedef std::map<std::string, std::vector<std::uint32_t>> Candidates;
+
+class CodeIndexTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    _dir = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(_dir);
+  }
+
+  void TearDown() override
+  {
+    boost::filesystem::remove_all(_dir);
+  }
+
+  std::string indexPath(const std::string& name_) const
+  {
+    return (_dir / name_).string();
+  }
+
+  /**
+   * Adds the same files to the builder in every test.
+   */
+  static void addFiles(CodeIndexBuilder& builder_)
+  {
+    builder_.addFile(3, "/src/main.cpp",
+      "#include \"parser.h\"\n"
+      "int main()\n"
+      "{\n"
+      "  Parser parser;\n"
+      "  return parser.run();\n"
+      "}\n");
+    builder_.addFile(1, "/src/parser.h",
+      "class Parser\n"
+      "{\n"
+      "public:\n"
+      "  int run();\n"
+      "};\n");
+    builder_.addFile(2, "/README",
+      "A parser which runs.");
+  }
+
+  /**
+   * Returns the candidate lines by file path.
+   */
+  static Candidates findCandidates(
+    const CodeIndex& index_,
+    const std::vector<std::string>& literals_)
+  {
+    Candidates candidates;
+
+    index_.findCandidates(literals_,
+      [&](std::uint32_t file_, const std::vector<std::uint32_t>& lines_)
+      {
+        candidates[index_.file(file_).path] = lines_;
+        return true;
+      });
+
+    return candidates;
+  }
+
+  boost::filesystem::path _dir;
+};
+
+}
+
+TEST_F(CodeIndexTest, MissingIndex)
+{
+  EXPECT_EQ(nullptr, CodeIndex::open(indexPath("missing")));
+}
+
+TEST_F(CodeIndexTest, RoundTrip)
+{
+  CodeIndexBuilder builder(indexPath("index"));
+  addFiles(builder);
+  builder.addFile(2, "/README", "A parser\nwhich runs.\n");
+  EXPECT_EQ(3u, builder.fileCount());
+  builder.write();
+
+  auto index = CodeIndex::open(indexPath("index"));
+  ASSERT_NE(nullptr, index);
+  ASSERT_EQ(3u, index->fileCount());
+
+  CodeIndex::File readme = index->file(0);
+  EXPECT_EQ(2u, readme.id);
+  EXPECT_EQ("/README", readme.path);
+  EXPECT_EQ("A parser\nwhich runs.\n",
+    std::string(readme.content, readme.contentSize));
+  ASSERT_EQ(2u, readme.lineCount);
+  EXPECT_EQ("A parser", readme.line(0));
+  EXPECT_EQ("which runs.", readme.line(1));
+
+  CodeIndex::File main = index->file(1);
+  EXPECT_EQ(3u, main.id);
+  EXPECT_EQ("/src/main.cpp", main.path);
+  ASSERT_EQ(6u, main.lineCount);
+  EXPECT_EQ("  return parser.run();", main.line(4));
+
+  CodeIndex::File parser = index->file(2);
+  EXPECT_EQ(1u, parser.id);
+  EXPECT_EQ("/src/parser.h", parser.path);
+  EXPECT_EQ(5u, parser.lineCount);
+}
+
+TEST_F(CodeIndexTest, FindCandidates)
+{
+  CodeIndexBuilder builder(indexPath("index"));
+  addFiles(builder);
+  builder.write();
+
+  auto index = CodeIndex::open(indexPath("index"));
+  ASSERT_NE(nullptr, index);
+
+  // The trigrams are taken from the lower case contents.
+  Candidates expected{
+    {"/README", {0}},
+    {"/src/main.cpp", {0, 3, 4}},
+    {"/src/parser.h", {0}}};
+  EXPECT_EQ(expected, findCandidates(*index, {"parser"}));
+
+  expected = {{"/src/main.cpp", {4}}};
+  EXPECT_EQ(expected, findCandidates(*index, {"parser", "return"}));
+
+  EXPECT_TRUE(findCandidates(*index, {"lexer"}).empty());
+
+  // Without a literal of a trigram every line is a candidate.
+  Candidates all = findCandidates(*index, {"p"});
+  EXPECT_EQ(1u, all["/README"].size());
+  EXPECT_EQ(6u, all["/src/main.cpp"].size());
+  EXPECT_EQ(5u, all["/src/parser.h"].size());
+  EXPECT_EQ(all, findCandidates(*index, {}));
+}
+
+TEST_F(CodeIndexTest, MergedRunsGiveTheSameCandidates)
+{
+  {
+    CodeIndexBuilder builder(indexPath("index"));
+    addFiles(builder);
+    builder.write();
+
+    // Spills the postings to several run files which have to be merged.
+    CodeIndexBuilder smallRuns(indexPath("small"), 16);
+    addFiles(smallRuns);
+    smallRuns.write();
+  }
+
+  auto index = CodeIndex::open(indexPath("index"));
+  auto merged = CodeIndex::open(indexPath("small"));
+  ASSERT_NE(nullptr, index);
+  ASSERT_NE(nullptr, merged);
+
+  EXPECT_EQ(index->size(), merged->size());
+
+  for (const std::vector<std::string>& literals :
+    std::vector<std::vector<std::string>>{
+      {"parser"}, {"run"}, {"int", "run"}, {"{"}, {"class parser"}, {"x"}})
+  {
+    EXPECT_EQ(
+      findCandidates(*index, literals),
+      findCandidates(*merged, literals));
+  }
+
+  // Only the index files are left after the builders are destroyed.
+  std::size_t files = std::distance(
+    boost::filesystem::directory_iterator(_dir),
+    boost::filesystem::directory_iterator());
+  EXPECT_EQ(2u, files);
+}
+
+TEST_F(CodeIndexTest, AddFilesOfPreviousIndex)
+{
+  {
+    CodeIndexBuilder builder(indexPath("index"));
+    addFiles(builder);
+    builder.write();
+  }
+
+  auto previous = CodeIndex::open(indexPath("index"));
+  ASSERT_NE(nullptr, previous);
+
+  CodeIndexBuilder builder(indexPath("index"));
+  builder.addFiles(*previous,
+    [](std::uint64_t id_) { return id_ != 3; });
+  builder.addFile(4, "/src/lexer.h", "class Lexer;\n");
+  builder.write();
+
+  auto index = CodeIndex::open(indexPath("index"));
+  ASSERT_NE(nullptr, index);
+  ASSERT_EQ(3u, index->fileCount());
+  EXPECT_EQ("/README", index->file(0).path);
+  EXPECT_EQ("/src/lexer.h", index->file(1).path);
+  EXPECT_EQ("/src/parser.h", index->file(2).path);
+
+  // The previous mapping stays valid after the index is replaced.
+  EXPECT_EQ("/src/main.cpp", previous->file(1).path);
+
+  Candidates expected{
+    {"/src/lexer.h", {0}},
+    {"/src/parser.h", {0}}};
+  EXPECT_EQ(expected, findCandidates(*index, {"class"}));
+}
@@ -0,0 +1,155 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <querylog.h>
+
+using namespace cc::service::search;
+
+namespace
+{
+
+typedef QueryLog::Clock Clock;
+
+QueryProfile profile(const std::string& query_, std::int64_t totalUs_)
+{
+  QueryProfile profile;
+  profile.query = query_;
+  profile.totalUs = totalUs_;
+  return profile;
+}
+
+std::vector<std::string> queries(const std::vector<QueryProfile>& profiles_)
+{
+  std::vector<std::string> queries;
+
+  for (const QueryProfile& profile : profiles_)
+    queries.push_back(profile.query);
+
+  return queries;
+}
+
+/**
+ * Sleeps for the given time and returns the time actually slept.
+ */
+Clock::duration sleep(std::chrono::milliseconds duration_)
+{
+  Clock::time_point start = Clock::now();
+  std::this_thread::sleep_for(duration_);
+  return Clock::now() - start;
+}
+
+}
+
+TEST(QueryLogTest, SlowestFirst)
+{
+  QueryLog log(10);
+
+  log.add(profile("a", 5));
+  log.add(profile("b", 30));
+  log.add(profile("c", 10));
+  log.add(profile("d", 20));
+  log.add(profile("e", 1));
+
+  EXPECT_EQ(std::vector<std::string>({"b", "d", "c"}),
+    queries(log.slowest(3)));
+  EXPECT_EQ(std::vector<std::string>({"b", "d", "c", "a", "e"}),
+    queries(log.slowest(10)));
+  EXPECT_TRUE(log.slowest(0).empty());
+}
+
+TEST(QueryLogTest, OldestIsEvictedAtCapacity)
+{
+  QueryLog log(3);
+
+  log.add(profile("old", 100));
+  log.add(profile("a", 1));
+  log.add(profile("b", 2));
+  EXPECT_EQ(std::vector<std::string>({"old", "b", "a"}),
+    queries(log.slowest(10)));
+
+  // The slowest query is dropped too if it is the oldest one.
+  log.add(profile("c", 3));
+  EXPECT_EQ(std::vector<std::string>({"c", "b", "a"}),
+    queries(log.slowest(10)));
+}
+
+TEST(QueryLogTest, FailedQueryIsNotLogged)
+{
+  QueryLog log(10);
+
+  {
+    QueryLog::Timer timer(log, "search", "failed", 0);
+  }
+
+  EXPECT_TRUE(log.slowest(10).empty());
+}
+
+TEST(QueryLogTest, TimeSplitAddsUpToTotal)
+{
+  QueryLog log(10);
+
+  {
+    QueryLog::Timer timer(log, "search", "query", 1);
+
+    // Two calls to the search service processes, the first one is reported
+    // by the process.
+    Clock::duration wait = sleep(std::chrono::milliseconds(20));
+    Clock::duration run = sleep(std::chrono::milliseconds(30));
+
+    SearchTiming processTiming;
+    processTiming.matchUs = 15000;
+    processTiming.lineMatchUs = 5000;
+    QueryLog::addProcessCall(timer.profile(), wait, run, &processTiming);
+
+    wait = sleep(std::chrono::milliseconds(10));
+    run = sleep(std::chrono::milliseconds(10));
+    QueryLog::addProcessCall(timer.profile(), wait, run);
+
+    timer.finish(7);
+  }
+
+  std::vector<QueryProfile> profiles = log.slowest(1);
+  ASSERT_EQ(1u, profiles.size());
+
+  const QueryProfile& profile = profiles.front();
+  EXPECT_EQ("search", profile.method);
+  EXPECT_EQ("query", profile.query);
+  EXPECT_EQ(1, profile.options);
+  EXPECT_EQ(7, profile.resultCount);
+
+  EXPECT_LE(30000, profile.queueWaitUs);
+  EXPECT_EQ(15000, profile.matchUs);
+  EXPECT_EQ(5000, profile.lineMatchUs);
+  EXPECT_LE(20000, profile.ipcUs);
+
+  // Only the time between the measured parts is missing from the split.
+  std::int64_t parts = profile.queueWaitUs + profile.matchUs
+    + profile.lineMatchUs + profile.ipcUs;
+  EXPECT_LE(parts, profile.totalUs);
+  EXPECT_GT(parts + 10000, profile.totalUs);
+}
+
+TEST(QueryLogTest, CommunicationTimeIsNotNegative)
+{
+  QueryProfile profile;
+
+  // The process may report more than the measured run because of the
+  // rounding of the clocks, the communication time is not negative then.
+  SearchTiming processTiming;
+  processTiming.matchUs = 900;
+  processTiming.lineMatchUs = 200;
+  QueryLog::addProcessCall(profile, std::chrono::microseconds(100),
+    std::chrono::microseconds(1000), &processTiming);
+
+  EXPECT_EQ(100, profile.queueWaitUs);
+  EXPECT_EQ(900, profile.matchUs);
+  EXPECT_EQ(200, profile.lineMatchUs);
+  EXPECT_EQ(0, profile.ipcUs);
+}
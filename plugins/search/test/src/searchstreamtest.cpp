@@ -0,0 +1,299 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <service/searchstream.h>
+
+using namespace cc::service::search;
+
+namespace
+{
+
+typedef SearchStream::Clock Clock;
+
+/**
+ * Holds back a producer until it is opened or its search is cancelled.
+ */
+class Gate
+{
+public:
+  void open()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _open = true;
+    }
+
+    _signal.notify_all();
+  }
+
+  /**
+   * @return False if the search was cancelled.
+   */
+  bool pass(const SearchStream& stream_)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (!_open && !stream_.cancelled())
+      _signal.wait_for(lock, std::chrono::milliseconds(10));
+
+    return _open;
+  }
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _signal;
+  bool _open = false;
+};
+
+SearchResultEntry entry(const std::string& path_)
+{
+  SearchResultEntry entry;
+  entry.finfo.path = path_;
+  return entry;
+}
+
+/**
+ * Tells whether a producer has started and returned.
+ */
+struct ProducerRun
+{
+  std::atomic<bool> started{false};
+  std::atomic<bool> stopped{false};
+};
+
+/**
+ * Returns a producer which adds the given number of entries, waits for the
+ * gate, then adds the rest.
+ */
+SearchStreams::Producer producer(
+  std::size_t before_,
+  std::size_t after_,
+  std::shared_ptr<Gate> gate_,
+  std::shared_ptr<ProducerRun> run_)
+{
+  return [=](SearchStream& stream_)
+  {
+    run_->started = true;
+
+    stream_.setTotal(before_);
+    for (std::size_t i = 0; i < before_; ++i)
+      stream_.add(entry("/before" + std::to_string(i)));
+
+    if (gate_->pass(stream_))
+    {
+      stream_.setTotal(before_ + after_);
+      for (std::size_t i = 0; i < after_; ++i)
+        stream_.add(entry("/after" + std::to_string(i)));
+    }
+
+    run_->stopped = true;
+  };
+}
+
+/**
+ * Waits until the flag is set, but not longer than a few seconds.
+ */
+bool waitFor(const std::atomic<bool>& flag_)
+{
+  Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+
+  while (!flag_ && Clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  return flag_;
+}
+
+class SearchStreamTest : public ::testing::Test
+{
+protected:
+  SearchStreamTest()
+    : _gate(std::make_shared<Gate>()),
+      _run(std::make_shared<ProducerRun>())
+  {
+  }
+
+  std::shared_ptr<Gate> _gate;
+  std::shared_ptr<ProducerRun> _run;
+};
+
+}
+
+TEST_F(SearchStreamTest, Continuation)
+{
+  SearchStreams streams(8, std::chrono::minutes(1), 2);
+  std::string token = streams.start(3, producer(3, 2, _gate, _run));
+
+  // The first page is returned as soon as it is filled.
+  SearchProgress progress;
+  streams.get(token)->fetch(progress, std::chrono::seconds(10));
+  EXPECT_FALSE(progress.complete);
+  ASSERT_EQ(3u, progress.result.results.size());
+  EXPECT_EQ("/before0", progress.result.results[0].finfo.path);
+  EXPECT_EQ(3, progress.result.totalFiles);
+
+  _gate->open();
+
+  progress = SearchProgress();
+  streams.get(token)->fetch(progress, std::chrono::seconds(10));
+  EXPECT_TRUE(progress.complete);
+  ASSERT_EQ(2u, progress.result.results.size());
+  EXPECT_EQ("/after0", progress.result.results[0].finfo.path);
+  EXPECT_EQ(5, progress.result.totalFiles);
+
+  // The drained search is forgotten.
+  EXPECT_EQ(nullptr, streams.get(token));
+}
+
+TEST_F(SearchStreamTest, FirstPageDeadline)
+{
+  SearchStreams streams(8, std::chrono::minutes(1), 2);
+  std::string token = streams.start(10, producer(1, 0, _gate, _run));
+
+  Clock::time_point start = Clock::now();
+
+  SearchProgress progress;
+  streams.get(token)->fetch(progress, std::chrono::milliseconds(100));
+
+  // The page is not filled, so the results found until the deadline are
+  // returned.
+  EXPECT_LE(std::chrono::milliseconds(100), Clock::now() - start);
+  EXPECT_FALSE(progress.complete);
+  EXPECT_EQ(1u, progress.result.results.size());
+
+  _gate->open();
+
+  progress = SearchProgress();
+  streams.get(token)->fetch(progress, std::chrono::seconds(10));
+  EXPECT_TRUE(progress.complete);
+  EXPECT_TRUE(progress.result.results.empty());
+}
+
+TEST_F(SearchStreamTest, Failure)
+{
+  SearchStreams streams(8, std::chrono::minutes(1), 2);
+  std::string token = streams.start(10, [](SearchStream&)
+  {
+    SearchException ex;
+    ex.message = "Invalid query";
+    throw ex;
+  });
+
+  SearchProgress progress;
+
+  try
+  {
+    streams.get(token)->fetch(progress, std::chrono::seconds(10));
+    ADD_FAILURE() << "The failure of the search should be thrown.";
+  }
+  catch (const SearchException& ex)
+  {
+    EXPECT_EQ("Invalid query", ex.message);
+  }
+
+  EXPECT_EQ(nullptr, streams.get(token));
+}
+
+TEST_F(SearchStreamTest, Cancellation)
+{
+  SearchStreams streams(8, std::chrono::minutes(1), 2);
+  std::string token = streams.start(10, producer(1, 1, _gate, _run));
+  std::shared_ptr<SearchStream> stream = streams.get(token);
+  ASSERT_TRUE(waitFor(_run->started));
+
+  streams.cancel(token);
+
+  EXPECT_EQ(nullptr, streams.get(token));
+  EXPECT_TRUE(stream->cancelled());
+  EXPECT_TRUE(waitFor(_run->stopped));
+
+  // A cancelled search refuses more results.
+  EXPECT_FALSE(stream->add(entry("/late")));
+}
+
+TEST_F(SearchStreamTest, IdleExpiry)
+{
+  SearchStreams streams(8, std::chrono::milliseconds(50), 2);
+  std::string token = streams.start(10, producer(1, 1, _gate, _run));
+  std::shared_ptr<SearchStream> stream = streams.get(token);
+  ASSERT_TRUE(waitFor(_run->started));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // The abandoned search is cancelled when the searches are looked up.
+  EXPECT_EQ(nullptr, streams.get(token));
+  EXPECT_TRUE(stream->cancelled());
+  EXPECT_TRUE(waitFor(_run->stopped));
+}
+
+TEST_F(SearchStreamTest, LeastRecentlyUsedIsEvicted)
+{
+  SearchStreams streams(2, std::chrono::minutes(1), 3);
+
+  std::shared_ptr<ProducerRun> runs[3] = {
+    std::make_shared<ProducerRun>(),
+    std::make_shared<ProducerRun>(),
+    std::make_shared<ProducerRun>()};
+
+  std::string first = streams.start(10, producer(0, 0, _gate, runs[0]));
+  std::string second = streams.start(10, producer(0, 0, _gate, runs[1]));
+  ASSERT_TRUE(waitFor(runs[1]->started));
+
+  // Fetching the first search makes the second one the least recently used.
+  SearchProgress progress;
+  streams.get(first)->fetch(progress, Clock::duration::zero());
+
+  std::shared_ptr<SearchStream> evicted = streams.get(second);
+  std::string third = streams.start(10, producer(0, 0, _gate, runs[2]));
+
+  EXPECT_EQ(nullptr, streams.get(second));
+  EXPECT_TRUE(evicted->cancelled());
+  EXPECT_TRUE(waitFor(runs[1]->stopped));
+
+  EXPECT_NE(nullptr, streams.get(first));
+  EXPECT_NE(nullptr, streams.get(third));
+  EXPECT_FALSE(runs[0]->stopped);
+  EXPECT_FALSE(runs[2]->stopped);
+}
+
+TEST_F(SearchStreamTest, ThreadsAreBounded)
+{
+  std::shared_ptr<ProducerRun> queued = std::make_shared<ProducerRun>();
+
+  {
+    SearchStreams streams(8, std::chrono::minutes(1), 1);
+
+    streams.start(10, producer(0, 0, _gate, _run));
+    streams.start(10, producer(0, 0, _gate, queued));
+
+    ASSERT_TRUE(waitFor(_run->started));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(queued->started);
+
+    // The queued search runs when the only thread becomes free.
+    _gate->open();
+    EXPECT_TRUE(waitFor(queued->stopped));
+
+    // A search cancelled while it is queued doesn't run.
+    _gate = std::make_shared<Gate>();
+    _run = std::make_shared<ProducerRun>();
+    queued = std::make_shared<ProducerRun>();
+
+    streams.start(10, producer(0, 0, _gate, _run));
+    streams.cancel(streams.start(10, producer(0, 0, _gate, queued)));
+    ASSERT_TRUE(waitFor(_run->started));
+  }
+
+  // The destructor cancels the running search and joins the threads.
+  EXPECT_TRUE(_run->stopped);
+  EXPECT_FALSE(queued->started);
+}
@@ -0,0 +1,254 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <service/serviceprocesspool.h>
+
+using namespace cc::service::search;
+
+namespace
+{
+
+/**
+ * Stands for a search service process. A query on it fails like on a real
+ * process when it has been killed.
+ */
+class FakeProcess
+{
+public:
+  class ProcessDied : public apache::thrift::TException
+  {
+  public:
+    ProcessDied() : apache::thrift::TException("Service process died!") {}
+  };
+
+  explicit FakeProcess(int id_) : id(id_) {}
+
+  bool isAlive() const
+  {
+    return alive;
+  }
+
+  /**
+   * Runs a query, throwing ProcessDied if the process is dead.
+   */
+  int query()
+  {
+    if (!alive)
+      throw ProcessDied();
+
+    ++queries;
+    return id;
+  }
+
+  const int id;
+  std::atomic_bool alive{true};
+  std::atomic<int> queries{0};
+};
+
+typedef BasicServiceProcessPool<FakeProcess> FakeProcessPool;
+
+/**
+ * Starts fake processes with increasing ids. Processes can be made to fail
+ * starting. The started processes are reachable for killing them, but a
+ * killed one is destroyed by the pool.
+ */
+struct FakeFactory
+{
+  std::unique_ptr<FakeProcess> operator()()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (failures > 0)
+    {
+      --failures;
+      throw std::runtime_error("Couldn't start the process.");
+    }
+
+    std::unique_ptr<FakeProcess> process(new FakeProcess(started++));
+    processes.push_back(process.get());
+    return process;
+  }
+
+  FakeProcess* process(int id_)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return processes[id_];
+  }
+
+  int startedCount()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return started;
+  }
+
+  std::mutex mutex;
+  std::vector<FakeProcess*> processes;
+  int started = 0;
+  int failures = 0;
+};
+
+/**
+ * Waits until the factory has started the given number of processes.
+ */
+bool waitForStarts(FakeFactory& factory_, int count_)
+{
+  for (int i = 0; i < 500; ++i)
+  {
+    if (factory_.startedCount() >= count_)
+      return true;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  return false;
+}
+
+/**
+ * Runs a query on the pool and returns the id of the process which served
+ * it.
+ */
+int query(FakeProcessPool& pool_)
+{
+  int id = -1;
+  pool_.call([&id](FakeProcess& process_) { id = process_.query(); });
+  return id;
+}
+
+}
+
+TEST(ServiceProcessPoolTest, StartsAtLeastOneProcess)
+{
+  auto factory = std::make_shared<FakeFactory>();
+  FakeProcessPool pool(0, [factory]{ return (*factory)(); });
+
+  EXPECT_EQ(1, factory->startedCount());
+  EXPECT_EQ(0, query(pool));
+}
+
+TEST(ServiceProcessPoolTest, RetriesOnAnotherProcess)
+{
+  auto factory = std::make_shared<FakeFactory>();
+  FakeProcessPool pool(2, [factory]{ return (*factory)(); });
+
+  // Both processes are idle, the first one gets the query. The retry is
+  // served by the other one, or by the restarted first one if it has been
+  // started already.
+  factory->process(0)->alive = false;
+
+  EXPECT_NE(0, query(pool));
+}
+
+TEST(ServiceProcessPoolTest, RestartsDeadProcess)
+{
+  auto factory = std::make_shared<FakeFactory>();
+  FakeProcessPool pool(1, [factory]{ return (*factory)(); });
+
+  factory->process(0)->alive = false;
+
+  // The only process died, so the query can't be retried.
+  EXPECT_THROW(query(pool), FakeProcessPool::Unavailable);
+
+  ASSERT_TRUE(waitForStarts(*factory, 2));
+
+  // The restarted process is put in the slot shortly after its start.
+  int id = -1;
+  for (int i = 0; i < 500 && id == -1; ++i)
+  {
+    try
+    {
+      id = query(pool);
+    }
+    catch (const FakeProcessPool::Unavailable&)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  EXPECT_EQ(1, id);
+}
+
+TEST(ServiceProcessPoolTest, RetriesFailedRestart)
+{
+  auto factory = std::make_shared<FakeFactory>();
+  FakeProcessPool pool(1, [factory]{ return (*factory)(); },
+    std::chrono::milliseconds(10));
+
+  factory->failures = 2;
+  factory->process(0)->alive = false;
+
+  EXPECT_THROW(query(pool), FakeProcessPool::Unavailable);
+
+  ASSERT_TRUE(waitForStarts(*factory, 2));
+
+  std::lock_guard<std::mutex> lock(factory->mutex);
+  EXPECT_EQ(0, factory->failures);
+}
+
+TEST(ServiceProcessPoolTest, TransportErrorOfLiveProcessIsRethrown)
+{
+  auto factory = std::make_shared<FakeFactory>();
+  FakeProcessPool pool(2, [factory]{ return (*factory)(); });
+
+  int calls = 0;
+
+  EXPECT_THROW(
+    pool.call([&calls](FakeProcess&)
+    {
+      ++calls;
+      throw apache::thrift::transport::TTransportException("Timed out.");
+    }),
+    apache::thrift::transport::TTransportException);
+
+  // The query isn't retried and no process is restarted.
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(2, factory->startedCount());
+  EXPECT_EQ(0, query(pool));
+}
+
+TEST(ServiceProcessPoolTest, TransportErrorOfDeadProcessIsRetried)
+{
+  auto factory = std::make_shared<FakeFactory>();
+  FakeProcessPool pool(2, [factory]{ return (*factory)(); });
+
+  int id = -1;
+
+  pool.call([&id](FakeProcess& process_)
+  {
+    if (process_.id == 0)
+    {
+      // The process is killed while it serves the query.
+      process_.alive = false;
+      throw apache::thrift::transport::TTransportException("End of file.");
+    }
+
+    id = process_.query();
+  });
+
+  EXPECT_NE(-1, id);
+  EXPECT_NE(0, id);
+  EXPECT_TRUE(waitForStarts(*factory, 3));
+}
+
+TEST(ServiceProcessPoolTest, OtherErrorsAreRethrown)
+{
+  auto factory = std::make_shared<FakeFactory>();
+  FakeProcessPool pool(1, [factory]{ return (*factory)(); });
+
+  EXPECT_THROW(
+    pool.call([](FakeProcess&) { throw std::logic_error("Bad query."); }),
+    std::logic_error);
+
+  // The process still serves queries.
+  EXPECT_EQ(0, query(pool));
+  EXPECT_EQ(1, factory->startedCount());
+}
@@ -0,0 +1,199 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <suggestioncache.h>
+
+using namespace cc::service::search;
+
+namespace
+{
+
+std::vector<std::string> splitWords(const std::string& str_)
+{
+  std::vector<std::string> words;
+  std::string word;
+
+  for (char c : str_ + ' ')
+    if (!std::isspace(static_cast<unsigned char>(c)))
+      word += c;
+    else if (!word.empty())
+    {
+      words.push_back(word);
+      word.clear();
+    }
+
+  return words;
+}
+
+/**
+ * Simulates the lookup of the symbol suggester of the search service: Java
+ * lowers the case of the input, then AnalyzingInfixSuggester splits it like
+ * the WhitespaceAnalyzer and finds the suggestions which have one of the
+ * words, or a word starting with the last one. The suggestions are analyzed
+ * by the WhitespaceAnalyzer too, so their case is kept. The suggestions are
+ * given in the order of their weights.
+ */
+std::vector<std::string> javaLookup(
+  const std::vector<std::string>& suggestions_,
+  std::string input_,
+  std::size_t limit_)
+{
+  std::transform(input_.begin(), input_.end(), input_.begin(), ::tolower);
+  std::vector<std::string> inputWords = splitWords(input_);
+  std::vector<std::string> results;
+
+  for (const std::string& suggestion : suggestions_)
+  {
+    bool match = false;
+
+    for (const std::string& word : splitWords(suggestion))
+      for (std::size_t i = 0; i < inputWords.size(); ++i)
+        if (i + 1 < inputWords.size()
+          ? word == inputWords[i]
+          : word.compare(0, inputWords[i].size(), inputWords[i]) == 0)
+          match = true;
+
+    if (match && results.size() < limit_)
+      results.push_back(suggestion);
+  }
+
+  return results;
+}
+
+/**
+ * The last two suggestions are found for "m" and "size m" by their lower case
+ * words, but only their other words would match the longer inputs if the
+ * case was ignored.
+ */
+const std::vector<std::string> SUGGESTIONS{
+  "MyClass",
+  "myclass",
+  "my_func",
+  "MyCache get",
+  "getMy",
+  "mycount Size",
+  "size myc",
+  "MYCONST",
+  "mx MyCache",
+  "Size mx"};
+
+class SuggestionCacheTest : public ::testing::Test
+{
+protected:
+  SuggestionCacheTest()
+    : _cache(
+        (boost::filesystem::temp_directory_path()
+          / boost::filesystem::unique_path()).string(),
+        1 << 20,
+        std::chrono::minutes(10))
+  {
+  }
+
+  static SearchSuggestionParams params(
+    const std::string& input_,
+    std::int64_t limit_)
+  {
+    SearchSuggestionParams params;
+    params.options = SearchOptions::SearchInDefs;
+    params.userInput = input_;
+    params.limit = limit_;
+    return params;
+  }
+
+  /**
+   * Caches the complete suggestion list of the input.
+   */
+  void insertComplete(const std::string& input_)
+  {
+    _cache.insert(params(input_, 100),
+      javaLookup(SUGGESTIONS, input_, 100));
+  }
+
+  SuggestionCache _cache;
+};
+
+}
+
+TEST_F(SuggestionCacheTest, Miss)
+{
+  std::vector<std::string> results;
+  EXPECT_FALSE(_cache.find(params("my", 10), results));
+}
+
+TEST_F(SuggestionCacheTest, SameInput)
+{
+  _cache.insert(params("My", 2), javaLookup(SUGGESTIONS, "My", 2));
+
+  std::vector<std::string> results;
+  ASSERT_TRUE(_cache.find(params("mY", 1), results));
+  EXPECT_EQ(javaLookup(SUGGESTIONS, "my", 1), results);
+
+  // The first two suggestions don't tell the third one.
+  EXPECT_FALSE(_cache.find(params("my", 3), results));
+}
+
+TEST_F(SuggestionCacheTest, FilteredPrefixEqualsLookup)
+{
+  insertComplete("m");
+
+  for (const char* input :
+    {"my", "myc", "MyC", "mycl", "my_", "myco", "mycache", "mycount"})
+  {
+    std::vector<std::string> results;
+    ASSERT_TRUE(_cache.find(params(input, 100), results)) << input;
+    EXPECT_EQ(javaLookup(SUGGESTIONS, input, 100), results) << input;
+  }
+
+  // The lower case input doesn't find the words in upper case.
+  std::vector<std::string> results;
+  ASSERT_TRUE(_cache.find(params("MYC", 100), results));
+  EXPECT_EQ(std::vector<std::string>({"myclass", "mycount Size", "size myc"}),
+    results);
+}
+
+TEST_F(SuggestionCacheTest, FilteredPrefixOfSeveralWords)
+{
+  insertComplete("size m");
+
+  for (const char* input : {"size my", "Size myc", "size mycount"})
+  {
+    std::vector<std::string> results;
+    ASSERT_TRUE(_cache.find(params(input, 100), results)) << input;
+    EXPECT_EQ(javaLookup(SUGGESTIONS, input, 100), results) << input;
+  }
+
+  // A new word may find other suggestions.
+  std::vector<std::string> results;
+  EXPECT_FALSE(_cache.find(params("size m get", 100), results));
+}
+
+TEST_F(SuggestionCacheTest, IncompletePrefixIsNotFiltered)
+{
+  _cache.insert(params("m", 2), javaLookup(SUGGESTIONS, "m", 2));
+
+  std::vector<std::string> results;
+  EXPECT_FALSE(_cache.find(params("my", 2), results));
+}
+
+TEST_F(SuggestionCacheTest, FileNamesAreNotFiltered)
+{
+  SearchSuggestionParams prefix = params("m", 100);
+  prefix.options = SearchOptions::SearchForFileName;
+  _cache.insert(prefix, {"main.cpp"});
+
+  SearchSuggestionParams input = params("ma", 100);
+  input.options = SearchOptions::SearchForFileName;
+
+  std::vector<std::string> results;
+  EXPECT_FALSE(_cache.find(input, results));
+}
@@ -19,6 +19,12 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
   var moreSize = 5;
   var moreText = 'More ...';
 
+  /**
+   * Time in milliseconds a streamed search waits for results on the server
+   * before it returns the ones found so far.
+   */
+  var searchTimeout = 1000;
+
   var IconTree = declare([HtmlTree, TooltipTreeMixin], {
     getIconClass : function (item, opened) {
       if (item.fileName && item.name !== moreText)
@@ -79,6 +85,10 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
       });
 
       this.addChild(this._pager);
+
+      window.addEventListener('beforeunload', function () {
+        that._cancelSearch();
+      });
     },
 
     /**
@@ -270,54 +280,134 @@ function (ObjectStoreModel, BorderContainer, declare, Memory, Observable, topic,
       //--- Build new tree ---//
 
       this._moreMap = {};
+      this._cancelSearch();
 
+      if (data.searchType === SearchOptions.SearchForFileName) {
+        try {
+          var searchResult = model.searchservice.searchFile(params);
+        } catch (ex) {
+          topic.publish('codecompass/searchError', {exception: ex});
+        }
+
+        this._pager.set(
+          'total', searchResult ? searchResult.totalFiles : 0);
+
+        if (!searchResult || searchResult.totalFiles === 0)
+          this._addNoResult();
+        else
+          searchResult.results.forEach(function (fileInfo) {
+            that._createDirsByFInfo(fileInfo, true);
+          });
+
+        return;
+      }
+
+      // The other searches are streamed: the results found within the timeout
+      // are shown at once, the rest is added as it arrives.
       try {
-        var searchResult
-          = data.searchType === SearchOptions.SearchForFileName
-          ? model.searchservice.searchFile(params)
-          : model.searchservice.search(params);
+        var progress = model.searchservice.startSearch(params, searchTimeout);
       } catch (ex) {
         topic.publish('codecompass/searchError', {exception: ex});
       }
 
-      this._pager.set(
-        'total', searchResult ? searchResult.totalFiles : 0);
+      this._showProgress(progress);
+    },
+
+    /**
+     * This function adds the results of a streamed search to the tree and
+     * fetches the rest of them in the background.
+     * @param {SearchProgress} progress The result of a startSearch() or
+     * continueSearch() call.
+     */
+    _showProgress: function (progress) {
+      var that = this;
+
+      if (!progress) {
+        this._pager.set('total', 0);
+        this._addNoResult();
+        return;
+      }
+
+      this._pager.set('total', progress.result.totalFiles);
+
+      progress.result.results.forEach(function (searchResultEntry) {
+        that._addSearchResultEntry(searchResultEntry);
+      });
+
+      if (progress.complete) {
+        this._continuation = null;
+
+        if (progress.result.totalFiles === 0)
+          this._addNoResult();
 
-      if (!searchResult || searchResult.totalFiles === 0) {
-        this._store.add({
-          parent: 'root',
-          name: 'No result ...'
-        });
         return;
       }
 
-      if (data.searchType === SearchOptions.SearchForFileName)
-        searchResult.results.forEach(function (fileInfo) {
-          that._createDirsByFInfo(fileInfo, true);
+      var continuation = this._continuation = progress.continuation;
+
+      model.searchservice.continueSearch(continuation, searchTimeout,
+        function (next) {
+          // A new search was started in the meantime.
+          if (that._continuation !== continuation)
+            return;
+
+          if (!(next instanceof SearchProgress)) {
+            that._continuation = null;
+            topic.publish('codecompass/searchError', {exception: next});
+            return;
+          }
+
+          that._showProgress(next);
+          that._tree.expandAll();
         });
-      else
-        searchResult.results.forEach(function (searchResultEntry) {
-          var fileNode = that._createDirsByFInfo(searchResultEntry.finfo);
-
-          searchResultEntry.matchingLines.splice(0, moreSize).forEach(
-            function (lineMatch) {
-              that._store.add({
-                name: util.escapeTags(lineMatch.text),
-                parent: searchResultEntry.finfo.path,
-                fileRange: lineMatch.range,
-                fileName: searchResultEntry.finfo.name
-              });
-            });
+    },
 
-          if (searchResultEntry.matchingLines.length !== 0)
-            that._store.add({
-              name: moreText,
-              parent: searchResultEntry.finfo.path,
-              fileName: searchResultEntry.finfo.name
-            });
+    /**
+     * This function stops the streamed search whose results are being loaded,
+     * so that it doesn't use the server any longer.
+     */
+    _cancelSearch: function () {
+      if (!this._continuation)
+        return;
 
-          that._moreMap[fileNode.id] = searchResultEntry.matchingLines;
+      model.searchservice.cancelSearch(this._continuation, function () {});
+      this._continuation = null;
+    },
+
+    /**
+     * This function adds a file and its matching lines to the tree.
+     * @param {SearchResultEntry} searchResultEntry A result entry of a text
+     * search.
+     */
+    _addSearchResultEntry: function (searchResultEntry) {
+      var that = this;
+      var fileNode = this._createDirsByFInfo(searchResultEntry.finfo);
+
+      searchResultEntry.matchingLines.splice(0, moreSize).forEach(
+        function (lineMatch) {
+          that._store.add({
+            name: util.escapeTags(lineMatch.text),
+            parent: searchResultEntry.finfo.path,
+            fileRange: lineMatch.range,
+            fileName: searchResultEntry.finfo.name
+          });
+        });
+
+      if (searchResultEntry.matchingLines.length !== 0)
+        this._store.add({
+          name: moreText,
+          parent: searchResultEntry.finfo.path,
+          fileName: searchResultEntry.finfo.name
         });
+
+      this._moreMap[fileNode.id] = searchResultEntry.matchingLines;
+    },
+
+    _addNoResult: function () {
+      this._store.add({
+        parent: 'root',
+        name: 'No result ...'
+      });
     }
   });
 
@@ -0,0 +1,107 @@
+require([
+  'dojo/_base/declare',
+  'dojo/dom-construct',
+  'dijit/layout/ContentPane',
+  'codecompass/model',
+  'codecompass/viewHandler'],
+function (declare, dom, ContentPane, model, viewHandler) {
+
+  /**
+   * Number of the slowest recent queries listed on the page.
+   */
+  var maxQueries = 20;
+
+  /**
+   * Converts microseconds to milliseconds with one decimal digit.
+   */
+  function millis(us) {
+    return (Number(us) / 1000).toFixed(1);
+  }
+
+  /**
+   * Appends a table with the given header and rows to the parent node.
+   */
+  function createTable(parent, title, header, rows) {
+    dom.create('h3', { innerHTML : title }, parent);
+
+    var table = dom.create('table', { class : 'search-statistics' }, parent);
+
+    var tr = dom.create('tr', {}, table);
+    header.forEach(function (name) {
+      dom.create('th', { innerHTML : name }, tr);
+    });
+
+    rows.forEach(function (row) {
+      var tr = dom.create('tr', {}, table);
+      row.forEach(function (value) {
+        dom.create('td', { textContent : String(value) }, tr);
+      });
+    });
+  }
+
+  var StatisticsPage = declare(ContentPane, {
+    onShow : function () {
+      var that = this;
+
+      this.set('content', 'Loading...');
+
+      model.searchservice.getStatistics(maxQueries, function (statistics) {
+        if (statistics instanceof SearchStatistics)
+          that._render(statistics);
+        else
+          that.set('content', 'Failed to get the search statistics.');
+      });
+    },
+
+    _render : function (statistics) {
+      var node = dom.create('div');
+      var index = statistics.index;
+
+      createTable(node, 'Index', ['Property', 'Value'], [
+        ['Documents', index.documentCount],
+        ['Deleted documents', index.deletedDocumentCount],
+        ['Segments', index.segmentCount],
+        ['Size (bytes)', index.sizeBytes]]);
+
+      createTable(node, 'Fields',
+        ['Field', 'Documents', 'Terms', 'Tokens'],
+        index.fields.map(function (field) {
+          return [field.field, field.documentCount,
+            field.termCount < 0 ? 'unknown' : field.termCount,
+            field.tokenCount < 0 ? 'unknown' : field.tokenCount];
+        }));
+
+      createTable(node, 'Index files', ['Type', 'Size (bytes)'],
+        Object.keys(index.fileSizes).sort().map(function (type) {
+          return [type, index.fileSizes[type]];
+        }));
+
+      createTable(node, 'Slowest recent queries',
+        ['Method', 'Query', 'Started', 'Total (ms)', 'Queue wait (ms)',
+         'IPC (ms)', 'Match (ms)', 'Line match (ms)', 'Results'],
+        statistics.slowestQueries.map(function (query) {
+          return [query.method, query.query,
+            new Date(Number(query.startTime)).toLocaleString(),
+            millis(query.totalUs), millis(query.queueWaitUs),
+            millis(query.ipcUs), millis(query.matchUs),
+            millis(query.lineMatchUs), query.resultCount];
+        }));
+
+      createTable(node, 'Caches', ['Property', 'Value'],
+        Object.keys(statistics.caches).sort().map(function (name) {
+          return [name, statistics.caches[name]];
+        }));
+
+      this.set('content', node);
+    }
+  });
+
+  var infoPage = new StatisticsPage({
+    id    : 'searchstatistics',
+    title : 'Search Statistics'
+  });
+
+  viewHandler.registerModule(infoPage, {
+    type : viewHandler.moduleType.InfoPage
+  });
+});
@@ -108,6 +108,23 @@ service LanguageService
   string getDiagram(1:common.AstNodeId astNodeId, 2:i32 diagramId)
     throws (1:common.InvalidId exId, 2:common.Timeout exLong)
 
+  /**
+   * Returns the graph of a diagram about the AST node without layout
+   * information, so that the client can lay it out and render it by itself.
+   * @param astNodeId The AST node we want to draw diagram about.
+   * @param diagramId The diagram type we want to draw. The diagram types can be
+   * queried by getDiagramTypes().
+   * @return Compact JSON object with the attributes of the graph, its
+   * "subgraphs", "nodes" and "edges". Every node and edge has an "id" and the
+   * Graphviz "attributes" (label, shape, style, colors etc.) which decorate
+   * them; the edges also have "from" and "to" node IDs. If the diagram can't be
+   * generated then empty string returns.
+   * @exception common.InvalidId Exception is thrown if no AST node belongs to
+   * the given ID.
+   */
+  string getDiagramGraph(1:common.AstNodeId astNodeId, 2:i32 diagramId)
+    throws (1:common.InvalidId exId)
+
   /**
    * Returns the SVG represenation of the diagram legend used by getDiagram().
    * @param diagramId The diagram type. This should be one of the IDs returned
@@ -141,6 +158,20 @@ service LanguageService
   string getFileDiagram(1:common.FileId fileId, 2:i32 diagramId)
     throws (1:common.InvalidId exId, 2:common.Timeout exLong)
 
+  /**
+   * Returns the graph of a file diagram without layout information in the same
+   * JSON format as getDiagramGraph().
+   * @param fileId The file ID we would like to draw the diagram about.
+   * @param diagramId The diagram type we want to draw. These can be queried by
+   * getFileDiagramTypes().
+   * @return JSON description of the graph or empty string if the diagram can't
+   * be generated.
+   * @exception common.InvalidId Exception is thrown if no ID belongs to the
+   * given fileId.
+   */
+  string getFileDiagramGraph(1:common.FileId fileId, 2:i32 diagramId)
+    throws (1:common.InvalidId exId)
+
   /**
    * Returns the SVG represenation of the diagram legend used by
    * getFileDiagram().
@@ -171,6 +202,24 @@ service LanguageService
     1:common.AstNodeId astNodeId,
     2:i32 referenceId)
 
+  /**
+   * Batch variant of getReferenceCount(). Every requested reference type is
+   * counted for every given AST node in a single transaction. The simple
+   * reference types (definition, declaration, usage, etc.) are counted by one
+   * grouped query for all nodes.
+   * @param astNodeIds The AST nodes to be queried.
+   * @param referenceIds Reference types. Possible values can be queried by
+   * getReferenceTypes().
+   * @return A collection which maps the AST node IDs to a map from reference
+   * type to the number of references.
+   * @exception common.InvalidId Exception is thrown if no AST node belongs to
+   * any of the given IDs.
+   */
+  map<common.AstNodeId, map<i32, i32>> getReferenceCountBatch(
+    1:list<common.AstNodeId> astNodeIds,
+    2:list<i32> referenceIds)
+      throws (1:common.InvalidId ex)
+
   /**
    * Returns references to the AST node identified by astNodeId.
    * @param astNodeId The AST node to be queried.
@@ -0,0 +1,119 @@
+#ifndef CC_SERVICE_CORE_FILENAMEINDEX_H
+#define CC_SERVICE_CORE_FILENAMEINDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <odb/database.hxx>
+
+#include <util/projectgeneration.h>
+
+#include <project_types.h>
+
+namespace cc
+{
+namespace service
+{
+namespace core
+{
+
+/**
+ * In-memory index of the file names and paths of a project for file name
+ * search and "go to file". The index is built from the File table on the first
+ * query and rebuilt when the parser bumps the project generation. Queries in
+ * the meantime are served by the previous version of the index. Projects which
+ * are never searched don't build an index.
+ *
+ * The files are grouped by their directory prefix, so path queries are
+ * answered by scanning the distinct prefixes (far fewer than the files) and
+ * the names. Name queries are narrowed down by a trigram index of the lower
+ * case names, and by a bit mask of the characters occurring in each name.
+ */
+class FileNameIndex
+{
+public:
+  /**
+   * Returns the index of the given project directory. The index is created on
+   * the first call.
+   * @param datadir_ Project directory in the workspace.
+   */
+  static std::shared_ptr<FileNameIndex> forProject(
+    std::shared_ptr<odb::database> db_,
+    const std::string& datadir_);
+
+  FileNameIndex(
+    std::shared_ptr<odb::database> db_,
+    const std::string& datadir_);
+
+  /**
+   * Returns the files whose name (or path, if onlyFile_ is false) contains the
+   * text case-insensitively. Exact name matches come first, then name prefix
+   * matches, other name matches and path matches. The matches of the same
+   * rank are ordered by path length.
+   * @param onlyFile_ If true, directories are left out and only the names are
+   * searched.
+   */
+  std::vector<FileInfo> searchText(const std::string& text_, bool onlyFile_);
+
+  /**
+   * Returns the files (not directories) whose name matches the regular
+   * expression case-insensitively. The matches are grouped by their
+   * directories in path order, and the paging goes by these groups, because
+   * the search result view lists the files by directories.
+   * @param begin_ Position of the first returned directory.
+   * @param maxSize_ Maximal number of the returned directories.
+   * @param total_ The number of all directories containing matches.
+   * @throw boost::regex_error if the regular expression is invalid.
+   */
+  std::vector<FileInfo> searchRegex(
+    const std::string& regex_,
+    std::size_t begin_,
+    std::size_t maxSize_,
+    std::size_t& total_);
+
+  /**
+   * Returns the files (not directories) whose name contains the characters of
+   * the text in order, best matches first. If the text contains a slash then
+   * the whole path is matched. Consecutive characters and characters at the
+   * beginning of words weigh more.
+   */
+  std::vector<FileInfo> searchFuzzy(
+    const std::string& text_,
+    std::size_t maxSize_);
+
+private:
+  struct Data;
+
+  /**
+   * Returns the index of the current project generation, building it if
+   * necessary.
+   */
+  std::shared_ptr<const Data> data();
+
+  std::shared_ptr<const Data> build() const;
+
+  const std::shared_ptr<odb::database> _db;
+  const std::string _datadir;
+  util::ProjectGeneration _generation;
+
+  /**
+   * Guards _data and _dataGeneration.
+   */
+  std::mutex _mutex;
+  std::shared_ptr<const Data> _data;
+  std::uint64_t _dataGeneration = 0;
+
+  /**
+   * Held while the index is being built, so it's built by one thread only.
+   */
+  std::mutex _buildMutex;
+};
+
+} // core
+} // service
+} // cc
+
+#endif // CC_SERVICE_CORE_FILENAMEINDEX_H
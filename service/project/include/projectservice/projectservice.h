@@ -13,6 +13,8 @@
 
 #include <ProjectService.h>
 
+#include <projectservice/filenameindex.h>
+
 namespace cc 
 {
 namespace service
@@ -38,6 +40,7 @@ public:
   void getBuildLog(std::vector<BuildLog>& return_, const FileId& fileId_) override;
   void getParent(FileInfo& return_, const FileId& fileId_) override;
   void searchFile(std::vector<FileInfo>& return_, const std::string& text_, const bool onlyFile_) override;
+  void searchFileFuzzy(std::vector<FileInfo>& return_, const std::string& text_, const int32_t maxSize_) override;
   void getStatistics(std::vector<StatisticsInfo>& return_) override;
   void getFileTypes(std::vector<std::string>& return_) override;
   void getLabels(std::map<std::string, std::string>& return_) override;
@@ -54,6 +57,7 @@ private:
   std::shared_ptr<odb::database> _db;
   util::OdbTransaction _transaction;
   std::string _datadir;
+  std::shared_ptr<FileNameIndex> _fileNameIndex;
 };
 
 } // project
@@ -64,6 +64,14 @@ service ProjectService
   list<FileInfo> getPathTillFile(1:common.FileId fileId)
   list<BuildLog> getBuildLog(1:common.FileId fileId)
   list<FileInfo> searchFile(1:string text, 2:bool onlyFile)
+
+  /**
+  * This function returns the files whose name contains the characters of the
+  * text in order, best matches first. If the text contains a slash then the
+  * whole path is matched. It is meant for "go to file" dialogs.
+  */
+  list<FileInfo> searchFileFuzzy(1:string text, 2:i32 maxSize)
+
   list<StatisticsInfo> getStatistics()
   list<string> getFileTypes()
 
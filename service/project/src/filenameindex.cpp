@@ -0,0 +1,893 @@
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+#include <boost/regex.hpp>
+
+#include <odb/query.hxx>
+
+#include <model/file.h>
+#include <model/file-odb.hxx>
+
+#include <util/logutil.h>
+#include <util/odbtransaction.h>
+#include <util/regexliterals.h>
+
+#include <projectservice/filenameindex.h>
+
+namespace
+{
+
+/**
+ * A trigram is packed into the lower 24 bits of an integer.
+ */
+constexpr std::size_t TRIGRAM_COUNT = 1 << 24;
+
+std::uint32_t trigramAt(const char* str_)
+{
+  return
+    static_cast<std::uint32_t>(static_cast<unsigned char>(str_[0])) << 16 |
+    static_cast<std::uint32_t>(static_cast<unsigned char>(str_[1])) << 8 |
+    static_cast<std::uint32_t>(static_cast<unsigned char>(str_[2]));
+}
+
+char toLower(char c_)
+{
+  return 'A' <= c_ && c_ <= 'Z' ? c_ - 'A' + 'a' : c_;
+}
+
+std::string toLower(const std::string& str_)
+{
+  std::string lower(str_);
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+    [](char c_) { return toLower(c_); });
+  return lower;
+}
+
+/**
+ * Returns a bit of a lower case character for the character masks. The less
+ * frequent characters share the same bit.
+ */
+std::uint64_t charBit(char c_)
+{
+  if ('a' <= c_ && c_ <= 'z')
+    return std::uint64_t(1) << (c_ - 'a');
+  if ('0' <= c_ && c_ <= '9')
+    return std::uint64_t(1) << (26 + c_ - '0');
+
+  switch (c_)
+  {
+    case '_': return std::uint64_t(1) << 36;
+    case '-': return std::uint64_t(1) << 37;
+    case '.': return std::uint64_t(1) << 38;
+    case '/': return std::uint64_t(1) << 39;
+    default:  return std::uint64_t(1) << 40;
+  }
+}
+
+/**
+ * Directories have an extra bit in their name mask, so that the mask check
+ * can filter them out too.
+ */
+constexpr std::uint64_t DIRECTORY_BIT = std::uint64_t(1) << 63;
+
+std::uint64_t charMask(const char* str_, std::size_t size_)
+{
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < size_; ++i)
+    mask |= charBit(str_[i]);
+  return mask;
+}
+
+std::uint64_t charMask(const std::string& str_)
+{
+  return charMask(str_.data(), str_.size());
+}
+
+bool startsWith(
+  const char* str_,
+  std::size_t size_,
+  const char* prefix_,
+  std::size_t prefixSize_)
+{
+  return
+    prefixSize_ <= size_ && std::equal(prefix_, prefix_ + prefixSize_, str_);
+}
+
+bool contains(
+  const char* str_,
+  std::size_t size_,
+  const std::string& needle_)
+{
+  return std::search(str_, str_ + size_, needle_.begin(), needle_.end())
+    != str_ + size_;
+}
+
+bool isWordStart(const char* str_, std::size_t pos_)
+{
+  if (pos_ == 0)
+    return true;
+
+  char prev = str_[pos_ - 1];
+  char curr = str_[pos_];
+
+  return prev == '/' || prev == '_' || prev == '-' || prev == '.' ||
+    prev == ' ' || ('a' <= prev && prev <= 'z' && 'A' <= curr && curr <= 'Z');
+}
+
+/**
+ * Scores the fuzzy match of the lower case query in a string. Every matching
+ * character is worth a point, and characters following the previous match or
+ * starting a word are worth more. The first occurrence and the word starting
+ * occurrences of the first query character are tried as starting points, the
+ * rest of the query is matched greedily.
+ * @param str_ The original string for detecting the word boundaries.
+ * @param lower_ Lower case version of str_.
+ * @param bonusFrom_ Matches from this position get an extra point. This is
+ * the position of the file name in a path.
+ * @return The score of the best match or -1 if the query isn't a subsequence
+ * of the string.
+ */
+int fuzzyScore(
+  const char* str_,
+  const char* lower_,
+  std::size_t size_,
+  const std::string& query_,
+  std::size_t bonusFrom_)
+{
+  int best = -1;
+
+  for (std::size_t start = 0; start + query_.size() <= size_; ++start)
+  {
+    // Besides the first one, only the occurrences at word beginnings can
+    // improve the score.
+    if (lower_[start] != query_[0] ||
+        (best >= 0 && !isWordStart(str_, start)))
+      continue;
+
+    int score = 0;
+    std::size_t pos = start;
+    std::size_t prev = start;
+
+    for (std::size_t i = 0; i < query_.size(); ++i, ++pos)
+    {
+      while (pos < size_ && lower_[pos] != query_[i])
+        ++pos;
+
+      if (pos == size_)
+        return best;
+
+      score += 1;
+      if (i > 0 && pos == prev + 1)
+        score += 4;
+      if (isWordStart(str_, pos))
+        score += 3;
+      if (pos >= bonusFrom_)
+        score += 1;
+
+      prev = pos;
+    }
+
+    best = std::max(best, score);
+  }
+
+  return best;
+}
+
+/**
+ * Returns how many characters of the beginning of the query are a subsequence
+ * of the string.
+ */
+std::size_t subsequenceLength(
+  const char* str_,
+  std::size_t size_,
+  const char* query_,
+  std::size_t querySize_)
+{
+  std::size_t matched = 0;
+  for (std::size_t i = 0; i < size_ && matched < querySize_; ++i)
+    if (str_[i] == query_[matched])
+      ++matched;
+  return matched;
+}
+
+/**
+ * Intersects sorted lists of entry indices into the first one.
+ */
+void intersect(
+  std::vector<std::uint32_t>& result_,
+  const std::uint32_t* begin_,
+  const std::uint32_t* end_)
+{
+  result_.erase(
+    std::remove_if(result_.begin(), result_.end(),
+      [&](std::uint32_t entry_) {
+        begin_ = std::lower_bound(begin_, end_, entry_);
+        return begin_ == end_ || *begin_ != entry_;
+      }),
+    result_.end());
+}
+
+}
+
+namespace cc
+{
+namespace service
+{
+namespace core
+{
+
+struct FileNameIndex::Data
+{
+  struct Entry
+  {
+    model::FileId id;
+    model::FileId parent;
+    std::uint32_t name; /*!< Offset of the name in the name buffers. */
+    std::uint32_t nameSize;
+    std::uint32_t prefix; /*!< Index of the directory prefix. */
+    std::uint32_t type; /*!< Index of the file type. */
+    FileParseStatus::type parseStatus;
+    bool hasParent;
+    bool isDirectory;
+    bool nameInPath; /*!< The path is the prefix and the name, otherwise the
+      path is the prefix itself. */
+  };
+
+  /**
+   * Files ordered by their prefix and name.
+   */
+  std::vector<Entry> entries;
+  std::string names;
+  std::string lowerNames;
+  std::vector<std::uint64_t> nameMasks;
+
+  /**
+   * Distinct directory prefixes (the path without the name) in order. The
+   * entries of a prefix are in the [prefixBegin[i], prefixBegin[i + 1])
+   * range.
+   */
+  std::vector<std::string> prefixes;
+  std::vector<std::string> lowerPrefixes;
+  std::vector<std::uint64_t> prefixMasks;
+  std::vector<std::uint32_t> prefixBegin;
+
+  std::vector<std::string> types;
+
+  /**
+   * Trigram index of the lower case names. The entries containing the
+   * trigrams[i] are listed in the [postingBegin[i], postingBegin[i + 1]) range
+   * of the postings in ascending order.
+   */
+  std::vector<std::uint32_t> trigrams;
+  std::vector<std::uint32_t> postingBegin;
+  std::vector<std::uint32_t> postings;
+
+  const char* name(std::uint32_t entry_) const
+  {
+    return names.data() + entries[entry_].name;
+  }
+
+  const char* lowerName(std::uint32_t entry_) const
+  {
+    return lowerNames.data() + entries[entry_].name;
+  }
+
+  std::size_t pathSize(std::uint32_t entry_) const
+  {
+    const Entry& entry = entries[entry_];
+    return prefixes[entry.prefix].size()
+      + (entry.nameInPath ? entry.nameSize : 0);
+  }
+
+  /**
+   * Returns the postings of a trigram or an empty range if there is none.
+   */
+  std::pair<const std::uint32_t*, const std::uint32_t*> postingsOf(
+    std::uint32_t trigram_) const
+  {
+    auto it = std::lower_bound(trigrams.begin(), trigrams.end(), trigram_);
+    if (it == trigrams.end() || *it != trigram_)
+      return {nullptr, nullptr};
+
+    std::size_t i = it - trigrams.begin();
+    return {
+      postings.data() + postingBegin[i],
+      postings.data() + postingBegin[i + 1]};
+  }
+
+  /**
+   * Returns the entries whose name contains all the trigrams of the lower
+   * case strings, or all entries if the strings are shorter than a trigram.
+   */
+  std::vector<std::uint32_t> candidates(
+    const std::vector<std::string>& strs_) const
+  {
+    std::vector<std::pair<const std::uint32_t*, const std::uint32_t*>> lists;
+
+    for (const std::string& str : strs_)
+      for (std::size_t i = 0; i + 3 <= str.size(); ++i)
+        lists.push_back(postingsOf(trigramAt(str.data() + i)));
+
+    std::vector<std::uint32_t> result;
+
+    if (lists.empty())
+    {
+      result.resize(entries.size());
+      for (std::uint32_t i = 0; i < result.size(); ++i)
+        result[i] = i;
+      return result;
+    }
+
+    std::sort(lists.begin(), lists.end(), [](
+      const std::pair<const std::uint32_t*, const std::uint32_t*>& left_,
+      const std::pair<const std::uint32_t*, const std::uint32_t*>& right_)
+      {
+        return left_.second - left_.first < right_.second - right_.first;
+      });
+
+    result.assign(lists[0].first, lists[0].second);
+    for (std::size_t i = 1; i < lists.size() && !result.empty(); ++i)
+      intersect(result, lists[i].first, lists[i].second);
+
+    return result;
+  }
+
+  FileInfo fileInfo(std::uint32_t entry_) const
+  {
+    const Entry& entry = entries[entry_];
+
+    FileInfo fileInfo;
+
+    fileInfo.__set_id(std::to_string(entry.id));
+    fileInfo.__set_name(std::string(name(entry_), entry.nameSize));
+    fileInfo.__set_path(entry.nameInPath
+      ? prefixes[entry.prefix] + fileInfo.name
+      : prefixes[entry.prefix]);
+    fileInfo.__set_isDirectory(entry.isDirectory);
+    if (!entry.isDirectory)
+      fileInfo.__set_hasChildren(false);
+    fileInfo.__set_type(types[entry.type]);
+    if (entry.hasParent)
+      fileInfo.__set_parent(std::to_string(entry.parent));
+    fileInfo.__set_parseStatus(entry.parseStatus);
+
+    return fileInfo;
+  }
+};
+
+std::shared_ptr<FileNameIndex> FileNameIndex::forProject(
+  std::shared_ptr<odb::database> db_,
+  const std::string& datadir_)
+{
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<FileNameIndex>> indexes;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  std::shared_ptr<FileNameIndex> index = indexes[datadir_].lock();
+  if (!index)
+  {
+    index = std::make_shared<FileNameIndex>(db_, datadir_);
+    indexes[datadir_] = index;
+  }
+
+  return index;
+}
+
+FileNameIndex::FileNameIndex(
+  std::shared_ptr<odb::database> db_,
+  const std::string& datadir_)
+  : _db(db_), _datadir(datadir_), _generation(datadir_)
+{
+}
+
+std::shared_ptr<const FileNameIndex::Data> FileNameIndex::data()
+{
+  std::uint64_t generation = _generation.current();
+  std::shared_ptr<const Data> stale;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_data && _dataGeneration == generation)
+      return _data;
+    stale = _data;
+  }
+
+  // While the index is rebuilt, the queries are served by the previous one.
+  std::unique_lock<std::mutex> buildLock(_buildMutex, std::defer_lock);
+  if (stale)
+  {
+    if (!buildLock.try_lock())
+      return stale;
+  }
+  else
+    buildLock.lock();
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_data && _dataGeneration == generation)
+      return _data;
+  }
+
+  std::shared_ptr<const Data> data;
+
+  try
+  {
+    data = build();
+  }
+  catch (const odb::exception& ex)
+  {
+    if (!stale)
+      throw;
+
+    LOG(warning)
+      << "Failed to rebuild the file name index of " << _datadir
+      << ", using the previous one: " << ex.what();
+    return stale;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _data = data;
+  _dataGeneration = generation;
+
+  return _data;
+}
+
+std::shared_ptr<const FileNameIndex::Data> FileNameIndex::build() const
+{
+  auto start = std::chrono::steady_clock::now();
+
+  struct Record
+  {
+    model::File file;
+    std::size_t prefixSize;
+    bool nameInPath;
+  };
+
+  std::vector<Record> records;
+
+  util::OdbTransaction transaction(_db);
+  transaction([&, this]()
+  {
+    typedef odb::result<model::File> FileResult;
+
+    FileResult files = _db->query<model::File>();
+    for (FileResult::iterator it = files.begin(); it != files.end(); ++it)
+    {
+      records.emplace_back();
+      Record& record = records.back();
+      it.load(record.file);
+
+      const std::string& path = record.file.path;
+      const std::string& name = record.file.filename;
+
+      record.nameInPath = name.size() <= path.size() &&
+        path.compare(path.size() - name.size(), name.size(), name) == 0;
+      record.prefixSize = record.nameInPath
+        ? path.size() - name.size()
+        : path.size();
+    }
+  });
+
+  std::sort(records.begin(), records.end(),
+    [](const Record& left_, const Record& right_)
+    {
+      int cmp = left_.file.path.compare(
+        0, left_.prefixSize, right_.file.path, 0, right_.prefixSize);
+      return cmp != 0 ? cmp < 0 : left_.file.filename < right_.file.filename;
+    });
+
+  std::shared_ptr<Data> data = std::make_shared<Data>();
+  std::unordered_map<std::string, std::uint32_t> typeIndex;
+
+  data->entries.reserve(records.size());
+  data->nameMasks.reserve(records.size());
+
+  for (const Record& record : records)
+  {
+    const model::File& file = record.file;
+
+    if (data->prefixes.empty() ||
+        data->prefixes.back().compare(
+          0, std::string::npos, file.path, 0, record.prefixSize) != 0)
+    {
+      data->prefixes.push_back(file.path.substr(0, record.prefixSize));
+      data->lowerPrefixes.push_back(toLower(data->prefixes.back()));
+      data->prefixMasks.push_back(charMask(data->lowerPrefixes.back()));
+      data->prefixBegin.push_back(data->entries.size());
+    }
+
+    auto type = typeIndex.emplace(file.type, data->types.size());
+    if (type.second)
+      data->types.push_back(file.type);
+
+    Data::Entry entry;
+    entry.id = file.id;
+    entry.hasParent = static_cast<bool>(file.parent);
+    entry.parent = entry.hasParent ? file.parent.object_id() : 0;
+    entry.name = data->names.size();
+    entry.nameSize = file.filename.size();
+    entry.prefix = data->prefixes.size() - 1;
+    entry.type = type.first->second;
+    entry.isDirectory = file.type == model::File::DIRECTORY_TYPE;
+    entry.nameInPath = record.nameInPath;
+
+    switch (file.parseStatus)
+    {
+      default:
+      case model::File::PSNone:
+        entry.parseStatus = file.inSearchIndex
+          ? FileParseStatus::OnlyInSearchIndex
+          : FileParseStatus::Nothing;
+        break;
+      case model::File::PSPartiallyParsed:
+        entry.parseStatus = FileParseStatus::PartiallyParsed;
+        break;
+      case model::File::PSFullyParsed:
+        entry.parseStatus = FileParseStatus::FullyParsed;
+        break;
+    }
+
+    std::string lowerName = toLower(file.filename);
+    data->names += file.filename;
+    data->lowerNames += lowerName;
+    data->nameMasks.push_back(
+      charMask(lowerName) | (entry.isDirectory ? DIRECTORY_BIT : 0));
+    data->entries.push_back(entry);
+  }
+
+  data->prefixBegin.push_back(data->entries.size());
+
+  records.clear();
+  records.shrink_to_fit();
+
+  // The trigram index is built by counting sort: first the postings of every
+  // trigram are counted, then the entries are placed after each other.
+  std::vector<std::uint32_t> ends(TRIGRAM_COUNT, 0);
+  std::vector<std::uint32_t> nameTrigrams;
+
+  auto forEachTrigram = [&](std::uint32_t entry_, auto func_)
+  {
+    const Data::Entry& entry = data->entries[entry_];
+    const char* name = data->lowerName(entry_);
+
+    nameTrigrams.clear();
+    for (std::size_t i = 0; i + 3 <= entry.nameSize; ++i)
+      nameTrigrams.push_back(trigramAt(name + i));
+
+    std::sort(nameTrigrams.begin(), nameTrigrams.end());
+    nameTrigrams.erase(
+      std::unique(nameTrigrams.begin(), nameTrigrams.end()),
+      nameTrigrams.end());
+
+    for (std::uint32_t trigram : nameTrigrams)
+      func_(trigram);
+  };
+
+  for (std::uint32_t i = 0; i < data->entries.size(); ++i)
+    forEachTrigram(i, [&](std::uint32_t trigram_) { ++ends[trigram_]; });
+
+  std::uint32_t postingCount = 0;
+  for (std::uint32_t& end : ends)
+  {
+    std::uint32_t count = end;
+    end = postingCount;
+    postingCount += count;
+  }
+
+  data->postings.resize(postingCount);
+  for (std::uint32_t i = 0; i < data->entries.size(); ++i)
+    forEachTrigram(i, [&](std::uint32_t trigram_) {
+      data->postings[ends[trigram_]++] = i;
+    });
+
+  std::uint32_t begin = 0;
+  for (std::uint32_t trigram = 0; trigram < TRIGRAM_COUNT; ++trigram)
+  {
+    if (ends[trigram] == begin)
+      continue;
+
+    data->trigrams.push_back(trigram);
+    data->postingBegin.push_back(begin);
+    begin = ends[trigram];
+  }
+  data->postingBegin.push_back(begin);
+
+  LOG(info)
+    << "File name index of " << _datadir << " built: "
+    << data->entries.size() << " files, " << data->prefixes.size()
+    << " directories, " << data->trigrams.size() << " trigrams in "
+    << std::chrono::duration_cast<std::chrono::milliseconds>(
+         std::chrono::steady_clock::now() - start).count() << " ms";
+
+  return data;
+}
+
+std::vector<FileInfo> FileNameIndex::searchText(
+  const std::string& text_,
+  bool onlyFile_)
+{
+  std::shared_ptr<const Data> data = this->data();
+
+  std::string text = toLower(text_);
+  if (!text.empty() && text.back() == '/')
+    text.pop_back();
+
+  enum Rank : std::uint8_t
+  {
+    ExactName,
+    NamePrefix,
+    NameSubstring,
+    PathSubstring
+  };
+
+  std::vector<std::pair<Rank, std::uint32_t>> matches;
+  std::vector<bool> matched(data->entries.size(), false);
+  std::uint64_t mask = charMask(text);
+
+  for (std::uint32_t entry : data->candidates({text}))
+  {
+    const Data::Entry& file = data->entries[entry];
+
+    if ((data->nameMasks[entry] & (onlyFile_ ? mask | DIRECTORY_BIT : mask))
+        != mask)
+      continue;
+
+    const char* name = data->lowerName(entry);
+    const char* end = name + file.nameSize;
+    const char* pos = std::search(name, end, text.begin(), text.end());
+
+    if (pos == end && !text.empty())
+      continue;
+
+    matched[entry] = true;
+    matches.emplace_back(
+      pos != name
+        ? NameSubstring
+        : text.size() == file.nameSize ? ExactName : NamePrefix,
+      entry);
+  }
+
+  if (!onlyFile_)
+    for (std::uint32_t prefix = 0; prefix < data->prefixes.size(); ++prefix)
+    {
+      const std::string& lowerPrefix = data->lowerPrefixes[prefix];
+      std::uint32_t begin = data->prefixBegin[prefix];
+      std::uint32_t end = data->prefixBegin[prefix + 1];
+
+      if (lowerPrefix.find(text) != std::string::npos)
+      {
+        for (std::uint32_t entry = begin; entry < end; ++entry)
+          if (!matched[entry])
+            matches.emplace_back(PathSubstring, entry);
+        continue;
+      }
+
+      // The text may span the prefix and the name: its beginning is the end
+      // of the prefix and the rest is the beginning of the name.
+      for (std::size_t split = 1;
+           split < text.size() && split <= lowerPrefix.size();
+           ++split)
+      {
+        if (lowerPrefix.compare(
+              lowerPrefix.size() - split, split, text, 0, split) != 0)
+          continue;
+
+        for (std::uint32_t entry = begin; entry < end; ++entry)
+        {
+          const Data::Entry& file = data->entries[entry];
+
+          if (!matched[entry] && file.nameInPath &&
+              startsWith(data->lowerName(entry), file.nameSize,
+                text.data() + split, text.size() - split))
+          {
+            matched[entry] = true;
+            matches.emplace_back(PathSubstring, entry);
+          }
+        }
+      }
+    }
+
+  std::sort(matches.begin(), matches.end(),
+    [&data](
+      const std::pair<Rank, std::uint32_t>& left_,
+      const std::pair<Rank, std::uint32_t>& right_)
+    {
+      if (left_.first != right_.first)
+        return left_.first < right_.first;
+
+      std::size_t leftSize = data->pathSize(left_.second);
+      std::size_t rightSize = data->pathSize(right_.second);
+
+      return leftSize != rightSize
+        ? leftSize < rightSize
+        : left_.second < right_.second;
+    });
+
+  std::vector<FileInfo> result;
+  result.reserve(matches.size());
+
+  for (const std::pair<Rank, std::uint32_t>& match : matches)
+    result.push_back(data->fileInfo(match.second));
+
+  return result;
+}
+
+std::vector<FileInfo> FileNameIndex::searchRegex(
+  const std::string& regex_,
+  std::size_t begin_,
+  std::size_t maxSize_,
+  std::size_t& total_)
+{
+  boost::regex regex(regex_, boost::regex::icase);
+  std::vector<std::string> literals = util::requiredLiterals(regex_, true);
+
+  std::shared_ptr<const Data> data = this->data();
+
+  std::uint64_t mask = 0;
+  for (const std::string& literal : literals)
+    mask |= charMask(literal);
+
+  std::vector<FileInfo> result;
+  std::uint32_t lastPrefix = 0;
+  total_ = 0;
+
+  for (std::uint32_t entry : data->candidates(literals))
+  {
+    const Data::Entry& file = data->entries[entry];
+
+    if ((data->nameMasks[entry] & (mask | DIRECTORY_BIT)) != mask)
+      continue;
+
+    const char* lowerName = data->lowerName(entry);
+    if (!std::all_of(literals.begin(), literals.end(),
+          [&](const std::string& literal_) {
+            return contains(lowerName, file.nameSize, literal_);
+          }))
+      continue;
+
+    const char* name = data->name(entry);
+    if (!boost::regex_search(name, name + file.nameSize, regex))
+      continue;
+
+    // The candidates are ordered by their prefix, so the files of a directory
+    // follow each other.
+    if (total_ == 0 || file.prefix != lastPrefix)
+    {
+      lastPrefix = file.prefix;
+      ++total_;
+    }
+
+    if (begin_ < total_ && total_ - begin_ <= maxSize_)
+      result.push_back(data->fileInfo(entry));
+  }
+
+  return result;
+}
+
+std::vector<FileInfo> FileNameIndex::searchFuzzy(
+  const std::string& text_,
+  std::size_t maxSize_)
+{
+  std::shared_ptr<const Data> data = this->data();
+
+  std::string text = toLower(text_);
+  if (text.empty() || maxSize_ == 0)
+    return {};
+
+  bool matchPath = text.find('/') != std::string::npos;
+  std::uint64_t mask = charMask(text);
+
+  auto better = [&data](
+    const std::pair<int, std::uint32_t>& left_,
+    const std::pair<int, std::uint32_t>& right_)
+  {
+    if (left_.first != right_.first)
+      return left_.first > right_.first;
+
+    std::size_t leftSize = data->pathSize(left_.second);
+    std::size_t rightSize = data->pathSize(right_.second);
+
+    return leftSize != rightSize
+      ? leftSize < rightSize
+      : left_.second < right_.second;
+  };
+
+  // The best matches are kept in a heap whose top is the worst of them.
+  std::vector<std::pair<int, std::uint32_t>> matches;
+  auto addMatch = [&](int score_, std::uint32_t entry_)
+  {
+    if (score_ < 0)
+      return;
+
+    std::pair<int, std::uint32_t> match(score_, entry_);
+
+    if (matches.size() < maxSize_)
+    {
+      matches.push_back(match);
+      std::push_heap(matches.begin(), matches.end(), better);
+    }
+    else if (better(match, matches.front()))
+    {
+      std::pop_heap(matches.begin(), matches.end(), better);
+      matches.back() = match;
+      std::push_heap(matches.begin(), matches.end(), better);
+    }
+  };
+
+  std::string path;
+  std::string lowerPath;
+
+  // Only the masks are read for most of the files, the names are read only if
+  // the mask check passes.
+  if (matchPath)
+    for (std::uint32_t prefix = 0; prefix < data->prefixes.size(); ++prefix)
+    {
+      std::size_t prefixSize = data->prefixes[prefix].size();
+
+      // The rest of the query which is not matched by the prefix has to be
+      // matched by the name.
+      std::size_t prefixMatch = subsequenceLength(
+        data->lowerPrefixes[prefix].data(), prefixSize,
+        text.data(), text.size());
+      const char* rest = text.data() + prefixMatch;
+      std::size_t restSize = text.size() - prefixMatch;
+      std::uint64_t restMask = charMask(rest, restSize);
+
+      path = data->prefixes[prefix];
+      lowerPath = data->lowerPrefixes[prefix];
+
+      for (std::uint32_t entry = data->prefixBegin[prefix];
+           entry < data->prefixBegin[prefix + 1];
+           ++entry)
+      {
+        if ((data->nameMasks[entry] & (restMask | DIRECTORY_BIT)) != restMask)
+          continue;
+
+        const Data::Entry& file = data->entries[entry];
+
+        if (!file.nameInPath ||
+            subsequenceLength(data->lowerName(entry), file.nameSize,
+              rest, restSize) != restSize)
+          continue;
+
+        path.resize(prefixSize);
+        lowerPath.resize(prefixSize);
+        path.append(data->name(entry), file.nameSize);
+        lowerPath.append(data->lowerName(entry), file.nameSize);
+
+        addMatch(fuzzyScore(
+          path.data(), lowerPath.data(), path.size(), text, prefixSize),
+          entry);
+      }
+    }
+  else
+    for (std::uint32_t entry = 0; entry < data->entries.size(); ++entry)
+    {
+      if ((data->nameMasks[entry] & (mask | DIRECTORY_BIT)) != mask)
+        continue;
+
+      addMatch(fuzzyScore(
+        data->name(entry),
+        data->lowerName(entry),
+        data->entries[entry].nameSize,
+        text,
+        0),
+        entry);
+    }
+
+  std::sort_heap(matches.begin(), matches.end(), better);
+
+  std::vector<FileInfo> result;
+  result.reserve(matches.size());
+
+  for (const std::pair<int, std::uint32_t>& match : matches)
+    result.push_back(data->fileInfo(match.second));
+
+  return result;
+}
+
+} // core
+} // service
+} // cc
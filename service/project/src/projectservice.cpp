@@ -12,7 +12,6 @@
 #include <model/statistics.h>
 #include <model/statistics-odb.hxx>
 
-#include <util/dbutil.h>
 #include <util/odbtransaction.h>
 
 #include <projectservice/projectservice.h>
@@ -28,7 +27,8 @@ ProjectServiceHandler::ProjectServiceHandler(
   std::shared_ptr<odb::database> db_,
   std::shared_ptr<std::string> datadir_,
   const cc::webserver::ServerContext& /*context_*/)
-    : _db(db_), _transaction(db_), _datadir(*datadir_)
+    : _db(db_), _transaction(db_), _datadir(*datadir_),
+      _fileNameIndex(FileNameIndex::forProject(db_, _datadir))
 {
 }
 
@@ -276,30 +276,15 @@ void ProjectServiceHandler::searchFile(
   const std::string& text_,
   const bool onlyFile_)
 {
-  typedef odb::result<model::File> FileResult;
-  typedef odb::query<model::File> FileQuery;
-
-  std::string text = text_;
-
-  _transaction([&, this](){
-    if (text_.back() == '/')
-      text.pop_back();
-
-    FileResult r
-      = onlyFile_
-      ? _db->query<model::File>(
-          FileQuery::type != model::File::DIRECTORY_TYPE &&
-          FileQuery::filename + SQL_ILIKE + FileQuery::_val("%" + text + "%"))
-      : _db->query<model::File>(
-          FileQuery::path + SQL_ILIKE + FileQuery::_val("%" + text + "%"));
+  return_ = _fileNameIndex->searchText(text_, onlyFile_);
+}
 
-    model::File f;
-    for (FileResult::iterator i = r.begin(); i != r.end(); ++i)
-    {
-      i.load(f);
-      return_.push_back(makeFileInfo(f));
-    }
-  });
+void ProjectServiceHandler::searchFileFuzzy(
+  std::vector<FileInfo>& return_,
+  const std::string& text_,
+  const std::int32_t maxSize_)
+{
+  return_ = _fileNameIndex->searchFuzzy(text_, std::max(maxSize_, 0));
 }
 
 void ProjectServiceHandler::getStatistics(
@@ -0,0 +1,223 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/regex.hpp>
+
+#include <gtest/gtest.h>
+
+#include <model/file.h>
+#include <model/file-odb.hxx>
+
+#include <projectservice/filenameindex.h>
+
+#include <util/dbutil.h>
+#include <util/odbtransaction.h>
+
+extern const char* dbConnectionString;
+extern const char* sqlDir;
+
+namespace fs = boost::filesystem;
+
+using namespace cc;
+using namespace cc::service::core;
+
+typedef std::vector<std::string> Paths;
+
+/**
+ * Fills the File table of a separate test database with a small project, and
+ * queries the file name index built from it.
+ */
+class FileNameIndexTest : public ::testing::Test
+{
+public:
+  static void SetUpTestCase()
+  {
+    _db = util::connectDatabase(util::updateConnectionString(
+      dbConnectionString, "database", "filenameindextest"));
+    ASSERT_TRUE(_db);
+
+    util::removeTables(_db, sqlDir);
+    util::createTables(_db, sqlDir);
+
+    std::map<std::string, model::FilePtr> files;
+    model::FileId id = 0;
+
+    auto addFile = [&](const std::string& path_, const char* type_)
+    {
+      model::FilePtr file = std::make_shared<model::File>();
+      file->id = ++id;
+      file->type = type_;
+      file->path = path_;
+      file->filename = fs::path(path_).filename().string();
+
+      auto parent = files.find(fs::path(path_).parent_path().string());
+      if (parent != files.end())
+        file->parent = parent->second;
+
+      files[path_] = file;
+      _db->persist(*file);
+    };
+
+    util::OdbTransaction transaction(_db);
+    transaction([&]()
+    {
+      for (const char* dir : {"/include", "/src", "/src/app", "/src/util",
+                              "/test"})
+        addFile(dir, model::File::DIRECTORY_TYPE);
+
+      for (const char* path : {
+        "/include/a.h",
+        "/include/b.h",
+        "/src/main.cpp",
+        "/src/mystring.h",
+        "/src/app/main.cpp",
+        "/src/app/MainWindow.cpp",
+        "/src/util/string.cpp",
+        "/src/util/string.h",
+        "/src/util/stringbuilder.h",
+        "/test/domain.cpp",
+        "/test/main_test.cpp"})
+        addFile(path, "CPP");
+    });
+
+    _datadir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(_datadir);
+  }
+
+  static void TearDownTestCase()
+  {
+    fs::remove_all(_datadir);
+    _db.reset();
+  }
+
+protected:
+  FileNameIndexTest()
+    : _index(std::make_shared<FileNameIndex>(_db, _datadir.string()))
+  {
+  }
+
+  static Paths paths(const std::vector<FileInfo>& files_)
+  {
+    Paths result;
+    for (const FileInfo& file : files_)
+      result.push_back(file.path);
+    return result;
+  }
+
+  static std::shared_ptr<odb::database> _db;
+  static fs::path _datadir;
+
+  std::shared_ptr<FileNameIndex> _index;
+};
+
+std::shared_ptr<odb::database> FileNameIndexTest::_db;
+fs::path FileNameIndexTest::_datadir;
+
+TEST_F(FileNameIndexTest, TextRanking)
+{
+  // Name prefix matches come before other name matches, and the matches of
+  // the same rank are ordered by path length.
+  EXPECT_EQ(Paths({
+      "/src/main.cpp",
+      "/src/app/main.cpp",
+      "/test/main_test.cpp",
+      "/src/app/MainWindow.cpp",
+      "/test/domain.cpp"}),
+    paths(_index->searchText("main", true)));
+
+  // Exact name matches come first.
+  EXPECT_EQ(Paths({
+      "/src/main.cpp",
+      "/src/app/main.cpp",
+      "/test/domain.cpp"}),
+    paths(_index->searchText("MAIN.cpp", true)));
+}
+
+TEST_F(FileNameIndexTest, TextPathMatches)
+{
+  // The directory itself matches by name, its files by their path.
+  std::vector<FileInfo> files = _index->searchText("util", false);
+
+  EXPECT_EQ(Paths({
+      "/src/util",
+      "/src/util/string.h",
+      "/src/util/string.cpp",
+      "/src/util/stringbuilder.h"}),
+    paths(files));
+  ASSERT_FALSE(files.empty());
+  EXPECT_TRUE(files[0].isDirectory);
+  EXPECT_EQ("util", files[0].name);
+
+  EXPECT_TRUE(_index->searchText("util", true).empty());
+
+  // The text spans the directory and the name.
+  EXPECT_EQ(Paths({
+      "/src/util/string.h",
+      "/src/util/string.cpp",
+      "/src/util/stringbuilder.h"}),
+    paths(_index->searchText("util/str", false)));
+  EXPECT_TRUE(_index->searchText("util/str", true).empty());
+}
+
+TEST_F(FileNameIndexTest, RegexPagingByDirectory)
+{
+  std::size_t total = 0;
+
+  EXPECT_EQ(Paths({
+      "/include/a.h",
+      "/include/b.h",
+      "/src/mystring.h",
+      "/src/util/string.h",
+      "/src/util/stringbuilder.h"}),
+    paths(_index->searchRegex("\\.H$", 0, 10, total)));
+  EXPECT_EQ(3u, total);
+
+  // A page holds whole directories.
+  EXPECT_EQ(Paths({"/include/a.h", "/include/b.h"}),
+    paths(_index->searchRegex("\\.h$", 0, 1, total)));
+  EXPECT_EQ(3u, total);
+
+  EXPECT_EQ(Paths({"/src/mystring.h"}),
+    paths(_index->searchRegex("\\.h$", 1, 1, total)));
+
+  EXPECT_EQ(Paths({"/src/util/string.h", "/src/util/stringbuilder.h"}),
+    paths(_index->searchRegex("\\.h$", 2, 5, total)));
+
+  EXPECT_TRUE(_index->searchRegex("\\.h$", 3, 5, total).empty());
+  EXPECT_EQ(3u, total);
+
+  // Directories never match.
+  EXPECT_TRUE(_index->searchRegex("^util$", 0, 10, total).empty());
+  EXPECT_EQ(0u, total);
+
+  EXPECT_THROW(
+    _index->searchRegex("main(", 0, 10, total), boost::regex_error);
+}
+
+TEST_F(FileNameIndexTest, Fuzzy)
+{
+  // Word starts weigh more, equal scores are ordered by path length.
+  EXPECT_EQ(Paths({
+      "/src/util/string.h",
+      "/src/util/stringbuilder.h",
+      "/src/mystring.h"}),
+    paths(_index->searchFuzzy("sh", 10)));
+
+  EXPECT_EQ(Paths({"/src/util/string.h", "/src/util/stringbuilder.h"}),
+    paths(_index->searchFuzzy("sh", 2)));
+
+  EXPECT_EQ(Paths({"/src/app/MainWindow.cpp"}),
+    paths(_index->searchFuzzy("mainw", 10)));
+
+  // With a slash the directory is matched too.
+  EXPECT_EQ(Paths({"/src/util/stringbuilder.h"}),
+    paths(_index->searchFuzzy("util/sb", 10)));
+
+  EXPECT_TRUE(_index->searchFuzzy("", 10).empty());
+  EXPECT_TRUE(_index->searchFuzzy("sh", 0).empty());
+}
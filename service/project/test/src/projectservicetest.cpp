@@ -0,0 +1,23 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <gtest/gtest.h>
+
+const char* dbConnectionString;
+const char* sqlDir;
+
+int main(int argc, char** argv)
+{
+  if (argc < 3 || strcmp(argv[1], "") == 0)
+  {
+    GTEST_LOG_(FATAL) << "No test database connection given.";
+    return 1;
+  }
+
+  dbConnectionString = argv[1];
+  sqlDir = argv[2];
+
+  GTEST_LOG_(INFO) << "Using database for tests: " << dbConnectionString;
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
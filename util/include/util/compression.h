@@ -0,0 +1,55 @@
+#ifndef CC_UTIL_COMPRESSION_H
+#define CC_UTIL_COMPRESSION_H
+
+#include <cstddef>
+#include <string>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * HTTP content codings which the web server can produce.
+ */
+enum class ContentEncoding
+{
+  IDENTITY,
+  GZIP,
+  DEFLATE
+};
+
+/**
+ * Responses smaller than this (in bytes) are not worth compressing: the
+ * saving doesn't pay for the CPU time and the compression headers.
+ */
+constexpr std::size_t COMPRESSION_THRESHOLD = 1024;
+
+/**
+ * Chooses the content coding of a response from the value of the
+ * Accept-Encoding request header. The coding with the highest quality value is
+ * chosen, gzip is preferred among equal ones. Codings with zero quality value
+ * are refused.
+ * @param acceptEncoding_ The header value or nullptr if it is missing.
+ */
+ContentEncoding negotiateEncoding(const char* acceptEncoding_);
+
+/**
+ * Returns the name of the coding as used in the Content-Encoding header.
+ */
+const char* encodingName(ContentEncoding encoding_);
+
+/**
+ * Compresses the data by zlib in the given content coding.
+ * @return False if the data can't be compressed in this coding.
+ */
+bool compress(
+  const char* data_,
+  std::size_t size_,
+  ContentEncoding encoding_,
+  std::string& result_);
+
+} // util
+} // cc
+
+#endif // CC_UTIL_COMPRESSION_H
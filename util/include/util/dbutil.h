@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <odb/database.hxx>
 
@@ -32,6 +33,45 @@ std::shared_ptr<odb::database> connectDatabase(
   const std::string& connStr_,
   bool create_ = true);
 
+/**
+ * Limits of the connection pool of a PostgreSQL database. Every connection
+ * string is connected only once by connectDatabase(), so all services of a
+ * project share the same pool. SQLite databases use a single connection.
+ */
+struct DatabasePoolOptions
+{
+  /**
+   * Maximal number of open connections per database, zero means unlimited.
+   * Transactions beyond this wait for a free connection.
+   */
+  std::size_t maxConnections = 0;
+
+  /**
+   * Number of connections per database which are kept open even if they are
+   * idle for longer than idleTimeout.
+   */
+  std::size_t minConnections = 0;
+
+  /**
+   * Seconds after which an idle connection is closed, as long as more than
+   * minConnections are open. Zero keeps the idle connections open.
+   */
+  std::size_t idleTimeout = 0;
+};
+
+/**
+ * Sets the limits of the connection pools. It affects the databases which
+ * are connected afterwards.
+ */
+void configureDatabasePool(const DatabasePoolOptions& options_);
+
+/**
+ * Returns the metrics of the connection pools in the Prometheus text
+ * exposition format: the number of acquired connections and the time spent
+ * waiting for them, labelled by the name of the database.
+ */
+std::string databasePoolMetrics();
+
 /**
  * This function adds indexes to the database. These indexes are added from the
  * .sql files which describe the model.
@@ -158,6 +198,39 @@ odb::query<TQueryParam> getFilterPathsQuery(
   return query;
 }
 
+/**
+ * This function runs the query built by build_ for consecutive chunks of the
+ * given values and collects the results. The chunks keep the number of bound
+ * parameters of an IN clause below the limit of the database.
+ * @param build_ A function which gets an iterator range of the values and
+ * returns the query for them.
+ */
+template <typename T, typename Container, typename Build>
+std::vector<T> queryInChunks(
+  odb::database& db_,
+  const Container& values_,
+  Build build_)
+{
+  const std::size_t chunkSize = 500;
+
+  std::vector<T> result;
+  auto it = values_.begin();
+
+  while (it != values_.end())
+  {
+    auto end = it;
+    for (std::size_t i = 0; i < chunkSize && end != values_.end(); ++i)
+      ++end;
+
+    odb::result<T> chunk = db_.query<T>(build_(it, end));
+    result.insert(result.end(), chunk.begin(), chunk.end());
+
+    it = end;
+  }
+
+  return result;
+}
+
 } // util
 } // cc
 
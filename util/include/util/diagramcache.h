@@ -0,0 +1,155 @@
+#ifndef CC_UTIL_DIAGRAMCACHE_H
+#define CC_UTIL_DIAGRAMCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <util/graph.h>
+#include <util/lrucache.h>
+#include <util/projectgeneration.h>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * Two-level cache of rendered diagrams. Building a diagram from the database
+ * and laying it out by Graphviz are both expensive, so they are cached
+ * separately:
+ *
+ *  - The first level maps a diagram (its kind, the ID of the queried node or
+ *    file and the generation of the project database) to the DOT description
+ *    of the graph. Entries of older generations are dropped when the project
+ *    is reparsed.
+ *  - The second level maps the hash of the DOT text to the rendered SVG. Since
+ *    these keys are content-addressed they never become stale: an unchanged
+ *    diagram of a reparsed project is not laid out again.
+ *
+ * Both levels are kept in memory and optionally also in the "diagramcache"
+ * directory of the project in the workspace, so the rendered diagrams survive
+ * a restart of the web server. The directory can be deleted any time.
+ *
+ * The graphs are laid out by the GraphLayout worker pool. A zero capacity
+ * disables the in-memory caching but the diagrams are still rendered this
+ * way.
+ */
+class DiagramCache
+{
+public:
+  struct StringSizer
+  {
+    std::size_t operator()(
+      const std::string& key_,
+      const std::string& value_) const
+    {
+      // The key is stored twice: in the LRU list and in the index.
+      return 2 * (sizeof(std::string) + key_.capacity())
+        + sizeof(std::string) + value_.capacity();
+    }
+  };
+
+  typedef LruCache<std::string, std::string, StringSizer> CacheType;
+
+  struct Statistics
+  {
+    CacheType::Statistics dot;
+    CacheType::Statistics svg;
+    std::uint64_t diskHits = 0;
+    std::uint64_t diskWrites = 0;
+  };
+
+  /**
+   * Returns the cache belonging to the given project directory. The cache is
+   * created on the first call, later calls ignore the other parameters.
+   * @param projectDir_ Project directory in the workspace.
+   * @param capacity_ Maximal size of the cached diagrams in memory in bytes.
+   * @param useDisk_ If true then the diagrams are also stored on disk.
+   */
+  static std::shared_ptr<DiagramCache> forProject(
+    const std::string& projectDir_,
+    std::size_t capacity_,
+    bool useDisk_);
+
+  DiagramCache(
+    const std::string& projectDir_,
+    std::size_t capacity_,
+    bool useDisk_);
+  ~DiagramCache();
+
+  /**
+   * Returns the SVG rendering of a diagram or an empty string if the diagram
+   * has no nodes.
+   * @param kind_ Identifies the service and the type of the diagram.
+   * @param id_ ID of the AST node or file of which the diagram is queried.
+   * @param build_ Builds the graph if its DOT text is not cached yet.
+   */
+  std::string getSvg(
+    const std::string& kind_,
+    const std::string& id_,
+    const std::function<Graph()>& build_);
+
+  /**
+   * Returns the JSON description of a diagram (see Graph::toJson()) or an
+   * empty string if the diagram has no nodes. These are cached in the first
+   * level, next to the DOT descriptions.
+   */
+  std::string getJson(
+    const std::string& kind_,
+    const std::string& id_,
+    const std::function<Graph()>& build_);
+
+  Statistics statistics() const;
+
+private:
+  /**
+   * Returns the description of the diagram from the first level, or builds
+   * the graph and converts it to text.
+   * @param format_ Extension of the file in the disk cache ("dot" or "json").
+   */
+  std::string getDescription(
+    const std::string& kind_,
+    const std::string& id_,
+    const std::string& format_,
+    const std::function<Graph()>& build_,
+    const std::function<std::string(Graph&)>& convert_);
+
+  /**
+   * Returns the SVG rendering of the DOT text from the second level, or lays
+   * out and renders the graph.
+   */
+  std::string render(const std::string& dot_);
+
+  /**
+   * Drops the first level if the generation of the project has changed.
+   * @return The current generation.
+   */
+  std::uint64_t checkGeneration();
+
+  bool readFile(const std::string& name_, std::string& content_);
+  void writeFile(const std::string& name_, const std::string& content_);
+  void removeDescriptionFiles();
+
+  void logStatistics(const std::string& reason_) const;
+
+  const std::string _projectDir;
+  const std::string _cacheDir;
+  const bool _useDisk;
+
+  ProjectGeneration _generation;
+  std::atomic<std::uint64_t> _lastGeneration;
+
+  CacheType _dotCache;
+  CacheType _svgCache;
+
+  std::atomic<std::uint64_t> _diskHits{0};
+  std::atomic<std::uint64_t> _diskWrites{0};
+};
+
+} // util
+} // cc
+
+#endif /* CC_UTIL_DIAGRAMCACHE_H */
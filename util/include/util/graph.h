@@ -27,7 +27,12 @@ struct GraphPimpl;
 class Graph
 {
 public:
-  enum Format {DOT, SVG};
+  /**
+   * DOT and SVG outputs are laid out by the dot algorithm. CANON is the DOT
+   * description of the graph without layout information, which is cheap to
+   * produce and can be rendered later by dotToSvg().
+   */
+  enum Format {DOT, SVG, CANON};
 
   typedef std::string Node;
   typedef std::string Edge;
@@ -140,6 +145,15 @@ public:
    */
   void delEdge(const Node& from_, const Node& to_);
 
+  /**
+   * This function shrinks the graph if it has more nodes or edges than the
+   * given limits, since the layout of huge graphs takes very long and they are
+   * unreadable anyway. The nodes with the fewest connections are removed and
+   * a note node is added which tells the number of the omitted nodes.
+   * @return The number of removed nodes.
+   */
+  std::size_t summarize(std::size_t maxNodes_, std::size_t maxEdges_);
+
   /**
    * This function sets the attributes of the graph. These attributes are listed
    * at this link: http://www.graphviz.org/content/attrs.
@@ -209,6 +223,20 @@ public:
    */
   std::string output(Format format_) const;
 
+  /**
+   * This function returns the graph without layout information as compact
+   * JSON, so that clients can lay it out by themselves:
+   *
+   * {"directed":true,"attributes":{...},
+   *  "subgraphs":[{"id":"...","attributes":{...},"nodes":["...",...]},...],
+   *  "nodes":[{"id":"...","attributes":{...}},...],
+   *  "edges":[{"id":"...","from":"...","to":"...","attributes":{...}},...]}
+   *
+   * Only the attributes which differ from their default value are listed. The
+   * values of HTML-like attributes are enclosed in angle brackets as in DOT.
+   */
+  std::string toJson() const;
+
   /**
    * This function returns the child nodes of a given node.
    */
@@ -327,6 +355,87 @@ inline std::set<Graph::Node> bfsBuild(
   return visitedNodes;
 }
 
+/**
+ * This function builds a graph in the order of breadth-first search like
+ * bfsBuild(), but the relation is evaluated for a whole level of the search at
+ * once. This way the children of all nodes on a level can be fetched by a
+ * single database query instead of one query per node.
+ * @param graph_ The graph will be appended by the new nodes and edges.
+ * @param startNodes_ Breadth-first search starts from these nodes. A start
+ * node is inserted into the returning set only if it is reachable from
+ * another start node.
+ * @param relations_ This function maps the nodes of a level to their child
+ * nodes. The nodes without children may be omitted from the result.
+ * @param nodeDecoration_ This parameter maps the style attributes for the newly
+ * created nodes.
+ * @param edgeDecoration_ This parameter maps the style attributes for the newly
+ * created edges.
+ * @param level_ The depth of the search, or -1 if it is unlimited.
+ * @param expandLimit_ The number of nodes whose children are fetched, or -1
+ * if it is unlimited. Like the level_ parameter of bfsBuild(), it stops the
+ * search in the middle of a level if needed.
+ * @return This function returns a set of nodes which are added to the graph.
+ */
+inline std::set<Graph::Node> bfsBuildLevels(
+  Graph& graph_,
+  const std::vector<Graph::Node>& startNodes_,
+  std::function<std::map<Graph::Node, std::vector<Graph::Node>>(
+    Graph&, const std::vector<Graph::Node>&)> relations_,
+  const std::vector<std::pair<std::string, std::string>>& nodeDecoration_
+    = std::vector<std::pair<std::string, std::string>>(),
+  const std::vector<std::pair<std::string, std::string>>& edgeDecoration_
+    = std::vector<std::pair<std::string, std::string>>(),
+  const int level_ = -1,
+  const int expandLimit_ = -1)
+{
+  std::set<Graph::Node> visitedNodes;
+
+  if (level_ < -1 || expandLimit_ < -1)
+    return visitedNodes;
+
+  std::set<Graph::Node> expandedNodes(startNodes_.begin(), startNodes_.end());
+  std::vector<Graph::Node> frontier(
+    expandedNodes.begin(), expandedNodes.end());
+  std::size_t expanded = 0;
+
+  for (int level = 0; !frontier.empty() && level != level_; ++level)
+  {
+    if (expandLimit_ != -1)
+    {
+      std::size_t left = static_cast<std::size_t>(expandLimit_) - expanded;
+
+      if (left == 0)
+        break;
+
+      if (frontier.size() > left)
+        frontier.resize(left);
+    }
+
+    expanded += frontier.size();
+
+    std::vector<Graph::Node> next;
+
+    for (const auto& children : relations_(graph_, frontier))
+      for (const Graph::Node& to : children.second)
+      {
+        if (visitedNodes.insert(to).second)
+          for (const auto& decoration : nodeDecoration_)
+            graph_.setNodeAttribute(to, decoration.first, decoration.second);
+
+        if (expandedNodes.insert(to).second)
+          next.push_back(to);
+
+        Graph::Edge edge = graph_.createEdge(children.first, to);
+        for (const auto& decoration : edgeDecoration_)
+          graph_.setEdgeAttribute(edge, decoration.first, decoration.second);
+      }
+
+    frontier.swap(next);
+  }
+
+  return visitedNodes;
+}
+
 } // util
 } // cc
 
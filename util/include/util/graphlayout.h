@@ -0,0 +1,114 @@
+#ifndef CC_UTIL_GRAPHLAYOUT_H
+#define CC_UTIL_GRAPHLAYOUT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include <util/graph.h>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * Lays out and renders graphs away from the request threads of the server.
+ *
+ * Every layout runs in a worker process (the CodeCompass_graphlayout
+ * executable), so a layout which doesn't finish until the deadline can be
+ * killed, and a crash in Graphviz doesn't take the server down. The number
+ * of concurrent workers is bounded: the requests wait for a free worker, but
+ * not longer than their deadline. Graphs exceeding the node or edge limit are
+ * summarized before the layout (see Graph::summarize()).
+ */
+class GraphLayout
+{
+public:
+  /**
+   * Thrown when a graph couldn't be rendered in time or the worker failed.
+   */
+  class Failure : public std::runtime_error
+  {
+  public:
+    Failure(const std::string& msg_);
+  };
+
+  struct Options
+  {
+    std::size_t workers = 4;
+    std::chrono::milliseconds timeout = std::chrono::seconds(60);
+    std::size_t maxNodes = 1000;
+    std::size_t maxEdges = 4000;
+
+    /**
+     * The worker executable. It is searched in PATH if it is not a path.
+     */
+    std::string worker = "CodeCompass_graphlayout";
+  };
+
+  /**
+   * Returns the process-wide layout pool.
+   */
+  static GraphLayout& instance();
+
+  /**
+   * Sets the options of the pool. It affects the layouts started afterwards.
+   * The options are shared by every project of the server, so they are set
+   * once, when the plugin using the pool is loaded.
+   */
+  void configure(const Options& options_);
+
+  Options options() const;
+
+  /**
+   * Summarizes the graph if it exceeds the limits and returns its DOT
+   * description without layout information.
+   */
+  std::string toDot(Graph& graph_) const;
+
+  /**
+   * Summarizes the graph if it exceeds the limits and returns its JSON
+   * description (see Graph::toJson()) for clients which lay out the graph by
+   * themselves.
+   */
+  std::string toJson(Graph& graph_) const;
+
+  /**
+   * Lays out the graph given in DOT format and renders it to SVG in a worker
+   * process.
+   * @throw Failure if the deadline expired or the worker failed.
+   */
+  std::string dotToSvg(const std::string& dot_);
+
+  /**
+   * Returns a small SVG image which shows the given message. It can be
+   * returned instead of a diagram which couldn't be rendered.
+   */
+  static std::string messageSvg(const std::string& message_);
+
+private:
+  GraphLayout() = default;
+
+  void summarize(Graph& graph_) const;
+
+  /**
+   * Waits for a free worker until the deadline.
+   * @return False if the deadline expired.
+   */
+  bool acquireWorker(std::chrono::steady_clock::time_point deadline_);
+  void releaseWorker();
+
+  mutable std::mutex _mutex;
+  std::condition_variable _freeWorker;
+  std::size_t _busyWorkers = 0;
+  Options _options;
+};
+
+} // util
+} // cc
+
+#endif /* CC_UTIL_GRAPHLAYOUT_H */
@@ -0,0 +1,246 @@
+#ifndef CC_UTIL_LRUCACHE_H
+#define CC_UTIL_LRUCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * Thread-safe least recently used cache bounded by the total size of the
+ * stored values in bytes. The keys are distributed among independently locked
+ * shards so concurrent requests rarely contend for the same mutex. Every shard
+ * gets an equal portion of the byte budget and evicts its own least recently
+ * used entries when that portion is exceeded.
+ *
+ * The size of an entry is computed by the Sizer functor which has to return
+ * the approximate number of bytes occupied by a key-value pair.
+ */
+template <
+  typename Key,
+  typename Value,
+  typename Sizer,
+  typename Hash = std::hash<Key>>
+class LruCache
+{
+public:
+  /**
+   * Counters describing the efficiency of the cache.
+   */
+  struct Statistics
+  {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+  };
+
+private:
+  class Shard
+  {
+  private:
+    struct Entry
+    {
+      Key key;
+      Value value;
+      std::size_t size;
+    };
+
+    typedef std::list<Entry>                ListType;
+    typedef typename ListType::iterator     ListIterator;
+
+  public:
+    explicit Shard(std::size_t capacity_) : _capacity(capacity_) {}
+
+    bool find(const Key& key_, Value& value_)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      auto it = _index.find(key_);
+      if (it == _index.end())
+        return false;
+
+      // Move the entry to the front, it became the most recently used one.
+      _entries.splice(_entries.begin(), _entries, it->second);
+      value_ = it->second->value;
+      return true;
+    }
+
+    /**
+     * Inserts the entry and returns the number of evicted entries.
+     */
+    std::uint64_t insert(const Key& key_, Value value_, std::size_t size_)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      if (size_ > _capacity)
+        return 0;
+
+      auto it = _index.find(key_);
+      if (it != _index.end())
+      {
+        _size -= it->second->size;
+        _entries.erase(it->second);
+        _index.erase(it);
+      }
+
+      _entries.push_front(Entry{key_, std::move(value_), size_});
+      _index.emplace(key_, _entries.begin());
+      _size += size_;
+
+      std::uint64_t evicted = 0;
+      while (_size > _capacity)
+      {
+        Entry& last = _entries.back();
+        _size -= last.size;
+        _index.erase(last.key);
+        _entries.pop_back();
+        ++evicted;
+      }
+
+      return evicted;
+    }
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _index.clear();
+      _entries.clear();
+      _size = 0;
+    }
+
+    void addStatistics(Statistics& stats_) const
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      stats_.entries += _index.size();
+      stats_.bytes += _size;
+    }
+
+  private:
+    const std::size_t _capacity;
+    std::size_t _size = 0;
+    ListType _entries;
+    std::unordered_map<Key, ListIterator, Hash> _index;
+    mutable std::mutex _mutex;
+  };
+
+public:
+  /**
+   * @param capacity_ Maximal total size of the cached entries in bytes.
+   * @param numShards_ Number of independently locked parts of the cache.
+   */
+  LruCache(
+    std::size_t capacity_,
+    std::size_t numShards_ = 16,
+    const Sizer& sizer_ = Sizer(),
+    const Hash& hasher_ = Hash())
+    : _sizer(sizer_), _hasher(hasher_)
+  {
+    if (numShards_ == 0)
+      numShards_ = 1;
+
+    _shards.reserve(numShards_);
+    for (std::size_t i = 0; i < numShards_; ++i)
+      _shards.emplace_back(new Shard(capacity_ / numShards_));
+  }
+
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  /**
+   * Looks up the given key. On hit the value is copied to value_ and the entry
+   * becomes the most recently used one in its shard.
+   * @return True if the key was found in the cache.
+   */
+  bool find(const Key& key_, Value& value_)
+  {
+    if (getShard(key_).find(key_, value_))
+    {
+      ++_hits;
+      return true;
+    }
+
+    ++_misses;
+    return false;
+  }
+
+  /**
+   * Inserts or replaces the value belonging to the given key. Values larger
+   * than the capacity of a shard are not stored at all.
+   */
+  void insert(const Key& key_, Value value_)
+  {
+    std::size_t size = _sizer(key_, value_);
+    _evictions += getShard(key_).insert(key_, std::move(value_), size);
+  }
+
+  /**
+   * Returns the cached value for the key or computes it with the given
+   * function and stores the result. The computation runs without holding any
+   * lock, so concurrent misses on the same key may compute it multiple times.
+   */
+  template <typename Compute>
+  Value getOrCompute(const Key& key_, Compute compute_)
+  {
+    Value value;
+
+    if (find(key_, value))
+      return value;
+
+    value = compute_();
+    insert(key_, value);
+    return value;
+  }
+
+  /**
+   * Removes every entry from the cache. The counters are kept.
+   */
+  void clear()
+  {
+    for (auto& shard : _shards)
+      shard->clear();
+  }
+
+  Statistics statistics() const
+  {
+    Statistics stats;
+    stats.hits = _hits;
+    stats.misses = _misses;
+    stats.evictions = _evictions;
+
+    for (const auto& shard : _shards)
+      shard->addStatistics(stats);
+
+    return stats;
+  }
+
+private:
+  Shard& getShard(const Key& key_)
+  {
+    return *_shards[_hasher(key_) % _shards.size()];
+  }
+
+  std::vector<std::unique_ptr<Shard>> _shards;
+  Sizer _sizer;
+  Hash _hasher;
+
+  std::atomic<std::uint64_t> _hits{0};
+  std::atomic<std::uint64_t> _misses{0};
+  std::atomic<std::uint64_t> _evictions{0};
+};
+
+} // util
+} // cc
+
+#endif /* CC_UTIL_LRUCACHE_H */
@@ -0,0 +1,137 @@
+#ifndef CC_UTIL_METRICS_H
+#define CC_UTIL_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * Latency histogram with logarithmic buckets, each octave split into linear
+ * sub-buckets (like HDR histograms). The values are recorded in microseconds
+ * with a relative error of at most 1/SUB_BUCKETS.
+ *
+ * A histogram is written by a single thread only, so recording is a plain
+ * load and store of a relaxed atomic. Other threads may read it at any time.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr std::size_t SUB_BUCKETS = 8;
+  static constexpr std::size_t MAX_SHIFT = 32;
+  static constexpr std::size_t BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+  void record(std::chrono::nanoseconds value_);
+
+  /**
+   * Adds the buckets of this histogram to the given counts.
+   */
+  void collect(std::vector<std::uint64_t>& counts_, double& sum_) const;
+
+  /**
+   * Returns the given quantile (0 < q_ <= 1) of the values, in seconds.
+   */
+  static double quantile(const std::vector<std::uint64_t>& counts_, double q_);
+
+private:
+  static std::size_t bucketOf(std::uint64_t micros_);
+
+  /**
+   * Returns the middle of the bucket in microseconds.
+   */
+  static double bucketValue(std::size_t bucket_);
+
+  std::atomic<std::uint64_t> _buckets[BUCKETS] = {};
+  std::atomic<std::uint64_t> _sumMicros{0};
+};
+
+/**
+ * Counters and latency histograms of the service requests per service method.
+ *
+ * Each thread records into its own shard of counters, so the request threads
+ * never contend for a lock or a cache line. Only the first request of a method
+ * on a thread registers a new shard under a mutex. The shards are summed up
+ * when the metrics are exported.
+ */
+class RequestMetrics
+{
+public:
+  struct Sample
+  {
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds database{0};
+    std::chrono::nanoseconds serialization{0};
+    bool error = false;
+  };
+
+  /**
+   * Returns the process-wide metrics.
+   */
+  static RequestMetrics& instance();
+
+  /**
+   * Records a served request.
+   * @param name_ Name of the method qualified by the service name, e.g.
+   * "CppService.getFileInfo".
+   */
+  void record(const std::string& name_, const Sample& sample_);
+
+  /**
+   * Returns the metrics in the Prometheus text exposition format.
+   */
+  std::string toPrometheus() const;
+
+private:
+  struct Shard
+  {
+    std::atomic<std::uint64_t> requests{0};
+    std::atomic<std::uint64_t> errors{0};
+    LatencyHistogram total;
+    LatencyHistogram database;
+    LatencyHistogram serialization;
+  };
+
+  RequestMetrics() = default;
+
+  Shard& threadShard(const std::string& name_);
+
+  mutable std::mutex _mutex;
+  std::unordered_map<std::string, std::vector<std::unique_ptr<Shard>>> _shards;
+};
+
+/**
+ * Returns the total time the current thread has spent in database
+ * transactions (see OdbTransaction). The difference of two calls gives the
+ * database time of a request.
+ */
+std::chrono::nanoseconds threadDatabaseTime();
+
+/**
+ * Measures the time of a database transaction of the current thread. Nested
+ * transactions are not measured again.
+ */
+class DatabaseTimer
+{
+public:
+  DatabaseTimer(bool active_);
+  ~DatabaseTimer();
+
+private:
+  bool _active;
+  std::chrono::steady_clock::time_point _start;
+};
+
+} // util
+} // cc
+
+#endif /* CC_UTIL_METRICS_H */
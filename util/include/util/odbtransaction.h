@@ -11,6 +11,7 @@
 #include <odb/session.hxx>
 
 #include "logutil.h"
+#include "metrics.h"
 
 namespace cc
 {
@@ -108,6 +109,8 @@ public:
     internal::TransRestore trRestore;
 
     bool alreadyInTransaction = transaction::has_current();
+    DatabaseTimer timer(!alreadyInTransaction);
+
 #ifdef DATABASE_SQLITE
     // We have to disable transaction switching for SQLite (otherwise we could
     // get a deadlock).
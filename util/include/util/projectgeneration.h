@@ -0,0 +1,63 @@
+#ifndef CC_UTIL_PROJECTGENERATION_H
+#define CC_UTIL_PROJECTGENERATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * This function reads the generation counter of a parsed project from the
+ * project_info.json file of the project directory. The parser increments this
+ * counter on every (incremental or full) parsing session, so the services can
+ * detect that the database content has changed.
+ * @param projectDir_ Project directory in the workspace.
+ * @return The generation of the project or 0 if it is not available.
+ */
+std::uint64_t readProjectGeneration(const std::string& projectDir_);
+
+/**
+ * Caches the generation counter of a project. The project info file is
+ * re-examined at most once per the given interval, and it is parsed again
+ * only if its modification time has changed. The modification time is
+ * compared in nanoseconds, so a parse finishing within the same second as
+ * the previous one is noticed too.
+ */
+class ProjectGeneration
+{
+public:
+  ProjectGeneration(
+    std::string projectDir_,
+    std::chrono::milliseconds recheckInterval_ = std::chrono::seconds(1));
+
+  /**
+   * Returns the current generation of the project.
+   */
+  std::uint64_t current();
+
+private:
+  const std::string _projectDir;
+  const std::chrono::milliseconds _recheckInterval;
+
+  std::atomic<std::uint64_t> _generation;
+  std::atomic<std::chrono::steady_clock::rep> _nextCheck;
+
+  /**
+   * Modification time of the project info file in nanoseconds since the
+   * epoch when it was last read.
+   */
+  std::int64_t _lastWriteTime;
+
+  std::mutex _mutex;
+};
+
+} // util
+} // cc
+
+#endif /* CC_UTIL_PROJECTGENERATION_H */
@@ -0,0 +1,35 @@
+#ifndef CC_UTIL_REGEXLITERALS_H
+#define CC_UTIL_REGEXLITERALS_H
+
+#include <string>
+#include <vector>
+
+namespace cc
+{
+namespace util
+{
+
+/**
+ * This function returns literal substrings which every text matched by the
+ * given regular expression (boost::regex Perl syntax) contains. The literals
+ * can be used to reject most of the candidates cheaply before the regular
+ * expression is run on them.
+ *
+ * The analysis is conservative: alternations and groups are not analysed, so
+ * the result may be empty even if the expression requires some literals, but
+ * every returned literal is really required. Escaped letters and digits,
+ * together with their operands like the code in \x{...}, break the literals.
+ * Unknown escapes, like \Q...\E quoting, make the result empty.
+ *
+ * @param regex_ The regular expression.
+ * @param icase_ True if the expression is matched case-insensitively. In this
+ * case the literals are lower case and contain ASCII characters only.
+ */
+std::vector<std::string> requiredLiterals(
+  const std::string& regex_,
+  bool icase_ = false);
+
+} // util
+} // cc
+
+#endif // CC_UTIL_REGEXLITERALS_H
@@ -0,0 +1,124 @@
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include <zlib.h>
+
+#include <util/compression.h>
+
+namespace cc
+{
+namespace util
+{
+
+ContentEncoding negotiateEncoding(const char* acceptEncoding_)
+{
+  if (!acceptEncoding_)
+    return ContentEncoding::IDENTITY;
+
+  std::vector<std::string> codings;
+  boost::split(codings, acceptEncoding_, boost::is_any_of(","));
+
+  // Negative quality means that the coding is not listed.
+  double gzipQuality = -1;
+  double deflateQuality = -1;
+  double anyQuality = -1;
+
+  for (std::string& coding : codings)
+  {
+    double quality = 1;
+
+    std::size_t semicolon = coding.find(';');
+    if (semicolon != std::string::npos)
+    {
+      std::size_t q = coding.find("q=", semicolon);
+      if (q != std::string::npos)
+        quality = std::atof(coding.c_str() + q + 2);
+
+      coding.erase(semicolon);
+    }
+
+    boost::trim(coding);
+    boost::to_lower(coding);
+
+    if (coding == "gzip" || coding == "x-gzip")
+      gzipQuality = quality;
+    else if (coding == "deflate")
+      deflateQuality = quality;
+    else if (coding == "*")
+      anyQuality = quality;
+  }
+
+  // The wildcard applies to the codings which are not listed explicitly.
+  if (gzipQuality < 0)
+    gzipQuality = anyQuality;
+  if (deflateQuality < 0)
+    deflateQuality = anyQuality;
+
+  if (gzipQuality > 0 && gzipQuality >= deflateQuality)
+    return ContentEncoding::GZIP;
+
+  if (deflateQuality > 0)
+    return ContentEncoding::DEFLATE;
+
+  return ContentEncoding::IDENTITY;
+}
+
+const char* encodingName(ContentEncoding encoding_)
+{
+  switch (encoding_)
+  {
+    case ContentEncoding::GZIP:
+      return "gzip";
+    case ContentEncoding::DEFLATE:
+      return "deflate";
+    case ContentEncoding::IDENTITY:
+      break;
+  }
+
+  return "identity";
+}
+
+bool compress(
+  const char* data_,
+  std::size_t size_,
+  ContentEncoding encoding_,
+  std::string& result_)
+{
+  if (encoding_ == ContentEncoding::IDENTITY ||
+      size_ > std::numeric_limits<uInt>::max())
+    return false;
+
+  // Adding 16 to the window bits makes zlib write a gzip header instead of a
+  // zlib one. HTTP "deflate" means the zlib format.
+  const int windowBits = encoding_ == ContentEncoding::GZIP ? 15 + 16 : 15;
+
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8,
+        Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  result_.resize(deflateBound(&stream, size_));
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data_));
+  stream.avail_in = static_cast<uInt>(size_);
+  stream.next_out = reinterpret_cast<Bytef*>(&result_[0]);
+  stream.avail_out = static_cast<uInt>(result_.size());
+
+  int status = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+
+  if (status != Z_STREAM_END)
+    return false;
+
+  result_.resize(stream.total_out);
+  return true;
+}
+
+} // util
+} // cc
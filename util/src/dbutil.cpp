@@ -1,5 +1,13 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <iterator>
 #include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
@@ -13,13 +21,18 @@
 #endif
 
 #ifdef DATABASE_PGSQL
+#  include <odb/pgsql/connection.hxx>
+#  include <odb/pgsql/connection-factory.hxx>
 #  include <odb/pgsql/database.hxx>
 #endif
 
 #include <odb/connection.hxx>
+#include <odb/details/shared-ptr.hxx>
+#include <odb/version.hxx>
 
 #include <util/logutil.h>
 #include <util/dbutil.h>
+#include <util/regexliterals.h>
 
 namespace
 {
@@ -105,6 +118,44 @@ void deleteCStyleOptions(char** options)
 }
 
 #ifdef DATABASE_SQLITE
+/**
+ * Compiled pattern of the REGEXP function. SQLite keeps it for the statement
+ * as auxiliary data of the pattern argument, so it is compiled only once and
+ * not for every row.
+ */
+struct SqliteRegex
+{
+  boost::regex regex;
+
+  /**
+   * Lower case literals which every matched text contains.
+   */
+  std::vector<std::string> literals;
+};
+
+/**
+ * Checks whether the text contains the literals required by the pattern. This
+ * is much cheaper than running the regex, and rejects most of the rows.
+ */
+bool containsLiterals(const SqliteRegex& regex_, const char* text_)
+{
+  if (regex_.literals.empty())
+    return true;
+
+  thread_local std::string lowerText;
+
+  lowerText.assign(text_);
+  for (char& c : lowerText)
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+
+  for (const std::string& literal : regex_.literals)
+    if (lowerText.find(literal) == std::string::npos)
+      return false;
+
+  return true;
+}
+
 void sqliteRegexImpl(
   sqlite3_context* context_,
   int argc_,
@@ -114,20 +165,37 @@ void sqliteRegexImpl(
 
   try
   {
-    boost::regex sqliteRegex;
-    std::string sqliteRegexExp;
+    const SqliteRegex* sqliteRegex
+      = static_cast<const SqliteRegex*>(sqlite3_get_auxdata(context_, 0));
+    std::unique_ptr<SqliteRegex> compiled;
 
-    const char* exprText = reinterpret_cast<const char*>(
-      sqlite3_value_text(argv_[0]));
-    if (sqliteRegexExp.compare(exprText) != 0)
+    if (!sqliteRegex)
     {
-      sqliteRegexExp.assign(exprText);
-      sqliteRegex.assign(exprText, boost::regex::icase);
+      const char* exprText = reinterpret_cast<const char*>(
+        sqlite3_value_text(argv_[0]));
+
+      compiled.reset(new SqliteRegex);
+      compiled->regex.assign(exprText ? exprText : "", boost::regex::icase);
+      compiled->literals
+        = cc::util::requiredLiterals(exprText ? exprText : "", true);
+      sqliteRegex = compiled.get();
     }
 
     const char* text = reinterpret_cast<const char*>(
       sqlite3_value_text(argv_[1]));
-    sqlite3_result_int(context_, boost::regex_search(text, sqliteRegex));
+
+    sqlite3_result_int(context_,
+      text &&
+      containsLiterals(*sqliteRegex, text) &&
+      boost::regex_search(text, sqliteRegex->regex));
+
+    // SQLite may destroy the data right away if the pattern isn't a constant,
+    // so it's handed over only after its last use.
+    if (compiled)
+      sqlite3_set_auxdata(context_, 0, compiled.release(), [](void* regex_)
+      {
+        delete static_cast<SqliteRegex*>(regex_);
+      });
   }
   catch (const boost::regex_error& err)
   {
@@ -278,6 +346,312 @@ void runSqlFiles(
   }
 }
 
+/**
+ * Counters of the connection pool of a database.
+ */
+struct PoolStatistics
+{
+  std::atomic<std::uint64_t> acquisitions{0};
+  std::atomic<std::uint64_t> waitNanos{0};
+  std::atomic<std::uint64_t> maxWaitNanos{0};
+  std::atomic<std::uint64_t> openConnections{0};
+  std::atomic<std::uint64_t> expiredConnections{0};
+  std::size_t maxConnections = 0;
+};
+
+cc::util::DatabasePoolOptions poolOptions;
+
+std::mutex poolStatisticsMutex;
+std::map<std::string, std::shared_ptr<PoolStatistics>> poolStatistics;
+
+#ifdef DATABASE_PGSQL
+class MeasuredConnectionPool;
+
+/**
+ * Closes the expired idle connections of every pool. One thread serves all
+ * projects, it is started by the first pool with an idle timeout.
+ */
+class ConnectionReaper
+{
+public:
+  static ConnectionReaper& instance()
+  {
+    static ConnectionReaper reaper;
+    return reaper;
+  }
+
+  ~ConnectionReaper()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+
+    _wakeUp.notify_all();
+
+    if (_thread.joinable())
+      _thread.join();
+  }
+
+  void add(MeasuredConnectionPool* pool_)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pools.insert(pool_);
+
+    if (!_thread.joinable())
+      _thread = std::thread(&ConnectionReaper::run, this);
+  }
+
+  void remove(MeasuredConnectionPool* pool_)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pools.erase(pool_);
+  }
+
+private:
+  ConnectionReaper() = default;
+
+  void run();
+
+  std::mutex _mutex;
+  std::condition_variable _wakeUp;
+  std::set<MeasuredConnectionPool*> _pools;
+  bool _stop = false;
+  std::thread _thread;
+};
+
+/**
+ * Bounded ODB connection pool which closes the connections idle for longer
+ * than a timeout and measures how long the transactions wait for a
+ * connection. The connections are returned to the pool by the reference
+ * counting callback of ODB, the same way as in odb::pgsql's own pool, which
+ * has no idle timeout.
+ */
+class MeasuredConnectionPool : public odb::pgsql::connection_factory
+{
+public:
+  MeasuredConnectionPool(
+    std::shared_ptr<PoolStatistics> statistics_,
+    const cc::util::DatabasePoolOptions& options_)
+    : _statistics(std::move(statistics_)),
+      _maxConnections(options_.maxConnections),
+      _minConnections(options_.minConnections),
+      _idleTimeout(std::chrono::seconds(options_.idleTimeout))
+  {
+  }
+
+  /**
+   * The connections have to be released before the pool is destroyed, like
+   * in the pools of ODB.
+   */
+  ~MeasuredConnectionPool() override
+  {
+    if (_idleTimeout.count() > 0)
+      ConnectionReaper::instance().remove(this);
+  }
+
+  void database(odb::pgsql::database& db_) override
+  {
+#if ODB_VERSION > 20400
+    odb::pgsql::connection_factory::database(db_);
+#endif
+    _db = &db_;
+
+    if (_idleTimeout.count() > 0)
+      ConnectionReaper::instance().add(this);
+  }
+
+  odb::pgsql::connection_ptr connect() override
+  {
+    auto start = std::chrono::steady_clock::now();
+    PooledConnectionPtr connection = acquire();
+
+    std::uint64_t wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+
+    ++_statistics->acquisitions;
+    _statistics->waitNanos += wait;
+
+    std::uint64_t max = _statistics->maxWaitNanos;
+    while (wait > max &&
+      !_statistics->maxWaitNanos.compare_exchange_weak(max, wait));
+
+    return connection;
+  }
+
+  /**
+   * Closes the connections which have been idle for longer than the timeout,
+   * as long as more than the minimal number of connections are open.
+   */
+  void closeExpired(std::chrono::steady_clock::time_point now_)
+  {
+    std::vector<PooledConnectionPtr> expired;
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      // The idle connections are ordered by the time of their release.
+      auto it = _idle.begin();
+      while (it != _idle.end() &&
+        _idle.end() - it + _inUse > _minConnections &&
+        now_ - (*it)->released >= _idleTimeout)
+        ++it;
+
+      expired.assign(
+        std::make_move_iterator(_idle.begin()), std::make_move_iterator(it));
+      _idle.erase(_idle.begin(), it);
+    }
+
+    // The connections are closed outside of the lock.
+    _statistics->expiredConnections += expired.size();
+    _statistics->openConnections -= expired.size();
+  }
+
+private:
+  class PooledConnection : public odb::pgsql::connection
+  {
+  public:
+    explicit PooledConnection(MeasuredConnectionPool& pool_)
+#if ODB_VERSION > 20400
+      : odb::pgsql::connection(pool_)
+#else
+      : odb::pgsql::connection(*pool_._db)
+#endif
+    {
+      _callback.arg = this;
+      _callback.zero_counter = &PooledConnection::zeroCounter;
+      odb::details::shared_base::callback_ = &_callback;
+    }
+
+    /**
+     * The pool which handed out the connection, null while it is idle. An
+     * idle connection is deleted when its last reference is dropped.
+     */
+    MeasuredConnectionPool* pool = nullptr;
+
+    /**
+     * Time when the connection was returned to the pool.
+     */
+    std::chrono::steady_clock::time_point released;
+
+    void prepareForReuse()
+    {
+      recycle();
+    }
+
+  private:
+    static bool zeroCounter(void* arg_)
+    {
+      PooledConnection* connection = static_cast<PooledConnection*>(arg_);
+      return connection->pool ? connection->pool->release(connection) : true;
+    }
+
+    odb::details::shared_base::refcount_callback _callback;
+  };
+
+  typedef odb::details::shared_ptr<PooledConnection> PooledConnectionPtr;
+
+  PooledConnectionPtr acquire()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (_idle.empty() &&
+      _maxConnections != 0 && _inUse >= _maxConnections)
+      _released.wait(lock);
+
+    ++_inUse;
+
+    if (!_idle.empty())
+    {
+      PooledConnectionPtr connection = _idle.back();
+      _idle.pop_back();
+      connection->pool = this;
+      return connection;
+    }
+
+    // Connecting takes a while, the others don't have to wait for it.
+    lock.unlock();
+
+    try
+    {
+      PooledConnectionPtr connection(
+        new (odb::details::shared) PooledConnection(*this));
+      connection->pool = this;
+      ++_statistics->openConnections;
+      return connection;
+    }
+    catch (...)
+    {
+      lock.lock();
+      --_inUse;
+      _released.notify_one();
+      throw;
+    }
+  }
+
+  /**
+   * Puts a released connection back to the pool.
+   * @return True if the connection has to be deleted.
+   */
+  bool release(PooledConnection* connection_)
+  {
+    connection_->pool = nullptr;
+
+    bool keep;
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_inUse;
+
+      keep = !connection_->failed();
+      if (keep)
+      {
+        connection_->released = std::chrono::steady_clock::now();
+        connection_->prepareForReuse();
+        _idle.push_back(
+          PooledConnectionPtr(odb::details::inc_ref(connection_)));
+      }
+    }
+
+    if (!keep)
+      --_statistics->openConnections;
+
+    _released.notify_one();
+
+    return !keep;
+  }
+
+  std::shared_ptr<PoolStatistics> _statistics;
+  const std::size_t _maxConnections;
+  const std::size_t _minConnections;
+  const std::chrono::steady_clock::duration _idleTimeout;
+  odb::pgsql::database* _db = nullptr;
+
+  std::mutex _mutex;
+  std::condition_variable _released;
+
+  /**
+   * The idle connections, the most recently released one is the last.
+   */
+  std::vector<PooledConnectionPtr> _idle;
+  std::size_t _inUse = 0;
+};
+
+void ConnectionReaper::run()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  while (!_wakeUp.wait_for(lock, std::chrono::seconds(1),
+    [this]{ return _stop; }))
+  {
+    auto now = std::chrono::steady_clock::now();
+
+    for (MeasuredConnectionPool* pool : _pools)
+      pool->closeExpired(now);
+  }
+}
+#endif
+
 }
 
 namespace cc
@@ -290,6 +664,66 @@ namespace util
  */
 static std::map<std::string, std::shared_ptr<odb::database>> databasePool;
 
+void configureDatabasePool(const DatabasePoolOptions& options_)
+{
+  poolOptions = options_;
+}
+
+std::string databasePoolMetrics()
+{
+  std::ostringstream acquisitions, wait, maxWait, maxConnections, open,
+    expired;
+
+  {
+    std::lock_guard<std::mutex> lock(poolStatisticsMutex);
+
+    for (const auto& entry : poolStatistics)
+    {
+      std::string labels = "{database=\"" + entry.first + "\"} ";
+      const PoolStatistics& stats = *entry.second;
+
+      acquisitions << "codecompass_db_connection_acquisitions_total"
+        << labels << stats.acquisitions.load() << '\n';
+      wait << "codecompass_db_connection_wait_seconds_total"
+        << labels << stats.waitNanos.load() / 1e9 << '\n';
+      maxWait << "codecompass_db_connection_wait_seconds_max"
+        << labels << stats.maxWaitNanos.load() / 1e9 << '\n';
+      maxConnections << "codecompass_db_connections_max"
+        << labels << stats.maxConnections << '\n';
+      open << "codecompass_db_connections_open"
+        << labels << stats.openConnections.load() << '\n';
+      expired << "codecompass_db_connections_expired_total"
+        << labels << stats.expiredConnections.load() << '\n';
+    }
+  }
+
+  return
+    "# HELP codecompass_db_connection_acquisitions_total Number of database "
+    "connections acquired by transactions.\n"
+    "# TYPE codecompass_db_connection_acquisitions_total counter\n"
+    + acquisitions.str() +
+    "# HELP codecompass_db_connection_wait_seconds_total Time spent waiting "
+    "for a database connection.\n"
+    "# TYPE codecompass_db_connection_wait_seconds_total counter\n"
+    + wait.str() +
+    "# HELP codecompass_db_connection_wait_seconds_max Longest wait for a "
+    "database connection.\n"
+    "# TYPE codecompass_db_connection_wait_seconds_max gauge\n"
+    + maxWait.str() +
+    "# HELP codecompass_db_connections_max Size limit of the connection pool, "
+    "zero if unlimited.\n"
+    "# TYPE codecompass_db_connections_max gauge\n"
+    + maxConnections.str() +
+    "# HELP codecompass_db_connections_open Number of open database "
+    "connections, idle or in use.\n"
+    "# TYPE codecompass_db_connections_open gauge\n"
+    + open.str() +
+    "# HELP codecompass_db_connections_expired_total Number of database "
+    "connections closed after being idle for the timeout.\n"
+    "# TYPE codecompass_db_connections_expired_total counter\n"
+    + expired.str();
+}
+
 std::shared_ptr<odb::database> connectDatabase(
   const std::string& connStr_,
   bool create_)
@@ -365,8 +799,18 @@ std::shared_ptr<odb::database> connectDatabase(
 
     if (checkPsqlDatbase(defaultPsqlConnStr, dbName, create_))
     {
-      db.reset(new odb::pgsql::database(optionsSize, cStyleOptions),
-               [](odb::database*) {});
+      std::shared_ptr<PoolStatistics> statistics
+        = std::make_shared<PoolStatistics>();
+      statistics->maxConnections = poolOptions.maxConnections;
+
+      {
+        std::lock_guard<std::mutex> lock(poolStatisticsMutex);
+        poolStatistics[dbName] = statistics;
+      }
+
+      db.reset(new odb::pgsql::database(optionsSize, cStyleOptions, false, "",
+          std::make_unique<MeasuredConnectionPool>(statistics, poolOptions)),
+        [](odb::database*) {});
     }
     else
     {
@@ -0,0 +1,289 @@
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+
+#include <util/diagramcache.h>
+#include <util/graphlayout.h>
+#include <util/hash.h>
+#include <util/logutil.h>
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+/**
+ * Returns the ratio of hits in percent.
+ */
+double hitRate(std::uint64_t hits_, std::uint64_t misses_)
+{
+  return hits_ + misses_ == 0 ? 0.0 : 100.0 * hits_ / (hits_ + misses_);
+}
+
+}
+
+namespace cc
+{
+namespace util
+{
+
+std::shared_ptr<DiagramCache> DiagramCache::forProject(
+  const std::string& projectDir_,
+  std::size_t capacity_,
+  bool useDisk_)
+{
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<DiagramCache>> caches;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  std::shared_ptr<DiagramCache> cache = caches[projectDir_].lock();
+  if (!cache)
+  {
+    cache = std::make_shared<DiagramCache>(projectDir_, capacity_, useDisk_);
+    caches[projectDir_] = cache;
+  }
+
+  return cache;
+}
+
+DiagramCache::DiagramCache(
+  const std::string& projectDir_,
+  std::size_t capacity_,
+  bool useDisk_)
+  : _projectDir(projectDir_),
+    _cacheDir(projectDir_ + "/diagramcache"),
+    _useDisk(useDisk_),
+    _generation(projectDir_),
+    _lastGeneration(_generation.current()),
+    // The DOT descriptions are much smaller than the rendered SVG images.
+    _dotCache(capacity_ / 4),
+    _svgCache(capacity_ - capacity_ / 4)
+{
+  if (_useDisk)
+  {
+    boost::system::error_code ec;
+    fs::create_directories(_cacheDir, ec);
+
+    if (ec)
+      LOG(warning)
+        << "Couldn't create diagram cache directory " << _cacheDir
+        << ": " << ec.message();
+  }
+}
+
+DiagramCache::~DiagramCache()
+{
+  logStatistics("closed");
+}
+
+std::string DiagramCache::getSvg(
+  const std::string& kind_,
+  const std::string& id_,
+  const std::function<Graph()>& build_)
+{
+  std::string dot = getDescription(kind_, id_, "dot", build_,
+    [](Graph& graph_){ return GraphLayout::instance().toDot(graph_); });
+
+  return dot.empty() ? std::string() : render(dot);
+}
+
+std::string DiagramCache::getJson(
+  const std::string& kind_,
+  const std::string& id_,
+  const std::function<Graph()>& build_)
+{
+  return getDescription(kind_, id_, "json", build_,
+    [](Graph& graph_){ return GraphLayout::instance().toJson(graph_); });
+}
+
+std::string DiagramCache::getDescription(
+  const std::string& kind_,
+  const std::string& id_,
+  const std::string& format_,
+  const std::function<Graph()>& build_,
+  const std::function<std::string(Graph&)>& convert_)
+{
+  std::string key = kind_;
+  key += '\0';
+  key += id_;
+  key += '\0';
+  key += format_;
+  key += '\0';
+  key += std::to_string(checkGeneration());
+
+  std::string description;
+  if (_dotCache.find(key, description))
+    return description;
+
+  const std::string fileName = sha1Hash(key) + '.' + format_;
+
+  if (!readFile(fileName, description))
+  {
+    Graph graph = build_();
+
+    // Empty diagrams are cached too, as an empty text.
+    if (graph.nodeCount() != 0)
+      description = convert_(graph);
+
+    writeFile(fileName, description);
+  }
+
+  _dotCache.insert(key, description);
+  return description;
+}
+
+std::string DiagramCache::render(const std::string& dot_)
+{
+  const std::string hash = sha1Hash(dot_);
+
+  std::string svg;
+  if (_svgCache.find(hash, svg))
+    return svg;
+
+  const std::string fileName = hash + ".svg";
+
+  if (!readFile(fileName, svg))
+  {
+    try
+    {
+      svg = GraphLayout::instance().dotToSvg(dot_);
+    }
+    catch (const GraphLayout::Failure& ex)
+    {
+      // The failure isn't cached, the next request may succeed.
+      LOG(warning) << "Couldn't render diagram: " << ex.what();
+      return GraphLayout::messageSvg(
+        "This diagram is too complex to be rendered in time.");
+    }
+
+    writeFile(fileName, svg);
+  }
+
+  _svgCache.insert(hash, svg);
+  return svg;
+}
+
+std::uint64_t DiagramCache::checkGeneration()
+{
+  std::uint64_t generation = _generation.current();
+  std::uint64_t last = _lastGeneration;
+
+  if (generation != last &&
+      _lastGeneration.compare_exchange_strong(last, generation))
+  {
+    logStatistics("invalidated by generation " + std::to_string(generation));
+
+    // The rendered images are content-addressed, so only the descriptions of
+    // the previous generation have to be dropped.
+    _dotCache.clear();
+    removeDescriptionFiles();
+  }
+
+  return generation;
+}
+
+bool DiagramCache::readFile(const std::string& name_, std::string& content_)
+{
+  if (!_useDisk)
+    return false;
+
+  std::ifstream file(_cacheDir + '/' + name_, std::ios::binary);
+  if (!file)
+    return false;
+
+  content_.assign(
+    std::istreambuf_iterator<char>(file),
+    std::istreambuf_iterator<char>());
+
+  ++_diskHits;
+  return true;
+}
+
+void DiagramCache::writeFile(
+  const std::string& name_,
+  const std::string& content_)
+{
+  if (!_useDisk)
+    return;
+
+  // The file is written under a temporary name and then renamed, so a
+  // concurrent reader never sees a partially written file.
+  fs::path target = fs::path(_cacheDir) / name_;
+  fs::path temp = fs::path(_cacheDir) / fs::unique_path("%%%%-%%%%-%%%%.tmp");
+
+  {
+    std::ofstream file(temp.string(), std::ios::binary);
+    file << content_;
+
+    if (!file)
+    {
+      LOG(warning) << "Couldn't write diagram cache file " << temp;
+      return;
+    }
+  }
+
+  boost::system::error_code ec;
+  fs::rename(temp, target, ec);
+
+  if (ec)
+  {
+    LOG(warning)
+      << "Couldn't write diagram cache file " << target << ": "
+      << ec.message();
+    fs::remove(temp, ec);
+    return;
+  }
+
+  ++_diskWrites;
+}
+
+void DiagramCache::removeDescriptionFiles()
+{
+  if (!_useDisk)
+    return;
+
+  boost::system::error_code ec;
+
+  for (fs::directory_iterator it(_cacheDir, ec), end; !ec && it != end;
+       it.increment(ec))
+    if (it->path().extension() == ".dot" ||
+        it->path().extension() == ".json")
+    {
+      boost::system::error_code removeEc;
+      fs::remove(it->path(), removeEc);
+    }
+}
+
+DiagramCache::Statistics DiagramCache::statistics() const
+{
+  Statistics stats;
+  stats.dot = _dotCache.statistics();
+  stats.svg = _svgCache.statistics();
+  stats.diskHits = _diskHits;
+  stats.diskWrites = _diskWrites;
+
+  return stats;
+}
+
+void DiagramCache::logStatistics(const std::string& reason_) const
+{
+  Statistics stats = statistics();
+
+  LOG(info)
+    << "Diagram cache of '" << _projectDir << "' " << reason_
+    << " (DOT hit rate: " << hitRate(stats.dot.hits, stats.dot.misses)
+    << "% of " << stats.dot.hits + stats.dot.misses
+    << ", SVG hit rate: " << hitRate(stats.svg.hits, stats.svg.misses)
+    << "% of " << stats.svg.hits + stats.svg.misses
+    << ", disk hits: " << stats.diskHits
+    << ", disk writes: " << stats.diskWrites
+    << ", entries: " << stats.dot.entries + stats.svg.entries
+    << ", bytes: " << stats.dot.bytes + stats.svg.bytes << ")";
+}
+
+} // util
+} // cc
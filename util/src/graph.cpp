@@ -1,6 +1,89 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
 #include <util/graph.h>
 #include "graphpimpl.h"
 
+namespace
+{
+
+/**
+ * Appends the string to the output as a JSON string literal.
+ */
+void appendJsonString(std::string& out_, const char* str_)
+{
+  out_ += '"';
+
+  for (const char* c = str_; *c; ++c)
+    switch (*c)
+    {
+      case '"':  out_ += "\\\""; break;
+      case '\\': out_ += "\\\\"; break;
+      case '\n': out_ += "\\n"; break;
+      case '\r': out_ += "\\r"; break;
+      case '\t': out_ += "\\t"; break;
+
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20)
+        {
+          char buffer[8];
+          std::snprintf(buffer, sizeof(buffer), "\\u%04x", *c);
+          out_ += buffer;
+        }
+        else
+          out_ += *c;
+    }
+
+  out_ += '"';
+}
+
+/**
+ * Appends the attributes of a graph object (the graph, a subgraph, a node or
+ * an edge) to the output as a JSON object. The empty attributes and the node
+ * and edge attributes having their default value are skipped. (Setting a root
+ * graph attribute also changes its default, so those can't be compared.)
+ * @param kind_ AGRAPH, AGNODE or AGEDGE.
+ */
+void appendJsonAttributes(
+  std::string& out_,
+  Agraph_t* graph_,
+  int kind_,
+  void* object_)
+{
+  out_ += '{';
+  bool first = true;
+
+  for (Agsym_t* sym = agnxtattr(graph_, kind_, nullptr);
+       sym;
+       sym = agnxtattr(graph_, kind_, sym))
+  {
+    char* value = agxget(object_, sym);
+
+    if (!value || !*value)
+      continue;
+
+    if (kind_ != AGRAPH && sym->defval && !std::strcmp(value, sym->defval))
+      continue;
+
+    if (!first)
+      out_ += ',';
+    first = false;
+
+    appendJsonString(out_, sym->name);
+    out_ += ':';
+
+    if (aghtmlstr(value))
+      appendJsonString(out_, ('<' + std::string(value) + '>').c_str());
+    else
+      appendJsonString(out_, value);
+  }
+
+  out_ += '}';
+}
+
+}
+
 namespace cc
 {
 namespace util
@@ -38,7 +121,7 @@ std::string Graph::dotToSvg(const std::string& graph_)
   char** result        = new char*;
   unsigned int* length = new unsigned int;
 
-  gvRenderData(gvc, graph, "dot", result, length);
+  gvRenderData(gvc, graph, "svg", result, length);
   gvFreeLayout(gvc, graph);
 
   std::string res = *result;
@@ -165,6 +248,56 @@ void Graph::delEdge(const Node& from_, const Node& to_)
       0));
 }
 
+std::size_t Graph::summarize(std::size_t maxNodes_, std::size_t maxEdges_)
+{
+  Agraph_t* graph = _graphPimpl->_graph;
+
+  auto fits = [&graph, maxNodes_, maxEdges_](std::size_t reserved_){
+    return static_cast<std::size_t>(agnnodes(graph)) + reserved_ <= maxNodes_
+      && static_cast<std::size_t>(agnedges(graph)) <= maxEdges_;
+  };
+
+  if (fits(0))
+    return 0;
+
+  std::vector<std::pair<int, Agnode_t*>> nodes;
+  for (Agnode_t* node = agfstnode(graph); node; node = agnxtnode(graph, node))
+    nodes.emplace_back(agdegree(graph, node, 1, 1), node);
+
+  // The nodes with the fewest connections are the least informative ones.
+  std::stable_sort(nodes.begin(), nodes.end(),
+    [](const std::pair<int, Agnode_t*>& lhs_,
+       const std::pair<int, Agnode_t*>& rhs_){
+      return lhs_.first < rhs_.first;
+    });
+
+  std::size_t removed = 0;
+
+  // One place is kept for the node which notes the omitted ones.
+  for (const std::pair<int, Agnode_t*>& node : nodes)
+  {
+    if (fits(1))
+      break;
+
+    for (Agedge_t* edge = agfstedge(graph, node.second);
+         edge;
+         edge = agnxtedge(graph, edge, node.second))
+      if (const char* name = agnameof(edge))
+        _graphPimpl->_edgeMap.erase(name);
+
+    _ids.erase(agnameof(node.second));
+    agdelnode(graph, node.second);
+    ++removed;
+  }
+
+  Node note = createNode();
+  setNodeAttribute(note, "shape", "note");
+  setNodeAttribute(note, "label", std::to_string(removed)
+    + " less connected nodes are omitted from this diagram");
+
+  return removed;
+}
+
 void Graph::setAttribute(const std::string& key_, const std::string& value_)
 {
   agsafeset(
@@ -276,16 +409,21 @@ std::string Graph::output(Graph::Format format_) const
   char** result        = new char*;
   unsigned int* length = new unsigned int;
 
-  gvLayout(_graphPimpl->_gvc, _graphPimpl->_graph, "dot");
+  // The canonical DOT output doesn't need layout information.
+  const bool layout = format_ != Graph::CANON;
+
+  if (layout)
+    gvLayout(_graphPimpl->_gvc, _graphPimpl->_graph, "dot");
 
   gvRenderData(
     _graphPimpl->_gvc,
     _graphPimpl->_graph,
-    format_ == Graph::DOT ? "dot" : "svg",
+    format_ == Graph::DOT ? "dot" : format_ == Graph::SVG ? "svg" : "canon",
     result,
     length);
 
-  gvFreeLayout(_graphPimpl->_gvc, _graphPimpl->_graph);
+  if (layout)
+    gvFreeLayout(_graphPimpl->_gvc, _graphPimpl->_graph);
 
   std::string res = *result;
 
@@ -295,6 +433,80 @@ std::string Graph::output(Graph::Format format_) const
   return res;
 }
 
+std::string Graph::toJson() const
+{
+  Agraph_t* graph = _graphPimpl->_graph;
+  std::string json;
+
+  json += "{\"directed\":";
+  json += _directed ? "true" : "false";
+
+  json += ",\"attributes\":";
+  appendJsonAttributes(json, graph, AGRAPH, graph);
+
+  json += ",\"subgraphs\":[";
+  for (Agraph_t* subg = agfstsubg(graph); subg; subg = agnxtsubg(subg))
+  {
+    if (subg != agfstsubg(graph))
+      json += ',';
+
+    json += "{\"id\":";
+    appendJsonString(json, agnameof(subg));
+    json += ",\"attributes\":";
+    appendJsonAttributes(json, graph, AGRAPH, subg);
+
+    json += ",\"nodes\":[";
+    for (Agnode_t* node = agfstnode(subg); node; node = agnxtnode(subg, node))
+    {
+      if (node != agfstnode(subg))
+        json += ',';
+      appendJsonString(json, agnameof(node));
+    }
+    json += "]}";
+  }
+
+  json += "],\"nodes\":[";
+  for (Agnode_t* node = agfstnode(graph); node; node = agnxtnode(graph, node))
+  {
+    if (node != agfstnode(graph))
+      json += ',';
+
+    json += "{\"id\":";
+    appendJsonString(json, agnameof(node));
+    json += ",\"attributes\":";
+    appendJsonAttributes(json, graph, AGNODE, node);
+    json += '}';
+  }
+
+  json += "],\"edges\":[";
+  bool first = true;
+  for (Agnode_t* node = agfstnode(graph); node; node = agnxtnode(graph, node))
+    for (Agedge_t* edge = agfstout(graph, node);
+         edge;
+         edge = agnxtout(graph, edge))
+    {
+      if (!first)
+        json += ',';
+      first = false;
+
+      const char* name = agnameof(edge);
+
+      json += "{\"id\":";
+      appendJsonString(json, name ? name : "");
+      json += ",\"from\":";
+      appendJsonString(json, agnameof(agtail(edge)));
+      json += ",\"to\":";
+      appendJsonString(json, agnameof(aghead(edge)));
+      json += ",\"attributes\":";
+      appendJsonAttributes(json, graph, AGEDGE, edge);
+      json += '}';
+    }
+
+  json += "]}";
+
+  return json;
+}
+
 std::vector<Graph::Node> Graph::getChildren(const Node& node) const
 {
   std::vector<Graph::Node> result;
@@ -0,0 +1,302 @@
+#include <cerrno>
+#include <csignal>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <util/graphlayout.h>
+#include <util/logutil.h>
+#include <util/pipedprocess.h>
+#include <util/util.h>
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Worker process which lays out a single graph. The worker executable reads
+ * the DOT text on its standard input and writes the SVG to its standard
+ * output. The child process executes it right after the fork: the server is
+ * multithreaded, so the child must not touch locks (e.g. of the allocator or
+ * the logger) which another thread may have held at the time of the fork.
+ */
+class LayoutProcess : public cc::util::PipedProcess
+{
+public:
+  LayoutProcess(const std::string& worker_, const std::string& dot_)
+    : _worker(worker_), _dot(dot_)
+  {
+    // Everything the child needs is prepared before the fork.
+    const char* argv[] = { _worker.c_str(), nullptr };
+
+    openPipe(_inputFd[0], _inputFd[1]);
+
+    int pid;
+
+    try
+    {
+      pid = startProcess();
+    }
+    catch (...)
+    {
+      closePipe(_inputFd[0], _inputFd[1]);
+      throw;
+    }
+
+    if (pid == 0)
+    {
+      ::dup2(_inputFd[0], STDIN_FILENO);
+      ::dup2(_pipeFd[1], STDOUT_FILENO);
+
+      ::close(_inputFd[0]);
+      ::close(_inputFd[1]);
+      ::close(_pipeFd[0]);
+      ::close(_pipeFd[1]);
+
+      ::execvp(argv[0], const_cast<char* const*>(argv));
+      ::_exit(EXEC_FAILED);
+    }
+
+    ::close(_inputFd[0]);
+    _inputFd[0] = 0;
+    ::close(_pipeFd[1]);
+    _pipeFd[1] = 0;
+
+    // The output is read while the input is written, so neither of the pipes
+    // can fill up and block both processes.
+    ::fcntl(_inputFd[1], F_SETFL, ::fcntl(_inputFd[1], F_GETFL) | O_NONBLOCK);
+  }
+
+  ~LayoutProcess()
+  {
+    closePipe(_inputFd[0], _inputFd[1]);
+  }
+
+  /**
+   * Writes the graph to the worker and reads the rendered output. If the
+   * worker doesn't finish until the deadline then it is killed.
+   * @throw cc::util::GraphLayout::Failure on timeout or if the worker failed.
+   */
+  std::string read(Clock::time_point deadline_)
+  {
+    std::string result;
+    char buffer[8192];
+    std::size_t written = 0;
+
+    if (_dot.empty())
+      closePipe(_inputFd[0], _inputFd[1]);
+
+    while (true)
+    {
+      Clock::time_point now = Clock::now();
+
+      if (now >= deadline_)
+      {
+        kill();
+        throw cc::util::GraphLayout::Failure("Graph layout timed out.");
+      }
+
+      pollfd pfds[2] = {
+        {_pipeFd[0], POLLIN, 0},
+        {_inputFd[1] != 0 ? _inputFd[1] : -1, POLLOUT, 0}};
+
+      int ready = ::poll(pfds, 2, static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline_ - now).count()) + 1);
+
+      if (ready == 0 || (ready < 0 && errno == EINTR))
+        continue;
+
+      if (ready < 0)
+      {
+        kill();
+        throw cc::util::GraphLayout::Failure("Reading graph layout failed.");
+      }
+
+      if (pfds[1].revents != 0)
+      {
+        ssize_t size = ::write(
+          _inputFd[1], _dot.data() + written, _dot.size() - written);
+
+        if (size > 0)
+          written += size;
+
+        // On an error (e.g. the worker exited early) the input is dropped and
+        // the exit status of the worker tells the result.
+        if (written == _dot.size() || (size < 0 && errno != EAGAIN &&
+            errno != EWOULDBLOCK && errno != EINTR))
+          closePipe(_inputFd[0], _inputFd[1]);
+      }
+
+      if (pfds[0].revents == 0)
+        continue;
+
+      ssize_t size = ::read(_pipeFd[0], buffer, sizeof(buffer));
+
+      if (size < 0)
+      {
+        if (errno == EINTR)
+          continue;
+
+        kill();
+        throw cc::util::GraphLayout::Failure("Reading graph layout failed.");
+      }
+
+      if (size == 0)
+        break;
+
+      result.append(buffer, size);
+    }
+
+    closePipe(_inputFd[0], _inputFd[1]);
+    refreshExitStatus(true);
+
+    if (WIFEXITED(_childExitStatus) &&
+        WEXITSTATUS(_childExitStatus) == EXEC_FAILED)
+      throw cc::util::GraphLayout::Failure(
+        "Graph layout worker " + _worker + " couldn't be started.");
+
+    if (!WIFEXITED(_childExitStatus) || WEXITSTATUS(_childExitStatus) != 0)
+      throw cc::util::GraphLayout::Failure("Graph layout worker failed.");
+
+    return result;
+  }
+
+private:
+  /**
+   * Exit code of the child process if the worker couldn't be executed.
+   */
+  static constexpr int EXEC_FAILED = 127;
+
+private:
+  void kill()
+  {
+    // The destructor of PipedProcess reaps the killed process.
+    if (_childPid > 0)
+      ::kill(_childPid, SIGKILL);
+  }
+
+  const std::string _worker;
+  const std::string& _dot;
+  int _inputFd[2] = {0, 0};
+};
+
+}
+
+namespace cc
+{
+namespace util
+{
+
+GraphLayout::Failure::Failure(const std::string& msg_) :
+  std::runtime_error(msg_) {}
+
+GraphLayout& GraphLayout::instance()
+{
+  static GraphLayout layout;
+  return layout;
+}
+
+void GraphLayout::configure(const Options& options_)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _options = options_;
+
+  LOG(debug) << "Graph layout worker: " << _options.worker;
+
+  if (_options.workers == 0)
+    _options.workers = 1;
+
+  _freeWorker.notify_all();
+}
+
+GraphLayout::Options GraphLayout::options() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _options;
+}
+
+std::string GraphLayout::toDot(Graph& graph_) const
+{
+  summarize(graph_);
+  return graph_.output(Graph::CANON);
+}
+
+std::string GraphLayout::toJson(Graph& graph_) const
+{
+  // The client-side layout engines don't cope with huge graphs either.
+  summarize(graph_);
+  return graph_.toJson();
+}
+
+void GraphLayout::summarize(Graph& graph_) const
+{
+  Options options = this->options();
+
+  std::size_t removed = graph_.summarize(options.maxNodes, options.maxEdges);
+  if (removed != 0)
+    LOG(debug) << removed << " nodes are omitted from a too large graph.";
+}
+
+std::string GraphLayout::dotToSvg(const std::string& dot_)
+{
+  Clock::time_point deadline = Clock::now() + options().timeout;
+
+  if (!acquireWorker(deadline))
+    throw Failure("No graph layout worker became free in time.");
+
+  try
+  {
+    LayoutProcess process(options().worker, dot_);
+    std::string svg = process.read(deadline);
+
+    releaseWorker();
+    return svg;
+  }
+  catch (const PipedProcess::Failure& ex)
+  {
+    releaseWorker();
+    throw Failure(ex.what());
+  }
+  catch (...)
+  {
+    releaseWorker();
+    throw;
+  }
+}
+
+std::string GraphLayout::messageSvg(const std::string& message_)
+{
+  return
+    "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"600\" height=\"40\">"
+    "<text x=\"10\" y=\"25\" font-family=\"sans-serif\" font-size=\"14\">"
+    + escapeHtml(message_) + "</text></svg>";
+}
+
+bool GraphLayout::acquireWorker(Clock::time_point deadline_)
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  if (!_freeWorker.wait_until(lock, deadline_,
+    [this]{ return _busyWorkers < _options.workers; }))
+    return false;
+
+  ++_busyWorkers;
+  return true;
+}
+
+void GraphLayout::releaseWorker()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_busyWorkers;
+  }
+
+  _freeWorker.notify_one();
+}
+
+} // util
+} // cc
@@ -0,0 +1,25 @@
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include <util/graph.h>
+
+/**
+ * Worker process of cc::util::GraphLayout. It reads a graph in DOT format on
+ * the standard input, lays it out and writes the rendered SVG to the standard
+ * output.
+ */
+int main()
+{
+  std::string dot(
+    (std::istreambuf_iterator<char>(std::cin)),
+    std::istreambuf_iterator<char>());
+
+  if (dot.empty())
+    return 1;
+
+  std::cout << cc::util::Graph::dotToSvg(dot);
+  std::cout.flush();
+
+  return std::cout ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <util/metrics.h>
+
+namespace
+{
+
+/**
+ * Total time of the database transactions of the current thread in
+ * nanoseconds.
+ */
+thread_local std::int64_t databaseTime = 0;
+
+/**
+ * Increments a counter which is written by the current thread only. This is
+ * cheaper than an atomic read-modify-write.
+ */
+void add(std::atomic<std::uint64_t>& counter_, std::uint64_t value_)
+{
+  counter_.store(
+    counter_.load(std::memory_order_relaxed) + value_,
+    std::memory_order_relaxed);
+}
+
+std::string escapeLabel(const std::string& value_)
+{
+  std::string result;
+
+  for (char c : value_)
+    switch (c)
+    {
+      case '\\': result += "\\\\"; break;
+      case '"': result += "\\\""; break;
+      case '\n': result += "\\n"; break;
+      default: result += c;
+    }
+
+  return result;
+}
+
+}
+
+namespace cc
+{
+namespace util
+{
+
+constexpr std::size_t LatencyHistogram::SUB_BUCKETS;
+constexpr std::size_t LatencyHistogram::MAX_SHIFT;
+constexpr std::size_t LatencyHistogram::BUCKETS;
+
+void LatencyHistogram::record(std::chrono::nanoseconds value_)
+{
+  std::uint64_t micros = value_.count() > 0
+    ? static_cast<std::uint64_t>(value_.count()) / 1000
+    : 0;
+
+  add(_buckets[bucketOf(micros)], 1);
+  add(_sumMicros, micros);
+}
+
+void LatencyHistogram::collect(
+  std::vector<std::uint64_t>& counts_,
+  double& sum_) const
+{
+  counts_.resize(BUCKETS);
+
+  for (std::size_t i = 0; i < BUCKETS; ++i)
+    counts_[i] += _buckets[i].load(std::memory_order_relaxed);
+
+  sum_ += _sumMicros.load(std::memory_order_relaxed) / 1e6;
+}
+
+double LatencyHistogram::quantile(
+  const std::vector<std::uint64_t>& counts_,
+  double q_)
+{
+  std::uint64_t total = 0;
+  for (std::uint64_t count : counts_)
+    total += count;
+
+  if (total == 0)
+    return 0.0;
+
+  std::uint64_t rank = std::max<std::uint64_t>(
+    1, static_cast<std::uint64_t>(std::ceil(q_ * total)));
+
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < counts_.size(); ++i)
+  {
+    seen += counts_[i];
+    if (seen >= rank)
+      return bucketValue(i) / 1e6;
+  }
+
+  return bucketValue(counts_.size() - 1) / 1e6;
+}
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t micros_)
+{
+  if (micros_ < SUB_BUCKETS)
+    return micros_;
+
+  // The highest set bit selects the octave, the next bits the sub-bucket.
+  std::size_t msb = 63 - __builtin_clzll(micros_);
+  std::size_t shift = msb - 3;
+
+  if (shift > MAX_SHIFT)
+    return BUCKETS - 1;
+
+  return (shift + 1) * SUB_BUCKETS + ((micros_ >> shift) & (SUB_BUCKETS - 1));
+}
+
+double LatencyHistogram::bucketValue(std::size_t bucket_)
+{
+  if (bucket_ < SUB_BUCKETS)
+    return bucket_;
+
+  std::size_t shift = bucket_ / SUB_BUCKETS - 1;
+  double lower = static_cast<double>(
+    (SUB_BUCKETS + bucket_ % SUB_BUCKETS) << shift);
+
+  return lower + static_cast<double>(std::uint64_t(1) << shift) / 2;
+}
+
+RequestMetrics& RequestMetrics::instance()
+{
+  static RequestMetrics metrics;
+  return metrics;
+}
+
+void RequestMetrics::record(const std::string& name_, const Sample& sample_)
+{
+  Shard& shard = threadShard(name_);
+
+  add(shard.requests, 1);
+  if (sample_.error)
+    add(shard.errors, 1);
+
+  shard.total.record(sample_.total);
+  shard.database.record(sample_.database);
+  shard.serialization.record(sample_.serialization);
+}
+
+RequestMetrics::Shard& RequestMetrics::threadShard(const std::string& name_)
+{
+  thread_local std::unordered_map<std::string, Shard*> shards;
+
+  Shard*& shard = shards[name_];
+
+  if (!shard)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<std::unique_ptr<Shard>>& methodShards = _shards[name_];
+    methodShards.emplace_back(new Shard);
+    shard = methodShards.back().get();
+  }
+
+  return *shard;
+}
+
+std::string RequestMetrics::toPrometheus() const
+{
+  struct Method
+  {
+    std::string labels;
+    std::uint64_t requests = 0;
+    std::uint64_t errors = 0;
+    std::vector<std::uint64_t> total, database, serialization;
+    double totalSum = 0, databaseSum = 0, serializationSum = 0;
+  };
+
+  std::vector<Method> methods;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (const auto& entry : _shards)
+    {
+      std::string::size_type dot = entry.first.find('.');
+      std::string service = entry.first.substr(0, dot);
+      std::string method = dot == std::string::npos
+        ? std::string() : entry.first.substr(dot + 1);
+
+      Method m;
+      m.labels = "service=\"" + escapeLabel(service)
+        + "\",method=\"" + escapeLabel(method) + '"';
+
+      for (const std::unique_ptr<Shard>& shard : entry.second)
+      {
+        m.requests += shard->requests.load(std::memory_order_relaxed);
+        m.errors += shard->errors.load(std::memory_order_relaxed);
+        shard->total.collect(m.total, m.totalSum);
+        shard->database.collect(m.database, m.databaseSum);
+        shard->serialization.collect(m.serialization, m.serializationSum);
+      }
+
+      methods.push_back(std::move(m));
+    }
+  }
+
+  std::sort(methods.begin(), methods.end(),
+    [](const Method& lhs_, const Method& rhs_)
+    {
+      return lhs_.labels < rhs_.labels;
+    });
+
+  std::ostringstream out;
+
+  out
+    << "# HELP codecompass_requests_total Number of served service requests.\n"
+    << "# TYPE codecompass_requests_total counter\n";
+  for (const Method& m : methods)
+    out << "codecompass_requests_total{" << m.labels << "} "
+        << m.requests << '\n';
+
+  out
+    << "# HELP codecompass_request_errors_total Number of service requests "
+       "failed by an unexpected exception.\n"
+    << "# TYPE codecompass_request_errors_total counter\n";
+  for (const Method& m : methods)
+    out << "codecompass_request_errors_total{" << m.labels << "} "
+        << m.errors << '\n';
+
+  auto summary = [&](
+    const char* name_,
+    const char* help_,
+    std::vector<std::uint64_t> Method::*counts_,
+    double Method::*sum_)
+  {
+    out
+      << "# HELP " << name_ << ' ' << help_ << '\n'
+      << "# TYPE " << name_ << " summary\n";
+
+    for (const Method& m : methods)
+    {
+      for (const char* q : {"0.5", "0.9", "0.99"})
+        out << name_ << '{' << m.labels << ",quantile=\"" << q << "\"} "
+            << LatencyHistogram::quantile(m.*counts_, std::stod(q)) << '\n';
+
+      out << name_ << "_sum{" << m.labels << "} " << m.*sum_ << '\n'
+          << name_ << "_count{" << m.labels << "} " << m.requests << '\n';
+    }
+  };
+
+  summary("codecompass_request_duration_seconds",
+    "Time of serving the service requests.",
+    &Method::total, &Method::totalSum);
+  summary("codecompass_request_database_seconds",
+    "Time spent in database transactions while serving the requests.",
+    &Method::database, &Method::databaseSum);
+  summary("codecompass_request_serialization_seconds",
+    "Time of reading the arguments and writing the results of the requests.",
+    &Method::serialization, &Method::serializationSum);
+
+  return out.str();
+}
+
+std::chrono::nanoseconds threadDatabaseTime()
+{
+  return std::chrono::nanoseconds(databaseTime);
+}
+
+DatabaseTimer::DatabaseTimer(bool active_) : _active(active_)
+{
+  if (_active)
+    _start = std::chrono::steady_clock::now();
+}
+
+DatabaseTimer::~DatabaseTimer()
+{
+  if (_active)
+    databaseTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - _start).count();
+}
+
+} // util
+} // cc
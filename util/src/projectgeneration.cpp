@@ -0,0 +1,80 @@
+#include <sys/stat.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <util/logutil.h>
+#include <util/projectgeneration.h>
+
+namespace pt = boost::property_tree;
+
+namespace cc
+{
+namespace util
+{
+
+std::uint64_t readProjectGeneration(const std::string& projectDir_)
+{
+  const std::string projectInfo = projectDir_ + "/project_info.json";
+
+  try
+  {
+    pt::ptree root;
+    pt::read_json(projectInfo, root);
+    return root.get<std::uint64_t>("generation", 0);
+  }
+  catch (const pt::ptree_error& ex)
+  {
+    LOG(debug) << "Couldn't read project generation from "
+      << projectInfo << ": " << ex.what();
+  }
+
+  return 0;
+}
+
+ProjectGeneration::ProjectGeneration(
+  std::string projectDir_,
+  std::chrono::milliseconds recheckInterval_)
+  : _projectDir(std::move(projectDir_)),
+    _recheckInterval(recheckInterval_),
+    _generation(0),
+    _nextCheck(0),
+    _lastWriteTime(0)
+{
+}
+
+std::uint64_t ProjectGeneration::current()
+{
+  const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+
+  if (now < _nextCheck)
+    return _generation;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if (now < _nextCheck)
+    return _generation;
+
+  struct stat st;
+
+  if (::stat((_projectDir + "/project_info.json").c_str(), &st) == 0)
+  {
+    std::int64_t writeTime
+      = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000
+      + st.st_mtim.tv_nsec;
+
+    if (writeTime != _lastWriteTime)
+    {
+      _lastWriteTime = writeTime;
+      _generation = readProjectGeneration(_projectDir);
+    }
+  }
+
+  _nextCheck = now + std::chrono::duration_cast<
+    std::chrono::steady_clock::duration>(_recheckInterval).count();
+
+  return _generation;
+}
+
+} // util
+} // cc
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <cctype>
+
+#include <util/regexliterals.h>
+
+namespace
+{
+
+/**
+ * Returns the position after the bracket expression starting at pos_.
+ */
+std::size_t skipBracket(const std::string& regex_, std::size_t pos_)
+{
+  std::size_t i = pos_ + 1;
+
+  if (i < regex_.size() && regex_[i] == '^')
+    ++i;
+
+  // A closing bracket right after the opening one is a literal.
+  if (i < regex_.size() && regex_[i] == ']')
+    ++i;
+
+  while (i < regex_.size() && regex_[i] != ']')
+  {
+    if (regex_[i] == '\\')
+      i += 2;
+    else if (regex_[i] == '[' && i + 1 < regex_.size() &&
+      (regex_[i + 1] == ':' || regex_[i + 1] == '.' || regex_[i + 1] == '='))
+    {
+      // Character classes like [:alpha:] end with the same delimiter.
+      std::size_t end = regex_.find(std::string{regex_[i + 1], ']'}, i + 2);
+      i = end == std::string::npos ? regex_.size() : end + 2;
+    }
+    else
+      ++i;
+  }
+
+  return i + 1;
+}
+
+/**
+ * Returns the position after the delimited operand of an escape, like
+ * {...} in \x{...}, if it starts at pos_. Otherwise pos_ is returned.
+ */
+std::size_t skipDelimited(
+  const std::string& regex_,
+  std::size_t pos_,
+  const char* delimiters_)
+{
+  if (pos_ >= regex_.size())
+    return pos_;
+
+  for (const char* d = delimiters_; *d; d += 2)
+    if (regex_[pos_] == d[0])
+    {
+      std::size_t end = regex_.find(d[1], pos_ + 1);
+      return end == std::string::npos ? regex_.size() : end + 1;
+    }
+
+  return pos_;
+}
+
+/**
+ * Returns the position after at most max_ characters starting at pos_ which
+ * satisfy the predicate.
+ */
+template <typename Pred>
+std::size_t skipWhile(
+  const std::string& regex_,
+  std::size_t pos_,
+  std::size_t max_,
+  Pred pred_)
+{
+  std::size_t end = max_ < regex_.size() - pos_
+    ? pos_ + max_
+    : regex_.size();
+
+  while (pos_ < end && pred_(static_cast<unsigned char>(regex_[pos_])))
+    ++pos_;
+
+  return pos_;
+}
+
+/**
+ * Returns the position after the escape sequence starting with a letter or
+ * digit at pos_, including its operand, or std::string::npos if the escape is
+ * unknown. Skipping too much only loses literals, but an operand which is
+ * taken for literal text would make the result wrong.
+ */
+std::size_t skipEscape(const std::string& regex_, std::size_t pos_)
+{
+  const char c = regex_[pos_ + 1];
+  const std::size_t i = pos_ + 2;
+
+  auto isDigit = [](unsigned char c_) { return std::isdigit(c_); };
+
+  switch (c)
+  {
+    // Character classes and assertions.
+    case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+    case 'h': case 'H': case 'v': case 'V': case 'l': case 'L':
+    case 'u': case 'U': case 'b': case 'B': case 'A': case 'z':
+    case 'Z': case 'G': case 'R': case 'X': case 'C': case 'K':
+    // Control characters, these aren't followed in the literals.
+    case 'a': case 'e': case 'f': case 'n': case 'r': case 't':
+      return i;
+
+    // \xhh or \x{h...}
+    case 'x':
+    {
+      std::size_t end = skipDelimited(regex_, i, "{}");
+      return end != i ? end : skipWhile(regex_, i, 2,
+        [](unsigned char c_) { return std::isxdigit(c_); });
+    }
+
+    // \cX
+    case 'c':
+      return std::min(regex_.size(), i + 1);
+
+    // \pL, \p{Name}, \PL, \P{Name}
+    case 'p':
+    case 'P':
+    {
+      std::size_t end = skipDelimited(regex_, i, "{}");
+      return end != i ? end : std::min(regex_.size(), i + 1);
+    }
+
+    // \N{name}
+    case 'N':
+      return skipDelimited(regex_, i, "{}");
+
+    // \g1, \g-1, \g{1}, \g{name}
+    case 'g':
+    {
+      std::size_t end = skipDelimited(regex_, i, "{}");
+      if (end != i)
+        return end;
+
+      end = i < regex_.size() && regex_[i] == '-' ? i + 1 : i;
+      return skipWhile(regex_, end, std::string::npos, isDigit);
+    }
+
+    // \k<name>, \k'name', \k{name}
+    case 'k':
+      return skipDelimited(regex_, i, "<>''{}");
+
+    // \0ooo octal codes and \1... back references.
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+      return skipWhile(regex_, i, std::string::npos, isDigit);
+
+    default:
+      return std::string::npos;
+  }
+}
+
+}
+
+namespace cc
+{
+namespace util
+{
+
+std::vector<std::string> requiredLiterals(
+  const std::string& regex_,
+  bool icase_)
+{
+  std::vector<std::string> literals;
+  std::string current;
+
+  auto flush = [&literals, &current]()
+  {
+    if (!current.empty())
+      literals.push_back(std::move(current));
+    current.clear();
+  };
+
+  std::size_t i = 0;
+
+  while (i < regex_.size())
+  {
+    char c = regex_[i];
+
+    switch (c)
+    {
+      // Any branch of an alternation may match, and groups may be optional.
+      case '|':
+      case '(':
+      case ')':
+        return {};
+
+      case '[':
+        flush();
+        i = skipBracket(regex_, i);
+        continue;
+
+      case '.':
+      case '^':
+      case '$':
+      case '*':
+      case '?':
+      case '+':
+        flush();
+        ++i;
+        continue;
+
+      case '{':
+      {
+        flush();
+        std::size_t end = regex_.find('}', i);
+        i = end == std::string::npos ? regex_.size() : end + 1;
+        continue;
+      }
+
+      case '\\':
+        if (i + 1 >= regex_.size())
+          return {};
+
+        c = regex_[i + 1];
+
+        // Escaped letters and digits are classes, assertions, references or
+        // character codes, some of them with an operand.
+        if (std::isalnum(static_cast<unsigned char>(c)) ||
+            static_cast<unsigned char>(c) >= 0x80)
+        {
+          flush();
+          i = skipEscape(regex_, i);
+
+          // Unknown escapes, like \Q...\E quoting, may hide anything.
+          if (i == std::string::npos)
+            return {};
+
+          continue;
+        }
+
+        ++i;
+        break;
+    }
+
+    // The character c at position i is a literal.
+    ++i;
+
+    char next = i < regex_.size() ? regex_[i] : '\0';
+
+    if (next == '*' || next == '?' || next == '{')
+    {
+      // The character is optional.
+      flush();
+      continue;
+    }
+
+    if (icase_ && static_cast<unsigned char>(c) >= 0x80)
+    {
+      // Case folding of non-ASCII characters is not followed.
+      flush();
+      continue;
+    }
+
+    current += icase_
+      ? static_cast<char>(std::tolower(static_cast<unsigned char>(c)))
+      : c;
+
+    // The character may be repeated, the literal can't continue.
+    if (next == '+')
+      flush();
+  }
+
+  flush();
+
+  return literals;
+}
+
+} // util
+} // cc
@@ -0,0 +1,116 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+
+#include <util/compression.h>
+
+using namespace cc::util;
+
+namespace
+{
+
+/**
+ * Decompresses data compressed by compress() in the given coding.
+ */
+std::string decompress(const std::string& data_, ContentEncoding encoding_)
+{
+  z_stream stream{};
+  inflateInit2(&stream, encoding_ == ContentEncoding::GZIP ? 15 + 16 : 15);
+
+  std::string result(1 << 16, '\0');
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data_.data()));
+  stream.avail_in = static_cast<uInt>(data_.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+  stream.avail_out = static_cast<uInt>(result.size());
+
+  int status = inflate(&stream, Z_FINISH);
+  inflateEnd(&stream);
+
+  EXPECT_EQ(Z_STREAM_END, status);
+  result.resize(stream.total_out);
+
+  return result;
+}
+
+}
+
+TEST(NegotiateEncodingTest, MissingOrEmptyHeader)
+{
+  EXPECT_EQ(ContentEncoding::IDENTITY, negotiateEncoding(nullptr));
+  EXPECT_EQ(ContentEncoding::IDENTITY, negotiateEncoding(""));
+  EXPECT_EQ(ContentEncoding::IDENTITY, negotiateEncoding("identity"));
+  EXPECT_EQ(ContentEncoding::IDENTITY, negotiateEncoding("br, zstd"));
+}
+
+TEST(NegotiateEncodingTest, PlainCodings)
+{
+  EXPECT_EQ(ContentEncoding::GZIP, negotiateEncoding("gzip"));
+  EXPECT_EQ(ContentEncoding::GZIP, negotiateEncoding("x-gzip"));
+  EXPECT_EQ(ContentEncoding::GZIP, negotiateEncoding(" GZIP "));
+  EXPECT_EQ(ContentEncoding::DEFLATE, negotiateEncoding("deflate"));
+  EXPECT_EQ(ContentEncoding::DEFLATE, negotiateEncoding("br, deflate"));
+
+  // gzip is preferred among codings of equal quality.
+  EXPECT_EQ(ContentEncoding::GZIP, negotiateEncoding("deflate, gzip"));
+  EXPECT_EQ(ContentEncoding::GZIP, negotiateEncoding("gzip, deflate, br"));
+}
+
+TEST(NegotiateEncodingTest, QualityValues)
+{
+  EXPECT_EQ(ContentEncoding::DEFLATE,
+    negotiateEncoding("gzip;q=0.5, deflate;q=0.8"));
+  EXPECT_EQ(ContentEncoding::GZIP,
+    negotiateEncoding("gzip;q=0.8, deflate;q=0.5"));
+  EXPECT_EQ(ContentEncoding::GZIP,
+    negotiateEncoding("gzip ; q=0.3, deflate;q=0.3"));
+  EXPECT_EQ(ContentEncoding::DEFLATE,
+    negotiateEncoding("gzip;q=0.001, deflate"));
+}
+
+TEST(NegotiateEncodingTest, ZeroQualityRefuses)
+{
+  EXPECT_EQ(ContentEncoding::IDENTITY, negotiateEncoding("gzip;q=0"));
+  EXPECT_EQ(ContentEncoding::IDENTITY,
+    negotiateEncoding("gzip;q=0, deflate;q=0.0"));
+  EXPECT_EQ(ContentEncoding::DEFLATE,
+    negotiateEncoding("gzip;q=0, deflate"));
+}
+
+TEST(NegotiateEncodingTest, Wildcard)
+{
+  EXPECT_EQ(ContentEncoding::GZIP, negotiateEncoding("*"));
+  EXPECT_EQ(ContentEncoding::IDENTITY, negotiateEncoding("*;q=0"));
+
+  // The wildcard applies only to the codings which are not listed.
+  EXPECT_EQ(ContentEncoding::DEFLATE, negotiateEncoding("gzip;q=0, *"));
+  EXPECT_EQ(ContentEncoding::GZIP, negotiateEncoding("deflate;q=0, *"));
+  EXPECT_EQ(ContentEncoding::GZIP, negotiateEncoding("gzip, *;q=0"));
+  EXPECT_EQ(ContentEncoding::DEFLATE,
+    negotiateEncoding("deflate;q=0.9, *;q=0.5"));
+}
+
+TEST(CompressionTest, RoundTrip)
+{
+  std::string data;
+  for (int i = 0; i < 1000; ++i)
+    data += "line " + std::to_string(i) + "\n";
+
+  for (ContentEncoding encoding
+    : {ContentEncoding::GZIP, ContentEncoding::DEFLATE})
+  {
+    std::string compressed;
+    ASSERT_TRUE(compress(data.data(), data.size(), encoding, compressed));
+    EXPECT_LT(compressed.size(), data.size());
+    EXPECT_EQ(data, decompress(compressed, encoding));
+  }
+
+  std::string compressed;
+  EXPECT_FALSE(
+    compress(data.data(), data.size(), ContentEncoding::IDENTITY, compressed));
+}
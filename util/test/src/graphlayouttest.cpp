@@ -0,0 +1,203 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <util/graphlayout.h>
+
+using namespace cc::util;
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * The tests replace the layout worker by shell scripts, so they don't depend
+ * on Graphviz. The pool is process-wide, so every test configures it.
+ */
+class GraphLayoutTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    _dir = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(_dir / "running");
+  }
+
+  void TearDown() override
+  {
+    boost::filesystem::remove_all(_dir);
+  }
+
+  /**
+   * Writes an executable worker script with the given body.
+   */
+  std::string worker(const std::string& name_, const std::string& body_)
+  {
+    boost::filesystem::path path = _dir / name_;
+
+    std::ofstream script(path.string());
+    script << "#!/bin/sh\n" << body_ << '\n';
+    script.close();
+
+    boost::filesystem::permissions(path,
+      boost::filesystem::owner_all | boost::filesystem::group_read);
+
+    return path.string();
+  }
+
+  /**
+   * Returns a worker which echoes its input after the given delay. It prints
+   * the number of workers running at its start in front of the input.
+   */
+  std::string echoWorker(const std::string& delay_)
+  {
+    std::string running = (_dir / "running").string();
+
+    return worker("echo.sh",
+      "touch " + running + "/$$\n"
+      "ls " + running + " | wc -l | tr -d ' \\n'\n"
+      "echo ':'\n"
+      "sleep " + delay_ + "\n"
+      "rm " + running + "/$$\n"
+      "cat");
+  }
+
+  static void configure(
+    const std::string& worker_,
+    std::size_t workers_,
+    std::chrono::milliseconds timeout_)
+  {
+    GraphLayout::Options options;
+    options.worker = worker_;
+    options.workers = workers_;
+    options.timeout = timeout_;
+    GraphLayout::instance().configure(options);
+  }
+
+  /**
+   * Lays out the graph on a few threads at once and returns the results or
+   * the failure messages.
+   */
+  static std::vector<std::string> layoutConcurrently(std::size_t threads_)
+  {
+    std::vector<std::string> results(threads_);
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 0; i < threads_; ++i)
+      threads.emplace_back([i, &results]()
+      {
+        try
+        {
+          results[i] = GraphLayout::instance().dotToSvg("digraph {}");
+        }
+        catch (const GraphLayout::Failure& ex)
+        {
+          results[i] = ex.what();
+        }
+      });
+
+    for (std::thread& thread : threads)
+      thread.join();
+
+    return results;
+  }
+
+  boost::filesystem::path _dir;
+};
+
+}
+
+TEST_F(GraphLayoutTest, WorkerOutput)
+{
+  configure("cat", 1, std::chrono::seconds(10));
+
+  std::string dot(100000, 'x');
+  EXPECT_EQ(dot, GraphLayout::instance().dotToSvg(dot));
+}
+
+TEST_F(GraphLayoutTest, ConcurrentWorkersAreBounded)
+{
+  configure(echoWorker("0.3"), 2, std::chrono::seconds(10));
+
+  Clock::time_point start = Clock::now();
+  std::vector<std::string> results = layoutConcurrently(6);
+  Clock::duration elapsed = Clock::now() - start;
+
+  for (const std::string& result : results)
+  {
+    ASSERT_EQ(":\ndigraph {}", result.substr(1));
+    EXPECT_GE('2', result[0]);
+  }
+
+  // Only two of the six workers may run at the same time.
+  EXPECT_LE(std::chrono::milliseconds(900), elapsed);
+}
+
+TEST_F(GraphLayoutTest, WaitingForWorkerTimesOut)
+{
+  std::string echo = echoWorker("1");
+  configure(echo, 1, std::chrono::seconds(10));
+
+  std::string result;
+  std::thread busy([&result]()
+  {
+    result = GraphLayout::instance().dotToSvg("digraph {}");
+  });
+
+  while (boost::filesystem::is_empty(_dir / "running"))
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  // The only worker is busy for a second.
+  configure(echo, 1, std::chrono::milliseconds(200));
+
+  try
+  {
+    GraphLayout::instance().dotToSvg("digraph {}");
+    ADD_FAILURE() << "The layout should have timed out.";
+  }
+  catch (const GraphLayout::Failure& ex)
+  {
+    EXPECT_EQ(
+      std::string("No graph layout worker became free in time."), ex.what());
+  }
+
+  busy.join();
+  EXPECT_EQ("1:\ndigraph {}", result);
+}
+
+TEST_F(GraphLayoutTest, PoolRecoversFromFailedWorkers)
+{
+  configure(worker("fail.sh", "exit 1"), 1, std::chrono::seconds(10));
+  EXPECT_THROW(
+    GraphLayout::instance().dotToSvg("digraph {}"), GraphLayout::Failure);
+
+  configure((_dir / "missing").string(), 1, std::chrono::seconds(10));
+  EXPECT_THROW(
+    GraphLayout::instance().dotToSvg("digraph {}"), GraphLayout::Failure);
+
+  configure(
+    worker("hang.sh", "exec sleep 10"), 1, std::chrono::milliseconds(200));
+
+  Clock::time_point start = Clock::now();
+  EXPECT_THROW(
+    GraphLayout::instance().dotToSvg("digraph {}"), GraphLayout::Failure);
+
+  // The hanging worker is killed at the deadline.
+  EXPECT_GT(std::chrono::seconds(5), Clock::now() - start);
+
+  // The single worker slot is free again after every failure.
+  configure("cat", 1, std::chrono::seconds(1));
+  EXPECT_EQ("digraph {}", GraphLayout::instance().dotToSvg("digraph {}"));
+}
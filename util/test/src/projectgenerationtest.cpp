@@ -0,0 +1,84 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <util/projectgeneration.h>
+
+using namespace cc::util;
+
+namespace
+{
+
+class ProjectGenerationTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    _dir = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(_dir);
+  }
+
+  void TearDown() override
+  {
+    boost::filesystem::remove_all(_dir);
+  }
+
+  /**
+   * Writes the project info file like the parser does.
+   */
+  void writeGeneration(std::uint64_t generation_)
+  {
+    std::ofstream info((_dir / "project_info.json").string());
+    info << "{ \"generation\": \"" << generation_ << "\" }\n";
+  }
+
+  boost::filesystem::path _dir;
+};
+
+}
+
+TEST_F(ProjectGenerationTest, MissingProject)
+{
+  EXPECT_EQ(0u, readProjectGeneration(_dir.string()));
+
+  ProjectGeneration generation(_dir.string());
+  EXPECT_EQ(0u, generation.current());
+}
+
+TEST_F(ProjectGenerationTest, ChangeWithinSecondIsNoticed)
+{
+  ProjectGeneration generation(
+    _dir.string(), std::chrono::milliseconds::zero());
+
+  writeGeneration(1);
+  EXPECT_EQ(1u, generation.current());
+
+  // The modification time of the file changes by a few milliseconds only.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  writeGeneration(2);
+  EXPECT_EQ(2u, generation.current());
+}
+
+TEST_F(ProjectGenerationTest, ChangeIsNoticedAfterInterval)
+{
+  ProjectGeneration generation(_dir.string(), std::chrono::milliseconds(200));
+
+  writeGeneration(1);
+  EXPECT_EQ(1u, generation.current());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  writeGeneration(2);
+  EXPECT_EQ(1u, generation.current());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_EQ(2u, generation.current());
+}
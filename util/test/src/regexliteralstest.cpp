@@ -0,0 +1,126 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <string>
+#include <vector>
+
+#include <boost/regex.hpp>
+
+#include <gtest/gtest.h>
+
+#include <util/regexliterals.h>
+
+using namespace cc::util;
+
+namespace
+{
+
+typedef std::vector<std::string> Literals;
+
+/**
+ * Checks that the given texts match the regular expression and contain all
+ * the literals required by it.
+ */
+void expectContained(
+  const std::string& regex_,
+  const std::vector<std::string>& texts_)
+{
+  boost::regex regex(regex_, boost::regex::perl);
+  Literals literals = requiredLiterals(regex_);
+
+  for (const std::string& text : texts_)
+  {
+    ASSERT_TRUE(boost::regex_search(text, regex)) << regex_ << " " << text;
+
+    for (const std::string& literal : literals)
+      EXPECT_NE(std::string::npos, text.find(literal))
+        << regex_ << " requires " << literal << " which isn't in " << text;
+  }
+}
+
+}
+
+TEST(RegexLiteralsTest, PlainText)
+{
+  EXPECT_EQ(Literals({"foobar"}), requiredLiterals("foobar"));
+  EXPECT_EQ(Literals({"foo.bar"}), requiredLiterals("foo\\.bar"));
+  EXPECT_EQ(Literals({"a(b)"}), requiredLiterals("a\\(b\\)"));
+  EXPECT_EQ(Literals({"foobar"}), requiredLiterals("FooBar", true));
+  EXPECT_EQ(Literals(), requiredLiterals(""));
+  EXPECT_EQ(Literals(), requiredLiterals("foo\\"));
+}
+
+TEST(RegexLiteralsTest, Alternation)
+{
+  EXPECT_EQ(Literals(), requiredLiterals("foo|bar"));
+  EXPECT_EQ(Literals(), requiredLiterals("foo(bar)?"));
+  EXPECT_EQ(Literals(), requiredLiterals("(?i)foo"));
+  EXPECT_EQ(Literals({"foo|bar"}), requiredLiterals("foo\\|bar"));
+}
+
+TEST(RegexLiteralsTest, Brackets)
+{
+  EXPECT_EQ(Literals({"foo", "bar"}), requiredLiterals("foo[abc]bar"));
+  EXPECT_EQ(Literals({"a", "b"}), requiredLiterals("a[^x]b"));
+  EXPECT_EQ(Literals({"a", "b"}), requiredLiterals("a[]x]b"));
+  EXPECT_EQ(Literals({"a", "b"}), requiredLiterals("a[^]x]b"));
+  EXPECT_EQ(Literals({"a", "b"}), requiredLiterals("a[\\]x]b"));
+  EXPECT_EQ(Literals({"a", "b"}), requiredLiterals("a[[:alpha:]]]*b"));
+}
+
+TEST(RegexLiteralsTest, Quantifiers)
+{
+  EXPECT_EQ(Literals({"ab"}), requiredLiterals("abc*"));
+  EXPECT_EQ(Literals({"ab", "d"}), requiredLiterals("abc?d"));
+  EXPECT_EQ(Literals({"ab", "c"}), requiredLiterals("ab+c"));
+  EXPECT_EQ(Literals({"a", "c"}), requiredLiterals("ab{0,2}c"));
+  EXPECT_EQ(Literals({"a", "c"}), requiredLiterals("a.*?c"));
+  EXPECT_EQ(Literals({"a", "c"}), requiredLiterals("^a\\.?c$"));
+}
+
+TEST(RegexLiteralsTest, ClassEscapes)
+{
+  EXPECT_EQ(Literals({"foo", "bar"}), requiredLiterals("foo\\d+bar"));
+  EXPECT_EQ(Literals({"foo", "bar"}), requiredLiterals("\\bfoo\\s*bar\\b"));
+  EXPECT_EQ(Literals({"a", "b"}), requiredLiterals("a\\nb"));
+}
+
+TEST(RegexLiteralsTest, EscapeOperands)
+{
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\x41cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\x{263a}cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\cAcd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\pLcd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\p{Lu}cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\PLcd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\N{comma}cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\012cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\g1cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\g-1cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\g{x}cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\k<x>cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\k'x'cd"));
+  EXPECT_EQ(Literals({"ab", "cd"}), requiredLiterals("ab\\k{x}cd"));
+
+  // The operand is not taken for literal text even if it's incomplete.
+  EXPECT_EQ(Literals({"ab"}), requiredLiterals("ab\\x{41"));
+  EXPECT_EQ(Literals({"ab"}), requiredLiterals("ab\\c"));
+}
+
+TEST(RegexLiteralsTest, UnknownEscapes)
+{
+  EXPECT_EQ(Literals(), requiredLiterals("ab\\Q|\\Ecd"));
+  EXPECT_EQ(Literals(), requiredLiterals("ab\\ycd"));
+}
+
+TEST(RegexLiteralsTest, LiteralsOfMatches)
+{
+  expectContained("ab\\x41cd", {"abAcd"});
+  expectContained("ab\\x{42}cd", {"abBcd"});
+  expectContained("ab\\cAcd", {"ab\x01" "cd"});
+  expectContained("ab\\0101cd", {"abAcd"});
+  expectContained("ab\\p{upper}cd", {"abXcd"});
+  expectContained("a(x)\\1b", {"axxb"});
+  expectContained("fo+ba?r\\d{2,}", {"foobr12", "fobar123"});
+  expectContained("x[ab]{2}y", {"xaby", "xbay"});
+}
@@ -99,7 +99,8 @@ export const Diagrams = (): JSX.Element => {
     const parentNode = (e.target as HTMLElement)?.parentElement;
     if ((parentNode?.className as unknown as SVGAnimatedString).baseVal !== 'node') return;
 
-    const diagramGenId = parentNode?.id as string;
+    // An aggregated "more directories" node expands its parent directory.
+    const diagramGenId = (parentNode?.id as string).replace(/^more:/, '');
 
     const initDiagramInfo =
       appCtx.diagramType === 'file'
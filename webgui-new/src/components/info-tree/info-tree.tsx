@@ -6,7 +6,7 @@ import {
   getCppReferenceTypes,
   getCppReferences,
   getCppProperties,
-  getCppReferenceCount,
+  getCppReferenceCountBatch,
   getCppAstNodeInfo,
 } from 'service/cpp-service';
 import { AstNodeInfo, FileInfo, Range } from '@thrift-generated';
@@ -48,9 +48,14 @@ export const InfoTree = (): JSX.Element => {
       const initRefs: typeof refs = new Map();
       const initFileUsages: typeof fileUsages = new Map();
 
+      const refCountBatch = await getCppReferenceCountBatch(
+        [initAstNodeInfo.id as string],
+        [...initRefTypes.values()]
+      );
+      const nodeRefCounts = refCountBatch.get(initAstNodeInfo.id as string);
+
       for (const [rType, rId] of initRefTypes) {
-        const refCount = await getCppReferenceCount(initAstNodeInfo.id as string, rId);
-        initRefCounts.set(rType, refCount);
+        initRefCounts.set(rType, nodeRefCounts?.get(rId) ?? 0);
 
         const refsForType = await getCppReferences(initAstNodeInfo.id as string, rId, initAstNodeInfo.tags ?? []);
         initRefs.set(rType, refsForType);
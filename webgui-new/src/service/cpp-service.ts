@@ -50,6 +50,19 @@ export const getCppFileDiagram = async (fileId: string, diagramId: number) => {
   }
 };
 
+export const getCppFileDiagramGraph = async (fileId: string, diagramId: number) => {
+  if (!client) {
+    return '';
+  }
+  try {
+    return await client.getFileDiagramGraph(fileId, diagramId);
+  } catch (e) {
+    toast.error('Could not display diagram.');
+    console.error(e);
+    return '';
+  }
+};
+
 export const getCppFileDiagramLegend = async (diagramId: number) => {
   if (!client) {
     return '';
@@ -90,6 +103,19 @@ export const getCppDiagram = async (astNodeId: string, diagramId: number) => {
   }
 };
 
+export const getCppDiagramGraph = async (astNodeId: string, diagramId: number) => {
+  if (!client) {
+    return '';
+  }
+  try {
+    return await client.getDiagramGraph(astNodeId, diagramId);
+  } catch (e) {
+    toast.error('Could not display diagram.');
+    console.error(e);
+    return '';
+  }
+};
+
 export const getCppDiagramLegend = async (diagramId: number) => {
   if (!client) {
     return '';
@@ -179,6 +205,20 @@ export const getCppReferenceCount = async (astNodeId: string, referenceId: numbe
   }
 };
 
+export const getCppReferenceCountBatch = async (astNodeIds: string[], referenceIds: number[]) => {
+  let resultMap = new Map<string, Map<number, number>>();
+  if (!client) {
+    return resultMap;
+  }
+  try {
+    resultMap = await client.getReferenceCountBatch(astNodeIds, referenceIds);
+  } catch (e) {
+    console.error(e);
+    resultMap = new Map();
+  }
+  return resultMap;
+};
+
 export const getCppReferencesInFile = async (
   astNodeId: string,
   referenceId: number,
@@ -73,10 +73,28 @@ public:
   }
 
   int beginRequest(struct mg_connection *conn_) override
+  {
+    HttpResponse response;
+    handleRequest(HttpRequest::fromConnection(conn_), response);
+    response.send(conn_);
+
+    // Returning non-zero tells mongoose that our function has replied to
+    // the client, and mongoose should not send client any more data.
+    return MG_TRUE;
+  }
+
+  bool isAsync() const override
+  {
+    return true;
+  }
+
+  void handleRequest(
+    const HttpRequest& request_,
+    HttpResponse& response_) override
   {
     try
     {
-      std::string request = getContent(conn_);
+      const std::string& request = request_.content;
       LOG(debug) << "[LSP] Request content:\n" << request;
 
       pt::ptree responseTree;
@@ -266,40 +284,26 @@ public:
 
       std::stringstream responseStream;
       pt::write_json(responseStream, responseTree);
-      std::string response = responseStream.str();
-
-      LOG(debug) << "[LSP] Response content:\n" << response << std::endl;
-
-      // Send HTTP reply to the client create headers
-      mg_send_header(conn_, "Content-Type", "application/json");
-      mg_send_header(
-        conn_, "Content-Length", std::to_string(response.length()).c_str());
+      response_.content = responseStream.str();
 
-      // Terminate headers
-      mg_write(conn_, "\r\n", 2);
+      LOG(debug) << "[LSP] Response content:\n" << response_.content
+        << std::endl;
 
-      // Send content
-      mg_write(conn_, response.c_str(), response.length());
+      response_.headers.emplace_back("Content-Type", "application/json");
     }
     catch (const std::exception& ex)
     {
       LOG(warning) << ex.what();
+      response_.status = 500; // 500 Internal Server Error.
     }
     catch (...)
     {
       LOG(warning) << "Unknown exception has been caught";
+      response_.status = 500; // 500 Internal Server Error.
     }
-
-    // Returning non-zero tells mongoose that our function has replied to
-    // the client, and mongoose should not send client any more data.
-    return MG_TRUE;
   }
 
 private:
-  inline std::string getContent(mg_connection* conn_)
-  {
-    return std::string(conn_->content, conn_->content + conn_->content_len);
-  }
 
   LspMethod parseMethod(const std::string& method) const
   {
@@ -1,8 +1,11 @@
 #ifndef CC_WEBSERVER_PLUGIN_H
 #define CC_WEBSERVER_PLUGIN_H
 
+#include <strings.h>
+
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/program_options.hpp>
@@ -10,16 +13,105 @@
 #include "pluginhandler.h"
 #include "mongoose.h"
 
-namespace cc 
-{ 
+namespace cc
+{
 namespace webserver
 {
 
+/**
+ * Copy of an HTTP request. Unlike the mongoose connection it can be handled on
+ * a worker thread while the I/O thread of the connection serves others. The
+ * body is copied too, because mongoose frees the receive buffer when the
+ * client closes the connection (MG_CLOSE) while the request is in flight.
+ */
+struct HttpRequest
+{
+  std::string method;
+  std::string uri;
+  std::string queryString;
+  std::vector<std::pair<std::string, std::string>> headers;
+  std::string content;
+
+  static HttpRequest fromConnection(const struct mg_connection* conn_)
+  {
+    HttpRequest request;
+    request.method = conn_->request_method ? conn_->request_method : "";
+    request.uri = conn_->uri ? conn_->uri : "";
+    request.queryString = conn_->query_string ? conn_->query_string : "";
+    if (conn_->content_len != 0)
+      request.content.assign(conn_->content, conn_->content_len);
+
+    for (int i = 0; i < conn_->num_headers; ++i)
+      request.headers.emplace_back(
+        conn_->http_headers[i].name, conn_->http_headers[i].value);
+
+    return request;
+  }
+
+  /**
+   * Returns the value of the given header (case-insensitively) or nullptr if
+   * the request has no such header, like mg_get_header().
+   */
+  const char* header(const char* name_) const
+  {
+    for (const auto& header : headers)
+      if (::strcasecmp(header.first.c_str(), name_) == 0)
+        return header.second.c_str();
+
+    return nullptr;
+  }
+};
+
+struct HttpResponse
+{
+  int status = 200;
+  std::vector<std::pair<std::string, std::string>> headers;
+  std::string content;
+
+  /**
+   * Writes the response to the connection. It must be called on the I/O thread
+   * of the connection.
+   */
+  void send(struct mg_connection* conn_) const
+  {
+    mg_send_status(conn_, status);
+
+    for (const auto& header : headers)
+      mg_send_header(conn_, header.first.c_str(), header.second.c_str());
+
+    mg_send_header(
+      conn_, "Content-Length", std::to_string(content.size()).c_str());
+
+    // Terminate headers
+    mg_write(conn_, "\r\n", 2);
+
+    mg_write(conn_, content.data(), content.size());
+  }
+};
+
 class RequestHandler
 {
 public:
   virtual std::string key() const = 0;
   virtual int beginRequest(struct mg_connection*) = 0;
+
+  /**
+   * Returns true if the handler implements handleRequest(). The web server
+   * runs such handlers on its worker pool, so a slow request doesn't block
+   * the other connections of the same I/O thread. The others are called by
+   * beginRequest() on the I/O thread.
+   */
+  virtual bool isAsync() const { return false; }
+
+  /**
+   * Serves a copied request without accessing the connection. It may be
+   * called on any thread.
+   */
+  virtual void handleRequest(const HttpRequest&, HttpResponse& response_)
+  {
+    response_.status = 501; // 501 Not Implemented.
+  }
+
   virtual ~RequestHandler() = default;
 };
 
@@ -2,14 +2,22 @@
 #define CC_WEBSERVER_THRIFTHANDLER_H
 
 #include <stdio.h>
+#include <strings.h>
+#include <chrono>
+#include <cstring>
 #include <memory>
 
+#include <thrift/TProcessor.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/THttpServer.h>
 #include <thrift/transport/TTransport.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
 #include <thrift/protocol/TJSONProtocol.h>
 
+#include <util/compression.h>
 #include <util/logutil.h>
+#include <util/metrics.h>
 #include <webserver/requesthandler.h>
 
 #include "mongoose.h"
@@ -19,19 +27,41 @@ namespace cc
 namespace webserver
 {
 
+/**
+ * Serves the Thrift services over HTTP. The protocol is chosen by the
+ * Content-Type of the request:
+ *
+ *  - application/vnd.apache.thrift.binary: TBinaryProtocol
+ *  - application/vnd.apache.thrift.compact: TCompactProtocol
+ *  - anything else (application/x-thrift,
+ *    application/vnd.apache.thrift.json): TJSONProtocol
+ *
+ * The binary protocols are much cheaper to encode and decode than JSON, which
+ * matters for big reference lists and file contents, so API clients other
+ * than the web browser should prefer them. The response is sent in the same
+ * protocol, compressed if the client accepts it and the response is big
+ * enough.
+ */
 template<class Processor>
 class ThriftHandler : public RequestHandler
 {
 protected:
+  enum class Protocol
+  {
+    JSON,
+    BINARY,
+    COMPACT
+  };
+
   /**
    * Calling context for thrift process calls.
    */
   struct CallContext
   {
     /**
-     * Mongoose connection.
+     * The HTTP request being served.
      */
-    struct mg_connection* connection;
+    const HttpRequest* request;
 
     /**
      * A pointer for the real call context (for dispatch call).
@@ -62,17 +92,91 @@ protected:
     }
   };
 
+  /**
+   * Measures the phases of the calls for the request metrics (see
+   * util::RequestMetrics). The processor calls these hooks around reading
+   * the arguments, calling the service and writing the result, all on the
+   * thread serving the request.
+   */
+  class MetricsEventHandler
+    : public apache::thrift::TProcessorEventHandler
+  {
+  public:
+    void* getContext(const char*, void*) override
+    {
+      return new Call;
+    }
+
+    void freeContext(void* ctx_, const char* fnName_) override
+    {
+      std::unique_ptr<Call> call(static_cast<Call*>(ctx_));
+      Clock::time_point end = Clock::now();
+
+      util::RequestMetrics::Sample sample;
+      sample.total = end - call->start;
+      sample.database = util::threadDatabaseTime() - call->databaseStart;
+      sample.serialization = (call->readEnd - call->readStart)
+        + (call->writeEnd - call->writeStart);
+      sample.error = call->error;
+
+      util::RequestMetrics::instance().record(fnName_, sample);
+    }
+
+    void preRead(void* ctx_, const char*) override
+    {
+      static_cast<Call*>(ctx_)->readStart = Clock::now();
+    }
+
+    void postRead(void* ctx_, const char*, std::uint32_t) override
+    {
+      static_cast<Call*>(ctx_)->readEnd = Clock::now();
+    }
+
+    void preWrite(void* ctx_, const char*) override
+    {
+      static_cast<Call*>(ctx_)->writeStart = Clock::now();
+    }
+
+    void postWrite(void* ctx_, const char*, std::uint32_t) override
+    {
+      static_cast<Call*>(ctx_)->writeEnd = Clock::now();
+    }
+
+    void handlerError(void* ctx_, const char*) override
+    {
+      static_cast<Call*>(ctx_)->error = true;
+    }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Call
+    {
+      // The phases which are skipped (e.g. writing the result after an
+      // error) are measured as zero.
+      Clock::time_point start = Clock::now();
+      Clock::time_point readStart = start;
+      Clock::time_point readEnd = start;
+      Clock::time_point writeStart = start;
+      Clock::time_point writeEnd = start;
+      std::chrono::nanoseconds databaseStart = util::threadDatabaseTime();
+      bool error = false;
+    };
+  };
+
 public:
   template<class Handler>
   ThriftHandler(Handler *handler_)
     : _processor(std::shared_ptr<Handler>(handler_))
   {
+    _processor.setEventHandler(std::make_shared<MetricsEventHandler>());
   }
 
   template<class Handler>
   ThriftHandler(Handler handler_)
     : _processor(handler_)
   {
+    _processor.setEventHandler(std::make_shared<MetricsEventHandler>());
   }
 
   std::string key() const override
@@ -81,6 +185,24 @@ public:
   }
 
   int beginRequest(struct mg_connection *conn_) override
+  {
+    HttpResponse response;
+    handleRequest(HttpRequest::fromConnection(conn_), response);
+    response.send(conn_);
+
+    // Returning non-zero tells mongoose that our function has replied to
+    // the client, and mongoose should not send client any more data.
+    return MG_TRUE;
+  }
+
+  bool isAsync() const override
+  {
+    return true;
+  }
+
+  void handleRequest(
+    const HttpRequest& request_,
+    HttpResponse& response_) override
   {
     using namespace ::apache::thrift;
     using namespace ::apache::thrift::transport;
@@ -88,56 +210,141 @@ public:
 
     try
     {
-      std::string content{conn_->content, conn_->content + conn_->content_len};
+      const Protocol protocol
+        = negotiateProtocol(request_.header("Content-Type"));
 
-      LOG(debug) << "Request content:\n" << content;
+      if (protocol == Protocol::JSON)
+        LOG(debug) << "Request content:\n" << request_.content;
 
-      std::shared_ptr<TTransport> inputBuffer(
-        new TMemoryBuffer((std::uint8_t*)content.c_str(), content.length()));
+      // The transport observes the body of the copied request, so it isn't
+      // copied once more. The copy itself can't be avoided: the connection
+      // and its receive buffer may be closed while the request is served.
+      std::shared_ptr<TMemoryBuffer> inputBuffer(new TMemoryBuffer(
+        reinterpret_cast<std::uint8_t*>(
+          const_cast<char*>(request_.content.data())),
+        static_cast<std::uint32_t>(request_.content.size()),
+        TMemoryBuffer::OBSERVE));
 
-      std::shared_ptr<TTransport> outputBuffer(new TMemoryBuffer(4096));
+      std::shared_ptr<TMemoryBuffer> outputBuffer(new TMemoryBuffer(4096));
 
-      std::shared_ptr<TProtocol> inputProtocol(
-        new TJSONProtocol(inputBuffer));
-      std::shared_ptr<TProtocol> outputProtocol(
-        new TJSONProtocol(outputBuffer));
+      std::shared_ptr<TProtocol> inputProtocol
+        = createProtocol(protocol, inputBuffer);
+      std::shared_ptr<TProtocol> outputProtocol
+        = createProtocol(protocol, outputBuffer);
 
-      CallContext ctx{conn_, nullptr};
+      CallContext ctx{&request_, nullptr};
       _processor.process(inputProtocol, outputProtocol, &ctx);
 
-      TMemoryBuffer *mBuffer = dynamic_cast<TMemoryBuffer*>(outputBuffer.get());
-
-      std::string response = mBuffer->getBufferAsString();
+      std::uint8_t* response;
+      std::uint32_t responseLength;
+      outputBuffer->getBuffer(&response, &responseLength);
 
-      LOG(debug)
-        << "Response:\n" << response.c_str() << std::endl;
+      if (protocol == Protocol::JSON)
+        LOG(debug) << "Response:\n"
+          << std::string(reinterpret_cast<const char*>(response),
+                         responseLength);
 
-      // Send HTTP reply to the client create headers
-      mg_send_header(conn_, "Content-Type", "application/x-thrift");
-      mg_send_header(
-        conn_, "Content-Length", std::to_string(response.length()).c_str());
+      // File contents and long reference lists compress very well.
+      util::ContentEncoding encoding
+        = responseLength >= util::COMPRESSION_THRESHOLD
+        ? util::negotiateEncoding(request_.header("Accept-Encoding"))
+        : util::ContentEncoding::IDENTITY;
 
-      // Terminate headers
-      mg_write(conn_, "\r\n", 2);
+      if (encoding == util::ContentEncoding::IDENTITY ||
+          !util::compress(reinterpret_cast<const char*>(response),
+            responseLength, encoding, response_.content))
+      {
+        encoding = util::ContentEncoding::IDENTITY;
+        response_.content.assign(
+          reinterpret_cast<const char*>(response), responseLength);
+      }
 
-      // Send content
-      mg_write(conn_, response.c_str(), response.length());
+      response_.headers.emplace_back("Content-Type", contentType(protocol));
+      response_.headers.emplace_back("Vary", "Accept-Encoding");
+      if (encoding != util::ContentEncoding::IDENTITY)
+        response_.headers.emplace_back(
+          "Content-Encoding", util::encodingName(encoding));
     }
     catch (const std::exception& ex)
     {
       LOG(warning) << ex.what();
+      fail(response_);
     }
     catch (...)
     {
       LOG(warning) << "Unknown exception has been caught";
+      fail(response_);
     }
-
-    // Returning non-zero tells mongoose that our function has replied to
-    // the client, and mongoose should not send client any more data.
-    return MG_TRUE;
   }
 
 private:
+  /**
+   * Chooses the protocol by the media type of the request. The parameters of
+   * the media type (e.g. charset) are ignored.
+   */
+  static Protocol negotiateProtocol(const char* contentType_)
+  {
+    if (!contentType_)
+      return Protocol::JSON;
+
+    auto matches = [contentType_](const char* mediaType_){
+      std::size_t length = std::strlen(mediaType_);
+      return ::strncasecmp(contentType_, mediaType_, length) == 0 &&
+        (contentType_[length] == '\0' || contentType_[length] == ';' ||
+         contentType_[length] == ' ');
+    };
+
+    if (matches("application/vnd.apache.thrift.binary"))
+      return Protocol::BINARY;
+
+    if (matches("application/vnd.apache.thrift.compact"))
+      return Protocol::COMPACT;
+
+    return Protocol::JSON;
+  }
+
+  static void fail(HttpResponse& response_)
+  {
+    response_.status = 500; // 500 Internal Server Error.
+    response_.headers.clear();
+    response_.content.clear();
+  }
+
+  static const char* contentType(Protocol protocol_)
+  {
+    switch (protocol_)
+    {
+      case Protocol::BINARY:
+        return "application/vnd.apache.thrift.binary";
+      case Protocol::COMPACT:
+        return "application/vnd.apache.thrift.compact";
+      case Protocol::JSON:
+        break;
+    }
+
+    // The existing clients expect this type for JSON.
+    return "application/x-thrift";
+  }
+
+  static std::shared_ptr<apache::thrift::protocol::TProtocol> createProtocol(
+    Protocol protocol_,
+    std::shared_ptr<apache::thrift::transport::TMemoryBuffer> buffer_)
+  {
+    using namespace ::apache::thrift::protocol;
+
+    switch (protocol_)
+    {
+      case Protocol::BINARY:
+        return std::make_shared<TBinaryProtocol>(buffer_);
+      case Protocol::COMPACT:
+        return std::make_shared<TCompactProtocol>(buffer_);
+      case Protocol::JSON:
+        break;
+    }
+
+    return std::make_shared<TJSONProtocol>(buffer_);
+  }
+
   LoggingProcessor _processor;
 };
 
@@ -1,4 +1,8 @@
+#include <atomic>
+
+#include <util/dbutil.h>
 #include <util/logutil.h>
+#include <util/metrics.h>
 #include <util/util.h>
 
 #include "mainrequesthandler.h"
@@ -41,6 +45,20 @@ namespace cc
 namespace webserver
 {
 
+/**
+ * State of a request which is served on the worker pool. The connection and
+ * the worker share it, because the connection may be closed before the
+ * worker finishes.
+ */
+struct PendingRequest
+{
+  HttpRequest request;
+  HttpResponse response;
+  std::atomic_bool done{false};
+};
+
+typedef std::shared_ptr<PendingRequest> PendingRequestPtr;
+
 static void logRequest(const struct mg_connection* conn_, const Session* sess_)
 {
   std::string username = sess_ ? sess_->username : "Anonymous";
@@ -70,14 +88,18 @@ auto MainRequestHandler::executeWithSessionContext(Session* sess_, F func)
 }
 
 
-int MainRequestHandler::begin_request_handler(struct mg_connection* conn_)
+int MainRequestHandler::begin_request_handler(
+  struct mg_connection* conn_,
+  std::shared_ptr<Session> sess_)
 {
   // We advance it by one because of the '/' character.
   const std::string& uri = conn_->uri + 1;
 
   auto handler = pluginHandler.getImplementation(uri);
   if (handler)
-    return handler->beginRequest(conn_);
+    return handler->isAsync()
+      ? dispatchRequest(conn_, handler, sess_)
+      : handler->beginRequest(conn_);
 
   if (uri == "ga.txt")
   {
@@ -95,6 +117,17 @@ int MainRequestHandler::begin_request_handler(struct mg_connection* conn_)
     }
   }
 
+  if (uri == "metrics")
+  {
+    HttpResponse response;
+    response.headers.emplace_back(
+      "Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    response.content = util::RequestMetrics::instance().toPrometheus()
+      + util::databasePoolMetrics();
+    response.send(conn_);
+    return MG_TRUE;
+  }
+
   if (uri.find("doxygen/") == 0)
   {
     mg_send_file(conn_, getDocDirByURI(uri).c_str());
@@ -102,8 +135,64 @@ int MainRequestHandler::begin_request_handler(struct mg_connection* conn_)
   }
 
   // Returning MG_FALSE tells mongoose that we didn't served the request
-  // so mongoose should serve it.
-  return MG_FALSE;
+  // so mongoose should serve it. The compressible files are served by us
+  // compressed.
+  return staticFileHandler.serve(conn_);
+}
+
+int MainRequestHandler::dispatchRequest(
+  struct mg_connection* conn_,
+  std::shared_ptr<RequestHandler> handler_,
+  std::shared_ptr<Session> sess_)
+{
+  PendingRequestPtr pending = std::make_shared<PendingRequest>();
+  pending->request = HttpRequest::fromConnection(conn_);
+  conn_->connection_param = new PendingRequestPtr(pending);
+
+  server->dispatch([this, pending, handler_, sess_]()
+  {
+    try
+    {
+      executeWithSessionContext(sess_.get(), [&]()
+      {
+        handler_->handleRequest(pending->request, pending->response);
+        return true;
+      });
+    }
+    catch (const std::exception& ex)
+    {
+      LOG(warning) << ex.what();
+      pending->response = HttpResponse();
+      pending->response.status = 500; // 500 Internal Server Error.
+    }
+    catch (...)
+    {
+      LOG(warning) << "Unknown exception has been caught";
+      pending->response = HttpResponse();
+      pending->response.status = 500; // 500 Internal Server Error.
+    }
+
+    pending->done = true;
+  });
+
+  // The reply is sent later by pollReply() on this I/O thread.
+  return MG_MORE;
+}
+
+int MainRequestHandler::pollReply(struct mg_connection* conn_)
+{
+  PendingRequestPtr* pending
+    = static_cast<PendingRequestPtr*>(conn_->connection_param);
+
+  if (!pending || !(*pending)->done)
+    return MG_FALSE;
+
+  (*pending)->response.send(conn_);
+
+  delete pending;
+  conn_->connection_param = nullptr;
+
+  return MG_TRUE;
 }
 
 int MainRequestHandler::operator()(struct mg_connection* conn_,
@@ -114,21 +203,39 @@ int MainRequestHandler::operator()(struct mg_connection* conn_,
     // our own authentication system.
     return MG_TRUE;
 
+  if (ev_ == MG_POLL)
+    return pollReply(conn_);
+
+  if (ev_ == MG_CLOSE)
+  {
+    // The worker may still be serving the request, but its reply is dropped.
+    delete static_cast<PendingRequestPtr*>(conn_->connection_param);
+    conn_->connection_param = nullptr;
+    return MG_TRUE;
+  }
+
   if (ev_ != MG_REQUEST)
     // For everything else, bail out.
     return MG_FALSE;
 
+  if (conn_->connection_param)
+    // More data of a pipelined request has arrived while the previous one is
+    // still served. It is parsed when the reply has been sent.
+    return MG_MORE;
+
   const char* cookieHeader = mg_get_header(conn_, "Cookie");
 
   if (strcmp("/AuthenticationService", conn_->uri) == 0)
   {
-    Session* sessCookie = sessionManager->getSessionCookie(cookieHeader);
-    logRequest(conn_, sessCookie);
+    std::shared_ptr<Session> sessCookie
+      = sessionManager->getSessionCookie(cookieHeader);
+    logRequest(conn_, sessCookie.get());
 
     // Handle the authentication service specially - it needs access to the
     // session if it exists, but does NOT require a valid session to access.
-    return executeWithSessionContext(
-      sessCookie, [this, &conn_]() { return begin_request_handler(conn_); });
+    return executeWithSessionContext(sessCookie.get(),
+      [this, &conn_, sessCookie]()
+      { return begin_request_handler(conn_, sessCookie); });
   }
 
   if (!isProtected(conn_->uri))
@@ -136,24 +243,26 @@ int MainRequestHandler::operator()(struct mg_connection* conn_,
     // For unprotected endpoints, just serve naturally, without querying the
     // session.
     logRequest(conn_, nullptr);
-    return begin_request_handler(conn_);
+    return begin_request_handler(conn_, nullptr);
   }
 
-  Session* sessCookie = sessionManager->getSessionCookie(cookieHeader);
-  logRequest(conn_, sessCookie);
+  std::shared_ptr<Session> sessCookie
+    = sessionManager->getSessionCookie(cookieHeader);
+  logRequest(conn_, sessCookie.get());
 
-  if (!sessionManager->isValid(sessCookie))
+  if (!sessionManager->isValid(sessCookie.get()))
   {
     // If authentication is needed and the user does not have a valid session,
     // redirect them to login.
-    sessionManager->destroySessionCookie(sessCookie);
+    sessionManager->destroySessionCookie(sessCookie.get());
 
     writeRedirect(conn_, "/login.html");
     return MG_TRUE;
   }
 
-  return executeWithSessionContext(
-    sessCookie, [this, &conn_]() { return begin_request_handler(conn_); });
+  return executeWithSessionContext(sessCookie.get(),
+    [this, &conn_, sessCookie]()
+    { return begin_request_handler(conn_, sessCookie); });
 }
 
 std::string MainRequestHandler::getDocDirByURI(std::string uri_)
@@ -4,6 +4,9 @@
 #include <webserver/pluginhandler.h>
 #include <webserver/requesthandler.h>
 
+#include "staticfilehandler.h"
+#include "threadedmongoose.h"
+
 namespace cc
 {
 namespace webserver
@@ -19,11 +22,33 @@ public:
   PluginHandler<RequestHandler> pluginHandler;
   std::map<std::string, std::string> dataDir;
   std::string gaTrackingIdPath;
+  StaticFileHandler staticFileHandler;
+  ThreadedMongoose* server;
 
   int operator()(struct mg_connection* conn_, enum mg_event ev_);
 
 private:
-  int begin_request_handler(struct mg_connection* conn_);
+  int begin_request_handler(
+    struct mg_connection* conn_,
+    std::shared_ptr<Session> sess_);
+
+  /**
+   * Serves the request by the handler on the worker pool of the server. The
+   * connection is kept pending until the reply is sent by pollReply(). The
+   * job shares the session, because it may be destroyed by a logout or
+   * expire before the job runs.
+   */
+  int dispatchRequest(
+    struct mg_connection* conn_,
+    std::shared_ptr<RequestHandler> handler_,
+    std::shared_ptr<Session> sess_);
+
+  /**
+   * Sends the reply of the dispatched request if it is ready.
+   * @return MG_TRUE if the reply has been sent.
+   */
+  int pollReply(struct mg_connection* conn_);
+
   std::string getDocDirByURI(std::string uri_);
 
   // Detail template - implementation in the .cpp only.
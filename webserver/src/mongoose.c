@@ -2793,6 +2793,9 @@ static int call_request_handler(struct connection *conn) {
       write_terminating_chunk(conn);
     }
     close_local_endpoint(conn);
+  } else if (result == MG_MORE && conn->endpoint_type == EP_USER) {
+    // The reply is completed later on MG_POLL, the connection is not idle.
+    conn->ns_conn->flags |= MG_LONG_RUNNING;
   }
   return result;
 }
@@ -4520,8 +4523,14 @@ static void close_local_endpoint(struct connection *conn) {
   }
 #endif
 
-  // Gobble possible POST data sent to the URI handler
-  iobuf_free(&conn->ns_conn->recv_iobuf);
+  // Gobble possible POST data sent to the URI handler, but keep the
+  // pipelined requests which follow it
+  if (keep_alive && conn->cl >= 0 &&
+      (size_t) conn->cl < conn->ns_conn->recv_iobuf.len) {
+    iobuf_remove(&conn->ns_conn->recv_iobuf, (size_t) conn->cl);
+  } else {
+    iobuf_free(&conn->ns_conn->recv_iobuf);
+  }
   free(conn->request);
   free(conn->path_info);
 
@@ -4986,7 +4995,8 @@ static void mg_ev_handler(struct ns_connection *nc, enum ns_event ev, void *p) {
           ping_idle_websocket_connection(conn, current_time);
         }
 
-        if (nc->last_io_time + MONGOOSE_IDLE_TIMEOUT_SECONDS < current_time) {
+        if (!(nc->flags & MG_LONG_RUNNING) &&
+            nc->last_io_time + MONGOOSE_IDLE_TIMEOUT_SECONDS < current_time) {
           mg_ev_handler(nc, NS_CLOSE, NULL);
           nc->flags |= NSF_CLOSE_IMMEDIATELY;
         }
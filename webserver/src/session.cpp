@@ -64,7 +64,7 @@ SessionManagerAccess::auth_usernameAndPassword(const std::string& username_,
   if (!_manager)
     throw std::runtime_error("Accessing SessionManager through null!");
 
-  Session* sess =
+  std::shared_ptr<Session> sess =
     _manager->authenticateUserWithNameAndPassword(username_, password_);
 
   return sess ? sess->sessId : EmptyStr;
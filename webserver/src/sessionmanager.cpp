@@ -29,7 +29,8 @@ SessionManager::SessionManager(const Authentication* authEngine_)
   if (!isRequiringAuthentication())
     // Create a default session for services to be able to use, which is shared
     // between all users.
-    _sessions.emplace(CODECOMPASS_SESSION_COOKIE, Session{CODECOMPASS_SESSION_COOKIE, "Anonymous"});
+    _sessions.emplace(CODECOMPASS_SESSION_COOKIE, std::make_shared<Session>(
+      CODECOMPASS_SESSION_COOKIE, "Anonymous"));
 }
 
 bool SessionManager::isRequiringAuthentication() const
@@ -47,13 +48,14 @@ std::string SessionManager::getSessionCookieName() const
   return CODECOMPASS_SESSION_COOKIE;
 }
 
-Session* SessionManager::getSessionCookie(const char* cookieHeader_)
+std::shared_ptr<Session> SessionManager::getSessionCookie(
+  const char* cookieHeader_)
 {
   if (!isRequiringAuthentication())
   {
     const std::lock_guard<std::mutex> lock{_sessionMapLock};
     auto it = _sessions.find(CODECOMPASS_SESSION_COOKIE);
-    return &it->second;
+    return it->second;
   }
 
   if (!cookieHeader_)
@@ -85,7 +87,7 @@ Session* SessionManager::getSessionCookie(const char* cookieHeader_)
   auto it = _sessions.find(identifier);
   if (it == _sessions.end())
     return nullptr;
-  return &it->second;
+  return it->second;
 }
 
 void SessionManager::destroySessionCookie(Session* session_)
@@ -117,7 +119,8 @@ bool SessionManager::isValid(const Session* session_) const
   return true;
 }
 
-Session* SessionManager::authenticateUserWithNameAndPassword(
+std::shared_ptr<Session>
+SessionManager::authenticateUserWithNameAndPassword(
   const std::string& username_, const std::string& password_)
 {
   if (!_authEngine->authenticateUsernamePassword(username_, password_))
@@ -133,8 +136,8 @@ Session* SessionManager::authenticateUserWithNameAndPassword(
   std::string id = util::sha1Hash(os.str());
 
   const std::lock_guard<std::mutex> lock{_sessionMapLock};
-  auto it = _sessions.emplace(id, Session{id, username_});
-  return &it.first->second;
+  auto it = _sessions.emplace(id, std::make_shared<Session>(id, username_));
+  return it.first->second;
 }
 
 /**
@@ -147,7 +150,7 @@ void SessionManager::cleanupOldSessions()
   {
     for (auto it = _sessions.begin(); it != _sessions.end();)
     {
-      if (!isValid(&it->second))
+      if (!isValid(it->second.get()))
         it = _sessions.erase(it);
       else
         ++it;
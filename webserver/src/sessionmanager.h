@@ -1,6 +1,7 @@
 #ifndef CC_WEBSERVER_SESSIONMANAGER_H
 #define CC_WEBSERVER_SESSIONMANAGER_H
 
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -38,9 +39,10 @@ public:
 
   /**
    * Parse the given HTTP header containing all cookies in the request, and
-   * fetch the session cookie, if exists.
+   * fetch the session cookie, if exists. The session is shared, so it stays
+   * alive while the request is served even if it is destroyed meanwhile.
    */
-  Session* getSessionCookie(const char* cookieHeader_);
+  std::shared_ptr<Session> getSessionCookie(const char* cookieHeader_);
 
   /**
    * Deletes the given session cookie from memory.
@@ -49,14 +51,15 @@ public:
 
   bool isValid(const Session* session_) const;
 
-  Session* authenticateUserWithNameAndPassword(const std::string& username_,
-                                               const std::string& password_);
+  std::shared_ptr<Session> authenticateUserWithNameAndPassword(
+    const std::string& username_,
+    const std::string& password_);
 
 private:
   const Authentication* _authEngine;
 
   mutable std::mutex _sessionMapLock;
-  std::unordered_map<std::string, Session> _sessions;
+  std::unordered_map<std::string, std::shared_ptr<Session>> _sessions;
 
   void cleanupOldSessions();
 };
@@ -0,0 +1,205 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <sys/stat.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <util/logutil.h>
+#include <webserver/mongoose.h>
+
+#include "staticfilehandler.h"
+
+namespace
+{
+
+/**
+ * Bigger files are served uncompressed by mongoose instead of keeping them in
+ * memory.
+ */
+const std::int64_t MAX_COMPRESSED_FILE_SIZE = 16 << 20;
+
+/**
+ * Returns the MIME type of the file if it is worth compressing, otherwise
+ * nullptr. Images (except SVG), fonts and archives are compressed already.
+ */
+const char* compressibleMimeType(const std::string& path_)
+{
+  static const std::pair<const char*, const char*> types[] = {
+    {".html", "text/html"},
+    {".htm",  "text/html"},
+    {".js",   "application/javascript"},
+    {".mjs",  "application/javascript"},
+    {".css",  "text/css"},
+    {".svg",  "image/svg+xml"},
+    {".json", "application/json"},
+    {".map",  "application/json"},
+    {".txt",  "text/plain"},
+    {".xml",  "text/xml"}
+  };
+
+  for (const auto& type : types)
+    if (boost::iends_with(path_, type.first))
+      return type.second;
+
+  return nullptr;
+}
+
+/**
+ * The files under _next/static are named by the hash of their content by the
+ * web GUI build, so they never change. The others have to be revalidated,
+ * which is cheap by the ETag.
+ */
+const char* cacheControl(const std::string& uri_)
+{
+  return uri_.find("/_next/static/") != std::string::npos
+    ? "public, max-age=31536000, immutable"
+    : "no-cache";
+}
+
+std::string gmtTime(std::time_t time_)
+{
+  char buffer[64];
+  std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT",
+    std::gmtime(&time_));
+  return buffer;
+}
+
+}
+
+namespace cc
+{
+namespace webserver
+{
+
+void StaticFileHandler::setDocumentRoot(const std::string& documentRoot_)
+{
+  _documentRoot = documentRoot_;
+
+  while (!_documentRoot.empty() && _documentRoot.back() == '/')
+    _documentRoot.pop_back();
+}
+
+int StaticFileHandler::serve(struct mg_connection* conn_)
+{
+  const bool head = std::strcmp(conn_->request_method, "HEAD") == 0;
+
+  if (_documentRoot.empty() ||
+      (!head && std::strcmp(conn_->request_method, "GET") != 0))
+    return MG_FALSE;
+
+  const std::string uri = conn_->uri;
+
+  if (uri.empty() || uri[0] != '/' || uri.find("..") != std::string::npos)
+    return MG_FALSE;
+
+  std::string path = _documentRoot + uri;
+
+  struct stat st;
+  if (::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+  {
+    if (path.back() != '/')
+      return MG_FALSE; // Mongoose redirects to the URI with a trailing slash.
+
+    path += "index.html";
+  }
+
+  if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size < static_cast<std::int64_t>(util::COMPRESSION_THRESHOLD) ||
+      st.st_size > MAX_COMPRESSED_FILE_SIZE)
+    return MG_FALSE;
+
+  const char* mimeType = compressibleMimeType(path);
+  if (!mimeType)
+    return MG_FALSE;
+
+  util::ContentEncoding encoding
+    = util::negotiateEncoding(mg_get_header(conn_, "Accept-Encoding"));
+  if (encoding == util::ContentEncoding::IDENTITY)
+    return MG_FALSE;
+
+  // The same format as the ETag of mongoose, but different for each encoding.
+  char etag[96];
+  std::snprintf(etag, sizeof(etag), "\"%lx.%lld-%s\"",
+    static_cast<unsigned long>(st.st_mtime),
+    static_cast<long long>(st.st_size),
+    util::encodingName(encoding));
+
+  const char* ifNoneMatch = mg_get_header(conn_, "If-None-Match");
+  if (ifNoneMatch && std::strstr(ifNoneMatch, etag))
+  {
+    mg_send_status(conn_, 304); // 304 Not Modified.
+    mg_send_header(conn_, "ETag", etag);
+    mg_send_header(conn_, "Cache-Control", cacheControl(uri));
+    mg_send_header(conn_, "Vary", "Accept-Encoding");
+    mg_write(conn_, "\r\n", 2);
+    return MG_TRUE;
+  }
+
+  std::shared_ptr<const CompressedFile> file
+    = getCompressed(path, st.st_mtime, st.st_size, encoding);
+  if (!file)
+    return MG_FALSE;
+
+  mg_send_header(conn_, "Content-Type", mimeType);
+  mg_send_header(conn_, "Content-Encoding", util::encodingName(encoding));
+  mg_send_header(conn_, "Vary", "Accept-Encoding");
+  mg_send_header(conn_, "ETag", etag);
+  mg_send_header(conn_, "Last-Modified", gmtTime(st.st_mtime).c_str());
+  mg_send_header(conn_, "Cache-Control", cacheControl(uri));
+  mg_send_header(
+    conn_, "Content-Length", std::to_string(file->content.size()).c_str());
+  mg_write(conn_, "\r\n", 2);
+
+  if (!head)
+    mg_write(conn_, file->content.data(), file->content.size());
+
+  return MG_TRUE;
+}
+
+std::shared_ptr<const StaticFileHandler::CompressedFile>
+StaticFileHandler::getCompressed(
+  const std::string& path_,
+  std::time_t mtime_,
+  std::int64_t size_,
+  util::ContentEncoding encoding_)
+{
+  const std::string key = path_ + '\0' + util::encodingName(encoding_);
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _cache.find(key);
+    if (it != _cache.end() &&
+        it->second->mtime == mtime_ && it->second->size == size_)
+      return it->second;
+  }
+
+  std::ifstream stream(path_, std::ios::binary);
+  std::string content(
+    (std::istreambuf_iterator<char>(stream)),
+    std::istreambuf_iterator<char>());
+
+  if (!stream.good() && !stream.eof())
+    return nullptr;
+
+  auto file = std::make_shared<CompressedFile>();
+  file->mtime = mtime_;
+  file->size = size_;
+
+  if (!util::compress(content.data(), content.size(), encoding_, file->content))
+  {
+    LOG(warning) << "Couldn't compress " << path_;
+    return nullptr;
+  }
+
+  // Concurrent requests may compress the same file, the last one wins.
+  std::lock_guard<std::mutex> lock(_mutex);
+  _cache[key] = file;
+
+  return file;
+}
+
+} // webserver
+} // cc
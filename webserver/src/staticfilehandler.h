@@ -0,0 +1,69 @@
+#ifndef CC_WEBSERVER_STATICFILEHANDLER_H
+#define CC_WEBSERVER_STATICFILEHANDLER_H
+
+#include <ctime>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <util/compression.h>
+
+struct mg_connection;
+
+namespace cc
+{
+namespace webserver
+{
+
+/**
+ * Serves the compressible static files of the web GUI (HTML, JavaScript, CSS,
+ * SVG etc.) compressed, together with validator and caching headers. The
+ * compressed files are kept in memory until the file changes on disk.
+ *
+ * Other files, and requests of clients which don't accept a compressed
+ * response, are left to mongoose. It also sends ETag and Last-Modified headers
+ * and answers conditional requests by 304 Not Modified.
+ */
+class StaticFileHandler
+{
+public:
+  void setDocumentRoot(const std::string& documentRoot_);
+
+  /**
+   * Serves the requested file if it is worth compressing.
+   * @return MG_TRUE if the request has been served, MG_FALSE if it should be
+   * served by mongoose.
+   */
+  int serve(struct mg_connection* conn_);
+
+private:
+  struct CompressedFile
+  {
+    std::time_t mtime;
+    std::int64_t size;
+    std::string content;
+  };
+
+  /**
+   * Returns the compressed content of the file, compressing it if it isn't
+   * cached yet or the file has changed since.
+   */
+  std::shared_ptr<const CompressedFile> getCompressed(
+    const std::string& path_,
+    std::time_t mtime_,
+    std::int64_t size_,
+    util::ContentEncoding encoding_);
+
+  std::string _documentRoot;
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, std::shared_ptr<const CompressedFile>>
+    _cache;
+};
+
+} // webserver
+} // cc
+
+#endif // CC_WEBSERVER_STATICFILEHANDLER_H
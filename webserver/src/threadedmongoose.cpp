@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "threadedmongoose.h"
 
 namespace cc
@@ -22,7 +24,10 @@ const unsigned ThreadedMongoose::DEFAULT_MAX_THREAD;
 
 ThreadedMongoose::Handler ThreadedMongoose::handler;
 
-ThreadedMongoose::ThreadedMongoose(int numThreads_) : _numThreads(numThreads_)
+thread_local mg_server* ThreadedMongoose::_currentServer = nullptr;
+
+ThreadedMongoose::ThreadedMongoose(int numThreads_, int numWorkers_)
+  : _numThreads(numThreads_), _numWorkers(numWorkers_)
 {
 }
 
@@ -38,6 +43,19 @@ std::string ThreadedMongoose::getOption(const std::string& optName_)
   return _options[optName_];
 }
 
+void ThreadedMongoose::dispatch(std::function<void()> job_)
+{
+  mg_server* server = _currentServer;
+
+  _workers->enqueue([job_, server]()
+  {
+    job_();
+
+    // The result is delivered by the I/O thread of the connection.
+    mg_wakeup_server(server);
+  });
+}
+
 void ThreadedMongoose::run(Handler handler_)
 {
   run((void*)0, handler_);
@@ -50,6 +68,8 @@ void ThreadedMongoose::signalHandler(int sigNum_)
 
 void* ThreadedMongoose::serve(void* server_)
 {
+  _currentServer = static_cast<mg_server*>(server_);
+
   while (!exitFlag)
   {
     mg_poll_server((mg_server*)server_, 1000);
@@ -58,6 +78,28 @@ void* ThreadedMongoose::serve(void* server_)
   return nullptr;
 }
 
+int ThreadedMongoose::defaultThreadCount()
+{
+  return std::max(std::thread::hardware_concurrency(), DEFAULT_MAX_THREAD);
+}
+
+void ThreadedMongoose::startWorkers()
+{
+  _workers = util::make_thread_pool<std::function<void()>>(
+    _numWorkers,
+    [](std::function<void()> job_)
+    {
+      job_();
+    },
+    true);
+}
+
+void ThreadedMongoose::stopWorkers()
+{
+  _workers->wait();
+  _workers.reset();
+}
+
 int ThreadedMongoose::delegater(mg_connection *conn_, enum mg_event ev_)
 {
   if (handler)
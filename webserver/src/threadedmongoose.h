@@ -10,6 +10,8 @@
 #include <signal.h>
 #include <stdexcept>
 
+#include <util/threadpool.h>
+
 #include <webserver/mongoose.h>
 
 namespace cc
@@ -30,6 +32,16 @@ private:
   SignalHandler _origHandler;
 };
 
+/**
+ * Multithreaded front end of the Mongoose server. The connections are served
+ * by a few I/O threads, each running an event loop of its own Mongoose server
+ * on the shared listening socket. The expensive requests are not served on
+ * the I/O threads: the handler passes them to dispatch(), which runs them on
+ * a separate worker pool. When a job finishes, the I/O thread which has
+ * dispatched it is woken up and the handler sends the reply on the next
+ * MG_POLL event of the connection. This way a slow request doesn't delay
+ * the other connections of the same I/O thread.
+ */
 class ThreadedMongoose
 {
 public:
@@ -37,11 +49,13 @@ public:
 
   /**
    * Constructor for creating a multithreaded Mongoose server.
-   * @param numThreads_ Number of threads to run the server on. If its value is
-   * less than 1 then by default maximum the number of available cores and the
-   * value of DEFAULT_MAX_THREAD will be used.
+   * @param numThreads_ Number of I/O threads to run the server on. If its
+   * value is less than 1 then by default maximum the number of available
+   * cores and the value of DEFAULT_MAX_THREAD will be used.
+   * @param numWorkers_ Number of worker threads serving the dispatched jobs.
+   * If its value is less than 1 then the same default is used.
    */
-  ThreadedMongoose(int numThreads_ = 0);
+  ThreadedMongoose(int numThreads_ = 0, int numWorkers_ = 0);
 
   /**
    * This function configures the Mongoose server with the given option. The
@@ -57,6 +71,14 @@ public:
    */
   std::string getOption(const std::string& optName_);
 
+  /**
+   * Runs the job on the worker pool, then wakes up the calling I/O thread so
+   * it delivers MG_POLL events to its connections. The job must not access
+   * any mongoose connection. It can only be called by the handler on an I/O
+   * thread.
+   */
+  void dispatch(std::function<void()> job_);
+
   void run(Handler handler_);
 
   template <typename T>
@@ -72,17 +94,14 @@ public:
     SignalChanger intSig(SIGINT, signalHandler);
 
     if (_numThreads < 1)
-    {
-      _numThreads
-        = std::max(std::thread::hardware_concurrency(), DEFAULT_MAX_THREAD);
-    }
+      _numThreads = defaultThreadCount();
+
+    if (_numWorkers < 1)
+      _numWorkers = defaultThreadCount();
 
     std::vector<ServerPtr> servers;
     servers.reserve(_numThreads);
 
-    std::vector<std::thread> threads;
-    threads.reserve(_numThreads - 1);
-
     for (int i = 0; i < _numThreads; ++i)
     {
       ServerPtr server = ServerPtr(
@@ -117,29 +136,41 @@ public:
         }
       }
 
-      // if this is not the last server, create a new thread
-      if (i != _numThreads - 1)
-      {
-        threads.push_back(std::thread(serve, server.get()));
-      }
-      // this is the last server, run serve in current thread
-      else
-      {
-        serve(server.get());
-      }
-
       servers.push_back(std::move(server));
     }
 
-    // ~joiner waits for all threads to finish
+    startWorkers();
+
+    std::vector<std::thread> threads;
+    threads.reserve(_numThreads - 1);
+
+    // the last server runs in the current thread
+    for (int i = 0; i < _numThreads - 1; ++i)
+      threads.push_back(std::thread(serve, servers[i].get()));
+
+    serve(servers.back().get());
+
+    for (std::thread& thread : threads)
+      thread.join();
+
+    // The workers may still wake up the servers, so they are stopped before
+    // the servers are destroyed.
+    stopWorkers();
+
     // ~servers releases the servers' resources
     // ~termSig and ~intSig restores signal handlers
   }
 
 private:
+  typedef util::JobQueueThreadPool<std::function<void()>> WorkerPool;
+
   static void signalHandler(int sigNum_);
   static void* serve(void* server_);
   static int delegater(mg_connection *conn_, enum mg_event ev_);
+  static int defaultThreadCount();
+
+  void startWorkers();
+  void stopWorkers();
 
   static volatile int exitFlag;
   static Handler handler;
@@ -147,6 +178,16 @@ private:
 
   std::map<std::string, std::string> _options;
   int _numThreads;
+  int _numWorkers;
+
+  std::unique_ptr<WorkerPool> _workers;
+
+  /**
+   * The server of the I/O thread. The connections of a server are only served
+   * by its own thread, so this is the server to wake up when a job of the
+   * thread finishes.
+   */
+  static thread_local mg_server* _currentServer;
 };
 
 } // mongoose
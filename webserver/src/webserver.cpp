@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <functional>
 #include <iostream>
 
 #include <boost/filesystem.hpp>
@@ -7,6 +9,7 @@
 #include <boost/optional.hpp>
 #include <boost/program_options.hpp>
 
+#include <util/dbutil.h>
 #include <util/filesystem.h>
 #include <util/logutil.h>
 #include <util/webserverutil.h>
@@ -41,7 +44,21 @@ po::options_description commandLineArguments()
          "This is the path to the folder where the logging output files will be written. "
          "If omitted, the output will be on the console only.")
         ("jobs,j", po::value<int>()->default_value(4),
-         "Number of worker threads.");
+         "Number of worker threads serving the service requests.")
+        ("io-threads", po::value<int>()->default_value(2),
+         "Number of threads accepting the connections and serving the static "
+         "files.")
+        ("db-pool-max", po::value<std::size_t>(),
+         "Maximal number of connections to the database of a project, shared "
+         "by all services. By default it is the number of worker threads "
+         "(--jobs). Zero means unlimited.")
+        ("db-pool-min", po::value<std::size_t>()->default_value(1),
+         "Number of connections to the database of a project which are kept "
+         "open even if they are idle for longer than --db-pool-idle-timeout.")
+        ("db-pool-idle-timeout", po::value<std::size_t>()->default_value(60),
+         "Seconds after which an idle database connection is closed, as long "
+         "as more than --db-pool-min connections of the project are open. "
+         "Zero keeps the idle connections open.");
 
     return desc;
 }
@@ -146,6 +163,17 @@ int main(int argc, char* argv[])
       LOG(debug) << "Google Analytics monitoring disabled.";
     }
 
+    //--- Set up the database connection pools ---//
+
+    cc::util::DatabasePoolOptions poolOptions;
+    poolOptions.maxConnections = vm.count("db-pool-max")
+        ? vm["db-pool-max"].as<std::size_t>()
+        : static_cast<std::size_t>(std::max(vm["jobs"].as<int>(), 0));
+    poolOptions.minConnections = vm["db-pool-min"].as<std::size_t>();
+    poolOptions.idleTimeout = vm["db-pool-idle-timeout"].as<std::size_t>();
+
+    cc::util::configureDatabasePool(poolOptions);
+
     //--- Process workspaces ---//
 
     cc::webserver::ServerContext ctx(compassRoot, vm, sessions.get());
@@ -153,9 +181,13 @@ int main(int argc, char* argv[])
 
     //--- Start mongoose server ---//
 
-    cc::webserver::ThreadedMongoose server(vm["jobs"].as<int>());
+    cc::webserver::ThreadedMongoose server(
+        vm["io-threads"].as<int>(), vm["jobs"].as<int>());
+    requestHandler.server = &server;
     server.setOption("listening_port", std::to_string(vm["port"].as<int>()));
     server.setOption("document_root", vm["webguiDir"].as<std::string>());
+    requestHandler.staticFileHandler.setDocumentRoot(
+        vm["webguiDir"].as<std::string>());
 
     // Check if certificate.pem exists in the workspace - if so, start SSL.
     auto certPath = fs::path(vm["workspace"].as<std::string>())
@@ -176,7 +208,7 @@ int main(int argc, char* argv[])
 
     try
     {
-        server.run(requestHandler);
+        server.run(std::ref(requestHandler));
         LOG(info) << "Exiting, waiting for all threads to finish...";
     }
     catch (const std::exception& ex)
@@ -0,0 +1,237 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <webserver/mongoose.h>
+
+#include "staticfilehandler.h"
+
+namespace fs = boost::filesystem;
+
+using namespace cc::webserver;
+
+namespace
+{
+
+StaticFileHandler staticFileHandler;
+
+int handler(struct mg_connection* conn_, enum mg_event ev_)
+{
+  switch (ev_)
+  {
+    case MG_AUTH:
+      return MG_TRUE;
+
+    case MG_REQUEST:
+      return staticFileHandler.serve(conn_);
+
+    default:
+      return MG_FALSE;
+  }
+}
+
+struct Response
+{
+  int status = 0;
+  std::string headers;
+  std::string body;
+
+  /**
+   * Returns the value of the given header or an empty string if it is
+   * missing.
+   */
+  std::string header(const std::string& name_) const
+  {
+    std::string::size_type pos = headers.find("\r\n" + name_ + ": ");
+    if (pos == std::string::npos)
+      return std::string();
+
+    pos += name_.size() + 4;
+    return headers.substr(pos, headers.find("\r\n", pos) - pos);
+  }
+};
+
+}
+
+/**
+ * Runs a mongoose server in a thread which serves the static files of a
+ * temporary document root through the StaticFileHandler.
+ */
+class StaticFileHandlerTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    _root = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(_root);
+
+    std::string content;
+    for (int i = 0; i < 200; ++i)
+      content += "console.log(" + std::to_string(i) + ");\n";
+
+    std::ofstream((_root / "app.js").string()) << content;
+    std::ofstream((_root / "small.js").string()) << "console.log(0);\n";
+
+    staticFileHandler.setDocumentRoot(_root.string());
+
+    _server = mg_create_server(nullptr, handler);
+    mg_set_option(_server, "document_root", _root.string().c_str());
+    ASSERT_EQ(nullptr, mg_set_option(_server, "listening_port", "127.0.0.1:0"));
+
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    ::getsockname(mg_get_listening_socket(_server),
+      reinterpret_cast<sockaddr*>(&addr), &len);
+    _port = ntohs(addr.sin_port);
+
+    _running = true;
+    _thread = std::thread([this]{
+      while (_running)
+        mg_poll_server(_server, 50);
+    });
+  }
+
+  void TearDown() override
+  {
+    _running = false;
+    _thread.join();
+    mg_destroy_server(&_server);
+
+    fs::remove_all(_root);
+  }
+
+  /**
+   * Sends a GET request with the given extra headers and reads the response
+   * until the server closes the connection.
+   */
+  Response get(const std::string& uri_, const std::string& headers_ = "")
+  {
+    int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    Response response;
+
+    if (::connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+      ::close(sock);
+      return response;
+    }
+
+    const std::string request = "GET " + uri_ + " HTTP/1.1\r\n"
+      "Host: localhost\r\nConnection: close\r\n" + headers_ + "\r\n";
+    ::send(sock, request.data(), request.size(), 0);
+
+    std::string raw;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::recv(sock, buffer, sizeof(buffer), 0)) > 0)
+      raw.append(buffer, n);
+
+    ::close(sock);
+
+    std::string::size_type end = raw.find("\r\n\r\n");
+    if (end == std::string::npos || raw.compare(0, 9, "HTTP/1.1 ") != 0)
+      return response;
+
+    response.status = std::stoi(raw.substr(9, 3));
+    response.headers = raw.substr(0, end + 2);
+    response.body = raw.substr(end + 4);
+
+    return response;
+  }
+
+  fs::path _root;
+  struct mg_server* _server = nullptr;
+  unsigned short _port = 0;
+  std::atomic<bool> _running{false};
+  std::thread _thread;
+};
+
+TEST_F(StaticFileHandlerTest, ServesCompressedFile)
+{
+  Response response = get("/app.js", "Accept-Encoding: gzip\r\n");
+
+  EXPECT_EQ(200, response.status);
+  EXPECT_EQ("gzip", response.header("Content-Encoding"));
+  EXPECT_EQ("Accept-Encoding", response.header("Vary"));
+  EXPECT_EQ("no-cache", response.header("Cache-Control"));
+  EXPECT_EQ(
+    std::to_string(response.body.size()), response.header("Content-Length"));
+  EXPECT_NE(std::string::npos, response.header("ETag").find("-gzip\""));
+}
+
+TEST_F(StaticFileHandlerTest, LeavesUncompressedRequestsToMongoose)
+{
+  Response response = get("/app.js");
+
+  EXPECT_EQ(200, response.status);
+  EXPECT_EQ("", response.header("Content-Encoding"));
+  EXPECT_EQ(fs::file_size(_root / "app.js"), response.body.size());
+
+  response = get("/small.js", "Accept-Encoding: gzip\r\n");
+
+  EXPECT_EQ(200, response.status);
+  EXPECT_EQ("", response.header("Content-Encoding"));
+  EXPECT_EQ("console.log(0);\n", response.body);
+}
+
+TEST_F(StaticFileHandlerTest, MatchingETagIsNotModified)
+{
+  Response first = get("/app.js", "Accept-Encoding: gzip\r\n");
+  const std::string etag = first.header("ETag");
+  ASSERT_FALSE(etag.empty());
+
+  Response response = get("/app.js",
+    "Accept-Encoding: gzip\r\nIf-None-Match: " + etag + "\r\n");
+
+  EXPECT_EQ(304, response.status);
+  EXPECT_EQ(etag, response.header("ETag"));
+  EXPECT_EQ("Accept-Encoding", response.header("Vary"));
+  EXPECT_EQ("no-cache", response.header("Cache-Control"));
+  EXPECT_TRUE(response.body.empty());
+
+  // One of several validators matches.
+  response = get("/app.js",
+    "Accept-Encoding: gzip\r\nIf-None-Match: \"1.2-gzip\", " + etag + "\r\n");
+
+  EXPECT_EQ(304, response.status);
+}
+
+TEST_F(StaticFileHandlerTest, OtherETagIsServed)
+{
+  Response first = get("/app.js", "Accept-Encoding: gzip\r\n");
+  const std::string etag = first.header("ETag");
+  ASSERT_FALSE(etag.empty());
+
+  Response response = get("/app.js",
+    "Accept-Encoding: gzip\r\nIf-None-Match: \"1.2-gzip\"\r\n");
+
+  EXPECT_EQ(200, response.status);
+  EXPECT_EQ(first.body, response.body);
+
+  // The ETag differs for each encoding, so a cached gzip response doesn't
+  // validate a deflate one.
+  response = get("/app.js",
+    "Accept-Encoding: deflate\r\nIf-None-Match: " + etag + "\r\n");
+
+  EXPECT_EQ(200, response.status);
+  EXPECT_EQ("deflate", response.header("Content-Encoding"));
+  EXPECT_NE(etag, response.header("ETag"));
+}